@@ -1,4 +1,6 @@
 #include "Game/App.h"
+#include "Game/ChessEvaluation.hpp"
+#include "Game/ChessTablebase.hpp"
 #include "Engine/Core/EventSystem.hpp"
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/Renderer/Camera.h"
@@ -36,6 +38,25 @@ App::~App()
 void App::Startup()
 {
 	LoadGameConfig("Data/GameConfig.xml");
+
+	std::string evalWeightsFile = g_gameConfigBlackboard.GetValue("evalWeightsFile", "Data/ChessEvalWeights.xml");
+	if (!g_chessEvalWeights.LoadFromXmlFile(evalWeightsFile))
+	{
+		DebuggerPrintf("WARNING: Failed to load evaluation weights from file \"%s\", using built-in weights\n", evalWeightsFile.c_str());
+	}
+
+	// Tablebase files are only listed here; each one is mapped the first time a search needs it
+	std::string syzygyPath = g_gameConfigBlackboard.GetValue("syzygyPath", "");
+	if (!syzygyPath.empty() && g_chessTablebases.Initialize(syzygyPath) == 0)
+	{
+		DebuggerPrintf("WARNING: No Syzygy tablebases found in \"%s\"\n", syzygyPath.c_str());
+	}
+	std::string endgameTablePath = g_gameConfigBlackboard.GetValue("endgameTablePath", "");
+	if (!endgameTablePath.empty() && g_chessTablebases.AddEndgameTables(endgameTablePath) == 0)
+	{
+		DebuggerPrintf("WARNING: No generated endgame tables found in \"%s\" (build them with -egtb)\n", endgameTablePath.c_str());
+	}
+
 	float windowAspect = g_gameConfigBlackboard.GetValue("windowAspect", 0.f);
 
 	// Create all Engine Subsystems
@@ -0,0 +1,614 @@
+#include "Game/ChessAlphaBetaEngine.hpp"
+#include "Game/ChessEvaluation.hpp"
+#include "Game/ChessTablebase.hpp"
+#include <algorithm>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+constexpr int BOUND_EXACT = 0;
+constexpr int BOUND_LOWER = 1;
+constexpr int BOUND_UPPER = 2;
+constexpr int SEARCH_INFINITY = CHESS_MATE_SCORE + 1;
+constexpr uint64_t NODES_BETWEEN_TIME_CHECKS = 1024;
+// -----------------------------------------------------------------------------
+
+ChessAlphaBetaEngine::ChessAlphaBetaEngine(int transpositionTableSizeMB)
+{
+	ResizeTranspositionTable(transpositionTableSizeMB);
+}
+
+ChessAlphaBetaEngine::~ChessAlphaBetaEngine()
+{
+}
+
+void ChessAlphaBetaEngine::ResizeTranspositionTable(int sizeMB)
+{
+	uint64_t numEntries = 1;
+	uint64_t maxEntries = (static_cast<uint64_t>(sizeMB) * 1024 * 1024) / sizeof(ChessTranspositionEntry);
+	while (numEntries * 2 <= maxEntries)
+	{
+		numEntries *= 2;
+	}
+
+	m_transpositionTable = std::vector<ChessTranspositionEntry>(numEntries);
+	m_transpositionMask = numEntries - 1;
+}
+
+void ChessAlphaBetaEngine::ClearTranspositionTable()
+{
+	for (ChessTranspositionEntry& entry : m_transpositionTable)
+	{
+		entry.m_keyXorData = 0;
+		entry.m_data = 0;
+	}
+}
+
+ChessSearchResult ChessAlphaBetaEngine::Search(ChessPosition const& position, ChessSearchLimits const& limits)
+{
+	m_isStopRequested = false;
+	m_searchStartTime = std::chrono::steady_clock::now();
+	m_maxSeconds = limits.m_maxSeconds;
+	m_maxNodes = limits.m_maxNodes;
+	m_sharedNodes = 0;
+	m_useTablebases = limits.m_useTablebases;
+	m_tablebaseHits = 0;
+
+	// Tablebase endings need no search at all
+	ChessSearchResult tablebaseResult;
+	if (ProbeTablebaseRoot(position, tablebaseResult))
+	{
+		tablebaseResult.m_seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_searchStartTime).count();
+		tablebaseResult.m_bestMoveSeconds = tablebaseResult.m_seconds;
+		return tablebaseResult;
+	}
+
+	int numThreads = (limits.m_numThreads < 1) ? 1 : limits.m_numThreads;
+	int maxDepth = (limits.m_maxDepth < 1) ? 1 : std::min(limits.m_maxDepth, CHESS_MAX_SEARCH_PLY - 1);
+
+	std::vector<ChessSearchThread> searchThreads(numThreads);
+	std::vector<std::thread> helperThreads;
+	for (int threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		searchThreads[threadIndex].m_threadIndex = threadIndex;
+	}
+
+	// Helper threads only warm the shared table; the main thread's result is the one reported
+	for (int threadIndex = 1; threadIndex < numThreads; ++threadIndex)
+	{
+		helperThreads.emplace_back([this, &searchThreads, &position, threadIndex, maxDepth]()
+		{
+			RunIterativeDeepening(searchThreads[threadIndex], position, maxDepth);
+		});
+	}
+	RunIterativeDeepening(searchThreads[0], position, maxDepth);
+
+	m_isStopRequested = true;
+	for (std::thread& helperThread : helperThreads)
+	{
+		helperThread.join();
+	}
+
+	ChessSearchResult result;
+	result.m_bestMove = searchThreads[0].m_bestRootMove;
+	result.m_score = searchThreads[0].m_bestRootScore;
+	result.m_depth = searchThreads[0].m_completedDepth;
+	result.m_bestMoveSeconds = searchThreads[0].m_bestMoveSeconds;
+	result.m_bestMoveNodes = searchThreads[0].m_bestMoveNodes;
+	for (ChessSearchThread const& searchThread : searchThreads)
+	{
+		result.m_nodes += searchThread.m_nodes;
+	}
+	result.m_tablebaseHits = m_tablebaseHits;
+	result.m_seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_searchStartTime).count();
+	return result;
+}
+
+void ChessAlphaBetaEngine::RunIterativeDeepening(ChessSearchThread& thread, ChessPosition const& rootPosition, int maxDepth)
+{
+	thread.m_pathHashes[0] = rootPosition.GetHash();
+
+	// Always have a legal move to fall back on, even if the first iteration gets interrupted
+	ChessMoveList rootMoves;
+	rootPosition.GenerateLegalMoves(rootMoves);
+	if (rootMoves.m_count == 0)
+	{
+		return;
+	}
+	thread.m_bestRootMove = rootMoves[0];
+
+	int previousScore = 0;
+	for (int depth = 1 + (thread.m_threadIndex % 2); depth <= maxDepth; ++depth)
+	{
+		// Aspiration window around the previous score once the search has settled
+		int window = 40;
+		int alpha = (depth >= 4) ? previousScore - window : -SEARCH_INFINITY;
+		int beta = (depth >= 4) ? previousScore + window : SEARCH_INFINITY;
+
+		int score = 0;
+		while (true)
+		{
+			score = SearchRoot(thread, rootPosition, depth, alpha, beta);
+			if (IsStopRequested())
+			{
+				break;
+			}
+			if (score <= alpha)
+			{
+				alpha = std::max(-SEARCH_INFINITY, alpha - window);
+				window *= 2;
+			}
+			else if (score >= beta)
+			{
+				beta = std::min(SEARCH_INFINITY, beta + window);
+				window *= 2;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (IsStopRequested() && depth > 1)
+		{
+			break;
+		}
+
+		// Test suites score the time to solution from the iteration that last changed the root move
+		if (thread.m_threadIndex == 0 && (thread.m_completedDepth == 0 || thread.m_iterationBestMove != thread.m_bestRootMove))
+		{
+			thread.m_bestMoveSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_searchStartTime).count();
+			thread.m_bestMoveNodes = m_sharedNodes + (thread.m_nodes % NODES_BETWEEN_TIME_CHECKS);
+		}
+
+		previousScore = score;
+		thread.m_bestRootScore = score;
+		thread.m_bestRootMove = thread.m_iterationBestMove;
+		thread.m_completedDepth = depth;
+
+		// A forced mate will not get shorter with more depth
+		if (abs(score) >= CHESS_MATE_THRESHOLD && depth > 1 && thread.m_threadIndex == 0)
+		{
+			break;
+		}
+	}
+
+	if (thread.m_threadIndex == 0)
+	{
+		m_isStopRequested = true;
+	}
+}
+
+int ChessAlphaBetaEngine::SearchRoot(ChessSearchThread& thread, ChessPosition const& rootPosition, int depth, int alpha, int beta)
+{
+	ChessMoveList moves;
+	rootPosition.GenerateLegalMoves(moves);
+	OrderMoves(thread, rootPosition, moves, thread.m_bestRootMove, 0);
+
+	int bestScore = -SEARCH_INFINITY;
+	ChessMove bestMove = moves[0];
+	int originalAlpha = alpha;
+
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessPosition child = rootPosition;
+		child.MakeMove(moves[moveIndex]);
+		thread.m_pathHashes[1] = child.GetHash();
+
+		int score = 0;
+		if (moveIndex == 0)
+		{
+			score = -SearchNode(thread, child, depth - 1, -beta, -alpha, 1, true);
+		}
+		else
+		{
+			score = -SearchNode(thread, child, depth - 1, -alpha - 1, -alpha, 1, true);
+			if (score > alpha && score < beta)
+			{
+				score = -SearchNode(thread, child, depth - 1, -beta, -alpha, 1, true);
+			}
+		}
+
+		if (IsStopRequested() && depth > 1)
+		{
+			return bestScore;
+		}
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestMove = moves[moveIndex];
+			thread.m_iterationBestMove = bestMove;
+		}
+		if (score > alpha)
+		{
+			alpha = score;
+		}
+		if (alpha >= beta)
+		{
+			break;
+		}
+	}
+
+	int bound = (bestScore <= originalAlpha) ? BOUND_UPPER : ((bestScore >= beta) ? BOUND_LOWER : BOUND_EXACT);
+	StoreTranspositionTable(rootPosition.GetHash(), bestMove, bestScore, depth, bound, 0);
+	return bestScore;
+}
+
+int ChessAlphaBetaEngine::SearchNode(ChessSearchThread& thread, ChessPosition const& position, int depth, int alpha, int beta, int ply, bool allowNullMove)
+{
+	int sideToMove = position.GetSideToMove();
+
+	// A missing king or an opponent king left en prise ends the game immediately
+	if (position.GetKingSquare(sideToMove) == CHESS_NO_SQUARE)
+	{
+		return -CHESS_MATE_SCORE + ply;
+	}
+	if (position.IsInCheck(1 - sideToMove))
+	{
+		return CHESS_MATE_SCORE - ply;
+	}
+
+	if (position.m_halfmoveClock >= 100 || IsRepetition(thread, position, ply) || position.IsInsufficientMaterial())
+	{
+		return 0;
+	}
+
+	if (depth <= 0 || ply >= CHESS_MAX_SEARCH_PLY - 1)
+	{
+		return SearchQuiescence(thread, position, alpha, beta, ply);
+	}
+
+	thread.m_nodes += 1;
+	if (ShouldStop(thread))
+	{
+		return 0;
+	}
+
+	// Mate distance pruning
+	alpha = std::max(alpha, -CHESS_MATE_SCORE + ply);
+	beta = std::min(beta, CHESS_MATE_SCORE - ply - 1);
+	if (alpha >= beta)
+	{
+		return alpha;
+	}
+
+	bool isPVNode = (beta - alpha) > 1;
+	ChessMove hashMove;
+	int hashScore = 0;
+	int hashDepth = 0;
+	int hashBound = 0;
+	if (ProbeTranspositionTable(position.GetHash(), hashMove, hashScore, hashDepth, hashBound, ply) && !isPVNode && hashDepth >= depth)
+	{
+		if (hashBound == BOUND_EXACT ||
+			(hashBound == BOUND_LOWER && hashScore >= beta) ||
+			(hashBound == BOUND_UPPER && hashScore <= alpha))
+		{
+			return hashScore;
+		}
+	}
+
+	// Generated tables give exact mate distances at any fifty-move count
+	ChessWDLScore tablebaseWDL = ChessWDLScore::DRAW;
+	int pliesToMate = 0;
+	if (m_useTablebases && g_chessTablebases.ProbeDTM(position, tablebaseWDL, pliesToMate))
+	{
+		m_tablebaseHits.fetch_add(1, std::memory_order_relaxed);
+		int mateScore = CHESS_MATE_SCORE - (ply + pliesToMate);
+		int tablebaseScore = (tablebaseWDL == ChessWDLScore::WIN) ? mateScore : ((tablebaseWDL == ChessWDLScore::LOSS) ? -mateScore : 0);
+		StoreTranspositionTable(position.GetHash(), ChessMove(), tablebaseScore, std::min(depth + 6, CHESS_MAX_SEARCH_PLY - 1), BOUND_EXACT, ply);
+		return tablebaseScore;
+	}
+
+	// Right after a capture or pawn move the fifty-move count is zero, so the WDL result is exact
+	if (m_useTablebases && position.m_halfmoveClock == 0 && g_chessTablebases.ProbeWDL(position, tablebaseWDL))
+	{
+		m_tablebaseHits.fetch_add(1, std::memory_order_relaxed);
+		int tablebaseScore = GetChessTablebaseScore(tablebaseWDL, ply);
+		StoreTranspositionTable(position.GetHash(), ChessMove(), tablebaseScore, std::min(depth + 6, CHESS_MAX_SEARCH_PLY - 1), BOUND_EXACT, ply);
+		return tablebaseScore;
+	}
+
+	bool isInCheck = position.IsInCheck(sideToMove);
+	if (isInCheck)
+	{
+		depth += 1;
+	}
+
+	// Null move pruning, skipped in pawn endings where zugzwang is common
+	if (allowNullMove && !isInCheck && !isPVNode && depth >= 3 && GetChessGamePhase(position) > 0 && EvaluateChessPosition(position) >= beta)
+	{
+		ChessPosition child = position;
+		child.MakeNullMove();
+		thread.m_pathHashes[ply + 1] = child.GetHash();
+		int reduction = (depth >= 6) ? 3 : 2;
+		int score = -SearchNode(thread, child, depth - 1 - reduction, -beta, -beta + 1, ply + 1, false);
+		if (score >= beta && !IsStopRequested())
+		{
+			return (score >= CHESS_MATE_THRESHOLD) ? beta : score;
+		}
+	}
+
+	ChessMoveList moves;
+	position.GeneratePseudoLegalMoves(moves);
+	OrderMoves(thread, position, moves, hashMove, ply);
+
+	int originalAlpha = alpha;
+	int bestScore = -SEARCH_INFINITY;
+	ChessMove bestMove;
+	int numLegalMoves = 0;
+
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = moves[moveIndex];
+		ChessPosition child = position;
+		child.MakeMove(move);
+		if (child.IsInCheck(sideToMove))
+		{
+			continue;
+		}
+
+		numLegalMoves += 1;
+		thread.m_pathHashes[ply + 1] = child.GetHash();
+
+		bool isQuiet = !move.IsCapture() && !move.IsPromotion();
+		int score = 0;
+		if (numLegalMoves == 1)
+		{
+			score = -SearchNode(thread, child, depth - 1, -beta, -alpha, ply + 1, true);
+		}
+		else
+		{
+			// Late move reductions for quiet moves that ordering placed near the end
+			int reduction = 0;
+			if (isQuiet && !isInCheck && depth >= 3 && numLegalMoves > 4 && !child.IsInCheck(child.GetSideToMove()))
+			{
+				reduction = (numLegalMoves > 12) ? 2 : 1;
+			}
+
+			score = -SearchNode(thread, child, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, true);
+			if (score > alpha && reduction > 0)
+			{
+				score = -SearchNode(thread, child, depth - 1, -alpha - 1, -alpha, ply + 1, true);
+			}
+			if (score > alpha && score < beta)
+			{
+				score = -SearchNode(thread, child, depth - 1, -beta, -alpha, ply + 1, true);
+			}
+		}
+
+		if (IsStopRequested())
+		{
+			return 0;
+		}
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestMove = move;
+		}
+		if (score > alpha)
+		{
+			alpha = score;
+		}
+		if (alpha >= beta)
+		{
+			if (isQuiet)
+			{
+				if (thread.m_killerMoves[ply][0] != move)
+				{
+					thread.m_killerMoves[ply][1] = thread.m_killerMoves[ply][0];
+					thread.m_killerMoves[ply][0] = move;
+				}
+				thread.m_history[move.m_from][move.m_to] += depth * depth;
+			}
+			break;
+		}
+	}
+
+	if (numLegalMoves == 0)
+	{
+		return isInCheck ? (-CHESS_MATE_SCORE + ply) : 0;
+	}
+
+	int bound = (bestScore <= originalAlpha) ? BOUND_UPPER : ((bestScore >= beta) ? BOUND_LOWER : BOUND_EXACT);
+	StoreTranspositionTable(position.GetHash(), bestMove, bestScore, depth, bound, ply);
+	return bestScore;
+}
+
+int ChessAlphaBetaEngine::SearchQuiescence(ChessSearchThread& thread, ChessPosition const& position, int alpha, int beta, int ply)
+{
+	thread.m_nodes += 1;
+	if (ShouldStop(thread))
+	{
+		return 0;
+	}
+
+	int sideToMove = position.GetSideToMove();
+	if (position.GetKingSquare(sideToMove) == CHESS_NO_SQUARE)
+	{
+		return -CHESS_MATE_SCORE + ply;
+	}
+
+	int standPat = EvaluateChessPosition(position);
+	if (standPat >= beta || ply >= CHESS_MAX_SEARCH_PLY - 1)
+	{
+		return standPat;
+	}
+	if (standPat > alpha)
+	{
+		alpha = standPat;
+	}
+
+	ChessMoveList moves;
+	position.GeneratePseudoLegalMoves(moves);
+	OrderMoves(thread, position, moves, ChessMove(), ply);
+
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = moves[moveIndex];
+		if (!move.IsCapture() && !move.IsPromotion())
+		{
+			continue;
+		}
+
+		ChessPosition child = position;
+		child.MakeMove(move);
+		if (child.IsInCheck(sideToMove))
+		{
+			continue;
+		}
+
+		int score = -SearchQuiescence(thread, child, -beta, -alpha, ply + 1);
+		if (IsStopRequested())
+		{
+			return 0;
+		}
+		if (score >= beta)
+		{
+			return score;
+		}
+		if (score > alpha)
+		{
+			alpha = score;
+		}
+	}
+	return alpha;
+}
+
+void ChessAlphaBetaEngine::OrderMoves(ChessSearchThread const& thread, ChessPosition const& position, ChessMoveList& moves, ChessMove const& hashMove, int ply) const
+{
+	int scores[CHESS_MAX_MOVES];
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = moves[moveIndex];
+		int score = 0;
+		if (move == hashMove)
+		{
+			score = 10000000;
+		}
+		else if (move.IsCapture() || move.IsPromotion())
+		{
+			uint8_t victim = position.GetPieceAt(move.m_to);
+			int victimValue = (victim != CHESS_EMPTY_SQUARE) ? GetChessPieceValue(GetChessPieceTypeForCode(victim)) : GetChessPieceValue(ChessPieceType::PAWN);
+			int attackerValue = GetChessPieceValue(GetChessPieceTypeForCode(position.GetPieceAt(move.m_from)));
+			score = 1000000 + victimValue * 10 - attackerValue / 100;
+			if (move.IsPromotion())
+			{
+				score += GetChessPieceValue(move.GetPromotionType());
+			}
+		}
+		else if (move == thread.m_killerMoves[ply][0])
+		{
+			score = 900000;
+		}
+		else if (move == thread.m_killerMoves[ply][1])
+		{
+			score = 800000;
+		}
+		else
+		{
+			score = std::min(thread.m_history[move.m_from][move.m_to], 700000);
+		}
+		scores[moveIndex] = score;
+	}
+
+	// Insertion sort: move lists are short and mostly need only the first few entries in order
+	for (int moveIndex = 1; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMove move = moves[moveIndex];
+		int score = scores[moveIndex];
+		int insertIndex = moveIndex - 1;
+		while (insertIndex >= 0 && scores[insertIndex] < score)
+		{
+			moves[insertIndex + 1] = moves[insertIndex];
+			scores[insertIndex + 1] = scores[insertIndex];
+			--insertIndex;
+		}
+		moves[insertIndex + 1] = move;
+		scores[insertIndex + 1] = score;
+	}
+}
+
+bool ChessAlphaBetaEngine::IsRepetition(ChessSearchThread const& thread, ChessPosition const& position, int ply) const
+{
+	int maxLookback = std::min(position.m_halfmoveClock, ply);
+	for (int back = 2; back <= maxLookback; back += 2)
+	{
+		if (thread.m_pathHashes[ply - back] == position.GetHash())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ChessAlphaBetaEngine::ShouldStop(ChessSearchThread& thread)
+{
+	if (IsStopRequested())
+	{
+		return true;
+	}
+	if ((thread.m_nodes % NODES_BETWEEN_TIME_CHECKS) != 0)
+	{
+		return false;
+	}
+
+	uint64_t totalNodes = m_sharedNodes.fetch_add(NODES_BETWEEN_TIME_CHECKS) + NODES_BETWEEN_TIME_CHECKS;
+	float elapsedSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_searchStartTime).count();
+	if ((m_maxSeconds > 0.f && elapsedSeconds >= m_maxSeconds) || (m_maxNodes > 0 && totalNodes >= m_maxNodes))
+	{
+		m_isStopRequested = true;
+	}
+	return IsStopRequested();
+}
+
+// -----------------------------------------------------------------------------
+// Data layout: move:16 | score:16 | depth:8 | bound:8
+// -----------------------------------------------------------------------------
+bool ChessAlphaBetaEngine::ProbeTranspositionTable(uint64_t hash, ChessMove& out_move, int& out_score, int& out_depth, int& out_bound, int ply) const
+{
+	ChessTranspositionEntry const& entry = m_transpositionTable[hash & m_transpositionMask];
+	uint64_t data = entry.m_data.load(std::memory_order_relaxed);
+	uint64_t keyXorData = entry.m_keyXorData.load(std::memory_order_relaxed);
+	if ((keyXorData ^ data) != hash || data == 0)
+	{
+		return false;
+	}
+
+	out_move = ChessMove::MakeFromPacked(static_cast<uint16_t>(data & 0xFFFF));
+	out_score = static_cast<int16_t>((data >> 16) & 0xFFFF);
+	out_depth = static_cast<int>((data >> 32) & 0xFF);
+	out_bound = static_cast<int>((data >> 40) & 0xFF);
+
+	// Mate scores are stored relative to the node, convert back to root distance
+	if (out_score >= CHESS_MATE_THRESHOLD)
+	{
+		out_score -= ply;
+	}
+	else if (out_score <= -CHESS_MATE_THRESHOLD)
+	{
+		out_score += ply;
+	}
+	return true;
+}
+
+void ChessAlphaBetaEngine::StoreTranspositionTable(uint64_t hash, ChessMove const& move, int score, int depth, int bound, int ply)
+{
+	if (score >= CHESS_MATE_THRESHOLD)
+	{
+		score += ply;
+	}
+	else if (score <= -CHESS_MATE_THRESHOLD)
+	{
+		score -= ply;
+	}
+
+	uint64_t data = static_cast<uint64_t>(move.GetPacked());
+	data |= static_cast<uint64_t>(static_cast<uint16_t>(static_cast<int16_t>(score))) << 16;
+	data |= static_cast<uint64_t>(std::max(0, std::min(depth, 255))) << 32;
+	data |= static_cast<uint64_t>(bound) << 40;
+
+	ChessTranspositionEntry& entry = m_transpositionTable[hash & m_transpositionMask];
+	entry.m_data.store(data, std::memory_order_relaxed);
+	entry.m_keyXorData.store(hash ^ data, std::memory_order_relaxed);
+}
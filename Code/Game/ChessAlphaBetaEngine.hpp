@@ -0,0 +1,70 @@
+#pragma once
+#include "Game/ChessEngine.hpp"
+#include <atomic>
+#include <chrono>
+#include <vector>
+// -----------------------------------------------------------------------------
+constexpr int CHESS_MAX_SEARCH_PLY = 128;
+// -----------------------------------------------------------------------------
+// Lock-free transposition entry: the key is stored XOR'd with the data so torn writes from
+// other search threads are detected on probe instead of returning a corrupted entry.
+// -----------------------------------------------------------------------------
+struct ChessTranspositionEntry
+{
+	std::atomic<uint64_t> m_keyXorData = 0;
+	std::atomic<uint64_t> m_data = 0;
+};
+// -----------------------------------------------------------------------------
+struct ChessSearchThread
+{
+public:
+	int		  m_threadIndex = 0;
+	uint64_t  m_nodes = 0;
+	ChessMove m_killerMoves[CHESS_MAX_SEARCH_PLY][2];
+	int		  m_history[CHESS_BOARD_SIZE][CHESS_BOARD_SIZE] = {};
+	uint64_t  m_pathHashes[CHESS_MAX_SEARCH_PLY] = {};
+	ChessMove m_bestRootMove;
+	ChessMove m_iterationBestMove;
+	int		  m_bestRootScore = 0;
+	int		  m_completedDepth = 0;
+	float	  m_bestMoveSeconds = 0.f;
+	uint64_t  m_bestMoveNodes = 0;
+};
+// -----------------------------------------------------------------------------
+// Iterative deepening PVS with a shared transposition table. Extra threads run Lazy SMP
+// helpers on the same table, so m_numThreads scales the search the classic way.
+// -----------------------------------------------------------------------------
+class ChessAlphaBetaEngine : public ChessEngine
+{
+public:
+	ChessAlphaBetaEngine(int transpositionTableSizeMB = 32);
+	~ChessAlphaBetaEngine();
+
+	ChessSearchResult Search(ChessPosition const& position, ChessSearchLimits const& limits) override;
+	ChessEngineType	  GetType() const override { return ChessEngineType::ALPHA_BETA; }
+
+	void ResizeTranspositionTable(int sizeMB);
+	void ClearTranspositionTable();
+
+private:
+	void RunIterativeDeepening(ChessSearchThread& thread, ChessPosition const& rootPosition, int maxDepth);
+	int  SearchRoot(ChessSearchThread& thread, ChessPosition const& rootPosition, int depth, int alpha, int beta);
+	int  SearchNode(ChessSearchThread& thread, ChessPosition const& position, int depth, int alpha, int beta, int ply, bool allowNullMove);
+	int  SearchQuiescence(ChessSearchThread& thread, ChessPosition const& position, int alpha, int beta, int ply);
+
+	void OrderMoves(ChessSearchThread const& thread, ChessPosition const& position, ChessMoveList& moves, ChessMove const& hashMove, int ply) const;
+	bool IsRepetition(ChessSearchThread const& thread, ChessPosition const& position, int ply) const;
+	bool ShouldStop(ChessSearchThread& thread);
+
+	bool ProbeTranspositionTable(uint64_t hash, ChessMove& out_move, int& out_score, int& out_depth, int& out_bound, int ply) const;
+	void StoreTranspositionTable(uint64_t hash, ChessMove const& move, int score, int depth, int bound, int ply);
+
+private:
+	std::vector<ChessTranspositionEntry> m_transpositionTable;
+	uint64_t m_transpositionMask = 0;
+
+	std::chrono::steady_clock::time_point m_searchStartTime;
+	float	 m_maxSeconds = 1.f;
+	uint64_t m_maxNodes = 0;
+	std::atomic<uint64_t> m_sharedNodes = 0;
+};
@@ -1,4 +1,5 @@
 #include "Game/ChessBoard.hpp"
+#include "Game/ChessPosition.hpp"
 #include "Engine/Core/EngineCommon.h"
 #include "Engine/Core/DevConsole.hpp"
 #include "Engine/Renderer/Renderer.h"
@@ -116,6 +117,106 @@ void ChessBoard::PopulateChessPiecesOnBoard()
 	m_chessPieces[CHESS_BOARD_COLUMNS * 3 + 7]->SetBoardPosition(IntVec2(7, 7));
 }
 
+void ChessBoard::SetupFromPosition(ChessPosition const& position)
+{
+	// Creating a piece builds its geometry and GPU buffers, so pieces are reused rather than rebuilt: those
+	// already standing where the position has the same piece stay, and the rest move to wherever their kind
+	// is needed. Seeking a few plies then touches a few pieces; new ones are only made for pieces a seek
+	// brings back from capture with no spare of their kind, as after a promotion
+	ChessPiece* keptPieces[CHESS_BOARD_SIZE] = {};
+	std::vector<ChessPiece*> sparePieces;
+	for (ChessPiece* chessPiece : m_chessPieces)
+	{
+		IntVec2 coords = chessPiece->GetBoardPosition();
+		int square = GetChessSquare(coords.x, coords.y);
+		uint8_t pieceCode = position.GetPieceAt(square);
+		bool isInPlace = m_board[coords.x][coords.y] == chessPiece && keptPieces[square] == nullptr && pieceCode != CHESS_EMPTY_SQUARE &&
+			GetChessPieceTypeForCode(pieceCode) == chessPiece->GetDefinition()->m_chessPieceType && GetPlayerIndexForCode(pieceCode) == chessPiece->GetPlayerIndex();
+		if (isInPlace)
+		{
+			keptPieces[square] = chessPiece;
+		}
+		else
+		{
+			sparePieces.push_back(chessPiece);
+		}
+	}
+	m_chessPieces.clear();
+	for (int column = 0; column < CHESS_BOARD_COLUMNS; ++column)
+	{
+		for (int row = 0; row < CHESS_BOARD_ROWS; ++row)
+		{
+			m_board[column][row] = nullptr;
+		}
+	}
+
+	// Pieces only know whether they have moved, so pawns off their start rank and kings and rooks
+	// that lost their castling rights are marked as moved to keep double steps and castling honest
+	uint8_t const castleFlags[2][2] = { { CASTLE_WHITE_KINGSIDE, CASTLE_WHITE_QUEENSIDE }, { CASTLE_BLACK_KINGSIDE, CASTLE_BLACK_QUEENSIDE } };
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = position.GetPieceAt(square);
+		if (pieceCode == CHESS_EMPTY_SQUARE)
+		{
+			continue;
+		}
+
+		ChessPieceType pieceType = GetChessPieceTypeForCode(pieceCode);
+		int playerIndex = GetPlayerIndexForCode(pieceCode);
+		IntVec2 coords(GetChessSquareX(square), GetChessSquareY(square));
+		int homeRank = (playerIndex == 0) ? 0 : 7;
+
+		bool hasMoved = false;
+		if (pieceType == ChessPieceType::PAWN)
+		{
+			hasMoved = coords.y != ((playerIndex == 0) ? 1 : 6);
+		}
+		else if (pieceType == ChessPieceType::KING)
+		{
+			hasMoved = coords != IntVec2(4, homeRank) || (position.m_castlingRights & (castleFlags[playerIndex][0] | castleFlags[playerIndex][1])) == 0;
+		}
+		else if (pieceType == ChessPieceType::ROOK)
+		{
+			bool isKingsideRook = coords == IntVec2(7, homeRank) && (position.m_castlingRights & castleFlags[playerIndex][0]) != 0;
+			bool isQueensideRook = coords == IntVec2(0, homeRank) && (position.m_castlingRights & castleFlags[playerIndex][1]) != 0;
+			hasMoved = !isKingsideRook && !isQueensideRook;
+		}
+
+		ChessPiece* chessPiece = keptPieces[square];
+		for (int spareIndex = 0; chessPiece == nullptr && spareIndex < static_cast<int>(sparePieces.size()); ++spareIndex)
+		{
+			ChessPiece* sparePiece = sparePieces[spareIndex];
+			if (sparePiece->GetDefinition()->m_chessPieceType == pieceType && sparePiece->GetPlayerIndex() == playerIndex)
+			{
+				chessPiece = sparePiece;
+				sparePieces[spareIndex] = sparePieces.back();
+				sparePieces.pop_back();
+			}
+		}
+		if (chessPiece == nullptr)
+		{
+			chessPiece = new ChessPiece(ChessPieceDefinition::GetChessPieceDef(pieceType), playerIndex, this);
+		}
+
+		// A jump, not a move, so the piece is put straight down
+		chessPiece->SetBoardPosition(coords);
+		chessPiece->m_position = chessPiece->m_targetPosition;
+		chessPiece->m_isMoving = false;
+		chessPiece->m_prevBoardPosition = hasMoved ? -IntVec2::ONE : IntVec2::ZERO;
+		m_chessPieces.push_back(chessPiece);
+	}
+	for (ChessPiece* sparePiece : sparePieces)
+	{
+		delete sparePiece;
+	}
+
+	m_enpassantTargetSquare = -IntVec2::ONE;
+	if (position.m_enpassantSquare != CHESS_NO_SQUARE)
+	{
+		m_enpassantTargetSquare = IntVec2(GetChessSquareX(position.m_enpassantSquare), GetChessSquareY(position.m_enpassantSquare));
+	}
+}
+
 void ChessBoard::Update(float deltaSeconds)
 {
 	for (int chessPieceIndex = 0; chessPieceIndex < static_cast<int>(m_chessPieces.size()); ++chessPieceIndex)
@@ -12,6 +12,7 @@ class VertexBuffer;
 class IndexBuffer;
 class Texture;
 class ChessMatch;
+class ChessPosition;
 // -----------------------------------------------------------------------------
 class ChessBoard : public ChessObject
 {
@@ -21,6 +22,7 @@ public:
 
 	void IntializeChessPieces();
 	void PopulateChessPiecesOnBoard();
+	void SetupFromPosition(ChessPosition const& position);
 
 	void Update(float deltaSeconds) override;
 	void Render() const override;
@@ -0,0 +1,520 @@
+#include "Game/ChessCommandLine.hpp"
+#include "Game/ChessEPDSuite.hpp"
+#include "Game/ChessEndgameGenerator.hpp"
+#include "Game/ChessEvalTuner.hpp"
+#include "Game/ChessGameArchive.hpp"
+#include "Game/ChessMatchServer.hpp"
+#include "Game/ChessPGN.hpp"
+#include "Game/ChessPositionIndex.hpp"
+#include "Game/ChessSavedGameReader.hpp"
+#include "Game/ChessSelfPlay.hpp"
+#include "Game/ChessTablebase.hpp"
+#include "Game/ChessUCIProtocol.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+typedef int (*ChessToolFunction)(ChessCommandLineArgs const& args);
+// -----------------------------------------------------------------------------
+
+ChessCommandLineArgs::ChessCommandLineArgs(char const* commandLine)
+{
+	// Tokens are separated by spaces; a value may be quoted to keep its spaces
+	std::string const text = (commandLine != nullptr) ? commandLine : "";
+	size_t cursor = 0;
+	while (cursor < text.size())
+	{
+		while (cursor < text.size() && text[cursor] == ' ')
+		{
+			++cursor;
+		}
+		if (cursor >= text.size())
+		{
+			break;
+		}
+
+		std::string token;
+		bool isQuoted = false;
+		for (; cursor < text.size() && (isQuoted || text[cursor] != ' '); ++cursor)
+		{
+			if (text[cursor] == '"')
+			{
+				isQuoted = !isQuoted;
+				continue;
+			}
+			token += text[cursor];
+		}
+
+		size_t equalsIndex = token.find('=');
+		if (token[0] == '-' && m_toolName.empty())
+		{
+			m_toolName = token.substr(1);
+		}
+		else if (equalsIndex != std::string::npos)
+		{
+			m_values[token.substr(0, equalsIndex)] = token.substr(equalsIndex + 1);
+		}
+	}
+}
+
+std::string ChessCommandLineArgs::GetValue(std::string const& key, std::string const& defaultValue) const
+{
+	auto found = m_values.find(key);
+	return (found != m_values.end()) ? found->second : defaultValue;
+}
+
+std::string ChessCommandLineArgs::GetValue(std::string const& key, char const* defaultValue) const
+{
+	return GetValue(key, std::string(defaultValue));
+}
+
+int ChessCommandLineArgs::GetValue(std::string const& key, int defaultValue) const
+{
+	auto found = m_values.find(key);
+	return (found != m_values.end()) ? atoi(found->second.c_str()) : defaultValue;
+}
+
+float ChessCommandLineArgs::GetValue(std::string const& key, float defaultValue) const
+{
+	auto found = m_values.find(key);
+	return (found != m_values.end()) ? static_cast<float>(atof(found->second.c_str())) : defaultValue;
+}
+
+std::vector<std::string> ChessCommandLineArgs::GetList(std::string const& key) const
+{
+	std::vector<std::string> list;
+	std::string value = GetValue(key, "");
+	size_t start = 0;
+	while (start < value.size())
+	{
+		size_t end = value.find(',', start);
+		if (end == std::string::npos)
+		{
+			end = value.size();
+		}
+		if (end > start)
+		{
+			list.push_back(value.substr(start, end - start));
+		}
+		start = end + 1;
+	}
+	return list;
+}
+
+// -----------------------------------------------------------------------------
+static int RunTuneTool(ChessCommandLineArgs const& args)
+{
+	ChessTunerSettings settings;
+	settings.m_corpusFiles = args.GetList("corpus");
+	settings.m_outputFile = args.GetValue("output", settings.m_outputFile);
+	settings.m_numThreads = args.GetValue("threads", settings.m_numThreads);
+	settings.m_numEpochs = args.GetValue("epochs", settings.m_numEpochs);
+	settings.m_batchSize = args.GetValue("batch", settings.m_batchSize);
+	settings.m_learningRate = args.GetValue("rate", settings.m_learningRate);
+	settings.m_scalingConstant = args.GetValue("k", settings.m_scalingConstant);
+	settings.m_skipOpeningPlies = args.GetValue("skipPlies", settings.m_skipOpeningPlies);
+
+	if (settings.m_corpusFiles.empty())
+	{
+		printf("Usage: -tune corpus=a.epd,b.pgn,c.xml [output=Data/ChessEvalWeights.xml] [weights=start.xml] [epochs=20] [threads=0] [batch=16384] [rate=1] [k=0] [skipPlies=8]\n");
+		return 1;
+	}
+
+	// Tuning continues from the weights the game currently ships with, when there are any
+	ChessEvalWeights initialWeights = ChessEvalWeights::GetDefaultWeights();
+	std::string initialWeightsFile = args.GetValue("weights", settings.m_outputFile);
+	if (initialWeights.LoadFromXmlFile(initialWeightsFile))
+	{
+		printf("Starting from weights in %s\n", initialWeightsFile.c_str());
+	}
+
+	ChessEvalTuner tuner(settings, initialWeights);
+	return tuner.Run() ? 0 : 1;
+}
+
+static int RunEndgameTableTool(ChessCommandLineArgs const& args)
+{
+	ChessEndgameGeneratorSettings settings;
+	settings.m_tableNames = args.GetList("tables");
+	settings.m_outputDirectory = args.GetValue("output", settings.m_outputDirectory);
+	settings.m_numThreads = args.GetValue("threads", settings.m_numThreads);
+
+	if (settings.m_tableNames.empty())
+	{
+		printf("Usage: -egtb tables=KQvK,KRvK,KPvK,KBNvK [output=Data/Tablebases] [threads=0]\n");
+		return 1;
+	}
+
+	ChessEndgameGenerator generator(settings);
+	return generator.Run() ? 0 : 1;
+}
+
+static int RunSelfPlayTool(ChessCommandLineArgs const& args)
+{
+	ChessSelfPlaySettings settings;
+	settings.m_numGames = args.GetValue("games", settings.m_numGames);
+	settings.m_numConcurrentGames = args.GetValue("concurrency", settings.m_numConcurrentGames);
+	settings.m_moveSeconds = args.GetValue("movetime", settings.m_moveSeconds);
+	settings.m_openingsFile = args.GetValue("openings", settings.m_openingsFile);
+	settings.m_randomOpeningPlies = args.GetValue("randomPlies", settings.m_randomOpeningPlies);
+	settings.m_maxPlies = args.GetValue("maxPlies", settings.m_maxPlies);
+	settings.m_useTablebaseAdjudication = args.GetValue("adjudicate", "true") == "true";
+	settings.m_seed = static_cast<uint64_t>(args.GetValue("seed", static_cast<int>(settings.m_seed)));
+	settings.m_gamesFile = args.GetValue("output", settings.m_gamesFile);
+	settings.m_resultsFile = args.GetValue("results", settings.m_resultsFile);
+
+	// tc=base+increment in seconds, e.g. tc=10+0.1
+	std::string timeControl = args.GetValue("tc", "");
+	if (!timeControl.empty())
+	{
+		size_t plusIndex = timeControl.find('+');
+		settings.m_baseSeconds = static_cast<float>(atof(timeControl.c_str()));
+		settings.m_incrementSeconds = (plusIndex != std::string::npos) ? static_cast<float>(atof(timeControl.c_str() + plusIndex + 1)) : 0.f;
+	}
+
+	// Per-side keys end in 1 or 2: engine1=alphabeta depth2=8 threads1=2 hash2=64 policy2=rollout
+	for (int playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		ChessSelfPlayPlayerSettings& player = settings.m_players[playerIndex];
+		std::string suffix = std::to_string(playerIndex + 1);
+		player.m_engineType = GetChessEngineTypeForName(args.GetValue("engine" + suffix, "alphabeta"));
+		player.m_name = args.GetValue("name" + suffix, std::string(GetChessEngineTypeName(player.m_engineType)) + suffix);
+		player.m_mctsPolicy = GetChessMCTSPolicyTypeForName(args.GetValue("policy" + suffix, GetChessMCTSPolicyTypeName(player.m_mctsPolicy)));
+		player.m_maxDepth = args.GetValue("depth" + suffix, player.m_maxDepth);
+		player.m_maxNodes = static_cast<uint64_t>(args.GetValue("nodes" + suffix, static_cast<int>(player.m_maxNodes)));
+		player.m_numThreads = args.GetValue("threads" + suffix, player.m_numThreads);
+		player.m_hashSizeMB = args.GetValue("hash" + suffix, player.m_hashSizeMB);
+		player.m_useTablebases = args.GetValue("tablebases" + suffix, "true") == "true";
+		if (player.m_engineType == ChessEngineType::NONE)
+		{
+			printf("Usage: -selfplay [games=100] [concurrency=0] [tc=10+0.1 | movetime=0.1] [openings=suite.epd] [randomPlies=6] [maxPlies=400]\n"
+				"       [engine1=alphabeta|mcts] [name1=] [depth1=] [nodes1=] [threads1=1] [hash1=16] [policy1=evaluation] [tablebases1=true]\n"
+				"       [engine2=...] ... [adjudicate=true] [seed=1] [output=Data/SelfPlay/games.txt] [results=Data/SelfPlay/results.txt]\n");
+			return 1;
+		}
+	}
+
+	// The same data the game loads at startup
+	g_chessEvalWeights.LoadFromXmlFile(args.GetValue("weights", "Data/ChessEvalWeights.xml"));
+	std::string syzygyPath = args.GetValue("syzygy", "");
+	if (!syzygyPath.empty())
+	{
+		g_chessTablebases.Initialize(syzygyPath);
+	}
+	g_chessTablebases.AddEndgameTables(args.GetValue("egtb", "Data/Tablebases"));
+
+	ChessSelfPlayTournament tournament(settings);
+	return tournament.Run() ? 0 : 1;
+}
+
+static int RunEPDSuiteTool(ChessCommandLineArgs const& args)
+{
+	ChessEPDSuiteSettings settings;
+	settings.m_suiteFiles = args.GetList("input");
+	settings.m_engineType = GetChessEngineTypeForName(args.GetValue("engine", "alphabeta"));
+	settings.m_mctsPolicy = GetChessMCTSPolicyTypeForName(args.GetValue("policy", GetChessMCTSPolicyTypeName(settings.m_mctsPolicy)));
+	settings.m_maxNodes = static_cast<uint64_t>(args.GetValue("nodes", static_cast<int>(settings.m_maxNodes)));
+	settings.m_maxDepth = args.GetValue("depth", settings.m_maxDepth);
+	settings.m_numConcurrentSearches = args.GetValue("concurrency", settings.m_numConcurrentSearches);
+	settings.m_numThreadsPerSearch = args.GetValue("threads", settings.m_numThreadsPerSearch);
+	settings.m_hashSizeMB = args.GetValue("hash", settings.m_hashSizeMB);
+	settings.m_useTablebases = args.GetValue("tablebases", "true") == "true";
+	settings.m_maxFailuresShown = args.GetValue("errors", settings.m_maxFailuresShown);
+	settings.m_resultsFile = args.GetValue("output", settings.m_resultsFile);
+
+	// nodes= alone makes the run a pure node budget, which repeats exactly from run to run on one search thread
+	settings.m_moveSeconds = args.GetValue("movetime", (settings.m_maxNodes > 0) ? 0.f : settings.m_moveSeconds);
+
+	if (settings.m_suiteFiles.empty() || settings.m_engineType == ChessEngineType::NONE)
+	{
+		printf("Usage: -epd input=wac.epd,sts.epd [movetime=1] [nodes=0] [depth=64] [concurrency=0] [threads=1] [hash=16]\n"
+			"       [engine=alphabeta|mcts] [policy=evaluation] [tablebases=true] [errors=20] [output=results.txt]\n");
+		return 1;
+	}
+
+	// The same data the game loads at startup
+	g_chessEvalWeights.LoadFromXmlFile(args.GetValue("weights", "Data/ChessEvalWeights.xml"));
+	std::string syzygyPath = args.GetValue("syzygy", "");
+	if (!syzygyPath.empty())
+	{
+		g_chessTablebases.Initialize(syzygyPath);
+	}
+	g_chessTablebases.AddEndgameTables(args.GetValue("egtb", "Data/Tablebases"));
+
+	ChessEPDSuiteRunner runner(settings);
+	return runner.Run() ? 0 : 1;
+}
+
+static int RunUCITool(ChessCommandLineArgs const&)
+{
+	ChessUCIProtocol protocol;
+	return protocol.Run();
+}
+
+static int RunMatchServerTool(ChessCommandLineArgs const& args)
+{
+	ChessMatchServerSettings settings;
+	settings.m_port = args.GetValue("port", settings.m_port);
+	settings.m_maxConnections = args.GetValue("connections", settings.m_maxConnections);
+	settings.m_statusSeconds = args.GetValue("status", settings.m_statusSeconds);
+	settings.m_runSeconds = args.GetValue("seconds", settings.m_runSeconds);
+	settings.m_seatHoldSeconds = args.GetValue("hold", settings.m_seatHoldSeconds);
+
+	ChessMatchServer server(settings);
+	return server.Run() ? 0 : 1;
+}
+
+static int RunServerLoadTool(ChessCommandLineArgs const& args)
+{
+	ChessServerLoadSettings settings;
+	settings.m_address = args.GetValue("ip", settings.m_address);
+	settings.m_port = args.GetValue("port", settings.m_port);
+	settings.m_numClients = args.GetValue("clients", settings.m_numClients);
+	settings.m_numPliesPerGame = args.GetValue("plies", settings.m_numPliesPerGame);
+	settings.m_numSpectators = args.GetValue("spectators", settings.m_numSpectators);
+	settings.m_maxConnectsInFlight = std::max(1, args.GetValue("inflight", settings.m_maxConnectsInFlight));
+	settings.m_timeoutSeconds = args.GetValue("timeout", settings.m_timeoutSeconds);
+
+	ChessServerLoadTest loadTest(settings);
+	return loadTest.Run() ? 0 : 2;
+}
+
+static int RunPGNTool(ChessCommandLineArgs const& args)
+{
+	std::vector<std::string> inputFiles = args.GetList("input");
+	std::string outputFile = args.GetValue("output", "");
+	int numThreads = args.GetValue("threads", 0);
+	int maxErrorsShown = args.GetValue("errors", 10);
+
+	if (inputFiles.empty())
+	{
+		printf("Usage: -pgn input=a.pgn,b.pgn [output=clean.pgn] [threads=0] [errors=10]\n");
+		return 1;
+	}
+
+	// Valid games are re-exported in normalized SAN; with several threads they land in the order they finish
+	ChessPGNWriter writer;
+	if (!outputFile.empty() && !writer.Open(outputFile, false))
+	{
+		printf("ERROR: could not write \"%s\"\n", outputFile.c_str());
+		return 1;
+	}
+
+	bool isEveryFileRead = true;
+	for (std::string const& inputFile : inputFiles)
+	{
+		ChessPGNReader reader;
+		if (!reader.Open(inputFile))
+		{
+			printf("ERROR: could not open \"%s\"\n", inputFile.c_str());
+			isEveryFileRead = false;
+			continue;
+		}
+
+		std::mutex outputMutex;
+		int numErrorsShown = 0;
+		ChessPGNReadStats stats = reader.ReadAllGames(numThreads, [&](ChessPGNGame const& game, int)
+		{
+			if (game.IsValid() && !writer.IsOpen())
+			{
+				return;
+			}
+
+			std::lock_guard<std::mutex> outputLock(outputMutex);
+			if (!game.IsValid())
+			{
+				if (numErrorsShown++ < maxErrorsShown)
+				{
+					printf("%s @%llu: %s\n", inputFile.c_str(), static_cast<unsigned long long>(game.m_fileOffset), game.m_error.c_str());
+				}
+			}
+			else
+			{
+				writer.WriteGame(game);
+			}
+		});
+
+		double seconds = (stats.m_seconds > 0.0) ? stats.m_seconds : 1e-9;
+		printf("%s: %llu games (%llu rejected), %llu moves in %.2fs, %.1f MB/s, %.0f games/s\n", inputFile.c_str(),
+			static_cast<unsigned long long>(stats.m_numGames), static_cast<unsigned long long>(stats.m_numInvalidGames), static_cast<unsigned long long>(stats.m_numMoves),
+			stats.m_seconds, static_cast<double>(stats.m_numBytes) / (1024.0 * 1024.0) / seconds, static_cast<double>(stats.m_numGames) / seconds);
+	}
+	return isEveryFileRead ? 0 : 1;
+}
+
+static int RunPositionIndexTool(ChessCommandLineArgs const& args)
+{
+	std::vector<std::string> inputPaths = args.GetList("input");
+	std::string outputFile = args.GetValue("output", "Data/SavedGames/Positions.cpi");
+	int numThreads = args.GetValue("threads", 0);
+	if (inputPaths.empty())
+	{
+		inputPaths.push_back("Data/SavedGames");
+	}
+
+	ChessPositionIndexBuildStats stats;
+	if (!ChessPositionIndex::Build(inputPaths, outputFile, numThreads, stats))
+	{
+		printf("ERROR: could not write \"%s\"\n", outputFile.c_str());
+		return 1;
+	}
+
+	ChessSavedGameReadStats const& readStats = stats.m_readStats;
+	printf("%s: %llu positions from %llu games in %llu files (%llu indexed only up to an error) in %.2fs, %.1f MB\n", outputFile.c_str(),
+		static_cast<unsigned long long>(stats.m_numPositions), static_cast<unsigned long long>(readStats.m_numGames), static_cast<unsigned long long>(readStats.m_numFiles),
+		static_cast<unsigned long long>(readStats.m_numInvalidGames), stats.m_seconds, static_cast<double>(stats.m_numBytes) / (1024.0 * 1024.0));
+	return 0;
+}
+
+static int RunArchiveTool(ChessCommandLineArgs const& args)
+{
+	std::vector<std::string> inputPaths = args.GetList("input");
+	std::string outputFile = args.GetValue("output", "Data/SavedGames/Archive.cga");
+	int numThreads = args.GetValue("threads", 0);
+	if (inputPaths.empty())
+	{
+		inputPaths.push_back("Data/SavedGames");
+	}
+
+	ChessGameArchiveBuildStats stats;
+	if (!ChessGameArchive::Build(inputPaths, outputFile, numThreads, stats))
+	{
+		printf("ERROR: could not write \"%s\"\n", outputFile.c_str());
+		return 1;
+	}
+
+	ChessSavedGameReadStats const& readStats = stats.m_readStats;
+	double numPlies = static_cast<double>(std::max<uint64_t>(stats.m_numPlies, 1));
+	printf("%s: %llu games, %llu moves from %llu files (%llu archived only up to an error) in %.2fs\n", outputFile.c_str(),
+		static_cast<unsigned long long>(stats.m_numGames), static_cast<unsigned long long>(stats.m_numPlies), static_cast<unsigned long long>(readStats.m_numFiles),
+		static_cast<unsigned long long>(readStats.m_numInvalidGames), stats.m_seconds);
+	printf("  %llu bytes, %.2f bits a move; the input was %llu bytes, %.1fx larger\n", static_cast<unsigned long long>(stats.m_numBytes),
+		static_cast<double>(stats.m_numBytes) * 8.0 / numPlies, static_cast<unsigned long long>(stats.m_numInputBytes),
+		static_cast<double>(stats.m_numInputBytes) / static_cast<double>(std::max<uint64_t>(stats.m_numBytes, 1)));
+	return 0;
+}
+
+static int RunValidateTool(ChessCommandLineArgs const& args)
+{
+	std::vector<std::string> inputPaths = args.GetList("input");
+	std::string reportFile = args.GetValue("output", "");
+	int numThreads = args.GetValue("threads", 0);
+	int maxErrorsShown = args.GetValue("errors", 20);
+	if (inputPaths.empty())
+	{
+		inputPaths.push_back("Data/SavedGames");
+	}
+	numThreads = (numThreads > 0) ? numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	// output= gets one line per game: file, offset, result, moves and the problem if there is one
+	std::ofstream report;
+	if (!reportFile.empty())
+	{
+		report.open(reportFile, std::ios::out | std::ios::trunc);
+		if (!report.is_open())
+		{
+			printf("ERROR: could not write \"%s\"\n", reportFile.c_str());
+			return 1;
+		}
+	}
+
+	static char const* const RESULT_NAMES[] = { "1-0", "0-1", "1/2-1/2", "*" };
+	std::vector<std::vector<uint64_t>> workerResultCounts(numThreads, std::vector<uint64_t>(4, 0));
+	std::vector<std::string> filePaths = ChessSavedGameReader::FindGameFiles(inputPaths);
+	std::mutex outputMutex;
+	int numErrorsShown = 0;
+	ChessSavedGameReadStats stats = ChessSavedGameReader::ReadAllGames(filePaths, numThreads, [&](ChessSavedGame const& game, int workerIndex)
+	{
+		int resultIndex = 3;
+		for (int nameIndex = 0; nameIndex < 3; ++nameIndex)
+		{
+			resultIndex = (game.m_result == RESULT_NAMES[nameIndex]) ? nameIndex : resultIndex;
+		}
+		workerResultCounts[workerIndex][resultIndex] += 1;
+		if (game.IsValid() && !game.m_wasTruncated && !report.is_open())
+		{
+			return;
+		}
+
+		std::string problem = game.m_error;
+		if (game.m_wasTruncated)
+		{
+			problem += problem.empty() ? "Truncated file" : " (truncated file)";
+		}
+
+		std::lock_guard<std::mutex> outputLock(outputMutex);
+		if (!problem.empty() && numErrorsShown++ < maxErrorsShown)
+		{
+			printf("%s @%llu: %s\n", game.m_filePath.c_str(), static_cast<unsigned long long>(game.m_fileOffset), problem.c_str());
+		}
+		if (report.is_open())
+		{
+			report << game.m_filePath << '\t' << game.m_fileOffset << '\t' << game.m_result << '\t' << game.m_moves.size() << '/' << game.m_numRecordedMoves << '\t'
+				<< (problem.empty() ? "ok" : problem) << '\n';
+		}
+	});
+
+	std::vector<uint64_t> resultCounts(4, 0);
+	for (std::vector<uint64_t> const& workerCounts : workerResultCounts)
+	{
+		for (int resultIndex = 0; resultIndex < 4; ++resultIndex)
+		{
+			resultCounts[resultIndex] += workerCounts[resultIndex];
+		}
+	}
+
+	double seconds = (stats.m_seconds > 0.0) ? stats.m_seconds : 1e-9;
+	printf("%llu games in %llu files, %llu moves in %.2fs (%.0f games/s on %d threads)\n", static_cast<unsigned long long>(stats.m_numGames),
+		static_cast<unsigned long long>(stats.m_numFiles), static_cast<unsigned long long>(stats.m_numMoves), stats.m_seconds, static_cast<double>(stats.m_numGames) / seconds, numThreads);
+	printf("  illegal or unreadable: %llu, truncated: %llu\n", static_cast<unsigned long long>(stats.m_numInvalidGames), static_cast<unsigned long long>(stats.m_numTruncatedGames));
+	printf("  results: 1-0 %llu, 0-1 %llu, 1/2-1/2 %llu, unfinished %llu\n", static_cast<unsigned long long>(resultCounts[0]), static_cast<unsigned long long>(resultCounts[1]),
+		static_cast<unsigned long long>(resultCounts[2]), static_cast<unsigned long long>(resultCounts[3]));
+	return (stats.m_numInvalidGames == 0 && stats.m_numTruncatedGames == 0) ? 0 : 2;
+}
+
+// -----------------------------------------------------------------------------
+static ChessToolFunction GetChessToolFunction(std::string const& toolName)
+{
+	static std::map<std::string, ChessToolFunction> const s_tools =
+	{
+		{ "tune", RunTuneTool },
+		{ "egtb", RunEndgameTableTool },
+		{ "selfplay", RunSelfPlayTool },
+		{ "epd", RunEPDSuiteTool },
+		{ "uci", RunUCITool },
+		{ "server", RunMatchServerTool },
+		{ "serverload", RunServerLoadTool },
+		{ "pgn", RunPGNTool },
+		{ "index", RunPositionIndexTool },
+		{ "archive", RunArchiveTool },
+		{ "validate", RunValidateTool },
+	};
+
+	auto found = s_tools.find(toolName);
+	return (found != s_tools.end()) ? found->second : nullptr;
+}
+
+bool IsChessCommandLineTool(char const* commandLine)
+{
+	ChessCommandLineArgs args(commandLine);
+	return GetChessToolFunction(args.GetToolName()) != nullptr;
+}
+
+int RunChessCommandLineTool(char const* commandLine)
+{
+	ChessCommandLineArgs args(commandLine);
+	ChessToolFunction toolFunction = GetChessToolFunction(args.GetToolName());
+	if (toolFunction == nullptr)
+	{
+		printf("Unknown tool \"-%s\"\n", args.GetToolName().c_str());
+		return 1;
+	}
+
+	int exitCode = toolFunction(args);
+	fflush(stdout);
+	return exitCode;
+}
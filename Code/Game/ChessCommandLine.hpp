@@ -0,0 +1,29 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+// Headless tools picked from the command line, e.g.
+//     Chess3D.exe -tune corpus=Data/Corpus/games.pgn epochs=10
+// Tools never create the window, renderer or audio system and report through stdout.
+// -----------------------------------------------------------------------------
+class ChessCommandLineArgs
+{
+public:
+	explicit ChessCommandLineArgs(char const* commandLine);
+
+	std::string const& GetToolName() const { return m_toolName; }
+	bool			   HasValue(std::string const& key) const { return m_values.find(key) != m_values.end(); }
+	std::string		   GetValue(std::string const& key, std::string const& defaultValue) const;
+	std::string		   GetValue(std::string const& key, char const* defaultValue) const;
+	int				   GetValue(std::string const& key, int defaultValue) const;
+	float			   GetValue(std::string const& key, float defaultValue) const;
+	std::vector<std::string> GetList(std::string const& key) const;
+
+private:
+	std::string m_toolName;
+	std::map<std::string, std::string> m_values;
+};
+// -----------------------------------------------------------------------------
+bool IsChessCommandLineTool(char const* commandLine);
+int  RunChessCommandLineTool(char const* commandLine);
@@ -0,0 +1,415 @@
+#include "Game/ChessEPDSuite.hpp"
+#include "Game/ChessAlphaBetaEngine.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+constexpr int EPD_PROGRESS_INTERVAL = 100;		// Positions between progress lines
+constexpr int EPD_NUM_SOLUTION_BANDS = 3;
+constexpr float EPD_SOLUTION_BANDS[EPD_NUM_SOLUTION_BANDS] = { 0.1f, 0.25f, 0.5f };		// Fractions of the budget
+// -----------------------------------------------------------------------------
+
+static ChessEngine* CreateEPDSuiteEngine(ChessEPDSuiteSettings const& settings)
+{
+	if (settings.m_engineType == ChessEngineType::ALPHA_BETA)
+	{
+		return new ChessAlphaBetaEngine(settings.m_hashSizeMB);
+	}
+	return ChessEngine::CreateEngine(settings.m_engineType);
+}
+
+static bool FindEPDMove(ChessPosition const& position, std::string const& moveText, ChessMove& out_move)
+{
+	if (position.FindMoveForSAN(moveText, out_move))
+	{
+		return true;
+	}
+
+	// Some suites are written in long algebraic
+	ChessMoveList moves;
+	position.GenerateLegalMoves(moves);
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		if (moves[moveIndex].GetNotation() == moveText)
+		{
+			out_move = moves[moveIndex];
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool AddEPDOperation(std::vector<std::string> const& tokens, ChessEPDTest& out_test, std::string& out_error)
+{
+	std::string const& opcode = tokens[0];
+	if (opcode == "id")
+	{
+		out_test.m_id = (tokens.size() > 1) ? tokens[1] : "";
+		return true;
+	}
+
+	// c0, ce, dm, pv and the rest are not scored
+	if (opcode != "bm" && opcode != "am")
+	{
+		return true;
+	}
+	std::vector<ChessMove>& moves = (opcode == "bm") ? out_test.m_bestMoves : out_test.m_avoidMoves;
+	for (size_t tokenIndex = 1; tokenIndex < tokens.size(); ++tokenIndex)
+	{
+		ChessMove move;
+		if (!FindEPDMove(out_test.m_position, tokens[tokenIndex], move))
+		{
+			out_error = "Illegal or unreadable " + opcode + " move \"" + tokens[tokenIndex] + "\"";
+			return false;
+		}
+		moves.push_back(move);
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+bool ChessEPDTest::IsSolvedBy(ChessMove const& move) const
+{
+	bool isBestMove = m_bestMoves.empty() || std::find(m_bestMoves.begin(), m_bestMoves.end(), move) != m_bestMoves.end();
+	bool isAvoidMove = std::find(m_avoidMoves.begin(), m_avoidMoves.end(), move) != m_avoidMoves.end();
+	return isBestMove && !isAvoidMove;
+}
+
+bool ChessEPDTest::ParseEPDLine(std::string const& line, ChessEPDTest& out_test, std::string& out_error)
+{
+	char const* operations = nullptr;
+	if (!out_test.m_position.SetFromFEN(line.c_str(), &operations))
+	{
+		out_error = "Unreadable FEN";
+		return false;
+	}
+	out_test.m_id.clear();
+	out_test.m_bestMoves.clear();
+	out_test.m_avoidMoves.clear();
+
+	// Operations are "opcode operand operand...;" and a quoted operand may hold spaces and semicolons
+	std::vector<std::string> tokens;
+	std::string token;
+	bool isQuoted = false;
+	for (char const* cursor = operations; ; ++cursor)
+	{
+		char glyph = *cursor;
+		bool isLineEnd = (glyph == '\0');
+		if (!isLineEnd && glyph == '"')
+		{
+			isQuoted = !isQuoted;
+			continue;
+		}
+		if (!isLineEnd && (isQuoted || (glyph != ' ' && glyph != '\t' && glyph != '\r' && glyph != ';')))
+		{
+			token += glyph;
+			continue;
+		}
+
+		if (!token.empty())
+		{
+			tokens.push_back(token);
+			token.clear();
+		}
+		if ((isLineEnd || glyph == ';') && !tokens.empty())
+		{
+			if (!AddEPDOperation(tokens, out_test, out_error))
+			{
+				return false;
+			}
+			tokens.clear();
+		}
+		if (isLineEnd)
+		{
+			break;
+		}
+	}
+
+	if (out_test.m_bestMoves.empty() && out_test.m_avoidMoves.empty())
+	{
+		out_error = "No bm or am operation";
+		return false;
+	}
+	if (!out_test.m_position.HasLegalMove())
+	{
+		out_error = "The side to move has no legal move";
+		return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+ChessEPDSuiteRunner::ChessEPDSuiteRunner(ChessEPDSuiteSettings const& settings)
+	: m_settings(settings)
+{
+	if (m_settings.m_numConcurrentSearches <= 0)
+	{
+		m_settings.m_numConcurrentSearches = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+}
+
+bool ChessEPDSuiteRunner::Run()
+{
+	if (!LoadSuites())
+	{
+		return false;
+	}
+	m_results.assign(m_tests.size(), ChessEPDTestResult());
+	m_settings.m_numConcurrentSearches = std::min(m_settings.m_numConcurrentSearches, static_cast<int>(m_tests.size()));
+
+	printf("%d positions from %d suites, %s, %d at a time, ", static_cast<int>(m_tests.size()), static_cast<int>(m_suiteNames.size()),
+		GetChessEngineTypeName(m_settings.m_engineType), m_settings.m_numConcurrentSearches);
+	if (m_settings.m_maxNodes > 0)
+	{
+		printf("%llu nodes", static_cast<unsigned long long>(m_settings.m_maxNodes));
+		printf((m_settings.m_moveSeconds > 0.f) ? " or " : "");
+	}
+	if (m_settings.m_moveSeconds > 0.f)
+	{
+		printf("%.3fs", m_settings.m_moveSeconds);
+	}
+	printf(" per position\n");
+
+	m_startTime = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int workerIndex = 0; workerIndex < m_settings.m_numConcurrentSearches; ++workerIndex)
+	{
+		workers.emplace_back(&ChessEPDSuiteRunner::RunWorker, this);
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+
+	PrintSummary(wallSeconds);
+	return m_settings.m_resultsFile.empty() || WriteResultsFile();
+}
+
+bool ChessEPDSuiteRunner::LoadSuites()
+{
+	int numRejectedLines = 0;
+	for (std::string const& suiteFile : m_settings.m_suiteFiles)
+	{
+		std::ifstream suite(suiteFile);
+		if (!suite.is_open())
+		{
+			printf("ERROR: could not open test suite \"%s\"\n", suiteFile.c_str());
+			return false;
+		}
+
+		int suiteIndex = static_cast<int>(m_suiteNames.size());
+		m_suiteNames.push_back(std::filesystem::path(suiteFile).stem().string());
+		std::string line;
+		int lineNumber = 0;
+		while (std::getline(suite, line))
+		{
+			++lineNumber;
+			if (line.empty() || line[0] == '#' || line[0] == '\r')
+			{
+				continue;
+			}
+
+			ChessEPDTest test;
+			std::string error;
+			if (!ChessEPDTest::ParseEPDLine(line, test, error))
+			{
+				printf("%s:%d: %s\n", suiteFile.c_str(), lineNumber, error.c_str());
+				++numRejectedLines;
+				continue;
+			}
+			test.m_suiteIndex = suiteIndex;
+			test.m_lineNumber = lineNumber;
+			if (test.m_id.empty())
+			{
+				test.m_id = m_suiteNames[suiteIndex] + ":" + std::to_string(lineNumber);
+			}
+			m_tests.push_back(test);
+		}
+	}
+
+	if (numRejectedLines > 0)
+	{
+		printf("Skipped %d unusable lines\n", numRejectedLines);
+	}
+	if (m_tests.empty())
+	{
+		printf("ERROR: no test positions in the suites\n");
+		return false;
+	}
+	return true;
+}
+
+void ChessEPDSuiteRunner::RunWorker()
+{
+	ChessEngine* engine = CreateEPDSuiteEngine(m_settings);
+	ChessSearchLimits limits;
+	limits.m_maxSeconds = m_settings.m_moveSeconds;
+	limits.m_maxNodes = m_settings.m_maxNodes;
+	limits.m_maxDepth = m_settings.m_maxDepth;
+	limits.m_numThreads = m_settings.m_numThreadsPerSearch;
+	limits.m_mctsPolicy = m_settings.m_mctsPolicy;
+	limits.m_useTablebases = m_settings.m_useTablebases;
+	limits.m_useOpeningBook = false;
+
+	for (int testIndex = m_nextTestIndex++; testIndex < static_cast<int>(m_tests.size()); testIndex = m_nextTestIndex++)
+	{
+		if (engine->GetType() == ChessEngineType::ALPHA_BETA)
+		{
+			static_cast<ChessAlphaBetaEngine*>(engine)->ClearTranspositionTable();
+		}
+
+		ChessEPDTest const& test = m_tests[testIndex];
+		ChessEPDTestResult result;
+		result.m_search = engine->Search(test.m_position, limits);
+		result.m_isSolved = result.m_search.HasMove() && test.m_position.IsLegalMove(result.m_search.m_bestMove) && test.IsSolvedBy(result.m_search.m_bestMove);
+		RecordResult(testIndex, result);
+	}
+
+	delete engine;
+}
+
+void ChessEPDSuiteRunner::RecordResult(int testIndex, ChessEPDTestResult const& result)
+{
+	std::lock_guard<std::mutex> outputLock(m_outputMutex);
+	m_results[testIndex] = result;
+	m_numFinishedTests += 1;
+	m_numSolvedTests += result.m_isSolved ? 1 : 0;
+
+	ChessEPDTest const& test = m_tests[testIndex];
+	if (!result.m_isSolved && m_numFailuresShown++ < m_settings.m_maxFailuresShown)
+	{
+		ChessMove const& playedMove = result.m_search.m_bestMove;
+		std::string playedText = !result.m_search.HasMove() ? "nothing" : (test.m_position.IsLegalMove(playedMove) ? test.m_position.GetSANForMove(playedMove) : playedMove.GetNotation());
+		std::string expectedText;
+		expectedText += test.m_bestMoves.empty() ? "" : " bm " + GetMoveListText(test.m_position, test.m_bestMoves);
+		expectedText += test.m_avoidMoves.empty() ? "" : " am " + GetMoveListText(test.m_position, test.m_avoidMoves);
+		printf("%s: played %s, expected%s\n", test.m_id.c_str(), playedText.c_str(), expectedText.c_str());
+	}
+
+	if ((m_numFinishedTests % EPD_PROGRESS_INTERVAL) == 0 && m_numFinishedTests < static_cast<int>(m_tests.size()))
+	{
+		float elapsedSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_startTime).count();
+		printf("After %d/%d positions: %d solved, %.1fs\n", m_numFinishedTests, static_cast<int>(m_tests.size()), m_numSolvedTests, elapsedSeconds);
+	}
+}
+
+void ChessEPDSuiteRunner::PrintSummary(double wallSeconds) const
+{
+	// Per suite, then the totals on the last row; unsolved positions are charged the whole search
+	int numRows = static_cast<int>(m_suiteNames.size()) + 1;
+	std::vector<int> numTests(numRows, 0);
+	std::vector<int> numSolved(numRows, 0);
+	std::vector<double> solutionSeconds(numRows, 0.0);
+	std::vector<double> chargedSeconds(numRows, 0.0);
+	std::vector<uint64_t> solutionNodes(numRows, 0);
+	int numSolvedWithin[EPD_NUM_SOLUTION_BANDS] = {};
+	uint64_t totalNodes = 0;
+	double totalSearchSeconds = 0.0;
+	for (size_t testIndex = 0; testIndex < m_tests.size(); ++testIndex)
+	{
+		ChessEPDTestResult const& result = m_results[testIndex];
+		totalNodes += result.m_search.m_nodes;
+		totalSearchSeconds += result.m_search.m_seconds;
+		for (int row : { m_tests[testIndex].m_suiteIndex, numRows - 1 })
+		{
+			numTests[row] += 1;
+			chargedSeconds[row] += result.m_isSolved ? result.m_search.m_bestMoveSeconds : result.m_search.m_seconds;
+			if (result.m_isSolved)
+			{
+				numSolved[row] += 1;
+				solutionSeconds[row] += result.m_search.m_bestMoveSeconds;
+				solutionNodes[row] += result.m_search.m_bestMoveNodes;
+			}
+		}
+		for (int bandIndex = 0; bandIndex < EPD_NUM_SOLUTION_BANDS; ++bandIndex)
+		{
+			numSolvedWithin[bandIndex] += (result.m_isSolved && GetSolutionFraction(result.m_search) <= EPD_SOLUTION_BANDS[bandIndex]) ? 1 : 0;
+		}
+	}
+
+	for (int row = 0; row < numRows; ++row)
+	{
+		// A single suite is its own total
+		if (row < numRows - 1 && numRows == 2)
+		{
+			continue;
+		}
+		int solvedDivisor = std::max(numSolved[row], 1);
+		printf("%s: solved %d/%d (%.1f%%), time to solution %.3fs mean, %llu nodes mean, %.2fs total with misses charged in full\n",
+			(row == numRows - 1) ? "Total" : m_suiteNames[row].c_str(), numSolved[row], numTests[row],
+			100.0 * numSolved[row] / std::max(numTests[row], 1), solutionSeconds[row] / solvedDivisor,
+			static_cast<unsigned long long>(solutionNodes[row] / static_cast<uint64_t>(solvedDivisor)), chargedSeconds[row]);
+	}
+	printf("  solved within 10%% of the budget %d, 25%% %d, 50%% %d\n", numSolvedWithin[0], numSolvedWithin[1], numSolvedWithin[2]);
+	printf("  %llu nodes, nps %.0f per search, %.0f overall; %.1fs on %d workers, %.2f solved/s\n", static_cast<unsigned long long>(totalNodes),
+		(totalSearchSeconds > 0.0) ? static_cast<double>(totalNodes) / totalSearchSeconds : 0.0, (wallSeconds > 0.0) ? static_cast<double>(totalNodes) / wallSeconds : 0.0,
+		wallSeconds, m_settings.m_numConcurrentSearches, (wallSeconds > 0.0) ? numSolved[numRows - 1] / wallSeconds : 0.0);
+}
+
+bool ChessEPDSuiteRunner::WriteResultsFile() const
+{
+	std::error_code errorCode;
+	std::filesystem::create_directories(std::filesystem::path(m_settings.m_resultsFile).parent_path(), errorCode);
+	std::ofstream resultsFile(m_settings.m_resultsFile, std::ios::out | std::ios::trunc);
+	if (!resultsFile.is_open())
+	{
+		printf("ERROR: could not write \"%s\"\n", m_settings.m_resultsFile.c_str());
+		return false;
+	}
+
+	// suite, id, solved/failed, move played, bm, am, seconds and nodes to solution, depth, nodes, seconds
+	for (size_t testIndex = 0; testIndex < m_tests.size(); ++testIndex)
+	{
+		ChessEPDTest const& test = m_tests[testIndex];
+		ChessSearchResult const& search = m_results[testIndex].m_search;
+		bool isLegalMove = search.HasMove() && test.m_position.IsLegalMove(search.m_bestMove);
+		resultsFile << m_suiteNames[test.m_suiteIndex] << '\t' << test.m_id << '\t' << (m_results[testIndex].m_isSolved ? "solved" : "failed") << '\t'
+			<< (isLegalMove ? test.m_position.GetSANForMove(search.m_bestMove) : "-") << '\t' << GetMoveListText(test.m_position, test.m_bestMoves) << '\t'
+			<< GetMoveListText(test.m_position, test.m_avoidMoves) << '\t';
+		if (m_results[testIndex].m_isSolved)
+		{
+			resultsFile << search.m_bestMoveSeconds << '\t' << search.m_bestMoveNodes;
+		}
+		else
+		{
+			resultsFile << "-\t-";
+		}
+		resultsFile << '\t' << search.m_depth << '\t' << search.m_nodes << '\t' << search.m_seconds << '\n';
+	}
+	printf("Wrote %s\n", m_settings.m_resultsFile.c_str());
+	return true;
+}
+
+std::string ChessEPDSuiteRunner::GetMoveListText(ChessPosition const& position, std::vector<ChessMove> const& moves) const
+{
+	std::string text;
+	for (ChessMove const& move : moves)
+	{
+		text += text.empty() ? "" : " ";
+		text += position.GetSANForMove(move);
+	}
+	return text.empty() ? "-" : text;
+}
+
+float ChessEPDSuiteRunner::GetSolutionFraction(ChessSearchResult const& search) const
+{
+	// Against whichever budget the run set; a depth-only run measures against the search itself
+	float fraction = 0.f;
+	if (m_settings.m_maxNodes > 0)
+	{
+		fraction = std::max(fraction, static_cast<float>(search.m_bestMoveNodes) / static_cast<float>(m_settings.m_maxNodes));
+	}
+	if (m_settings.m_moveSeconds > 0.f)
+	{
+		fraction = std::max(fraction, search.m_bestMoveSeconds / m_settings.m_moveSeconds);
+	}
+	if (m_settings.m_maxNodes == 0 && m_settings.m_moveSeconds <= 0.f && search.m_nodes > 0)
+	{
+		fraction = static_cast<float>(search.m_bestMoveNodes) / static_cast<float>(search.m_nodes);
+	}
+	return fraction;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "Game/ChessEngine.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+struct ChessEPDSuiteSettings
+{
+public:
+	std::vector<std::string> m_suiteFiles;
+	ChessEngineType		m_engineType = ChessEngineType::ALPHA_BETA;
+	ChessMCTSPolicyType m_mctsPolicy = ChessMCTSPolicyType::EVALUATION;
+	float	 m_moveSeconds = 1.f;			// Per position; 0 = only the node or depth limit stops the search
+	uint64_t m_maxNodes = 0;				// 0 = only the clock limits the search
+	int		 m_maxDepth = 64;
+	int		 m_numConcurrentSearches = 0;	// 0 = one per hardware thread
+	int		 m_numThreadsPerSearch = 1;		// Search threads inside each position, on top of the concurrent searches
+	int		 m_hashSizeMB = 16;
+	bool	 m_useTablebases = true;
+	int		 m_maxFailuresShown = 20;
+	std::string m_resultsFile;				// One tab-separated line per position; empty = none
+};
+// -----------------------------------------------------------------------------
+// One EPD record: the position plus its bm (best move) and am (avoid move) operations.
+// The engine solves it by playing one of the best moves and none of the avoid moves.
+// -----------------------------------------------------------------------------
+struct ChessEPDTest
+{
+public:
+	bool IsSolvedBy(ChessMove const& move) const;
+
+	// The FEN fields, then ';' terminated operations; moves may be SAN or long algebraic, e.g.
+	//     r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - bm Qxf7#; id "mate.001";
+	static bool ParseEPDLine(std::string const& line, ChessEPDTest& out_test, std::string& out_error);
+
+public:
+	int					   m_suiteIndex = 0;
+	int					   m_lineNumber = 0;
+	std::string			   m_id;
+	ChessPosition		   m_position;
+	std::vector<ChessMove> m_bestMoves;
+	std::vector<ChessMove> m_avoidMoves;
+};
+// -----------------------------------------------------------------------------
+struct ChessEPDTestResult
+{
+public:
+	ChessSearchResult m_search;
+	bool			  m_isSolved = false;
+};
+// -----------------------------------------------------------------------------
+// Runs every position of one or more EPD test suites through an engine on a pool of threads,
+// one position per thread at a time, each with the same fixed time or node budget. Every worker
+// owns one engine for its whole life and clears its table between positions, so a result never
+// depends on which positions the same worker searched before it.
+// -----------------------------------------------------------------------------
+class ChessEPDSuiteRunner
+{
+public:
+	explicit ChessEPDSuiteRunner(ChessEPDSuiteSettings const& settings);
+
+	bool Run();
+
+private:
+	bool LoadSuites();
+	void RunWorker();
+	void RecordResult(int testIndex, ChessEPDTestResult const& result);
+	void PrintSummary(double wallSeconds) const;
+	bool WriteResultsFile() const;
+	std::string GetMoveListText(ChessPosition const& position, std::vector<ChessMove> const& moves) const;
+	float GetSolutionFraction(ChessSearchResult const& search) const;
+
+private:
+	ChessEPDSuiteSettings m_settings;
+	std::vector<std::string> m_suiteNames;
+	std::vector<ChessEPDTest> m_tests;
+	std::vector<ChessEPDTestResult> m_results;		// Per test; each worker writes only the ones it ran
+	std::atomic<int> m_nextTestIndex = 0;
+
+	std::mutex m_outputMutex;
+	int		   m_numFinishedTests = 0;
+	int		   m_numSolvedTests = 0;
+	int		   m_numFailuresShown = 0;
+	std::chrono::steady_clock::time_point m_startTime;
+};
@@ -0,0 +1,536 @@
+#include "Game/ChessEndgameGenerator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+constexpr uint64_t ENDGAME_WORK_CHUNK = 4096;
+constexpr int	   NUM_PAWNLESS_SYMMETRIES = 8;		// Every combination of file flip, rank flip and transpose
+constexpr int	   NUM_PAWN_SYMMETRIES = 2;			// Pawns only allow the file flip
+// -----------------------------------------------------------------------------
+static int const s_kingOffsets[8][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+static int const s_knightOffsets[8][2] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+static int const s_rookDirections[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+static int const s_bishopDirections[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+// -----------------------------------------------------------------------------
+struct ChessEndgameBuild
+{
+public:
+	ChessEndgameMaterial m_material;
+	uint64_t			 m_numEntries = 0;
+	std::unique_ptr<std::atomic<uint8_t>[]> m_values;
+	std::unique_ptr<std::atomic<uint8_t>[]> m_queuedPass;			// Last pass that queued the position, so it is examined once per pass
+	std::vector<std::vector<uint32_t>>		m_conversionCandidates;	// Per pass: positions a capture or promotion may resolve then
+	std::vector<uint32_t>					m_lastResolved;
+	int										m_lastConversionPass = 0;
+};
+// -----------------------------------------------------------------------------
+
+static int TransformSquare(int square, int symmetry)
+{
+	if (symmetry & 1)
+	{
+		square ^= 7;
+	}
+	if (symmetry & 2)
+	{
+		square ^= 56;
+	}
+	if (symmetry & 4)
+	{
+		square = GetChessSquare(GetChessSquareY(square), GetChessSquareX(square));
+	}
+	return square;
+}
+
+static int AddUnmoveSteps(ChessPosition const& position, int square, int const (*offsets)[2], int numOffsets, bool isSliding, int* out_targets)
+{
+	int numTargets = 0;
+	for (int offsetIndex = 0; offsetIndex < numOffsets; ++offsetIndex)
+	{
+		int x = GetChessSquareX(square) + offsets[offsetIndex][0];
+		int y = GetChessSquareY(square) + offsets[offsetIndex][1];
+		while (x >= 0 && x < CHESS_BOARD_COLUMNS && y >= 0 && y < CHESS_BOARD_ROWS && position.m_squares[GetChessSquare(x, y)] == CHESS_EMPTY_SQUARE)
+		{
+			out_targets[numTargets++] = GetChessSquare(x, y);
+			if (!isSliding)
+			{
+				break;
+			}
+			x += offsets[offsetIndex][0];
+			y += offsets[offsetIndex][1];
+		}
+	}
+	return numTargets;
+}
+
+static int GetUnmoveTargets(ChessPosition const& position, int square, int (&out_targets)[CHESS_BOARD_SIZE])
+{
+	// Squares the piece could have come from without capturing; captures and promotions belong to other tables
+	uint8_t pieceCode = position.m_squares[square];
+	switch (GetChessPieceTypeForCode(pieceCode))
+	{
+		case ChessPieceType::KING:		return AddUnmoveSteps(position, square, s_kingOffsets, 8, false, out_targets);
+		case ChessPieceType::KNIGHT:	return AddUnmoveSteps(position, square, s_knightOffsets, 8, false, out_targets);
+		case ChessPieceType::ROOK:		return AddUnmoveSteps(position, square, s_rookDirections, 4, true, out_targets);
+		case ChessPieceType::BISHOP:	return AddUnmoveSteps(position, square, s_bishopDirections, 4, true, out_targets);
+		case ChessPieceType::QUEEN:
+		{
+			int numTargets = AddUnmoveSteps(position, square, s_rookDirections, 4, true, out_targets);
+			return numTargets + AddUnmoveSteps(position, square, s_bishopDirections, 4, true, out_targets + numTargets);
+		}
+		case ChessPieceType::PAWN:
+		{
+			int forward = (GetPlayerIndexForCode(pieceCode) == 0) ? 1 : -1;
+			int y = GetChessSquareY(square);
+			int fromY = y - forward;
+			int homeY = (forward == 1) ? 1 : CHESS_BOARD_ROWS - 2;
+			int numTargets = 0;
+			if (fromY >= 1 && fromY <= CHESS_BOARD_ROWS - 2 && position.m_squares[square - forward * CHESS_BOARD_COLUMNS] == CHESS_EMPTY_SQUARE)
+			{
+				out_targets[numTargets++] = square - forward * CHESS_BOARD_COLUMNS;
+				if (fromY - forward == homeY && position.m_squares[square - 2 * forward * CHESS_BOARD_COLUMNS] == CHESS_EMPTY_SQUARE)
+				{
+					out_targets[numTargets++] = square - 2 * forward * CHESS_BOARD_COLUMNS;
+				}
+			}
+			return numTargets;
+		}
+		default:
+			return 0;
+	}
+}
+
+// -----------------------------------------------------------------------------
+ChessEndgameGenerator::ChessEndgameGenerator(ChessEndgameGeneratorSettings const& settings)
+	: m_settings(settings)
+{
+	m_numThreads = (settings.m_numThreads > 0) ? settings.m_numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+bool ChessEndgameGenerator::Run()
+{
+	if (m_settings.m_tableNames.empty())
+	{
+		printf("ERROR: no tables given\n");
+		return false;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(m_settings.m_outputDirectory, errorCode);
+
+	printf("Generating with %d threads into %s\n", m_numThreads, m_settings.m_outputDirectory.c_str());
+	for (std::string const& tableName : m_settings.m_tableNames)
+	{
+		ChessEndgameMaterial material;
+		if (!material.SetFromName(tableName))
+		{
+			printf("ERROR: \"%s\" is not a table name (kings on both sides, at most %d pieces, e.g. KBNvK)\n", tableName.c_str(), CHESS_ENDGAME_MAX_PIECES);
+			return false;
+		}
+		if (!GenerateTable(material.GetCanonical()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<uint8_t> const* ChessEndgameGenerator::FindValues(ChessEndgameMaterial const& material) const
+{
+	auto found = m_tableValues.find(material.GetCanonical().GetName());
+	return (found != m_tableValues.end()) ? &found->second : nullptr;
+}
+
+bool ChessEndgameGenerator::GenerateTable(ChessEndgameMaterial const& material)
+{
+	std::string tableName = material.GetName();
+	if (m_tableValues.find(tableName) != m_tableValues.end())
+	{
+		return true;
+	}
+
+	// Everything a capture or promotion can lead to has to be finished first
+	int const pawn = static_cast<int>(ChessPieceType::PAWN);
+	for (int playerIndex = 0; playerIndex < CHESS_NUM_PLAYERS; ++playerIndex)
+	{
+		for (int typeIndex = 0; typeIndex < CHESS_ENDGAME_NUM_PIECE_TYPES; ++typeIndex)
+		{
+			if (typeIndex == static_cast<int>(ChessPieceType::KING) || material.m_counts[playerIndex][typeIndex] == 0)
+			{
+				continue;
+			}
+
+			ChessEndgameMaterial captured = material;
+			captured.m_counts[playerIndex][typeIndex] -= 1;
+			if (!GenerateTable(captured.GetCanonical()))
+			{
+				return false;
+			}
+
+			if (typeIndex != pawn)
+			{
+				continue;
+			}
+			for (ChessPieceType promotionType : { ChessPieceType::QUEEN, ChessPieceType::ROOK, ChessPieceType::BISHOP, ChessPieceType::KNIGHT })
+			{
+				ChessEndgameMaterial promoted = material;
+				promoted.m_counts[playerIndex][pawn] -= 1;
+				promoted.m_counts[playerIndex][static_cast<int>(promotionType)] += 1;
+				if (!GenerateTable(promoted.GetCanonical()))
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	ChessEndgameBuild build;
+	build.m_material = material;
+	build.m_numEntries = material.GetNumEntries();
+	if (build.m_numEntries > UINT32_MAX)
+	{
+		printf("ERROR: %s has too many positions\n", tableName.c_str());
+		return false;
+	}
+	build.m_values.reset(new std::atomic<uint8_t>[build.m_numEntries]());
+	build.m_queuedPass.reset(new std::atomic<uint8_t>[build.m_numEntries]());
+	build.m_conversionCandidates.resize(CHESS_ENDGAME_MAX_PLIES + 1);
+
+	InitializeTable(build);
+	int numPasses = 0;
+	for (int pass = 1; pass <= CHESS_ENDGAME_MAX_PLIES; ++pass)
+	{
+		if (build.m_lastResolved.empty() && pass > build.m_lastConversionPass)
+		{
+			break;
+		}
+		ResolvePass(build, pass);
+		numPasses = pass;
+	}
+
+	std::vector<uint8_t> values(build.m_numEntries);
+	uint64_t numWins = 0;
+	uint64_t numLosses = 0;
+	uint64_t numDraws = 0;
+	int longestMate = 0;
+	for (uint64_t index = 0; index < build.m_numEntries; ++index)
+	{
+		uint8_t value = build.m_values[index].load(std::memory_order_relaxed);
+		values[index] = value;
+		if (value == CHESS_ENDGAME_ILLEGAL)
+		{
+			continue;
+		}
+		numWins += IsChessEndgameWin(value) ? 1 : 0;
+		numLosses += IsChessEndgameLoss(value) ? 1 : 0;
+		numDraws += (value == CHESS_ENDGAME_DRAW) ? 1 : 0;
+		longestMate = IsChessEndgameResult(value) ? std::max(longestMate, GetChessEndgamePlies(value)) : longestMate;
+	}
+
+	std::string filePath = m_settings.m_outputDirectory + "/" + tableName + CHESS_ENDGAME_FILE_EXTENSION;
+	if (!WriteChessEndgameTableFile(filePath, material, values))
+	{
+		printf("ERROR: could not write \"%s\"\n", filePath.c_str());
+		return false;
+	}
+
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+	printf("%-8s %llu wins, %llu losses, %llu draws, longest mate %d plies, %d passes in %.1fs -> %s\n", tableName.c_str(),
+		static_cast<unsigned long long>(numWins), static_cast<unsigned long long>(numLosses), static_cast<unsigned long long>(numDraws),
+		longestMate, numPasses, seconds, filePath.c_str());
+	m_tableValues[tableName] = std::move(values);
+	return true;
+}
+
+void ChessEndgameGenerator::InitializeTable(ChessEndgameBuild& build)
+{
+	// Marks impossible placements and checkmates, and queues positions whose captures or promotions
+	// reach a known result for the pass where that result decides them
+	std::vector<std::vector<uint32_t>> threadMated(m_numThreads);
+	std::vector<std::vector<std::vector<uint32_t>>> threadCandidates(m_numThreads, std::vector<std::vector<uint32_t>>(CHESS_ENDGAME_MAX_PLIES + 1));
+	ParallelFor(build.m_numEntries, [&](int threadIndex, uint64_t begin, uint64_t end)
+	{
+		ChessPosition position;
+		ChessMoveList moves;
+		for (uint64_t index = begin; index < end; ++index)
+		{
+			if (!SetChessEndgamePosition(build.m_material, index, position) || position.IsInCheck(1 - position.GetSideToMove()))
+			{
+				build.m_values[index].store(CHESS_ENDGAME_ILLEGAL, std::memory_order_relaxed);
+				continue;
+			}
+
+			position.GenerateLegalMoves(moves);
+			if (moves.m_count == 0)
+			{
+				if (position.IsInCheck(position.GetSideToMove()))
+				{
+					build.m_values[index].store(CHESS_ENDGAME_MATED, std::memory_order_relaxed);
+					threadMated[threadIndex].push_back(static_cast<uint32_t>(index));
+				}
+				continue;
+			}
+
+			int fastestWin = 0;
+			int slowestLoss = 0;
+			for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+			{
+				ChessMove const& move = moves[moveIndex];
+				if (!move.IsCapture() && !move.IsPromotion())
+				{
+					continue;
+				}
+
+				ChessPosition child = position;
+				child.MakeMove(move);
+				uint8_t childValue = GetChildValue(build, child, true);
+				if (!IsChessEndgameResult(childValue) || GetChessEndgamePlies(childValue) >= CHESS_ENDGAME_MAX_PLIES)
+				{
+					continue;
+				}
+				int plies = GetChessEndgamePlies(childValue) + 1;
+				if (IsChessEndgameLoss(childValue))
+				{
+					fastestWin = (fastestWin == 0) ? plies : std::min(fastestWin, plies);
+				}
+				else
+				{
+					slowestLoss = std::max(slowestLoss, plies);
+				}
+			}
+
+			if (fastestWin > 0)
+			{
+				threadCandidates[threadIndex][fastestWin].push_back(static_cast<uint32_t>(index));
+			}
+			if (slowestLoss > 0 && slowestLoss != fastestWin)
+			{
+				threadCandidates[threadIndex][slowestLoss].push_back(static_cast<uint32_t>(index));
+			}
+		}
+	});
+
+	for (int threadIndex = 0; threadIndex < m_numThreads; ++threadIndex)
+	{
+		build.m_lastResolved.insert(build.m_lastResolved.end(), threadMated[threadIndex].begin(), threadMated[threadIndex].end());
+		for (int pass = 1; pass <= CHESS_ENDGAME_MAX_PLIES; ++pass)
+		{
+			std::vector<uint32_t> const& candidates = threadCandidates[threadIndex][pass];
+			build.m_conversionCandidates[pass].insert(build.m_conversionCandidates[pass].end(), candidates.begin(), candidates.end());
+			build.m_lastConversionPass = candidates.empty() ? build.m_lastConversionPass : std::max(build.m_lastConversionPass, pass);
+		}
+	}
+}
+
+void ChessEndgameGenerator::ResolvePass(ChessEndgameBuild& build, int pass)
+{
+	// Candidates: predecessors of last pass's positions plus conversions that land on this pass
+	std::vector<std::vector<uint32_t>> threadCandidates(m_numThreads);
+	ParallelFor(build.m_lastResolved.size(), [&](int threadIndex, uint64_t begin, uint64_t end)
+	{
+		for (uint64_t resolvedIndex = begin; resolvedIndex < end; ++resolvedIndex)
+		{
+			AddPredecessors(build, build.m_lastResolved[resolvedIndex], pass, threadCandidates[threadIndex]);
+		}
+	});
+
+	std::vector<uint32_t> candidates;
+	for (uint32_t index : build.m_conversionCandidates[pass])
+	{
+		if (build.m_queuedPass[index].exchange(static_cast<uint8_t>(pass)) != pass)
+		{
+			candidates.push_back(index);
+		}
+	}
+	for (std::vector<uint32_t> const& threadList : threadCandidates)
+	{
+		candidates.insert(candidates.end(), threadList.begin(), threadList.end());
+	}
+	build.m_conversionCandidates[pass].clear();
+	build.m_conversionCandidates[pass].shrink_to_fit();
+
+	std::vector<std::vector<uint32_t>> threadResolved(m_numThreads);
+	ParallelFor(candidates.size(), [&](int threadIndex, uint64_t begin, uint64_t end)
+	{
+		ChessPosition position;
+		for (uint64_t candidateIndex = begin; candidateIndex < end; ++candidateIndex)
+		{
+			uint32_t index = candidates[candidateIndex];
+			if (build.m_values[index].load(std::memory_order_relaxed) != CHESS_ENDGAME_DRAW || !SetChessEndgamePosition(build.m_material, index, position))
+			{
+				continue;
+			}
+
+			// Values written during this pass are all 'pass' plies, which EvaluatePosition treats as unknown
+			uint8_t value = EvaluatePosition(build, position, pass);
+			if (value != CHESS_ENDGAME_DRAW)
+			{
+				build.m_values[index].store(value, std::memory_order_relaxed);
+				threadResolved[threadIndex].push_back(index);
+			}
+		}
+	});
+
+	build.m_lastResolved.clear();
+	for (std::vector<uint32_t> const& threadList : threadResolved)
+	{
+		build.m_lastResolved.insert(build.m_lastResolved.end(), threadList.begin(), threadList.end());
+	}
+}
+
+uint8_t ChessEndgameGenerator::EvaluatePosition(ChessEndgameBuild const& build, ChessPosition const& position, int pass) const
+{
+	// Won if some move reaches a loss, lost once every move is known to reach a win; results
+	// from this pass onwards do not count yet, which keeps every distance minimal
+	ChessMoveList moves;
+	position.GenerateLegalMoves(moves);
+	int fastestWin = 0;
+	int slowestLoss = 0;
+	bool isEveryMoveLosing = moves.m_count > 0;
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = moves[moveIndex];
+		ChessPosition child = position;
+		child.MakeMove(move);
+		uint8_t childValue = GetChildValue(build, child, move.IsCapture() || move.IsPromotion());
+		if (!IsChessEndgameResult(childValue) || GetChessEndgamePlies(childValue) >= pass)
+		{
+			isEveryMoveLosing = false;
+			continue;
+		}
+
+		int plies = GetChessEndgamePlies(childValue) + 1;
+		if (IsChessEndgameLoss(childValue))
+		{
+			fastestWin = (fastestWin == 0) ? plies : std::min(fastestWin, plies);
+			isEveryMoveLosing = false;
+		}
+		else
+		{
+			slowestLoss = std::max(slowestLoss, plies);
+		}
+	}
+
+	if (fastestWin > 0)
+	{
+		return static_cast<uint8_t>(CHESS_ENDGAME_MATED + fastestWin);
+	}
+	if (isEveryMoveLosing)
+	{
+		return static_cast<uint8_t>(CHESS_ENDGAME_MATED + slowestLoss);
+	}
+	return CHESS_ENDGAME_DRAW;
+}
+
+uint8_t ChessEndgameGenerator::GetChildValue(ChessEndgameBuild const& build, ChessPosition const& child, bool isConversion) const
+{
+	uint64_t index = 0;
+	if (!isConversion)
+	{
+		return GetChessEndgameIndex(build.m_material, child, index) ? build.m_values[index].load(std::memory_order_relaxed) : CHESS_ENDGAME_DRAW;
+	}
+
+	// Finished tables are looked up in their stored colour orientation
+	ChessEndgameMaterial childMaterial;
+	childMaterial.SetFromPosition(child);
+	std::vector<uint8_t> const* childValues = FindValues(childMaterial);
+	if (childValues == nullptr || !GetChessEndgameIndex(childMaterial.GetCanonical(), child, index))
+	{
+		return CHESS_ENDGAME_DRAW;
+	}
+	return (*childValues)[index];
+}
+
+void ChessEndgameGenerator::AddPredecessors(ChessEndgameBuild& build, uint64_t index, int pass, std::vector<uint32_t>& out_candidates) const
+{
+	ChessPosition position;
+	if (!SetChessEndgamePosition(build.m_material, index, position))
+	{
+		return;
+	}
+
+	// The stored placement stands for all its mirror images, and a predecessor may reach any of them
+	int sideToMove = position.GetSideToMove();
+	int mover = 1 - sideToMove;
+	int numSymmetries = build.m_material.HasPawns() ? NUM_PAWN_SYMMETRIES : NUM_PAWNLESS_SYMMETRIES;
+	for (int symmetry = 0; symmetry < numSymmetries; ++symmetry)
+	{
+		ChessPosition image;
+		for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+		{
+			image.m_squares[TransformSquare(square, symmetry)] = position.m_squares[square];
+		}
+		image.m_sideToMove = mover;
+		image.RefreshDerivedState();
+
+		for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+		{
+			uint8_t pieceCode = image.m_squares[square];
+			if (pieceCode == CHESS_EMPTY_SQUARE || GetPlayerIndexForCode(pieceCode) != mover)
+			{
+				continue;
+			}
+
+			int targets[CHESS_BOARD_SIZE];
+			int numTargets = GetUnmoveTargets(image, square, targets);
+			for (int targetIndex = 0; targetIndex < numTargets; ++targetIndex)
+			{
+				ChessPosition predecessor = image;
+				predecessor.m_squares[square] = CHESS_EMPTY_SQUARE;
+				predecessor.m_squares[targets[targetIndex]] = pieceCode;
+				if (GetChessPieceTypeForCode(pieceCode) == ChessPieceType::KING)
+				{
+					predecessor.m_kingSquares[mover] = targets[targetIndex];
+				}
+
+				// The side that did not move may not have been left in check
+				uint64_t predecessorIndex = 0;
+				if (predecessor.IsInCheck(sideToMove) || !GetChessEndgameIndex(build.m_material, predecessor, predecessorIndex))
+				{
+					continue;
+				}
+				if (build.m_values[predecessorIndex].load(std::memory_order_relaxed) == CHESS_ENDGAME_DRAW &&
+					build.m_queuedPass[predecessorIndex].exchange(static_cast<uint8_t>(pass)) != pass)
+				{
+					out_candidates.push_back(static_cast<uint32_t>(predecessorIndex));
+				}
+			}
+		}
+	}
+}
+
+void ChessEndgameGenerator::ParallelFor(uint64_t count, std::function<void(int threadIndex, uint64_t begin, uint64_t end)> const& work) const
+{
+	std::atomic<uint64_t> nextBegin = 0;
+	auto workerLoop = [&](int threadIndex)
+	{
+		for (;;)
+		{
+			uint64_t begin = nextBegin.fetch_add(ENDGAME_WORK_CHUNK);
+			if (begin >= count)
+			{
+				return;
+			}
+			work(threadIndex, begin, std::min(count, begin + ENDGAME_WORK_CHUNK));
+		}
+	};
+
+	// Small passes are not worth waking the other threads for
+	int numWorkers = static_cast<int>(std::min<uint64_t>(m_numThreads, (count + ENDGAME_WORK_CHUNK - 1) / ENDGAME_WORK_CHUNK));
+	std::vector<std::thread> workers;
+	for (int threadIndex = 1; threadIndex < numWorkers; ++threadIndex)
+	{
+		workers.emplace_back(workerLoop, threadIndex);
+	}
+	workerLoop(0);
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
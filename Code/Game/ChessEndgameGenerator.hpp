@@ -0,0 +1,47 @@
+#pragma once
+#include "Game/ChessEndgameTable.hpp"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+struct ChessEndgameBuild;
+// -----------------------------------------------------------------------------
+struct ChessEndgameGeneratorSettings
+{
+public:
+	std::vector<std::string> m_tableNames;				// "KQvK", "KRvK", "KPvK", "KBNvK"; the 'v' may be left out
+	std::string m_outputDirectory = "Data/Tablebases";
+	int			m_numThreads = 0;						// 0 = one per hardware thread
+};
+// -----------------------------------------------------------------------------
+// Builds distance-to-mate tables by retrograde analysis. Every table the requested ones convert
+// into (captures and promotions) is built first and kept in memory, then each pass resolves the
+// positions one ply further from mate: only predecessors of the last pass's positions, found
+// by un-moving pieces, are re-examined, and each pass is split across all worker threads.
+// -----------------------------------------------------------------------------
+class ChessEndgameGenerator
+{
+public:
+	explicit ChessEndgameGenerator(ChessEndgameGeneratorSettings const& settings);
+
+	bool Run();
+
+	// In-memory values of a finished table, indexed like the file; nullptr if not generated
+	std::vector<uint8_t> const* FindValues(ChessEndgameMaterial const& material) const;
+
+private:
+	bool	GenerateTable(ChessEndgameMaterial const& material);
+	void	InitializeTable(ChessEndgameBuild& build);
+	void	ResolvePass(ChessEndgameBuild& build, int pass);
+	uint8_t EvaluatePosition(ChessEndgameBuild const& build, ChessPosition const& position, int pass) const;
+	uint8_t GetChildValue(ChessEndgameBuild const& build, ChessPosition const& child, bool isConversion) const;
+	void	AddPredecessors(ChessEndgameBuild& build, uint64_t index, int pass, std::vector<uint32_t>& out_candidates) const;
+	void	ParallelFor(uint64_t count, std::function<void(int threadIndex, uint64_t begin, uint64_t end)> const& work) const;
+
+private:
+	ChessEndgameGeneratorSettings m_settings;
+	int m_numThreads = 1;
+	std::map<std::string, std::vector<uint8_t>> m_tableValues;
+};
@@ -0,0 +1,483 @@
+#include "Game/ChessEndgameTable.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// -----------------------------------------------------------------------------
+constexpr char	   ENDGAME_TABLE_MAGIC[] = { 'C', '3', 'T', 'B' };
+constexpr uint32_t ENDGAME_TABLE_VERSION = 1;
+constexpr int	   ENDGAME_TABLE_NAME_SIZE = 16;
+constexpr int	   NUM_PAWNLESS_KING_SLOTS = 10;
+constexpr int	   NUM_PAWN_KING_SLOTS = 32;
+// -----------------------------------------------------------------------------
+// Name order, strongest first; the king is always the first letter of each side
+static ChessPieceType const s_nameOrder[] = { ChessPieceType::KING, ChessPieceType::QUEEN, ChessPieceType::ROOK, ChessPieceType::BISHOP, ChessPieceType::KNIGHT, ChessPieceType::PAWN };
+static char const s_letterForType[] = { 'R', 'N', 'B', 'Q', 'K', 'P' };
+static int const  s_valueForType[] = { 5, 3, 3, 9, 0, 1 };
+// -----------------------------------------------------------------------------
+
+static int GetTriangleSlot(int square)
+{
+	// a1-d1-d4: files a-d, on or below the long diagonal
+	static int s_slotForSquare[CHESS_BOARD_SIZE];
+	static bool s_isInitialized = [] ()
+	{
+		int slot = 0;
+		for (int boardSquare = 0; boardSquare < CHESS_BOARD_SIZE; ++boardSquare)
+		{
+			int x = GetChessSquareX(boardSquare);
+			int y = GetChessSquareY(boardSquare);
+			s_slotForSquare[boardSquare] = (x <= 3 && y <= x) ? slot++ : -1;
+		}
+		return true;
+	}();
+	(void)s_isInitialized;
+	return s_slotForSquare[square];
+}
+
+static int GetTriangleSquare(int slot)
+{
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		if (GetTriangleSlot(square) == slot)
+		{
+			return square;
+		}
+	}
+	return CHESS_NO_SQUARE;
+}
+
+static int GetPieceSlotCodes(ChessEndgameMaterial const& material, uint8_t (&out_codes)[CHESS_ENDGAME_MAX_PIECES])
+{
+	// Both kings first, then the other white pieces, then the other black pieces
+	int numSlots = 0;
+	out_codes[numSlots++] = MakeChessPieceCode(ChessPieceType::KING, 0);
+	out_codes[numSlots++] = MakeChessPieceCode(ChessPieceType::KING, 1);
+	for (int playerIndex = 0; playerIndex < CHESS_NUM_PLAYERS; ++playerIndex)
+	{
+		for (ChessPieceType pieceType : s_nameOrder)
+		{
+			if (pieceType == ChessPieceType::KING)
+			{
+				continue;
+			}
+			for (int count = 0; count < material.m_counts[playerIndex][static_cast<int>(pieceType)] && numSlots < CHESS_ENDGAME_MAX_PIECES; ++count)
+			{
+				out_codes[numSlots++] = MakeChessPieceCode(pieceType, playerIndex);
+			}
+		}
+	}
+	return numSlots;
+}
+
+static int TransposeSquare(int square)
+{
+	return GetChessSquare(GetChessSquareY(square), GetChessSquareX(square));
+}
+
+// -----------------------------------------------------------------------------
+bool ChessEndgameMaterial::SetFromName(std::string const& name)
+{
+	*this = ChessEndgameMaterial();
+
+	// "KQK" is accepted as "KQvK": the second king starts the black side
+	std::string text = name;
+	if (text.find_first_of("vV") == std::string::npos)
+	{
+		size_t secondKing = text.find_first_of("Kk", 1);
+		if (secondKing != std::string::npos)
+		{
+			text.insert(secondKing, 1, 'v');
+		}
+	}
+
+	int playerIndex = 0;
+	for (char glyph : text)
+	{
+		if (glyph == 'v' || glyph == 'V')
+		{
+			if (playerIndex == 1)
+			{
+				return false;
+			}
+			playerIndex = 1;
+			continue;
+		}
+
+		int typeIndex = -1;
+		for (int candidate = 0; candidate < CHESS_ENDGAME_NUM_PIECE_TYPES; ++candidate)
+		{
+			if (s_letterForType[candidate] == (glyph & ~0x20))
+			{
+				typeIndex = candidate;
+			}
+		}
+		if (typeIndex < 0)
+		{
+			return false;
+		}
+		m_counts[playerIndex][typeIndex] += 1;
+	}
+
+	int const king = static_cast<int>(ChessPieceType::KING);
+	return playerIndex == 1 && m_counts[0][king] == 1 && m_counts[1][king] == 1 && GetNumPieces() <= CHESS_ENDGAME_MAX_PIECES;
+}
+
+void ChessEndgameMaterial::SetFromPosition(ChessPosition const& position)
+{
+	*this = ChessEndgameMaterial();
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = position.m_squares[square];
+		if (pieceCode != CHESS_EMPTY_SQUARE)
+		{
+			m_counts[GetPlayerIndexForCode(pieceCode)][static_cast<int>(GetChessPieceTypeForCode(pieceCode))] += 1;
+		}
+	}
+}
+
+std::string ChessEndgameMaterial::GetName() const
+{
+	std::string name;
+	for (int playerIndex = 0; playerIndex < CHESS_NUM_PLAYERS; ++playerIndex)
+	{
+		if (playerIndex == 1)
+		{
+			name += 'v';
+		}
+		for (ChessPieceType pieceType : s_nameOrder)
+		{
+			name.append(m_counts[playerIndex][static_cast<int>(pieceType)], s_letterForType[static_cast<int>(pieceType)]);
+		}
+	}
+	return name;
+}
+
+ChessEndgameMaterial ChessEndgameMaterial::GetColorFlipped() const
+{
+	ChessEndgameMaterial flipped;
+	memcpy(flipped.m_counts[0], m_counts[1], sizeof(m_counts[1]));
+	memcpy(flipped.m_counts[1], m_counts[0], sizeof(m_counts[0]));
+	return flipped;
+}
+
+ChessEndgameMaterial ChessEndgameMaterial::GetCanonical() const
+{
+	return IsCanonical() ? *this : GetColorFlipped();
+}
+
+bool ChessEndgameMaterial::IsCanonical() const
+{
+	// Stronger side first by material value, then by the pieces in name order
+	int sideValues[CHESS_NUM_PLAYERS] = {};
+	for (int playerIndex = 0; playerIndex < CHESS_NUM_PLAYERS; ++playerIndex)
+	{
+		for (int typeIndex = 0; typeIndex < CHESS_ENDGAME_NUM_PIECE_TYPES; ++typeIndex)
+		{
+			sideValues[playerIndex] += m_counts[playerIndex][typeIndex] * s_valueForType[typeIndex];
+		}
+	}
+	if (sideValues[0] != sideValues[1])
+	{
+		return sideValues[0] > sideValues[1];
+	}
+	for (ChessPieceType pieceType : s_nameOrder)
+	{
+		int typeIndex = static_cast<int>(pieceType);
+		if (m_counts[0][typeIndex] != m_counts[1][typeIndex])
+		{
+			return m_counts[0][typeIndex] > m_counts[1][typeIndex];
+		}
+	}
+	return true;
+}
+
+bool ChessEndgameMaterial::HasPawns() const
+{
+	int const pawn = static_cast<int>(ChessPieceType::PAWN);
+	return m_counts[0][pawn] + m_counts[1][pawn] > 0;
+}
+
+int ChessEndgameMaterial::GetNumPieces() const
+{
+	int numPieces = 0;
+	for (int playerIndex = 0; playerIndex < CHESS_NUM_PLAYERS; ++playerIndex)
+	{
+		for (int typeIndex = 0; typeIndex < CHESS_ENDGAME_NUM_PIECE_TYPES; ++typeIndex)
+		{
+			numPieces += m_counts[playerIndex][typeIndex];
+		}
+	}
+	return numPieces;
+}
+
+uint64_t ChessEndgameMaterial::GetNumEntries() const
+{
+	uint64_t numEntries = CHESS_NUM_PLAYERS * static_cast<uint64_t>(HasPawns() ? NUM_PAWN_KING_SLOTS : NUM_PAWNLESS_KING_SLOTS);
+	for (int slot = 1; slot < GetNumPieces(); ++slot)
+	{
+		numEntries *= CHESS_BOARD_SIZE;
+	}
+	return numEntries;
+}
+
+bool ChessEndgameMaterial::operator==(ChessEndgameMaterial const& other) const
+{
+	return memcmp(m_counts, other.m_counts, sizeof(m_counts)) == 0;
+}
+
+// -----------------------------------------------------------------------------
+bool GetChessEndgameIndex(ChessEndgameMaterial const& material, ChessPosition const& position, uint64_t& out_index)
+{
+	// One pass over the board collects the pieces; the material check works from that list
+	uint8_t pieceCodes[CHESS_ENDGAME_MAX_PIECES];
+	int pieceSquares[CHESS_ENDGAME_MAX_PIECES];
+	int numPieces = 0;
+	int numSlots = material.GetNumPieces();
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		if (position.m_squares[square] == CHESS_EMPTY_SQUARE)
+		{
+			continue;
+		}
+		if (numPieces == numSlots)
+		{
+			return false;
+		}
+		pieceCodes[numPieces] = position.m_squares[square];
+		pieceSquares[numPieces++] = square;
+	}
+	if (numPieces != numSlots)
+	{
+		return false;
+	}
+
+	ChessEndgameMaterial positionMaterial;
+	for (int pieceIndex = 0; pieceIndex < numPieces; ++pieceIndex)
+	{
+		positionMaterial.m_counts[GetPlayerIndexForCode(pieceCodes[pieceIndex])][static_cast<int>(GetChessPieceTypeForCode(pieceCodes[pieceIndex]))] += 1;
+	}
+	bool isColorFlipped = false;
+	if (positionMaterial != material)
+	{
+		if (positionMaterial.GetColorFlipped() != material)
+		{
+			return false;
+		}
+		isColorFlipped = true;
+	}
+
+	uint8_t slotCodes[CHESS_ENDGAME_MAX_PIECES];
+	int squares[CHESS_ENDGAME_MAX_PIECES] = {};
+	GetPieceSlotCodes(material, slotCodes);
+	uint32_t filledSlots = 0;
+	for (int pieceIndex = 0; pieceIndex < numPieces; ++pieceIndex)
+	{
+		uint8_t pieceCode = isColorFlipped ? (pieceCodes[pieceIndex] ^ CHESS_PIECE_PLAYER_BIT) : pieceCodes[pieceIndex];
+		for (int slot = 0; slot < numSlots; ++slot)
+		{
+			if (slotCodes[slot] == pieceCode && (filledSlots & (1u << slot)) == 0)
+			{
+				squares[slot] = isColorFlipped ? (pieceSquares[pieceIndex] ^ 56) : pieceSquares[pieceIndex];
+				filledSlots |= 1u << slot;
+				break;
+			}
+		}
+	}
+
+	// Fold the white king: files e-h onto a-d, and without pawns ranks 5-8 and the upper triangle too
+	bool hasPawns = material.HasPawns();
+	if (GetChessSquareX(squares[0]) > 3)
+	{
+		for (int slot = 0; slot < numSlots; ++slot)
+		{
+			squares[slot] ^= 7;
+		}
+	}
+	if (!hasPawns && GetChessSquareY(squares[0]) > 3)
+	{
+		for (int slot = 0; slot < numSlots; ++slot)
+		{
+			squares[slot] ^= 56;
+		}
+	}
+	if (!hasPawns && GetChessSquareY(squares[0]) > GetChessSquareX(squares[0]))
+	{
+		for (int slot = 0; slot < numSlots; ++slot)
+		{
+			squares[slot] = TransposeSquare(squares[slot]);
+		}
+	}
+
+	int sideToMove = isColorFlipped ? 1 - position.GetSideToMove() : position.GetSideToMove();
+	int kingSlot = hasPawns ? GetChessSquareY(squares[0]) * 4 + GetChessSquareX(squares[0]) : GetTriangleSlot(squares[0]);
+	uint64_t index = static_cast<uint64_t>(sideToMove) * (hasPawns ? NUM_PAWN_KING_SLOTS : NUM_PAWNLESS_KING_SLOTS) + kingSlot;
+	for (int slot = 1; slot < numSlots; ++slot)
+	{
+		index = index * CHESS_BOARD_SIZE + squares[slot];
+	}
+	out_index = index;
+	return true;
+}
+
+bool SetChessEndgamePosition(ChessEndgameMaterial const& material, uint64_t index, ChessPosition& out_position)
+{
+	uint8_t slotCodes[CHESS_ENDGAME_MAX_PIECES];
+	int squares[CHESS_ENDGAME_MAX_PIECES];
+	int numSlots = GetPieceSlotCodes(material, slotCodes);
+	for (int slot = numSlots - 1; slot >= 1; --slot)
+	{
+		squares[slot] = static_cast<int>(index % CHESS_BOARD_SIZE);
+		index /= CHESS_BOARD_SIZE;
+	}
+
+	bool hasPawns = material.HasPawns();
+	int numKingSlots = hasPawns ? NUM_PAWN_KING_SLOTS : NUM_PAWNLESS_KING_SLOTS;
+	int kingSlot = static_cast<int>(index % numKingSlots);
+	uint64_t sideToMove = index / numKingSlots;
+	if (sideToMove >= CHESS_NUM_PLAYERS)
+	{
+		return false;
+	}
+	squares[0] = hasPawns ? GetChessSquare(kingSlot % 4, kingSlot / 4) : GetTriangleSquare(kingSlot);
+
+	out_position = ChessPosition();
+	for (int slot = 0; slot < numSlots; ++slot)
+	{
+		int square = squares[slot];
+		int y = GetChessSquareY(square);
+		if (out_position.m_squares[square] != CHESS_EMPTY_SQUARE ||
+			(GetChessPieceTypeForCode(slotCodes[slot]) == ChessPieceType::PAWN && (y == 0 || y == CHESS_BOARD_ROWS - 1)))
+		{
+			return false;
+		}
+		out_position.m_squares[square] = slotCodes[slot];
+	}
+	out_position.m_sideToMove = static_cast<int>(sideToMove);
+	out_position.RefreshDerivedState();
+	return true;
+}
+
+bool WriteChessEndgameTableFile(std::string const& filePath, ChessEndgameMaterial const& material, std::vector<uint8_t> const& values)
+{
+	uint8_t maxValue = 1;
+	for (uint8_t value : values)
+	{
+		maxValue = (value > maxValue) ? value : maxValue;
+	}
+	int bitsPerEntry = 1;
+	while ((1 << bitsPerEntry) <= maxValue)
+	{
+		++bitsPerEntry;
+	}
+
+	// Little-endian header, then the values LSB first; one spare byte lets readers always load two
+	uint8_t header[CHESS_ENDGAME_HEADER_SIZE] = {};
+	memcpy(header, ENDGAME_TABLE_MAGIC, sizeof(ENDGAME_TABLE_MAGIC));
+	std::string name = material.GetName();
+	memcpy(header + 8, name.c_str(), std::min(name.size(), static_cast<size_t>(ENDGAME_TABLE_NAME_SIZE - 1)));
+	uint64_t numEntries = values.size();
+	uint32_t maxPlies = static_cast<uint32_t>(maxValue >= CHESS_ENDGAME_MATED ? GetChessEndgamePlies(maxValue) : 0);
+	for (int byteIndex = 0; byteIndex < 8; ++byteIndex)
+	{
+		header[24 + byteIndex] = static_cast<uint8_t>(numEntries >> (8 * byteIndex));
+	}
+	for (int byteIndex = 0; byteIndex < 4; ++byteIndex)
+	{
+		header[4 + byteIndex] = static_cast<uint8_t>(ENDGAME_TABLE_VERSION >> (8 * byteIndex));
+		header[32 + byteIndex] = static_cast<uint8_t>(static_cast<uint32_t>(bitsPerEntry) >> (8 * byteIndex));
+		header[36 + byteIndex] = static_cast<uint8_t>(maxPlies >> (8 * byteIndex));
+	}
+
+	std::vector<uint8_t> packed((numEntries * bitsPerEntry + 7) / 8 + 1, 0);
+	uint64_t bitOffset = 0;
+	for (uint8_t value : values)
+	{
+		uint32_t shifted = static_cast<uint32_t>(value) << (bitOffset & 7);
+		packed[bitOffset >> 3] |= static_cast<uint8_t>(shifted);
+		packed[(bitOffset >> 3) + 1] |= static_cast<uint8_t>(shifted >> 8);
+		bitOffset += bitsPerEntry;
+	}
+
+	FILE* tableFile = fopen(filePath.c_str(), "wb");
+	if (tableFile == nullptr)
+	{
+		return false;
+	}
+	bool isWritten = fwrite(header, 1, sizeof(header), tableFile) == sizeof(header) && fwrite(packed.data(), 1, packed.size(), tableFile) == packed.size();
+	return (fclose(tableFile) == 0) && isWritten;
+}
+
+// -----------------------------------------------------------------------------
+ChessEndgameTable::ChessEndgameTable(std::string const& filePath, ChessEndgameMaterial const& material)
+	: m_filePath(filePath)
+	, m_material(material)
+{
+}
+
+bool ChessEndgameTable::Map()
+{
+	if (m_isReady.load(std::memory_order_acquire))
+	{
+		return true;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mapMutex);
+	if (m_isReady.load(std::memory_order_relaxed))
+	{
+		return true;
+	}
+	if (m_isBroken)
+	{
+		return false;
+	}
+
+	m_isBroken = true;
+	if (!m_file.Open(m_filePath) || m_file.GetSize() < static_cast<size_t>(CHESS_ENDGAME_HEADER_SIZE))
+	{
+		return false;
+	}
+
+	uint8_t const* header = m_file.GetData();
+	char name[ENDGAME_TABLE_NAME_SIZE] = {};
+	memcpy(name, header + 8, ENDGAME_TABLE_NAME_SIZE - 1);
+	uint64_t numEntries = static_cast<uint64_t>(ReadLittleEndian32(header + 24)) | (static_cast<uint64_t>(ReadLittleEndian32(header + 28)) << 32);
+	int bitsPerEntry = static_cast<int>(ReadLittleEndian32(header + 32));
+	bool isValid = memcmp(header, ENDGAME_TABLE_MAGIC, sizeof(ENDGAME_TABLE_MAGIC)) == 0 && ReadLittleEndian32(header + 4) == ENDGAME_TABLE_VERSION &&
+		m_material.GetName() == name && numEntries == m_material.GetNumEntries() && bitsPerEntry >= 1 && bitsPerEntry <= 8 &&
+		m_file.GetSize() >= CHESS_ENDGAME_HEADER_SIZE + (numEntries * bitsPerEntry + 7) / 8 + 1;
+	if (!isValid)
+	{
+		m_file.Close();
+		return false;
+	}
+
+	m_numEntries = numEntries;
+	m_bitsPerEntry = bitsPerEntry;
+	m_isBroken = false;
+	m_isReady.store(true, std::memory_order_release);
+	return true;
+}
+
+uint8_t ChessEndgameTable::GetValue(uint64_t index) const
+{
+	if (index >= m_numEntries)
+	{
+		return CHESS_ENDGAME_ILLEGAL;
+	}
+	uint64_t bitOffset = index * m_bitsPerEntry;
+	uint8_t const* bytes = m_file.GetData() + CHESS_ENDGAME_HEADER_SIZE + (bitOffset >> 3);
+	uint32_t word = bytes[0] | (static_cast<uint32_t>(bytes[1]) << 8);
+	return static_cast<uint8_t>((word >> (bitOffset & 7)) & ((1u << m_bitsPerEntry) - 1));
+}
+
+bool ChessEndgameTable::Probe(ChessPosition const& position, uint8_t& out_value)
+{
+	uint64_t index = 0;
+	if (!Map() || !GetChessEndgameIndex(m_material, position, index))
+	{
+		return false;
+	}
+	out_value = GetValue(index);
+	return out_value != CHESS_ENDGAME_ILLEGAL;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include "Game/ChessMappedFile.hpp"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+constexpr int	  CHESS_ENDGAME_MAX_PIECES = 5;
+constexpr int	  CHESS_ENDGAME_HEADER_SIZE = 64;
+constexpr char	  CHESS_ENDGAME_FILE_EXTENSION[] = ".ctb";
+constexpr int	  CHESS_ENDGAME_NUM_PIECE_TYPES = static_cast<int>(ChessPieceType::NUM_CHESSPIECETYPES);
+// -----------------------------------------------------------------------------
+// Stored values: 0 is a draw, 1 an impossible placement, otherwise 2 + plies to mate. Odd ply
+// counts are wins for the side to move and even ones losses, so 2 itself means "checkmated".
+// -----------------------------------------------------------------------------
+constexpr uint8_t CHESS_ENDGAME_DRAW = 0;
+constexpr uint8_t CHESS_ENDGAME_ILLEGAL = 1;
+constexpr uint8_t CHESS_ENDGAME_MATED = 2;
+constexpr int	  CHESS_ENDGAME_MAX_PLIES = 255 - CHESS_ENDGAME_MATED;
+// -----------------------------------------------------------------------------
+inline bool IsChessEndgameResult(uint8_t value)		{ return value >= CHESS_ENDGAME_MATED; }
+inline int	GetChessEndgamePlies(uint8_t value)		{ return value - CHESS_ENDGAME_MATED; }
+inline bool IsChessEndgameWin(uint8_t value)		{ return value > CHESS_ENDGAME_MATED && (GetChessEndgamePlies(value) & 1) != 0; }
+inline bool IsChessEndgameLoss(uint8_t value)		{ return value >= CHESS_ENDGAME_MATED && (GetChessEndgamePlies(value) & 1) == 0; }
+// -----------------------------------------------------------------------------
+// Which pieces a table covers, e.g. "KBNvK". Tables are stored with the stronger side as white;
+// positions with the colours the other way round are mirrored onto them when probing.
+// -----------------------------------------------------------------------------
+struct ChessEndgameMaterial
+{
+public:
+	bool		SetFromName(std::string const& name);
+	void		SetFromPosition(ChessPosition const& position);
+	std::string GetName() const;
+
+	ChessEndgameMaterial GetColorFlipped() const;
+	ChessEndgameMaterial GetCanonical() const;
+	bool				 IsCanonical() const;
+	bool				 HasPawns() const;
+	int					 GetNumPieces() const;
+	uint64_t			 GetNumEntries() const;
+
+	bool operator==(ChessEndgameMaterial const& other) const;
+	bool operator!=(ChessEndgameMaterial const& other) const { return !(*this == other); }
+
+public:
+	int m_counts[CHESS_NUM_PLAYERS][CHESS_ENDGAME_NUM_PIECE_TYPES] = {};
+};
+// -----------------------------------------------------------------------------
+// Index layout: side to move, the white king folded into a1-d1-d4 (or the a-d files when there
+// are pawns), then one 64-square slot for the black king and every other piece.
+// SetChessEndgamePosition fails for overlapping pieces and pawns on the back ranks; whether
+// the side not to move is in check is left to the caller.
+// -----------------------------------------------------------------------------
+bool GetChessEndgameIndex(ChessEndgameMaterial const& material, ChessPosition const& position, uint64_t& out_index);
+bool SetChessEndgamePosition(ChessEndgameMaterial const& material, uint64_t index, ChessPosition& out_position);
+bool WriteChessEndgameTableFile(std::string const& filePath, ChessEndgameMaterial const& material, std::vector<uint8_t> const& values);
+// -----------------------------------------------------------------------------
+// A generated distance-to-mate table (.ctb): a 64 byte header followed by the values packed
+// at the fewest bits the longest mate needs. The file is mapped on first use and read in place.
+// -----------------------------------------------------------------------------
+class ChessEndgameTable
+{
+public:
+	ChessEndgameTable(std::string const& filePath, ChessEndgameMaterial const& material);
+
+	std::string const&			GetFilePath() const { return m_filePath; }
+	ChessEndgameMaterial const& GetMaterial() const { return m_material; }
+
+	// Thread safe; false when the file is missing or does not match its name
+	bool	Map();
+	uint8_t GetValue(uint64_t index) const;
+
+	// Value for a position of this table's material, from its side to move
+	bool	Probe(ChessPosition const& position, uint8_t& out_value);
+
+private:
+	std::string			 m_filePath;
+	ChessEndgameMaterial m_material;
+	ChessMappedFile		 m_file;
+	std::atomic<bool>	 m_isReady = false;
+	bool				 m_isBroken = false;
+	std::mutex			 m_mapMutex;
+	uint64_t			 m_numEntries = 0;
+	int					 m_bitsPerEntry = 0;
+};
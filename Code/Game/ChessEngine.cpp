@@ -0,0 +1,104 @@
+#include "Game/ChessEngine.hpp"
+#include "Game/ChessAlphaBetaEngine.hpp"
+#include "Game/ChessMCTSEngine.hpp"
+#include "Game/ChessEvaluation.hpp"
+#include "Game/ChessTablebase.hpp"
+#include <algorithm>
+
+// -----------------------------------------------------------------------------
+constexpr int   CLOCK_DEFAULT_MOVES_TO_GO = 30;		// Sudden death games are budgeted as if this many moves remain
+constexpr float CLOCK_MAX_TIME_FRACTION = 0.5f;		// Never spend more than this share of the clock on one move
+// -----------------------------------------------------------------------------
+
+ChessEngineType GetChessEngineTypeForName(std::string const& engineName)
+{
+	if (engineName == "alphabeta" || engineName == "ab")
+	{
+		return ChessEngineType::ALPHA_BETA;
+	}
+	if (engineName == "mcts")
+	{
+		return ChessEngineType::MCTS;
+	}
+	return ChessEngineType::NONE;
+}
+
+char const* GetChessEngineTypeName(ChessEngineType engineType)
+{
+	switch (engineType)
+	{
+		case ChessEngineType::ALPHA_BETA:	return "alphabeta";
+		case ChessEngineType::MCTS:			return "mcts";
+		default:							return "human";
+	}
+}
+
+ChessMCTSPolicyType GetChessMCTSPolicyTypeForName(std::string const& policyName)
+{
+	if (policyName == "rollout")
+	{
+		return ChessMCTSPolicyType::ROLLOUT;
+	}
+	return ChessMCTSPolicyType::EVALUATION;
+}
+
+char const* GetChessMCTSPolicyTypeName(ChessMCTSPolicyType policyType)
+{
+	switch (policyType)
+	{
+		case ChessMCTSPolicyType::ROLLOUT:		return "rollout";
+		case ChessMCTSPolicyType::EVALUATION:	return "evaluation";
+		default:								return "unknown";
+	}
+}
+
+float GetChessMoveSecondsForClock(float remainingSeconds, float incrementSeconds, int movesToGo)
+{
+	// An even share of the clock plus most of the increment, never more than half of what is left
+	int numMoves = (movesToGo > 0) ? movesToGo : CLOCK_DEFAULT_MOVES_TO_GO;
+	float usableSeconds = std::max(0.f, remainingSeconds);
+	float moveSeconds = usableSeconds / static_cast<float>(numMoves) + 0.75f * incrementSeconds;
+	moveSeconds = std::min(moveSeconds, usableSeconds * CLOCK_MAX_TIME_FRACTION);
+	return std::max(0.001f, moveSeconds);
+}
+
+ChessEngine* ChessEngine::CreateEngine(ChessEngineType engineType)
+{
+	switch (engineType)
+	{
+		case ChessEngineType::ALPHA_BETA:	return new ChessAlphaBetaEngine();
+		case ChessEngineType::MCTS:			return new ChessMCTSEngine();
+		default:							return nullptr;
+	}
+}
+
+bool ChessEngine::ProbeTablebaseRoot(ChessPosition const& position, ChessSearchResult& out_result)
+{
+	if (!m_useTablebases)
+	{
+		return false;
+	}
+
+	// Generated tables know the distance to mate, so their wins are reported as real mate scores
+	ChessMove move;
+	ChessWDLScore wdl = ChessWDLScore::DRAW;
+	int pliesToMate = 0;
+	int dtz = 0;
+	if (g_chessTablebases.ProbeRootDTM(position, move, wdl, pliesToMate))
+	{
+		out_result.m_score = (wdl == ChessWDLScore::WIN) ? CHESS_MATE_SCORE - pliesToMate : ((wdl == ChessWDLScore::LOSS) ? -CHESS_MATE_SCORE + pliesToMate : 0);
+	}
+	else if (g_chessTablebases.ProbeRoot(position, move, wdl, dtz))
+	{
+		out_result.m_score = GetChessTablebaseScore(wdl, abs(dtz));
+	}
+	else
+	{
+		return false;
+	}
+
+	m_tablebaseHits += 1;
+	out_result.m_bestMove = move;
+	out_result.m_tablebaseHits = m_tablebaseHits;
+	return true;
+}
\ No newline at end of file
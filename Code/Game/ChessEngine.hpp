@@ -0,0 +1,82 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+// -----------------------------------------------------------------------------
+enum class ChessEngineType
+{
+	NONE = -1,		// Human controlled
+	ALPHA_BETA,
+	MCTS,
+	COUNT
+};
+ChessEngineType GetChessEngineTypeForName(std::string const& engineName);
+char const*		GetChessEngineTypeName(ChessEngineType engineType);
+// -----------------------------------------------------------------------------
+enum class ChessMCTSPolicyType
+{
+	ROLLOUT,		// Random capture-biased playouts, scored by the evaluation at the horizon
+	EVALUATION,		// Static evaluation + quiescence at the leaf, no playout
+	COUNT
+};
+ChessMCTSPolicyType GetChessMCTSPolicyTypeForName(std::string const& policyName);
+char const*			GetChessMCTSPolicyTypeName(ChessMCTSPolicyType policyType);
+// -----------------------------------------------------------------------------
+// Seconds to spend on one move from a running clock; movesToGo 0 means sudden death
+float GetChessMoveSecondsForClock(float remainingSeconds, float incrementSeconds, int movesToGo);
+// -----------------------------------------------------------------------------
+struct ChessSearchLimits
+{
+public:
+	float	 m_maxSeconds = 1.f;
+	int		 m_maxDepth = 64;
+	uint64_t m_maxNodes = 0;		// 0 = unlimited
+	int		 m_numThreads = 1;
+	ChessMCTSPolicyType m_mctsPolicy = ChessMCTSPolicyType::EVALUATION;
+	bool	 m_useOpeningBook = true;	// Play from the match's opening book while it has a move
+	bool	 m_useTablebases = true;	// Probe g_chessTablebases at the root and in the tree
+};
+// -----------------------------------------------------------------------------
+struct ChessSearchResult
+{
+public:
+	ChessMove m_bestMove;
+	int		  m_score = 0;			// Centipawns from the side to move, or mate scores near CHESS_MATE_SCORE
+	int		  m_depth = 0;
+	uint64_t  m_nodes = 0;
+	float	  m_seconds = 0.f;
+	uint64_t  m_tablebaseHits = 0;
+	float	  m_bestMoveSeconds = 0.f;	// When the search settled on m_bestMove and never changed its mind again...
+	uint64_t  m_bestMoveNodes = 0;		// ...and how many nodes it had searched by then
+
+public:
+	bool	HasMove() const { return !m_bestMove.IsNull(); }
+	float	GetNodesPerSecond() const { return (m_seconds > 0.f) ? static_cast<float>(m_nodes) / m_seconds : 0.f; }
+};
+// -----------------------------------------------------------------------------
+// Base class for every search mode a ChessPlayer can select.
+// Search() blocks the calling thread; RequestStop() may be called from any other thread.
+// -----------------------------------------------------------------------------
+class ChessEngine
+{
+public:
+	virtual ~ChessEngine() = default;
+	virtual ChessSearchResult Search(ChessPosition const& position, ChessSearchLimits const& limits) = 0;
+	virtual ChessEngineType	  GetType() const = 0;
+
+	void RequestStop()			{ m_isStopRequested = true; }
+	bool IsStopRequested() const { return m_isStopRequested; }
+
+	static ChessEngine* CreateEngine(ChessEngineType engineType);
+
+protected:
+	// Fills the result with the mate-optimal move from a generated table, or else the DTZ-optimal
+	// move when the root is in the Syzygy tablebases
+	bool ProbeTablebaseRoot(ChessPosition const& position, ChessSearchResult& out_result);
+
+protected:
+	std::atomic<bool> m_isStopRequested = false;
+	bool m_useTablebases = true;
+	std::atomic<uint64_t> m_tablebaseHits = 0;
+};
@@ -0,0 +1,639 @@
+#include "Game/ChessEvalTuner.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+constexpr double ADAM_BETA1 = 0.9;
+constexpr double ADAM_BETA2 = 0.999;
+constexpr double ADAM_EPSILON = 1e-8;
+constexpr double LN10_OVER_400 = 2.302585092994046 / 400.0;
+// -----------------------------------------------------------------------------
+
+static bool ParseResultToken(std::string_view token, float& out_whiteScore)
+{
+	if (token == "1-0" || token == "1.0")		{ out_whiteScore = 1.f;  return true; }
+	if (token == "0-1" || token == "0.0")		{ out_whiteScore = 0.f;  return true; }
+	if (token == "1/2-1/2" || token == "0.5")	{ out_whiteScore = 0.5f; return true; }
+	return false;
+}
+
+static double GetScaledWinProbability(double whiteScore, double scalingConstant)
+{
+	return 1.0 / (1.0 + std::pow(10.0, -scalingConstant * whiteScore / 400.0));
+}
+
+ChessTuningCorpusReader::ChessTuningCorpusReader(std::vector<std::string> const& filePaths, int skipOpeningPlies)
+	:m_filePaths(filePaths),
+	 m_skipOpeningPlies(skipOpeningPlies)
+{
+}
+
+ChessCorpusFileType ChessTuningCorpusReader::GetFileTypeForPath(std::string const& filePath)
+{
+	size_t extensionStart = filePath.find_last_of('.');
+	std::string extension = (extensionStart == std::string::npos) ? "" : filePath.substr(extensionStart);
+	if (extension == ".pgn")
+	{
+		return ChessCorpusFileType::PGN;
+	}
+	if (extension == ".xml")
+	{
+		return ChessCorpusFileType::SAVED_MATCH;
+	}
+	return ChessCorpusFileType::LABELLED_FEN;
+}
+
+void ChessTuningCorpusReader::Rewind()
+{
+	m_file.close();
+	m_file.clear();
+	m_fileIndex = -1;
+	m_pendingSamples.clear();
+	m_numPendingRead = 0;
+	m_numRejectedRecords = 0;
+}
+
+bool ChessTuningCorpusReader::OpenNextFile()
+{
+	m_file.close();
+	m_file.clear();
+	while (++m_fileIndex < static_cast<int>(m_filePaths.size()))
+	{
+		std::string const& filePath = m_filePaths[m_fileIndex];
+		m_fileType = GetFileTypeForPath(filePath);
+		if (m_fileType == ChessCorpusFileType::SAVED_MATCH)
+		{
+			// Saved matches are a handful of moves each, so the whole file is one pending game
+			if (ReadSavedMatch(filePath))
+			{
+				return true;
+			}
+			continue;
+		}
+
+		m_file.open(filePath, std::ios::in | std::ios::binary);
+		if (m_file.is_open())
+		{
+			return true;
+		}
+		printf("WARNING: could not open corpus file \"%s\"\n", filePath.c_str());
+	}
+	return false;
+}
+
+int ChessTuningCorpusReader::ReadBatch(std::vector<ChessTuningSample>& out_samples, int maxSamples)
+{
+	if (static_cast<int>(out_samples.size()) < maxSamples)
+	{
+		out_samples.resize(maxSamples);
+	}
+
+	int numSamples = 0;
+	while (numSamples < maxSamples)
+	{
+		if (m_numPendingRead < m_pendingSamples.size())
+		{
+			out_samples[numSamples++] = m_pendingSamples[m_numPendingRead++];
+			continue;
+		}
+		m_pendingSamples.clear();
+		m_numPendingRead = 0;
+
+		bool hasRecord = false;
+		if (m_fileIndex >= 0 && m_fileIndex < static_cast<int>(m_filePaths.size()))
+		{
+			if (m_fileType == ChessCorpusFileType::LABELLED_FEN)
+			{
+				hasRecord = ReadLabelledFENLine(out_samples[numSamples]);
+				if (hasRecord)
+				{
+					++numSamples;
+				}
+			}
+			else if (m_fileType == ChessCorpusFileType::PGN)
+			{
+				hasRecord = ReadNextPGNGame();
+			}
+		}
+
+		if (!hasRecord && !OpenNextFile())
+		{
+			break;
+		}
+	}
+	return numSamples;
+}
+
+bool ChessTuningCorpusReader::ReadLabelledFENLine(ChessTuningSample& out_sample)
+{
+	while (std::getline(m_file, m_line))
+	{
+		if (m_line.empty() || m_line[0] == '#')
+		{
+			continue;
+		}
+
+		char const* operations = nullptr;
+		if (!out_sample.m_position.SetFromFEN(m_line.c_str(), &operations))
+		{
+			++m_numRejectedRecords;
+			continue;
+		}
+
+		// The label is the first result-looking token after the FEN, quoted or bracketed or not
+		bool hasLabel = false;
+		std::string_view rest(operations);
+		while (!rest.empty() && !hasLabel)
+		{
+			size_t tokenStart = rest.find_first_not_of(" \t\r\n\"[];");
+			if (tokenStart == std::string_view::npos)
+			{
+				break;
+			}
+			rest.remove_prefix(tokenStart);
+			size_t tokenEnd = rest.find_first_of(" \t\r\n\"[];");
+			std::string_view token = rest.substr(0, tokenEnd);
+			hasLabel = ParseResultToken(token, out_sample.m_whiteScore);
+			rest.remove_prefix((tokenEnd == std::string_view::npos) ? rest.size() : tokenEnd);
+		}
+		if (!hasLabel)
+		{
+			++m_numRejectedRecords;
+			continue;
+		}
+		return true;
+	}
+	return false;
+}
+
+void ChessTuningCorpusReader::AddGamePosition(ChessPosition const& position, int ply)
+{
+	// Positions in check are tactical noise for a static evaluation
+	if (ply < m_skipOpeningPlies || position.GetKingSquare(0) == CHESS_NO_SQUARE || position.GetKingSquare(1) == CHESS_NO_SQUARE ||
+		position.IsInCheck(position.GetSideToMove()))
+	{
+		return;
+	}
+	ChessTuningSample sample;
+	sample.m_position = position;
+	m_pendingSamples.push_back(sample);
+}
+
+void ChessTuningCorpusReader::LabelPendingGame(float whiteScore)
+{
+	for (ChessTuningSample& sample : m_pendingSamples)
+	{
+		sample.m_whiteScore = whiteScore;
+	}
+	m_numPendingRead = 0;
+}
+
+bool ChessTuningCorpusReader::ReadNextPGNGame()
+{
+	ChessPosition position = ChessPosition::GetStartingPosition();
+	int ply = 0;
+	int commentDepth = 0;
+	int variationDepth = 0;
+	bool isInMoveText = false;
+	bool isGameValid = true;
+	m_pendingSamples.clear();
+
+	std::streampos lineStart = m_file.tellg();
+	while (std::getline(m_file, m_line))
+	{
+		std::string_view line(m_line);
+		while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+		{
+			line.remove_suffix(1);
+		}
+
+		if (commentDepth == 0 && !line.empty() && line[0] == '[')
+		{
+			// A tag after movetext means the previous game had no result token
+			if (isInMoveText)
+			{
+				m_file.seekg(lineStart);
+				++m_numRejectedRecords;
+				m_pendingSamples.clear();
+				return true;
+			}
+			if (line.compare(0, 5, "[FEN ") == 0)
+			{
+				size_t quoteStart = line.find('"');
+				size_t quoteEnd = line.rfind('"');
+				std::string fen(line.substr(quoteStart + 1, quoteEnd - quoteStart - 1));
+				isGameValid = (quoteStart != quoteEnd) && position.SetFromFEN(fen.c_str());
+			}
+			lineStart = m_file.tellg();
+			continue;
+		}
+
+		size_t cursor = 0;
+		while (cursor < line.size())
+		{
+			char glyph = line[cursor];
+			if (commentDepth > 0)
+			{
+				commentDepth -= (glyph == '}') ? 1 : 0;
+				++cursor;
+				continue;
+			}
+			if (glyph == '{')	{ ++commentDepth;	++cursor; continue; }
+			if (glyph == ';')	{ break; }
+			if (glyph == '(')	{ ++variationDepth; ++cursor; continue; }
+			if (glyph == ')')	{ --variationDepth; ++cursor; continue; }
+			if (glyph == ' ' || glyph == '\t')
+			{
+				++cursor;
+				continue;
+			}
+
+			size_t tokenEnd = line.find_first_of(" \t{}();", cursor);
+			std::string_view token = line.substr(cursor, (tokenEnd == std::string_view::npos) ? std::string_view::npos : tokenEnd - cursor);
+			cursor = (tokenEnd == std::string_view::npos) ? line.size() : tokenEnd;
+			isInMoveText = true;
+
+			if (variationDepth > 0 || token[0] == '$')
+			{
+				continue;
+			}
+
+			float whiteScore = 0.5f;
+			if (ParseResultToken(token, whiteScore) || token == "*")
+			{
+				if (token == "*" || !isGameValid)
+				{
+					++m_numRejectedRecords;
+					m_pendingSamples.clear();
+				}
+				else
+				{
+					LabelPendingGame(whiteScore);
+				}
+				return true;
+			}
+
+			// Move numbers may be glued to the move ("12.e4", "12...e5")
+			while (!token.empty() && ((token[0] >= '0' && token[0] <= '9') || token[0] == '.'))
+			{
+				token.remove_prefix(1);
+			}
+			if (token.empty() || !isGameValid)
+			{
+				continue;
+			}
+
+			ChessMove move;
+			if (!position.FindMoveForSAN(token, move))
+			{
+				isGameValid = false;
+				continue;
+			}
+			position.MakeMove(move);
+			++ply;
+			AddGamePosition(position, ply);
+		}
+		lineStart = m_file.tellg();
+	}
+
+	// End of file without a result token
+	if (isInMoveText)
+	{
+		++m_numRejectedRecords;
+	}
+	m_pendingSamples.clear();
+	return false;
+}
+
+bool ChessTuningCorpusReader::ReadSavedMatch(std::string const& filePath)
+{
+	XmlDocument xmlDocument;
+	if (xmlDocument.LoadFile(filePath.c_str()) != tinyxml2::XML_SUCCESS || xmlDocument.RootElement() == nullptr)
+	{
+		printf("WARNING: could not load saved match \"%s\"\n", filePath.c_str());
+		return false;
+	}
+
+	ChessPosition position = ChessPosition::GetStartingPosition();
+	int ply = 0;
+	m_pendingSamples.clear();
+	XmlElement* root = xmlDocument.RootElement();
+	for (XmlElement* moveElement = root->FirstChildElement("Move"); moveElement != nullptr; moveElement = moveElement->NextSiblingElement("Move"))
+	{
+		// Move text is the console command, e.g. "ChessMove from=e7 to=e8 promoteTo=queen"
+		char const* moveCommand = moveElement->GetText();
+		char const* fromText = (moveCommand != nullptr) ? strstr(moveCommand, "from=") : nullptr;
+		char const* toText = (moveCommand != nullptr) ? strstr(moveCommand, "to=") : nullptr;
+		char const* promotionText = (moveCommand != nullptr) ? strstr(moveCommand, "promoteTo=") : nullptr;
+		if (fromText == nullptr || toText == nullptr || strstr(moveCommand, "teleport=true") != nullptr)
+		{
+			++m_numRejectedRecords;
+			m_pendingSamples.clear();
+			return false;
+		}
+
+		ChessPieceType promotionType = ChessPieceType::QUEEN;
+		if (promotionText != nullptr)
+		{
+			promotionText += 10;
+			promotionType = (strncmp(promotionText, "rook", 4) == 0) ? ChessPieceType::ROOK :
+				(strncmp(promotionText, "bishop", 6) == 0) ? ChessPieceType::BISHOP :
+				(strncmp(promotionText, "knight", 6) == 0) ? ChessPieceType::KNIGHT : ChessPieceType::QUEEN;
+		}
+
+		ChessMove move;
+		if (!position.FindPseudoLegalMove(GetChessSquareForNotation(fromText + 5), GetChessSquareForNotation(toText + 3), promotionType, move))
+		{
+			++m_numRejectedRecords;
+			m_pendingSamples.clear();
+			return false;
+		}
+		position.MakeMove(move);
+		++ply;
+		AddGamePosition(position, ply);
+	}
+
+	// Saved matches carry no result tag; only finished games are usable
+	float whiteScore = 0.5f;
+	if (position.GetKingSquare(0) == CHESS_NO_SQUARE)		whiteScore = 0.f;
+	else if (position.GetKingSquare(1) == CHESS_NO_SQUARE)	whiteScore = 1.f;
+	else if (position.IsCheckmate())						whiteScore = (position.GetSideToMove() == 0) ? 0.f : 1.f;
+	else if (!position.IsStalemate() && !position.IsInsufficientMaterial())
+	{
+		++m_numRejectedRecords;
+		m_pendingSamples.clear();
+		return false;
+	}
+	LabelPendingGame(whiteScore);
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+ChessEvalTuner::ChessEvalTuner(ChessTunerSettings const& settings, ChessEvalWeights const& initialWeights)
+	:m_settings(settings),
+	 m_reader(settings.m_corpusFiles, settings.m_skipOpeningPlies),
+	 m_weights(initialWeights)
+{
+	m_numThreads = (settings.m_numThreads > 0) ? settings.m_numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	m_scalingConstant = (settings.m_scalingConstant > 0.f) ? settings.m_scalingConstant : 1.0;
+
+	int numParameters = ChessEvalWeights::GetNumParameters();
+	m_parameters.resize(numParameters);
+	m_firstMoments.assign(numParameters, 0.0);
+	m_secondMoments.assign(numParameters, 0.0);
+	for (int parameterIndex = 0; parameterIndex < numParameters; ++parameterIndex)
+	{
+		m_parameters[parameterIndex] = static_cast<double>(m_weights.GetParameter(parameterIndex));
+	}
+}
+
+bool ChessEvalTuner::Run()
+{
+	if (m_settings.m_corpusFiles.empty())
+	{
+		printf("ERROR: no corpus files given\n");
+		return false;
+	}
+
+	if (m_settings.m_scalingConstant <= 0.f)
+	{
+		m_scalingConstant = FitScalingConstant();
+		printf("Fitted scaling constant K = %.4f\n", m_scalingConstant);
+	}
+
+	double initialError = ComputeCorpusError(m_weights, m_scalingConstant);
+	printf("Initial error %.7f over %llu positions (%d records rejected)\n", initialError, static_cast<unsigned long long>(m_numPositionsSeen), m_reader.GetNumRejectedRecords());
+	if (m_numPositionsSeen == 0)
+	{
+		printf("ERROR: the corpus has no usable labelled positions\n");
+		return false;
+	}
+
+	for (int epochIndex = 0; epochIndex < m_settings.m_numEpochs; ++epochIndex)
+	{
+		auto epochStartTime = std::chrono::steady_clock::now();
+		double error = RunEpoch();
+		float epochSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - epochStartTime).count();
+		printf("Epoch %d: error %.7f, %llu positions in %.1fs (%.0f positions/s)\n", epochIndex + 1, error,
+			static_cast<unsigned long long>(m_numPositionsSeen), epochSeconds, static_cast<float>(m_numPositionsSeen) / std::max(epochSeconds, 0.001f));
+
+		// Written every epoch so a long run can be stopped at any point
+		if (!m_weights.SaveToXmlFile(m_settings.m_outputFile))
+		{
+			printf("ERROR: failed to write tuned weights to \"%s\"\n", m_settings.m_outputFile.c_str());
+			return false;
+		}
+	}
+
+	printf("Final error %.7f, tuned weights written to %s\n", ComputeCorpusError(m_weights, m_scalingConstant), m_settings.m_outputFile.c_str());
+	return true;
+}
+
+double ChessEvalTuner::FitScalingConstant()
+{
+	// Only the evaluations are kept, so the sample stays small while K is searched over it
+	std::vector<std::pair<int, float>> scoredSamples;
+	std::vector<ChessTuningSample> batch;
+	m_reader.Rewind();
+	while (static_cast<int>(scoredSamples.size()) < m_settings.m_scalingSamplePositions)
+	{
+		int numSamples = m_reader.ReadBatch(batch, m_settings.m_batchSize);
+		if (numSamples == 0)
+		{
+			break;
+		}
+		for (int sampleIndex = 0; sampleIndex < numSamples; ++sampleIndex)
+		{
+			ChessPosition const& position = batch[sampleIndex].m_position;
+			int score = EvaluateChessPosition(position, m_weights);
+			scoredSamples.emplace_back((position.GetSideToMove() == 0) ? score : -score, batch[sampleIndex].m_whiteScore);
+		}
+	}
+	if (scoredSamples.empty())
+	{
+		return 1.0;
+	}
+
+	auto computeError = [&scoredSamples](double scalingConstant)
+	{
+		double errorSum = 0.0;
+		for (std::pair<int, float> const& scoredSample : scoredSamples)
+		{
+			double difference = scoredSample.second - GetScaledWinProbability(scoredSample.first, scalingConstant);
+			errorSum += difference * difference;
+		}
+		return errorSum / static_cast<double>(scoredSamples.size());
+	};
+
+	// Golden-section search; the error is unimodal in K
+	double const goldenRatio = 0.6180339887498949;
+	double low = 0.1;
+	double high = 3.0;
+	double lowProbe = high - goldenRatio * (high - low);
+	double highProbe = low + goldenRatio * (high - low);
+	double lowError = computeError(lowProbe);
+	double highError = computeError(highProbe);
+	while (high - low > 0.0005)
+	{
+		if (lowError < highError)
+		{
+			high = highProbe;
+			highProbe = lowProbe;
+			highError = lowError;
+			lowProbe = high - goldenRatio * (high - low);
+			lowError = computeError(lowProbe);
+		}
+		else
+		{
+			low = lowProbe;
+			lowProbe = highProbe;
+			lowError = highError;
+			highProbe = low + goldenRatio * (high - low);
+			highError = computeError(highProbe);
+		}
+	}
+	return 0.5 * (low + high);
+}
+
+double ChessEvalTuner::ComputeCorpusError(ChessEvalWeights const& weights, double scalingConstant)
+{
+	std::vector<ChessTuningSample> batches[2];
+	std::vector<float> unusedGradient;
+	double errorSum = 0.0;
+	m_numPositionsSeen = 0;
+	m_reader.Rewind();
+
+	// The next batch is read while the workers score the current one
+	int currentBatch = 0;
+	int numSamples = m_reader.ReadBatch(batches[currentBatch], m_settings.m_batchSize);
+	while (numSamples > 0)
+	{
+		std::future<int> nextBatch = std::async(std::launch::async, [this, &batches, currentBatch]()
+		{
+			return m_reader.ReadBatch(batches[1 - currentBatch], m_settings.m_batchSize);
+		});
+
+		double batchErrorSum = 0.0;
+		ProcessBatch(batches[currentBatch], numSamples, weights, scalingConstant, false, batchErrorSum, unusedGradient);
+		errorSum += batchErrorSum;
+		m_numPositionsSeen += numSamples;
+
+		numSamples = nextBatch.get();
+		currentBatch = 1 - currentBatch;
+	}
+	return (m_numPositionsSeen > 0) ? errorSum / static_cast<double>(m_numPositionsSeen) : 0.0;
+}
+
+double ChessEvalTuner::RunEpoch()
+{
+	std::vector<ChessTuningSample> batches[2];
+	std::vector<float> gradient(ChessEvalWeights::GetNumParameters());
+	double errorSum = 0.0;
+	m_numPositionsSeen = 0;
+	m_reader.Rewind();
+
+	int currentBatch = 0;
+	int numSamples = m_reader.ReadBatch(batches[currentBatch], m_settings.m_batchSize);
+	while (numSamples > 0)
+	{
+		std::future<int> nextBatch = std::async(std::launch::async, [this, &batches, currentBatch]()
+		{
+			return m_reader.ReadBatch(batches[1 - currentBatch], m_settings.m_batchSize);
+		});
+
+		double batchErrorSum = 0.0;
+		ProcessBatch(batches[currentBatch], numSamples, m_weights, m_scalingConstant, true, batchErrorSum, gradient);
+		ApplyGradient(gradient, numSamples);
+		errorSum += batchErrorSum;
+		m_numPositionsSeen += numSamples;
+
+		numSamples = nextBatch.get();
+		currentBatch = 1 - currentBatch;
+	}
+	return (m_numPositionsSeen > 0) ? errorSum / static_cast<double>(m_numPositionsSeen) : 0.0;
+}
+
+void ChessEvalTuner::ProcessBatch(std::vector<ChessTuningSample> const& samples, int numSamples, ChessEvalWeights const& weights,
+	double scalingConstant, bool computeGradient, double& out_errorSum, std::vector<float>& out_gradient)
+{
+	int numParameters = ChessEvalWeights::GetNumParameters();
+	int numWorkers = std::min(m_numThreads, std::max(1, numSamples / 256));
+	std::vector<double> workerErrors(numWorkers, 0.0);
+	std::vector<std::vector<float>> workerGradients(computeGradient ? numWorkers : 0, std::vector<float>(numParameters, 0.f));
+
+	auto processRange = [&](int workerIndex)
+	{
+		int firstSample = static_cast<int>(static_cast<int64_t>(numSamples) * workerIndex / numWorkers);
+		int lastSample = static_cast<int>(static_cast<int64_t>(numSamples) * (workerIndex + 1) / numWorkers);
+		double errorSum = 0.0;
+		for (int sampleIndex = firstSample; sampleIndex < lastSample; ++sampleIndex)
+		{
+			ChessTuningSample const& sample = samples[sampleIndex];
+			int score = EvaluateChessPosition(sample.m_position, weights);
+			int whiteScore = (sample.m_position.GetSideToMove() == 0) ? score : -score;
+			double winProbability = GetScaledWinProbability(whiteScore, scalingConstant);
+			double difference = sample.m_whiteScore - winProbability;
+			errorSum += difference * difference;
+
+			if (computeGradient)
+			{
+				// d/dw of (result - sigmoid)^2, chained through the linear evaluation
+				double slope = -2.0 * difference * winProbability * (1.0 - winProbability) * scalingConstant * LN10_OVER_400;
+				AccumulateChessEvalGradient(sample.m_position, static_cast<float>(slope), workerGradients[workerIndex]);
+			}
+		}
+		workerErrors[workerIndex] = errorSum;
+	};
+
+	std::vector<std::thread> workers;
+	for (int workerIndex = 1; workerIndex < numWorkers; ++workerIndex)
+	{
+		workers.emplace_back(processRange, workerIndex);
+	}
+	processRange(0);
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	out_errorSum = 0.0;
+	for (double workerError : workerErrors)
+	{
+		out_errorSum += workerError;
+	}
+	if (computeGradient)
+	{
+		std::fill(out_gradient.begin(), out_gradient.end(), 0.f);
+		for (std::vector<float> const& workerGradient : workerGradients)
+		{
+			for (int parameterIndex = 0; parameterIndex < numParameters; ++parameterIndex)
+			{
+				out_gradient[parameterIndex] += workerGradient[parameterIndex];
+			}
+		}
+	}
+}
+
+void ChessEvalTuner::ApplyGradient(std::vector<float> const& gradient, int numSamples)
+{
+	++m_numSteps;
+	double firstCorrection = 1.0 - std::pow(ADAM_BETA1, m_numSteps);
+	double secondCorrection = 1.0 - std::pow(ADAM_BETA2, m_numSteps);
+
+	for (int parameterIndex = 0; parameterIndex < static_cast<int>(m_parameters.size()); ++parameterIndex)
+	{
+		double meanGradient = gradient[parameterIndex] / static_cast<double>(numSamples);
+		m_firstMoments[parameterIndex] = ADAM_BETA1 * m_firstMoments[parameterIndex] + (1.0 - ADAM_BETA1) * meanGradient;
+		m_secondMoments[parameterIndex] = ADAM_BETA2 * m_secondMoments[parameterIndex] + (1.0 - ADAM_BETA2) * meanGradient * meanGradient;
+
+		double step = (m_firstMoments[parameterIndex] / firstCorrection) / (std::sqrt(m_secondMoments[parameterIndex] / secondCorrection) + ADAM_EPSILON);
+		m_parameters[parameterIndex] -= m_settings.m_learningRate * step;
+		m_weights.GetParameter(parameterIndex) = static_cast<int>(std::lround(m_parameters[parameterIndex]));
+	}
+}
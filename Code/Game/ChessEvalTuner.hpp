@@ -0,0 +1,104 @@
+#pragma once
+#include "Game/ChessEvaluation.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+struct ChessTuningSample
+{
+public:
+	ChessPosition m_position;
+	float		  m_whiteScore = 0.5f;	// 1 white won, 0.5 draw, 0 black won
+};
+// -----------------------------------------------------------------------------
+enum class ChessCorpusFileType
+{
+	LABELLED_FEN,	// One "<fen> <result>" per line, results as 1-0 / [1.0] / c9 "1-0";
+	PGN,
+	SAVED_MATCH,	// Data/SavedGames xml written by ChessMatch::SaveGameToXmlFile
+	COUNT
+};
+// -----------------------------------------------------------------------------
+// Streams labelled positions from the corpus files a batch at a time. At most one game is
+// buffered, so memory stays flat no matter how many positions the corpus holds.
+// -----------------------------------------------------------------------------
+class ChessTuningCorpusReader
+{
+public:
+	ChessTuningCorpusReader(std::vector<std::string> const& filePaths, int skipOpeningPlies);
+
+	void Rewind();
+	int  ReadBatch(std::vector<ChessTuningSample>& out_samples, int maxSamples);
+	int  GetNumRejectedRecords() const { return m_numRejectedRecords; }
+
+	static ChessCorpusFileType GetFileTypeForPath(std::string const& filePath);
+
+private:
+	bool OpenNextFile();
+	bool ReadLabelledFENLine(ChessTuningSample& out_sample);
+	bool ReadNextPGNGame();
+	bool ReadSavedMatch(std::string const& filePath);
+	void AddGamePosition(ChessPosition const& position, int ply);
+	void LabelPendingGame(float whiteScore);
+
+private:
+	std::vector<std::string> m_filePaths;
+	int					m_fileIndex = -1;
+	ChessCorpusFileType m_fileType = ChessCorpusFileType::LABELLED_FEN;
+	std::ifstream		m_file;
+	std::string			m_line;
+	int					m_skipOpeningPlies = 8;
+	int					m_numRejectedRecords = 0;
+
+	std::vector<ChessTuningSample> m_pendingSamples;
+	size_t						   m_numPendingRead = 0;
+};
+// -----------------------------------------------------------------------------
+struct ChessTunerSettings
+{
+public:
+	std::vector<std::string> m_corpusFiles;
+	std::string m_outputFile = "Data/ChessEvalWeights.xml";
+	int			m_numThreads = 0;				// 0 = one per hardware thread
+	int			m_numEpochs = 20;
+	int			m_batchSize = 16384;
+	float		m_learningRate = 1.f;			// Centipawns per step at full Adam confidence
+	float		m_scalingConstant = 0.f;		// Sigmoid K; 0 fits it to the corpus before tuning
+	int			m_skipOpeningPlies = 8;
+	int			m_scalingSamplePositions = 1000000;
+};
+// -----------------------------------------------------------------------------
+// Texel-style tuner: minimises the squared error between game results and the sigmoid of the
+// static evaluation, streaming the corpus once per epoch and using Adam on minibatches.
+// Error and gradients are computed across all worker threads for every batch.
+// -----------------------------------------------------------------------------
+class ChessEvalTuner
+{
+public:
+	ChessEvalTuner(ChessTunerSettings const& settings, ChessEvalWeights const& initialWeights);
+
+	bool   Run();
+	double ComputeCorpusError(ChessEvalWeights const& weights, double scalingConstant);
+	ChessEvalWeights const& GetWeights() const { return m_weights; }
+
+private:
+	double FitScalingConstant();
+	double RunEpoch();
+	void   ProcessBatch(std::vector<ChessTuningSample> const& samples, int numSamples, ChessEvalWeights const& weights,
+						double scalingConstant, bool computeGradient, double& out_errorSum, std::vector<float>& out_gradient);
+	void   ApplyGradient(std::vector<float> const& gradient, int numSamples);
+
+private:
+	ChessTunerSettings		m_settings;
+	ChessTuningCorpusReader m_reader;
+	ChessEvalWeights		m_weights;
+	double					m_scalingConstant = 1.0;
+	int						m_numThreads = 1;
+
+	std::vector<double> m_parameters;
+	std::vector<double> m_firstMoments;
+	std::vector<double> m_secondMoments;
+	int					m_numSteps = 0;
+	uint64_t			m_numPositionsSeen = 0;
+};
@@ -0,0 +1,382 @@
+#include "Game/ChessEvaluation.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// -----------------------------------------------------------------------------
+ChessEvalWeights g_chessEvalWeights = ChessEvalWeights::GetDefaultWeights();
+// -----------------------------------------------------------------------------
+// Default tables are written as seen from white's side of the board: rank 8 first, file a on the left
+// -----------------------------------------------------------------------------
+static int const DEFAULT_PAWN_TABLE[CHESS_BOARD_SIZE] =
+{
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 50,  50,  50,  50,  50,  50,  50,  50,
+	 10,  10,  20,  30,  30,  20,  10,  10,
+	  5,   5,  10,  25,  25,  10,   5,   5,
+	  0,   0,   0,  20,  20,   0,   0,   0,
+	  5,  -5, -10,   0,   0, -10,  -5,   5,
+	  5,  10,  10, -20, -20,  10,  10,   5,
+	  0,   0,   0,   0,   0,   0,   0,   0
+};
+
+static int const DEFAULT_KNIGHT_TABLE[CHESS_BOARD_SIZE] =
+{
+	-50, -40, -30, -30, -30, -30, -40, -50,
+	-40, -20,   0,   0,   0,   0, -20, -40,
+	-30,   0,  10,  15,  15,  10,   0, -30,
+	-30,   5,  15,  20,  20,  15,   5, -30,
+	-30,   0,  15,  20,  20,  15,   0, -30,
+	-30,   5,  10,  15,  15,  10,   5, -30,
+	-40, -20,   0,   5,   5,   0, -20, -40,
+	-50, -40, -30, -30, -30, -30, -40, -50
+};
+
+static int const DEFAULT_BISHOP_TABLE[CHESS_BOARD_SIZE] =
+{
+	-20, -10, -10, -10, -10, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	-10,   5,   5,  10,  10,   5,   5, -10,
+	-10,   0,  10,  10,  10,  10,   0, -10,
+	-10,  10,  10,  10,  10,  10,  10, -10,
+	-10,   5,   0,   0,   0,   0,   5, -10,
+	-20, -10, -10, -10, -10, -10, -10, -20
+};
+
+static int const DEFAULT_ROOK_TABLE[CHESS_BOARD_SIZE] =
+{
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  5,  10,  10,  10,  10,  10,  10,   5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	  0,   0,   0,   5,   5,   0,   0,   0
+};
+
+static int const DEFAULT_QUEEN_TABLE[CHESS_BOARD_SIZE] =
+{
+	-20, -10, -10,  -5,  -5, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,   5,   5,   5,   0, -10,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	  0,   0,   5,   5,   5,   5,   0,  -5,
+	-10,   5,   5,   5,   5,   5,   0, -10,
+	-10,   0,   5,   0,   0,   0,   0, -10,
+	-20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+static int const DEFAULT_KING_MIDDLEGAME_TABLE[CHESS_BOARD_SIZE] =
+{
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-20, -30, -30, -40, -40, -30, -30, -20,
+	-10, -20, -20, -20, -20, -20, -20, -10,
+	 20,  20,   0,   0,   0,   0,  20,  20,
+	 20,  30,  10,   0,   0,  10,  30,  20
+};
+
+static int const DEFAULT_KING_ENDGAME_TABLE[CHESS_BOARD_SIZE] =
+{
+	-50, -40, -30, -20, -20, -30, -40, -50,
+	-30, -20, -10,   0,   0, -10, -20, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -30,   0,   0,   0,   0, -30, -30,
+	-50, -30, -30, -30, -30, -30, -30, -50
+};
+
+static int const PHASE_WEIGHTS[NUM_CHESS_PIECE_TYPES] = { 2, 1, 1, 4, 0, 0 };
+static char const* const PIECE_TYPE_NAMES[NUM_CHESS_PIECE_TYPES] = { "rook", "knight", "bishop", "queen", "king", "pawn" };
+
+// Flat parameter layout: piece values, then tables, then the scalar bonuses
+constexpr int PARAM_MIDDLEGAME_VALUES = 0;
+constexpr int PARAM_ENDGAME_VALUES = PARAM_MIDDLEGAME_VALUES + NUM_CHESS_PIECE_TYPES;
+constexpr int PARAM_MIDDLEGAME_TABLES = PARAM_ENDGAME_VALUES + NUM_CHESS_PIECE_TYPES;
+constexpr int PARAM_ENDGAME_TABLES = PARAM_MIDDLEGAME_TABLES + NUM_CHESS_PIECE_TYPES * CHESS_BOARD_SIZE;
+constexpr int PARAM_BISHOP_PAIR = PARAM_ENDGAME_TABLES + NUM_CHESS_PIECE_TYPES * CHESS_BOARD_SIZE;
+constexpr int PARAM_TEMPO = PARAM_BISHOP_PAIR + 1;
+constexpr int NUM_EVAL_PARAMETERS = PARAM_TEMPO + 1;
+
+// -----------------------------------------------------------------------------
+static void CopyTableFromWhiteView(int const* whiteViewTable, int* out_table)
+{
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		int x = GetChessSquareX(square);
+		int y = GetChessSquareY(square);
+		out_table[square] = whiteViewTable[(7 - y) * CHESS_BOARD_COLUMNS + x];
+	}
+}
+
+ChessEvalWeights ChessEvalWeights::GetDefaultWeights()
+{
+	ChessEvalWeights weights;
+
+	static int const MIDDLEGAME_VALUES[NUM_CHESS_PIECE_TYPES] = { 500, 320, 330, 900, 0, 100 };
+	static int const ENDGAME_VALUES[NUM_CHESS_PIECE_TYPES] = { 520, 300, 320, 930, 0, 120 };
+	for (int typeIndex = 0; typeIndex < NUM_CHESS_PIECE_TYPES; ++typeIndex)
+	{
+		weights.m_middlegamePieceValues[typeIndex] = MIDDLEGAME_VALUES[typeIndex];
+		weights.m_endgamePieceValues[typeIndex] = ENDGAME_VALUES[typeIndex];
+	}
+
+	int const* middlegameTables[NUM_CHESS_PIECE_TYPES] = { DEFAULT_ROOK_TABLE, DEFAULT_KNIGHT_TABLE, DEFAULT_BISHOP_TABLE, DEFAULT_QUEEN_TABLE, DEFAULT_KING_MIDDLEGAME_TABLE, DEFAULT_PAWN_TABLE };
+	int const* endgameTables[NUM_CHESS_PIECE_TYPES] = { DEFAULT_ROOK_TABLE, DEFAULT_KNIGHT_TABLE, DEFAULT_BISHOP_TABLE, DEFAULT_QUEEN_TABLE, DEFAULT_KING_ENDGAME_TABLE, DEFAULT_PAWN_TABLE };
+	for (int typeIndex = 0; typeIndex < NUM_CHESS_PIECE_TYPES; ++typeIndex)
+	{
+		CopyTableFromWhiteView(middlegameTables[typeIndex], weights.m_middlegameTables[typeIndex]);
+		CopyTableFromWhiteView(endgameTables[typeIndex], weights.m_endgameTables[typeIndex]);
+	}
+
+	weights.m_bishopPairBonus = 30;
+	weights.m_tempoBonus = 10;
+	return weights;
+}
+
+int ChessEvalWeights::GetNumParameters()
+{
+	return NUM_EVAL_PARAMETERS;
+}
+
+int& ChessEvalWeights::GetParameter(int parameterIndex)
+{
+	if (parameterIndex < PARAM_ENDGAME_VALUES)		return m_middlegamePieceValues[parameterIndex - PARAM_MIDDLEGAME_VALUES];
+	if (parameterIndex < PARAM_MIDDLEGAME_TABLES)	return m_endgamePieceValues[parameterIndex - PARAM_ENDGAME_VALUES];
+	if (parameterIndex < PARAM_ENDGAME_TABLES)		return (&m_middlegameTables[0][0])[parameterIndex - PARAM_MIDDLEGAME_TABLES];
+	if (parameterIndex < PARAM_BISHOP_PAIR)			return (&m_endgameTables[0][0])[parameterIndex - PARAM_ENDGAME_TABLES];
+	if (parameterIndex == PARAM_BISHOP_PAIR)		return m_bishopPairBonus;
+	return m_tempoBonus;
+}
+
+int ChessEvalWeights::GetParameter(int parameterIndex) const
+{
+	return const_cast<ChessEvalWeights*>(this)->GetParameter(parameterIndex);
+}
+
+static bool ParseTableText(char const* tableText, int* out_table)
+{
+	// Text is rank 8 first, like the default tables above
+	int whiteViewTable[CHESS_BOARD_SIZE];
+	char const* cursor = tableText;
+	for (int valueIndex = 0; valueIndex < CHESS_BOARD_SIZE; ++valueIndex)
+	{
+		char* valueEnd = nullptr;
+		long value = strtol(cursor, &valueEnd, 10);
+		if (valueEnd == cursor)
+		{
+			return false;
+		}
+		whiteViewTable[valueIndex] = static_cast<int>(value);
+		cursor = valueEnd;
+	}
+	CopyTableFromWhiteView(whiteViewTable, out_table);
+	return true;
+}
+
+static std::string GetTableText(int const* table)
+{
+	// Indented to line up inside the Piece element when the document is printed
+	std::string tableText = "\n";
+	for (int y = CHESS_BOARD_ROWS - 1; y >= 0; --y)
+	{
+		tableText += "            ";
+		for (int x = 0; x < CHESS_BOARD_COLUMNS; ++x)
+		{
+			char valueText[16];
+			snprintf(valueText, sizeof(valueText), "%4d", table[GetChessSquare(x, y)]);
+			tableText += valueText;
+			tableText += (x + 1 < CHESS_BOARD_COLUMNS) ? " " : "\n";
+		}
+	}
+	return tableText + "        ";
+}
+
+bool ChessEvalWeights::LoadFromXmlFile(std::string const& filePath)
+{
+	XmlDocument xmlDocument;
+	if (xmlDocument.LoadFile(filePath.c_str()) != tinyxml2::XML_SUCCESS || xmlDocument.RootElement() == nullptr)
+	{
+		return false;
+	}
+
+	// Terms missing from the file keep their current values
+	ChessEvalWeights weights = *this;
+	XmlElement* root = xmlDocument.RootElement();
+	weights.m_bishopPairBonus = root->IntAttribute("bishopPairBonus", weights.m_bishopPairBonus);
+	weights.m_tempoBonus = root->IntAttribute("tempoBonus", weights.m_tempoBonus);
+
+	for (XmlElement* pieceElement = root->FirstChildElement("Piece"); pieceElement != nullptr; pieceElement = pieceElement->NextSiblingElement("Piece"))
+	{
+		char const* typeName = pieceElement->Attribute("type");
+		int typeIndex = 0;
+		while (typeIndex < NUM_CHESS_PIECE_TYPES && (typeName == nullptr || strcmp(typeName, PIECE_TYPE_NAMES[typeIndex]) != 0))
+		{
+			++typeIndex;
+		}
+		if (typeIndex == NUM_CHESS_PIECE_TYPES)
+		{
+			return false;
+		}
+
+		weights.m_middlegamePieceValues[typeIndex] = pieceElement->IntAttribute("middlegameValue", weights.m_middlegamePieceValues[typeIndex]);
+		weights.m_endgamePieceValues[typeIndex] = pieceElement->IntAttribute("endgameValue", weights.m_endgamePieceValues[typeIndex]);
+
+		XmlElement* middlegameElement = pieceElement->FirstChildElement("MiddlegameTable");
+		if (middlegameElement != nullptr && (middlegameElement->GetText() == nullptr || !ParseTableText(middlegameElement->GetText(), weights.m_middlegameTables[typeIndex])))
+		{
+			return false;
+		}
+		XmlElement* endgameElement = pieceElement->FirstChildElement("EndgameTable");
+		if (endgameElement != nullptr && (endgameElement->GetText() == nullptr || !ParseTableText(endgameElement->GetText(), weights.m_endgameTables[typeIndex])))
+		{
+			return false;
+		}
+	}
+
+	*this = weights;
+	return true;
+}
+
+bool ChessEvalWeights::SaveToXmlFile(std::string const& filePath) const
+{
+	XmlDocument xmlDocument;
+	XmlElement* root = xmlDocument.NewElement("ChessEvalWeights");
+	xmlDocument.InsertFirstChild(root);
+	root->SetAttribute("bishopPairBonus", m_bishopPairBonus);
+	root->SetAttribute("tempoBonus", m_tempoBonus);
+
+	for (int typeIndex = 0; typeIndex < NUM_CHESS_PIECE_TYPES; ++typeIndex)
+	{
+		XmlElement* pieceElement = xmlDocument.NewElement("Piece");
+		pieceElement->SetAttribute("type", PIECE_TYPE_NAMES[typeIndex]);
+		pieceElement->SetAttribute("middlegameValue", m_middlegamePieceValues[typeIndex]);
+		pieceElement->SetAttribute("endgameValue", m_endgamePieceValues[typeIndex]);
+
+		XmlElement* middlegameElement = xmlDocument.NewElement("MiddlegameTable");
+		middlegameElement->SetText(GetTableText(m_middlegameTables[typeIndex]).c_str());
+		pieceElement->InsertEndChild(middlegameElement);
+
+		XmlElement* endgameElement = xmlDocument.NewElement("EndgameTable");
+		endgameElement->SetText(GetTableText(m_endgameTables[typeIndex]).c_str());
+		pieceElement->InsertEndChild(endgameElement);
+
+		root->InsertEndChild(pieceElement);
+	}
+
+	return xmlDocument.SaveFile(filePath.c_str()) == tinyxml2::XML_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+int GetChessGamePhase(ChessPosition const& position)
+{
+	int phase = 0;
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = position.m_squares[square];
+		if (pieceCode != CHESS_EMPTY_SQUARE)
+		{
+			phase += PHASE_WEIGHTS[static_cast<int>(GetChessPieceTypeForCode(pieceCode))];
+		}
+	}
+	return (phase > CHESS_MAX_PHASE) ? CHESS_MAX_PHASE : phase;
+}
+
+int EvaluateChessPosition(ChessPosition const& position, ChessEvalWeights const& weights)
+{
+	int middlegameScore = 0;
+	int endgameScore = 0;
+	int bishopCounts[CHESS_NUM_PLAYERS] = { 0, 0 };
+
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = position.m_squares[square];
+		if (pieceCode == CHESS_EMPTY_SQUARE)
+		{
+			continue;
+		}
+
+		int typeIndex = static_cast<int>(GetChessPieceTypeForCode(pieceCode));
+		int playerIndex = GetPlayerIndexForCode(pieceCode);
+		int tableSquare = (playerIndex == 0) ? square : GetChessSquare(GetChessSquareX(square), 7 - GetChessSquareY(square));
+		int sign = (playerIndex == 0) ? 1 : -1;
+
+		middlegameScore += sign * (weights.m_middlegamePieceValues[typeIndex] + weights.m_middlegameTables[typeIndex][tableSquare]);
+		endgameScore += sign * (weights.m_endgamePieceValues[typeIndex] + weights.m_endgameTables[typeIndex][tableSquare]);
+
+		if (typeIndex == static_cast<int>(ChessPieceType::BISHOP))
+		{
+			bishopCounts[playerIndex] += 1;
+		}
+	}
+
+	int bishopPairScore = ((bishopCounts[0] >= 2) ? weights.m_bishopPairBonus : 0) - ((bishopCounts[1] >= 2) ? weights.m_bishopPairBonus : 0);
+	middlegameScore += bishopPairScore;
+	endgameScore += bishopPairScore;
+
+	int phase = GetChessGamePhase(position);
+	int whiteScore = (middlegameScore * phase + endgameScore * (CHESS_MAX_PHASE - phase)) / CHESS_MAX_PHASE;
+	int sideScore = (position.GetSideToMove() == 0) ? whiteScore : -whiteScore;
+	return sideScore + weights.m_tempoBonus;
+}
+
+int GetChessPieceValue(ChessPieceType pieceType)
+{
+	static int const PIECE_VALUES[NUM_CHESS_PIECE_TYPES] = { 500, 320, 330, 900, 20000, 100 };
+	if (pieceType == ChessPieceType::CHESSPIECE_INVALID || pieceType == ChessPieceType::NUM_CHESSPIECETYPES)
+	{
+		return 0;
+	}
+	return PIECE_VALUES[static_cast<int>(pieceType)];
+}
+
+float GetWinProbabilityForScore(int centipawns)
+{
+	return 1.f / (1.f + powf(10.f, -static_cast<float>(centipawns) / 400.f));
+}
+
+void AccumulateChessEvalGradient(ChessPosition const& position, float scale, std::vector<float>& gradient)
+{
+	// The evaluation is linear in every weight apart from integer rounding, so each term's
+	// derivative is just how strongly the position exposes it
+	int phase = GetChessGamePhase(position);
+	float middlegameScale = scale * static_cast<float>(phase) / static_cast<float>(CHESS_MAX_PHASE);
+	float endgameScale = scale * static_cast<float>(CHESS_MAX_PHASE - phase) / static_cast<float>(CHESS_MAX_PHASE);
+	int bishopCounts[CHESS_NUM_PLAYERS] = { 0, 0 };
+
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = position.m_squares[square];
+		if (pieceCode == CHESS_EMPTY_SQUARE)
+		{
+			continue;
+		}
+
+		int typeIndex = static_cast<int>(GetChessPieceTypeForCode(pieceCode));
+		int playerIndex = GetPlayerIndexForCode(pieceCode);
+		int tableSquare = (playerIndex == 0) ? square : GetChessSquare(GetChessSquareX(square), 7 - GetChessSquareY(square));
+		float sign = (playerIndex == 0) ? 1.f : -1.f;
+
+		gradient[PARAM_MIDDLEGAME_VALUES + typeIndex] += sign * middlegameScale;
+		gradient[PARAM_ENDGAME_VALUES + typeIndex] += sign * endgameScale;
+		gradient[PARAM_MIDDLEGAME_TABLES + typeIndex * CHESS_BOARD_SIZE + tableSquare] += sign * middlegameScale;
+		gradient[PARAM_ENDGAME_TABLES + typeIndex * CHESS_BOARD_SIZE + tableSquare] += sign * endgameScale;
+
+		if (typeIndex == static_cast<int>(ChessPieceType::BISHOP))
+		{
+			bishopCounts[playerIndex] += 1;
+		}
+	}
+
+	float bishopPairSign = ((bishopCounts[0] >= 2) ? 1.f : 0.f) - ((bishopCounts[1] >= 2) ? 1.f : 0.f);
+	gradient[PARAM_BISHOP_PAIR] += bishopPairSign * scale;
+	gradient[PARAM_TEMPO] += (position.GetSideToMove() == 0) ? scale : -scale;
+}
\ No newline at end of file
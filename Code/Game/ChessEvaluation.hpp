@@ -0,0 +1,45 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+constexpr int NUM_CHESS_PIECE_TYPES = static_cast<int>(ChessPieceType::NUM_CHESSPIECETYPES);
+constexpr int CHESS_MAX_PHASE = 24;
+constexpr int CHESS_MATE_SCORE = 32000;
+constexpr int CHESS_MATE_THRESHOLD = CHESS_MATE_SCORE - 1000;
+// -----------------------------------------------------------------------------
+// Tapered material + piece-square evaluation. Tables are indexed from white's point of view
+// with a1 = 0; black pieces read the vertically mirrored square.
+// -----------------------------------------------------------------------------
+struct ChessEvalWeights
+{
+public:
+	int m_middlegamePieceValues[NUM_CHESS_PIECE_TYPES] = {};
+	int m_endgamePieceValues[NUM_CHESS_PIECE_TYPES] = {};
+	int m_middlegameTables[NUM_CHESS_PIECE_TYPES][CHESS_BOARD_SIZE] = {};
+	int m_endgameTables[NUM_CHESS_PIECE_TYPES][CHESS_BOARD_SIZE] = {};
+	int m_bishopPairBonus = 0;
+	int m_tempoBonus = 0;
+
+public:
+	static ChessEvalWeights GetDefaultWeights();
+
+	// Flat view of every tunable term, used by the tuner
+	static int GetNumParameters();
+	int&	   GetParameter(int parameterIndex);
+	int		   GetParameter(int parameterIndex) const;
+
+	// Tables are stored rank 8 first so the data file reads like a board
+	bool LoadFromXmlFile(std::string const& filePath);
+	bool SaveToXmlFile(std::string const& filePath) const;
+};
+// -----------------------------------------------------------------------------
+extern ChessEvalWeights g_chessEvalWeights;
+// -----------------------------------------------------------------------------
+int   EvaluateChessPosition(ChessPosition const& position, ChessEvalWeights const& weights = g_chessEvalWeights);
+int   GetChessGamePhase(ChessPosition const& position);
+int   GetChessPieceValue(ChessPieceType pieceType);
+float GetWinProbabilityForScore(int centipawns);
+
+// Adds scale * d(white-relative evaluation)/d(parameter) for every parameter the position touches
+void  AccumulateChessEvalGradient(ChessPosition const& position, float scale, std::vector<float>& gradient);
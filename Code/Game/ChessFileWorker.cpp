@@ -0,0 +1,89 @@
+#include "Game/ChessFileWorker.hpp"
+
+// -----------------------------------------------------------------------------
+ChessFileWorker::~ChessFileWorker()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_jobQueuedCondition.notify_all();
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void ChessFileWorker::QueueJob(std::unique_ptr<ChessFileJob> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queuedJobs.push_back(std::move(job));
+		if (!m_thread.joinable())
+		{
+			m_thread = std::thread(&ChessFileWorker::RunJobs, this);
+		}
+	}
+	m_jobQueuedCondition.notify_one();
+}
+
+std::unique_ptr<ChessFileJob> ChessFileWorker::PopFinishedJob()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_finishedJobs.empty())
+	{
+		return nullptr;
+	}
+	std::unique_ptr<ChessFileJob> job = std::move(m_finishedJobs.front());
+	m_finishedJobs.pop_front();
+	return job;
+}
+
+bool ChessFileWorker::IsBusy() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_runningJob != nullptr || !m_queuedJobs.empty();
+}
+
+bool ChessFileWorker::GetRunningJob(ChessFileJobType& out_type, std::string& out_filePath, float& out_progress, float& out_seconds) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_runningJob == nullptr)
+	{
+		return false;
+	}
+
+	// The job's type and path don't change once it is queued, and progress is atomic
+	out_type = m_runningJob->m_type;
+	out_filePath = m_runningJob->m_filePath;
+	out_progress = m_runningJob->m_progress;
+	out_seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_runningJobStartTime).count();
+	return true;
+}
+
+void ChessFileWorker::RunJobs()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_jobQueuedCondition.wait(lock, [this]() { return m_isStopping || !m_queuedJobs.empty(); });
+		if (m_queuedJobs.empty())
+		{
+			return;
+		}
+
+		std::unique_ptr<ChessFileJob> job = std::move(m_queuedJobs.front());
+		m_queuedJobs.pop_front();
+		m_runningJob = job.get();
+		m_runningJobStartTime = std::chrono::steady_clock::now();
+		lock.unlock();
+
+		job->m_succeeded = job->m_work(*job);
+		job->m_progress = 1.f;
+		job->m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_runningJobStartTime).count();
+
+		lock.lock();
+		m_runningJob = nullptr;
+		m_finishedJobs.push_back(std::move(job));
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "Game/ChessMoveRecord.hpp"
+#include "Game/ChessMoveTree.hpp"
+#include "Game/ChessPosition.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+// -----------------------------------------------------------------------------
+// What a save or load carries between the match and its file, copied so the file work never
+// touches the match or the board
+// -----------------------------------------------------------------------------
+struct ChessMatchRecord
+{
+public:
+	std::string					 m_startFEN;			// Empty for the standard starting layout
+	std::vector<ChessMoveRecord> m_moveHistory;		// The line on the board when saving, the main line when loading
+	ChessMoveTree				 m_moveTree;		// Every variation; only .xml files keep more than one line
+	bool						 m_hasPlayerInfo = false;	// Only the game log stores names and the clock
+	std::string					 m_playerNames[2];
+	float						 m_initialClockSeconds = 0.f;
+	int							 m_keyframeInterval = 0;	// 0 when the file has no keyframes
+	std::vector<ChessPosition>	 m_keyframes;
+};
+// -----------------------------------------------------------------------------
+enum class ChessFileJobType
+{
+	SAVE,
+	LOAD
+};
+// -----------------------------------------------------------------------------
+struct ChessFileJob
+{
+public:
+	ChessFileJobType m_type = ChessFileJobType::SAVE;
+	std::string		 m_filePath;
+	int				 m_gameNumber = 1;		// Which game of a PGN archive to load
+	ChessMatchRecord m_record;				// Saved from, or loaded into
+
+	// Runs on the worker thread; returns whether the file was written or read
+	std::function<bool(ChessFileJob& job)> m_work;
+
+	// Filled in by the worker
+	std::atomic<float> m_progress = 0.f;	// 0 to 1, for jobs that can tell
+	bool			   m_succeeded = false;
+	std::string		   m_message;			// The console line for the result, success or failure
+	double			   m_seconds = 0.0;
+};
+// -----------------------------------------------------------------------------
+// One background thread, owned by Game so it outlives any one match, that does the file reads and
+// writes in the order they were queued, so saving or loading never stalls a frame however slow the
+// disk or network share is. Finished jobs wait until the game thread collects them; nothing here
+// talks to the console.
+// -----------------------------------------------------------------------------
+class ChessFileWorker
+{
+public:
+	ChessFileWorker() = default;
+	~ChessFileWorker();		// Finishes every queued job first, so saves made on the way out still land
+	ChessFileWorker(ChessFileWorker const& copy) = delete;
+	ChessFileWorker& operator=(ChessFileWorker const& copy) = delete;
+
+	void QueueJob(std::unique_ptr<ChessFileJob> job);
+	std::unique_ptr<ChessFileJob> PopFinishedJob();		// nullptr when none are waiting
+
+	bool IsBusy() const;
+	bool GetRunningJob(ChessFileJobType& out_type, std::string& out_filePath, float& out_progress, float& out_seconds) const;
+
+private:
+	void RunJobs();
+
+private:
+	mutable std::mutex						  m_mutex;
+	std::condition_variable					  m_jobQueuedCondition;
+	std::deque<std::unique_ptr<ChessFileJob>> m_queuedJobs;
+	std::deque<std::unique_ptr<ChessFileJob>> m_finishedJobs;
+	ChessFileJob*							  m_runningJob = nullptr;
+	std::chrono::steady_clock::time_point	  m_runningJobStartTime;
+	bool									  m_isStopping = false;
+	std::thread								  m_thread;		// Started by the first job
+};
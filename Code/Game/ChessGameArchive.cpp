@@ -0,0 +1,614 @@
+#include "Game/ChessGameArchive.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+
+// -----------------------------------------------------------------------------
+constexpr uint8_t  GAME_ARCHIVE_MAGIC[4] = { 'C', '3', 'G', 'A' };
+constexpr uint16_t GAME_ARCHIVE_VERSION = 1;
+constexpr size_t   GAME_ARCHIVE_HEADER_SIZE = 32;
+constexpr int	   GAME_ARCHIVE_NUM_RANKS = 256;		// More than any position has legal moves
+constexpr size_t   GAME_ARCHIVE_MODEL_SIZE = GAME_ARCHIVE_NUM_RANKS * 2;
+constexpr uint8_t  GAME_ARCHIVE_FLAG_START_FEN = 1 << 0;
+constexpr int	   GAME_ARCHIVE_RESULT_SHIFT = 1;		// Two bits of flags hold the result code
+constexpr uint64_t GAME_ARCHIVE_MAX_PLIES = 1 << 20;	// Far past any real game; more means the count is damaged
+constexpr int	   RANGE_FREQUENCY_BITS = 15;
+constexpr uint32_t RANGE_FREQUENCY_TOTAL = 1 << RANGE_FREQUENCY_BITS;
+constexpr uint32_t RANGE_TOP = 1 << 24;
+constexpr int	   MOVE_ORDER_SCORE_BIAS = 1 << 20;
+// -----------------------------------------------------------------------------
+static char const* const GAME_RESULTS[] = { "*", "1-0", "0-1", "1/2-1/2" };
+// -----------------------------------------------------------------------------
+
+struct ChessArchiveGame
+{
+public:
+	uint32_t			 m_fileIndex = 0;
+	uint64_t			 m_fileOffset = 0;
+	std::string			 m_startFEN;		// Empty for the standard starting layout
+	std::string			 m_playerNames[2];
+	std::vector<uint8_t> m_ranks;
+	uint16_t			 m_finalHash = 0;	// Low bits of the final position's hash, checked after decoding
+	uint8_t				 m_result = 0;
+};
+
+static uint8_t GetResultCode(std::string const& result)
+{
+	for (uint8_t resultCode = 1; resultCode < 4; ++resultCode)
+	{
+		if (result == GAME_RESULTS[resultCode])
+		{
+			return resultCode;
+		}
+	}
+	return 0;
+}
+
+static void AppendLittleEndian(std::vector<uint8_t>& bytes, uint64_t value, int numBytes)
+{
+	for (int byteIndex = 0; byteIndex < numBytes; ++byteIndex)
+	{
+		bytes.push_back(static_cast<uint8_t>(value >> (8 * byteIndex)));
+	}
+}
+
+static void AppendVarint(std::vector<uint8_t>& bytes, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back(static_cast<uint8_t>(value));
+}
+
+static bool ReadVarint(uint8_t const* data, size_t dataSize, size_t& cursor, uint64_t& out_value)
+{
+	out_value = 0;
+	for (int shift = 0; cursor < dataSize && shift < 64; shift += 7)
+	{
+		uint8_t byte = data[cursor++];
+		out_value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void AppendShortString(std::vector<uint8_t>& bytes, std::string const& text)
+{
+	size_t length = std::min<size_t>(text.size(), 0xFF);
+	bytes.push_back(static_cast<uint8_t>(length));
+	bytes.insert(bytes.end(), text.begin(), text.begin() + length);
+}
+
+static bool ReadShortString(uint8_t const* data, size_t dataSize, size_t& cursor, std::string& out_text)
+{
+	if (cursor >= dataSize || cursor + 1 + data[cursor] > dataSize)
+	{
+		return false;
+	}
+	out_text.assign(reinterpret_cast<char const*>(data + cursor + 1), data[cursor]);
+	cursor += 1 + data[cursor];
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Range coder over a static model whose frequencies total RANGE_FREQUENCY_TOTAL. The encoder keeps
+// one byte back so a carry out of the low end can still reach it. The first byte out is always
+// zero and is never stored; the decoder reads zeros past the end, so trailing zeros aren't either.
+// -----------------------------------------------------------------------------
+class ChessRangeEncoder
+{
+public:
+	explicit ChessRangeEncoder(std::vector<uint8_t>& out_bytes)
+		:m_bytes(out_bytes)
+		,m_firstByteIndex(out_bytes.size())
+	{
+	}
+
+	void Encode(uint32_t cumulativeFrequency, uint32_t frequency)
+	{
+		m_range >>= RANGE_FREQUENCY_BITS;
+		m_low += static_cast<uint64_t>(cumulativeFrequency) * m_range;
+		m_range *= frequency;
+		while (m_range < RANGE_TOP)
+		{
+			m_range <<= 8;
+			ShiftLow();
+		}
+	}
+
+	void Finish()
+	{
+		// Any value in [low, low + range) decodes the same, so take the one ending in the most zero bits
+		for (int numZeroBits = 32; numZeroBits > 0; --numZeroBits)
+		{
+			uint64_t mask = (1ull << numZeroBits) - 1;
+			uint64_t roundedLow = (m_low + mask) & ~mask;
+			if (roundedLow < m_low + m_range)
+			{
+				m_low = roundedLow;
+				break;
+			}
+		}
+		for (int byteIndex = 0; byteIndex < 5; ++byteIndex)
+		{
+			ShiftLow();
+		}
+		while (m_bytes.size() > m_firstByteIndex && m_bytes.back() == 0)
+		{
+			m_bytes.pop_back();
+		}
+	}
+
+private:
+	void ShiftLow()
+	{
+		if (static_cast<uint32_t>(m_low) < 0xFF000000u || (m_low >> 32) != 0)
+		{
+			uint8_t carry = static_cast<uint8_t>(m_low >> 32);
+			uint8_t heldByte = m_cache;
+			do
+			{
+				if (!m_isFirstByte)
+				{
+					m_bytes.push_back(static_cast<uint8_t>(heldByte + carry));
+				}
+				m_isFirstByte = false;
+				heldByte = 0xFF;
+			}
+			while (--m_numCachedBytes != 0);
+			m_cache = static_cast<uint8_t>(m_low >> 24);
+		}
+		++m_numCachedBytes;
+		m_low = (m_low & 0x00FFFFFF) << 8;
+	}
+
+private:
+	std::vector<uint8_t>& m_bytes;
+	size_t	 m_firstByteIndex = 0;
+	uint64_t m_low = 0;
+	uint32_t m_range = 0xFFFFFFFF;
+	uint8_t	 m_cache = 0;
+	uint64_t m_numCachedBytes = 1;
+	bool	 m_isFirstByte = true;
+};
+
+class ChessRangeDecoder
+{
+public:
+	ChessRangeDecoder(uint8_t const* bytes, size_t numBytes)
+		:m_bytes(bytes)
+		,m_numBytes(numBytes)
+	{
+		for (int byteIndex = 0; byteIndex < 4; ++byteIndex)
+		{
+			m_code = (m_code << 8) | ReadByte();
+		}
+	}
+
+	uint32_t GetFrequency()
+	{
+		m_range >>= RANGE_FREQUENCY_BITS;
+		return std::min(m_code / m_range, RANGE_FREQUENCY_TOTAL - 1);
+	}
+
+	void Decode(uint32_t cumulativeFrequency, uint32_t frequency)
+	{
+		m_code -= cumulativeFrequency * m_range;
+		m_range *= frequency;
+		while (m_range < RANGE_TOP)
+		{
+			m_code = (m_code << 8) | ReadByte();
+			m_range <<= 8;
+		}
+	}
+
+private:
+	uint8_t ReadByte()
+	{
+		return (m_cursor < m_numBytes) ? m_bytes[m_cursor++] : 0;
+	}
+
+private:
+	uint8_t const* m_bytes = nullptr;
+	size_t		   m_numBytes = 0;
+	size_t		   m_cursor = 0;
+	uint32_t	   m_code = 0;
+	uint32_t	   m_range = 0xFFFFFFFF;
+};
+
+// -----------------------------------------------------------------------------
+// Likely moves first: captures of the most valuable victim by the least valuable attacker, then
+// promotions and castling, then quiet moves toward the centre, with anything stepping onto a square
+// an enemy pawn guards pushed back. The values are fixed here rather than taken from the tunable
+// evaluation, because every archive ever written decodes through this exact order.
+// -----------------------------------------------------------------------------
+static int GetMoveOrderScore(ChessPosition const& position, ChessMove const& move)
+{
+	static int const PIECE_VALUES[static_cast<int>(ChessPieceType::NUM_CHESSPIECETYPES)] = { 5, 3, 3, 9, 0, 1 };		// Rook, knight, bishop, queen, king, pawn
+
+	uint8_t pieceCode = position.GetPieceAt(move.m_from);
+	int pieceType = static_cast<int>(GetChessPieceTypeForCode(pieceCode));
+	int playerIndex = GetPlayerIndexForCode(pieceCode);
+	int score = 0;
+
+	if (move.IsCapture())
+	{
+		uint8_t victimCode = (move.m_flags & CHESS_MOVE_FLAG_ENPASSANT) ? MakeChessPieceCode(ChessPieceType::PAWN, 1 - playerIndex) : position.GetPieceAt(move.m_to);
+		score += 1000 + 16 * PIECE_VALUES[static_cast<int>(GetChessPieceTypeForCode(victimCode))] - PIECE_VALUES[pieceType];
+	}
+	if (move.IsPromotion())
+	{
+		score += 500 + 16 * PIECE_VALUES[static_cast<int>(move.GetPromotionType())];
+	}
+	if (move.m_flags & CHESS_MOVE_FLAG_CASTLE)
+	{
+		score += 200;
+	}
+
+	// Distance from the centre in half squares, 2 on the four centre squares up to 14 in the corners
+	auto getCentreDistance = [](int square) { return abs(2 * GetChessSquareX(square) - 7) + abs(2 * GetChessSquareY(square) - 7); };
+	ChessPieceType movingType = static_cast<ChessPieceType>(pieceType);
+	if (movingType == ChessPieceType::KNIGHT || movingType == ChessPieceType::BISHOP || movingType == ChessPieceType::PAWN)
+	{
+		score += 4 * (getCentreDistance(move.m_from) - getCentreDistance(move.m_to));
+	}
+	else if (movingType == ChessPieceType::QUEEN)
+	{
+		score += getCentreDistance(move.m_from) - getCentreDistance(move.m_to);
+	}
+
+	if (movingType != ChessPieceType::PAWN)
+	{
+		int enemyPawnRank = GetChessSquareY(move.m_to) + ((playerIndex == 0) ? 1 : -1);
+		uint8_t enemyPawnCode = MakeChessPieceCode(ChessPieceType::PAWN, 1 - playerIndex);
+		for (int fileOffset : { -1, 1 })
+		{
+			int enemyPawnFile = GetChessSquareX(move.m_to) + fileOffset;
+			if (enemyPawnRank >= 0 && enemyPawnRank < 8 && enemyPawnFile >= 0 && enemyPawnFile < 8 && position.GetPieceAt(GetChessSquare(enemyPawnFile, enemyPawnRank)) == enemyPawnCode)
+			{
+				score -= 16 * PIECE_VALUES[pieceType];
+				break;
+			}
+		}
+	}
+	return score;
+}
+
+static uint64_t GetMoveOrderKey(ChessPosition const& position, ChessMove const& move)
+{
+	// Ascending keys: higher scores first, ties broken by the packed move so the order is total
+	return (static_cast<uint64_t>(MOVE_ORDER_SCORE_BIAS - GetMoveOrderScore(position, move)) << 16) | move.GetPacked();
+}
+
+// -----------------------------------------------------------------------------
+int ChessGameArchive::GetRankForMove(ChessPosition const& position, ChessMoveList const& candidateMoves, ChessMove const& move)
+{
+	uint64_t moveKey = GetMoveOrderKey(position, move);
+	int rank = 0;
+	for (int moveIndex = 0; moveIndex < candidateMoves.Size(); ++moveIndex)
+	{
+		rank += (GetMoveOrderKey(position, candidateMoves[moveIndex]) < moveKey) ? 1 : 0;
+	}
+	return rank;
+}
+
+ChessMove ChessGameArchive::GetMoveForRank(ChessPosition const& position, ChessMoveList const& candidateMoves, int rank)
+{
+	uint64_t moveKeys[CHESS_MAX_MOVES];
+	for (int moveIndex = 0; moveIndex < candidateMoves.Size(); ++moveIndex)
+	{
+		moveKeys[moveIndex] = GetMoveOrderKey(position, candidateMoves[moveIndex]);
+	}
+	std::nth_element(moveKeys, moveKeys + rank, moveKeys + candidateMoves.Size());
+
+	uint16_t packedMove = static_cast<uint16_t>(moveKeys[rank]);
+	for (int moveIndex = 0; moveIndex < candidateMoves.Size(); ++moveIndex)
+	{
+		if (candidateMoves[moveIndex].GetPacked() == packedMove)
+		{
+			return candidateMoves[moveIndex];
+		}
+	}
+	return ChessMove();
+}
+
+// -----------------------------------------------------------------------------
+bool ChessGameArchive::Open(std::string const& filePath)
+{
+	Close();
+	if (!m_file.Open(filePath))
+	{
+		return false;
+	}
+
+	uint8_t const* data = m_file.GetData();
+	size_t fileSize = m_file.GetSize();
+	if (fileSize < GAME_ARCHIVE_HEADER_SIZE + GAME_ARCHIVE_MODEL_SIZE || !std::equal(GAME_ARCHIVE_MAGIC, GAME_ARCHIVE_MAGIC + 4, data) || ReadLittleEndian16(data + 4) != GAME_ARCHIVE_VERSION)
+	{
+		Close();
+		return false;
+	}
+	m_numGames = ReadLittleEndian32(data + 8);
+	m_numPlies = ReadLittleEndian64(data + 16);
+	m_gameTableOffset = ReadLittleEndian64(data + 24);
+	if (m_gameTableOffset < GAME_ARCHIVE_HEADER_SIZE + GAME_ARCHIVE_MODEL_SIZE || m_gameTableOffset + (static_cast<uint64_t>(m_numGames) + 1) * 8 > fileSize)
+	{
+		Close();
+		return false;
+	}
+
+	// The rank model, and a table from any coded frequency straight back to its rank
+	m_cumulativeFrequencies.assign(GAME_ARCHIVE_NUM_RANKS + 1, 0);
+	for (int rank = 0; rank < GAME_ARCHIVE_NUM_RANKS; ++rank)
+	{
+		m_cumulativeFrequencies[rank + 1] = m_cumulativeFrequencies[rank] + ReadLittleEndian16(data + GAME_ARCHIVE_HEADER_SIZE + rank * 2);
+	}
+	if (m_cumulativeFrequencies.back() != RANGE_FREQUENCY_TOTAL)
+	{
+		Close();
+		return false;
+	}
+	m_rankForFrequency.resize(RANGE_FREQUENCY_TOTAL);
+	for (int rank = 0; rank < GAME_ARCHIVE_NUM_RANKS; ++rank)
+	{
+		std::fill(m_rankForFrequency.begin() + m_cumulativeFrequencies[rank], m_rankForFrequency.begin() + m_cumulativeFrequencies[rank + 1], static_cast<uint8_t>(rank));
+	}
+	return true;
+}
+
+void ChessGameArchive::Close()
+{
+	m_file.Close();
+	m_numGames = 0;
+	m_numPlies = 0;
+	m_gameTableOffset = 0;
+	m_cumulativeFrequencies.clear();
+	m_rankForFrequency.clear();
+}
+
+bool ChessGameArchive::ReadGame(uint32_t gameIndex, ChessSavedGame& out_game) const
+{
+	out_game.Reset();
+	out_game.m_filePath = GetFilePath();
+	out_game.m_format = ChessSavedGameFormat::ARCHIVE;
+	if (gameIndex >= m_numGames)
+	{
+		return false;
+	}
+
+	uint8_t const* gameData = GetGameData(gameIndex);
+	uint64_t blockOffset = ReadLittleEndian64(gameData);
+	uint64_t blockEnd = ReadLittleEndian64(gameData + 8);
+	out_game.m_fileOffset = blockOffset;
+	if (blockOffset >= blockEnd || blockEnd > m_gameTableOffset)
+	{
+		out_game.m_error = "The game's data lies outside the archive";
+		out_game.m_wasTruncated = true;
+		return true;
+	}
+
+	// Flags and result, ply count, final hash check, start FEN when there is one, player names, then the coded ranks
+	uint8_t const* block = m_file.GetData() + blockOffset;
+	size_t blockSize = static_cast<size_t>(blockEnd - blockOffset);
+	size_t cursor = 1;
+	uint64_t numPlies = 0;
+	std::string startFEN;
+	if (!ReadVarint(block, blockSize, cursor, numPlies) || numPlies > GAME_ARCHIVE_MAX_PLIES || cursor + 2 > blockSize)
+	{
+		out_game.m_error = "The game's header is damaged";
+		return true;
+	}
+	uint16_t finalHash = ReadLittleEndian16(block + cursor);
+	cursor += 2;
+	if (((block[0] & GAME_ARCHIVE_FLAG_START_FEN) && !ReadShortString(block, blockSize, cursor, startFEN)) ||
+		!ReadShortString(block, blockSize, cursor, out_game.m_playerNames[0]) || !ReadShortString(block, blockSize, cursor, out_game.m_playerNames[1]))
+	{
+		out_game.m_error = "The game's header is damaged";
+		return true;
+	}
+	out_game.m_numRecordedMoves = static_cast<int>(numPlies);
+	out_game.m_result = GAME_RESULTS[(block[0] >> GAME_ARCHIVE_RESULT_SHIFT) & 3];
+	if (!startFEN.empty() && !out_game.m_startPosition.SetFromFEN(startFEN.c_str()))
+	{
+		out_game.m_error = "Unreadable start FEN \"" + startFEN + "\"";
+		return true;
+	}
+
+	ChessRangeDecoder decoder(block + cursor, blockSize - cursor);
+	ChessPosition position = out_game.m_startPosition;
+	ChessMoveList candidateMoves;
+	out_game.m_moves.reserve(static_cast<size_t>(numPlies));
+	for (uint64_t ply = 0; ply < numPlies; ++ply)
+	{
+		uint32_t frequency = decoder.GetFrequency();
+		int rank = m_rankForFrequency[frequency];
+		decoder.Decode(m_cumulativeFrequencies[rank], m_cumulativeFrequencies[rank + 1] - m_cumulativeFrequencies[rank]);
+
+		candidateMoves.m_count = 0;
+		position.GeneratePseudoLegalMoves(candidateMoves);
+		ChessMove move = (rank < candidateMoves.Size()) ? GetMoveForRank(position, candidateMoves, rank) : ChessMove();
+		if (move.IsNull() || !position.IsLegalMove(move))
+		{
+			out_game.m_error = "Damaged move data at ply " + std::to_string(ply + 1);
+			return true;
+		}
+		position.MakeMove(move);
+		out_game.m_moves.push_back(move);
+	}
+	if (static_cast<uint16_t>(position.GetHash()) != finalHash)
+	{
+		out_game.m_error = "The decoded game doesn't reach the position it was archived with";
+	}
+	return true;
+}
+
+uint8_t const* ChessGameArchive::GetGameData(uint32_t gameIndex) const
+{
+	return m_file.GetData() + m_gameTableOffset + static_cast<uint64_t>(gameIndex) * 8;
+}
+
+// -----------------------------------------------------------------------------
+bool ChessGameArchive::Build(std::vector<std::string> const& inputPaths, std::string const& outputFilePath, int numThreads, ChessGameArchiveBuildStats& out_stats)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	numThreads = (numThreads > 0) ? numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	// An archive being rebuilt in place may be sitting in one of the input folders
+	std::vector<std::string> sourceFilePaths = ChessSavedGameReader::FindGameFiles(inputPaths);
+	sourceFilePaths.erase(std::remove_if(sourceFilePaths.begin(), sourceFilePaths.end(), [&](std::string const& sourceFilePath)
+	{
+		std::error_code errorCode;
+		return std::filesystem::equivalent(sourceFilePath, outputFilePath, errorCode);
+	}), sourceFilePaths.end());
+
+	std::unordered_map<std::string, uint32_t> sourceFileIndices;
+	for (uint32_t fileIndex = 0; fileIndex < sourceFilePaths.size(); ++fileIndex)
+	{
+		sourceFileIndices[sourceFilePaths[fileIndex]] = fileIndex;
+		std::error_code errorCode;
+		uintmax_t fileSize = std::filesystem::file_size(sourceFilePaths[fileIndex], errorCode);
+		out_stats.m_numInputBytes += errorCode ? 0 : static_cast<uint64_t>(fileSize);
+	}
+
+	// The workers rank every move as they replay; coding waits for the rank counts of the whole archive
+	std::vector<std::vector<ChessArchiveGame>> workerGames(numThreads);
+	out_stats.m_readStats = ChessSavedGameReader::ReadAllGames(sourceFilePaths, numThreads, [&](ChessSavedGame const& savedGame, int workerIndex)
+	{
+		if (savedGame.m_moves.empty() && !savedGame.IsValid())
+		{
+			return;
+		}
+
+		ChessArchiveGame game;
+		game.m_fileIndex = sourceFileIndices[savedGame.m_filePath];
+		game.m_fileOffset = savedGame.m_fileOffset;
+		game.m_playerNames[0] = savedGame.m_playerNames[0];
+		game.m_playerNames[1] = savedGame.m_playerNames[1];
+		game.m_result = GetResultCode(savedGame.m_result);
+		std::string startFEN = savedGame.m_startPosition.GetFEN();
+		game.m_startFEN = (startFEN == ChessPosition::GetStartingPosition().GetFEN()) ? "" : startFEN;
+
+		ChessPosition position = savedGame.m_startPosition;
+		ChessMoveList candidateMoves;
+		game.m_ranks.reserve(savedGame.m_moves.size());
+		for (ChessMove const& move : savedGame.m_moves)
+		{
+			candidateMoves.m_count = 0;
+			position.GeneratePseudoLegalMoves(candidateMoves);
+			game.m_ranks.push_back(static_cast<uint8_t>(GetRankForMove(position, candidateMoves, move)));
+			position.MakeMove(move);
+		}
+		game.m_finalHash = static_cast<uint16_t>(position.GetHash());
+		workerGames[workerIndex].push_back(std::move(game));
+	});
+
+	std::vector<ChessArchiveGame> games;
+	for (std::vector<ChessArchiveGame>& workerGameList : workerGames)
+	{
+		std::move(workerGameList.begin(), workerGameList.end(), std::back_inserter(games));
+		std::vector<ChessArchiveGame>().swap(workerGameList);
+	}
+	std::sort(games.begin(), games.end(), [](ChessArchiveGame const& gameA, ChessArchiveGame const& gameB)
+	{
+		return (gameA.m_fileIndex != gameB.m_fileIndex) ? gameA.m_fileIndex < gameB.m_fileIndex : gameA.m_fileOffset < gameB.m_fileOffset;
+	});
+
+	// Every rank keeps a frequency of at least one, and whatever rounding leaves over goes to the most common
+	uint64_t rankCounts[GAME_ARCHIVE_NUM_RANKS] = {};
+	for (ChessArchiveGame const& game : games)
+	{
+		for (uint8_t rank : game.m_ranks)
+		{
+			rankCounts[rank] += 1;
+		}
+		out_stats.m_numPlies += game.m_ranks.size();
+	}
+	uint32_t frequencies[GAME_ARCHIVE_NUM_RANKS] = {};
+	uint32_t frequencyTotal = 0;
+	for (int rank = 0; rank < GAME_ARCHIVE_NUM_RANKS; ++rank)
+	{
+		frequencies[rank] = 1 + static_cast<uint32_t>(rankCounts[rank] * (RANGE_FREQUENCY_TOTAL - GAME_ARCHIVE_NUM_RANKS) / std::max<uint64_t>(out_stats.m_numPlies, 1));
+		frequencyTotal += frequencies[rank];
+	}
+	frequencies[std::max_element(rankCounts, rankCounts + GAME_ARCHIVE_NUM_RANKS) - rankCounts] += RANGE_FREQUENCY_TOTAL - frequencyTotal;
+	uint32_t cumulativeFrequencies[GAME_ARCHIVE_NUM_RANKS + 1] = {};
+	for (int rank = 0; rank < GAME_ARCHIVE_NUM_RANKS; ++rank)
+	{
+		cumulativeFrequencies[rank + 1] = cumulativeFrequencies[rank] + frequencies[rank];
+	}
+
+	std::ofstream file(outputFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	// The game table offset is filled in once the games are written
+	std::vector<uint8_t> bytes(GAME_ARCHIVE_MAGIC, GAME_ARCHIVE_MAGIC + 4);
+	AppendLittleEndian(bytes, GAME_ARCHIVE_VERSION, 2);
+	AppendLittleEndian(bytes, 0, 2);
+	AppendLittleEndian(bytes, games.size(), 4);
+	AppendLittleEndian(bytes, 0, 4);
+	AppendLittleEndian(bytes, out_stats.m_numPlies, 8);
+	AppendLittleEndian(bytes, 0, 8);
+	for (uint32_t frequency : frequencies)
+	{
+		AppendLittleEndian(bytes, frequency, 2);
+	}
+
+	constexpr size_t WRITE_BATCH_BYTES = 1 << 20;
+	std::vector<uint8_t> gameTable;
+	gameTable.reserve((games.size() + 1) * 8);
+	uint64_t blockOffset = bytes.size();
+	for (ChessArchiveGame const& game : games)
+	{
+		size_t blockStart = bytes.size();
+		bytes.push_back(static_cast<uint8_t>((game.m_startFEN.empty() ? 0 : GAME_ARCHIVE_FLAG_START_FEN) | (game.m_result << GAME_ARCHIVE_RESULT_SHIFT)));
+		AppendVarint(bytes, game.m_ranks.size());
+		AppendLittleEndian(bytes, game.m_finalHash, 2);
+		if (!game.m_startFEN.empty())
+		{
+			AppendShortString(bytes, game.m_startFEN);
+		}
+		AppendShortString(bytes, game.m_playerNames[0]);
+		AppendShortString(bytes, game.m_playerNames[1]);
+
+		ChessRangeEncoder encoder(bytes);
+		for (uint8_t rank : game.m_ranks)
+		{
+			encoder.Encode(cumulativeFrequencies[rank], frequencies[rank]);
+		}
+		encoder.Finish();
+
+		AppendLittleEndian(gameTable, blockOffset, 8);
+		blockOffset += bytes.size() - blockStart;
+
+		if (bytes.size() >= WRITE_BATCH_BYTES)
+		{
+			file.write(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+			bytes.clear();
+		}
+	}
+	AppendLittleEndian(gameTable, blockOffset, 8);
+	bytes.insert(bytes.end(), gameTable.begin(), gameTable.end());
+	file.write(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+
+	std::vector<uint8_t> gameTableOffsetBytes;
+	AppendLittleEndian(gameTableOffsetBytes, blockOffset, 8);
+	file.seekp(24);
+	file.write(reinterpret_cast<char const*>(gameTableOffsetBytes.data()), gameTableOffsetBytes.size());
+
+	out_stats.m_numGames = games.size();
+	out_stats.m_numBytes = blockOffset + gameTable.size();
+	out_stats.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return file.good();
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "Game/ChessMappedFile.hpp"
+#include "Game/ChessSavedGameReader.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+struct ChessGameArchiveBuildStats
+{
+public:
+	ChessSavedGameReadStats m_readStats;
+	uint64_t m_numGames = 0;			// Archived; files with no readable game are left out
+	uint64_t m_numPlies = 0;
+	uint64_t m_numInputBytes = 0;
+	uint64_t m_numBytes = 0;
+	double	 m_seconds = 0.0;
+};
+// -----------------------------------------------------------------------------
+// Long-term storage for finished games (.cga). Each move is stored as its rank among the
+// pseudo-legal moves of its position, in a fixed order that puts likely moves first, and the ranks
+// are range coded with one frequency table for the whole archive. Typical games take well under a
+// byte a move. Ranking the pseudo-legal list costs a fraction of a bit a move over the legal one,
+// and decoding only has to check the one move it picks. Every game is coded on its own and the
+// table at the end of the file holds where each one starts, so any game decodes without touching
+// the others, and a whole archive decodes in parallel.
+// -----------------------------------------------------------------------------
+class ChessGameArchive
+{
+public:
+	bool Open(std::string const& filePath);
+	void Close();
+	bool IsOpen() const { return m_file.IsOpen(); }
+
+	std::string const& GetFilePath() const { return m_file.GetFilePath(); }
+	uint32_t		   GetNumGames() const { return m_numGames; }
+	uint64_t		   GetNumPlies() const { return m_numPlies; }
+
+	// Replays the moves as they decode; a damaged block ends the game with an error, like an illegal move in any other format
+	bool ReadGame(uint32_t gameIndex, ChessSavedGame& out_game) const;
+
+	// Every game found under the input files and directories, in file order; games are kept up to their first illegal move
+	static bool Build(std::vector<std::string> const& inputPaths, std::string const& outputFilePath, int numThreads, ChessGameArchiveBuildStats& out_stats);
+
+	// The move order the ranks count in, over the moves GeneratePseudoLegalMoves lists; it is part of the file format and can never change
+	static int		 GetRankForMove(ChessPosition const& position, ChessMoveList const& candidateMoves, ChessMove const& move);
+	static ChessMove GetMoveForRank(ChessPosition const& position, ChessMoveList const& candidateMoves, int rank);
+
+private:
+	uint8_t const* GetGameData(uint32_t gameIndex) const;
+
+private:
+	ChessMappedFile		  m_file;
+	uint32_t			  m_numGames = 0;
+	uint64_t			  m_numPlies = 0;
+	uint64_t			  m_gameTableOffset = 0;
+	std::vector<uint32_t> m_cumulativeFrequencies;		// 257 entries, the last is the total
+	std::vector<uint8_t>  m_rankForFrequency;			// Decoding lookup, one entry per unit of the total
+};
@@ -0,0 +1,322 @@
+#include "Game/ChessGameLog.hpp"
+#include "Game/ChessMappedFile.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------------
+constexpr uint8_t  CHESS_LOG_MAGIC[4] = { 'C', '3', 'G', 'L' };
+constexpr uint16_t CHESS_LOG_VERSION = 1;
+constexpr size_t   CHESS_LOG_RECORD_SIZE = 4;
+constexpr size_t   CHESS_LOG_MAX_TEXT_LENGTH = 255;
+// -----------------------------------------------------------------------------
+
+static uint32_t UpdateCRC32(uint32_t crc, uint8_t const* bytes, size_t numBytes)
+{
+	static uint32_t const* const s_table = []()
+	{
+		static uint32_t table[256];
+		for (uint32_t byteValue = 0; byteValue < 256; ++byteValue)
+		{
+			uint32_t entry = byteValue;
+			for (int bitIndex = 0; bitIndex < 8; ++bitIndex)
+			{
+				entry = (entry & 1) ? (0xEDB88320u ^ (entry >> 1)) : (entry >> 1);
+			}
+			table[byteValue] = entry;
+		}
+		return table;
+	}();
+
+	crc = ~crc;
+	for (size_t byteIndex = 0; byteIndex < numBytes; ++byteIndex)
+	{
+		crc = s_table[(crc ^ bytes[byteIndex]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void AppendLittleEndian16(std::vector<uint8_t>& bytes, uint16_t value)
+{
+	bytes.push_back(static_cast<uint8_t>(value));
+	bytes.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+static void AppendLittleEndian32(std::vector<uint8_t>& bytes, uint32_t value)
+{
+	AppendLittleEndian16(bytes, static_cast<uint16_t>(value));
+	AppendLittleEndian16(bytes, static_cast<uint16_t>(value >> 16));
+}
+
+static void AppendShortText(std::vector<uint8_t>& bytes, std::string const& text)
+{
+	size_t length = std::min(text.size(), CHESS_LOG_MAX_TEXT_LENGTH);
+	bytes.push_back(static_cast<uint8_t>(length));
+	bytes.insert(bytes.end(), text.begin(), text.begin() + length);
+}
+
+static bool ReadShortText(std::vector<uint8_t> const& bytes, size_t& cursor, size_t end, std::string& out_text)
+{
+	if (cursor >= end || cursor + 1 + bytes[cursor] > end)
+	{
+		return false;
+	}
+	size_t length = bytes[cursor];
+	out_text.assign(reinterpret_cast<char const*>(&bytes[cursor + 1]), length);
+	cursor += 1 + length;
+	return true;
+}
+
+static std::vector<uint8_t> GetHeaderBytes(ChessGameLogHeader const& header)
+{
+	std::vector<uint8_t> bytes(CHESS_LOG_MAGIC, CHESS_LOG_MAGIC + 4);
+	AppendLittleEndian16(bytes, CHESS_LOG_VERSION);
+	AppendLittleEndian16(bytes, 0);		// Header size, filled in below
+	AppendLittleEndian32(bytes, header.m_initialClockMS);
+	AppendLittleEndian32(bytes, header.m_incrementMS);
+	AppendShortText(bytes, header.m_playerNames[0]);
+	AppendShortText(bytes, header.m_playerNames[1]);
+	AppendShortText(bytes, header.m_startFEN);
+
+	uint16_t headerSize = static_cast<uint16_t>(bytes.size() + 4);
+	bytes[6] = static_cast<uint8_t>(headerSize);
+	bytes[7] = static_cast<uint8_t>(headerSize >> 8);
+	AppendLittleEndian32(bytes, UpdateCRC32(0, bytes.data(), bytes.size()));
+	return bytes;
+}
+
+static void GetRecordBytes(uint16_t encodedMove, uint32_t& runningChecksum, uint8_t (&out_bytes)[CHESS_LOG_RECORD_SIZE])
+{
+	// The check half chains every earlier move, so a record from another game or position fails too
+	out_bytes[0] = static_cast<uint8_t>(encodedMove);
+	out_bytes[1] = static_cast<uint8_t>(encodedMove >> 8);
+	runningChecksum = UpdateCRC32(runningChecksum, out_bytes, 2);
+	out_bytes[2] = static_cast<uint8_t>(runningChecksum);
+	out_bytes[3] = static_cast<uint8_t>(runningChecksum >> 8);
+}
+
+// -----------------------------------------------------------------------------
+ChessGameLog::~ChessGameLog()
+{
+	Close();
+}
+
+bool ChessGameLog::Create(std::string const& filePath, ChessGameLogHeader const& header)
+{
+	Close();
+
+#if defined(_WIN32)
+	HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	m_fileHandle = fileHandle;
+#else
+	m_fileDescriptor = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+	if (m_fileDescriptor < 0)
+	{
+		return false;
+	}
+#endif
+
+	std::vector<uint8_t> headerBytes = GetHeaderBytes(header);
+	m_filePath = filePath;
+	m_runningChecksum = ReadLittleEndian32(&headerBytes[headerBytes.size() - 4]);
+	m_numMoves = 0;
+	m_numUnsyncedRecords = 1;
+	if (!WriteBytes(headerBytes.data(), headerBytes.size()) || !Sync())
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool ChessGameLog::AppendMove(uint16_t encodedMove)
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	uint8_t recordBytes[CHESS_LOG_RECORD_SIZE];
+	GetRecordBytes(encodedMove, m_runningChecksum, recordBytes);
+	if (!WriteBytes(recordBytes, CHESS_LOG_RECORD_SIZE))
+	{
+		return false;
+	}
+	m_numMoves += 1;
+	m_numUnsyncedRecords += 1;
+
+	// The write is already with the OS, which survives the game crashing; syncing only guards against power loss
+	float secondsSinceSync = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_lastSyncTime).count();
+	if (m_numUnsyncedRecords >= m_syncEveryRecords || secondsSinceSync >= m_syncEverySeconds)
+	{
+		return Sync();
+	}
+	return true;
+}
+
+bool ChessGameLog::Sync()
+{
+	if (!IsOpen() || m_numUnsyncedRecords == 0)
+	{
+		return IsOpen();
+	}
+
+#if defined(_WIN32)
+	bool isSynced = FlushFileBuffers(static_cast<HANDLE>(m_fileHandle)) != 0;
+#else
+	bool isSynced = fsync(m_fileDescriptor) == 0;
+#endif
+	m_numUnsyncedRecords = 0;
+	m_lastSyncTime = std::chrono::steady_clock::now();
+	return isSynced;
+}
+
+void ChessGameLog::Close()
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	Sync();
+#if defined(_WIN32)
+	CloseHandle(static_cast<HANDLE>(m_fileHandle));
+	m_fileHandle = nullptr;
+#else
+	close(m_fileDescriptor);
+	m_fileDescriptor = -1;
+#endif
+	m_filePath.clear();
+	m_numMoves = 0;
+	m_numUnsyncedRecords = 0;
+}
+
+void ChessGameLog::SetSyncBatch(int numRecords, float seconds)
+{
+	m_syncEveryRecords = (numRecords > 0) ? numRecords : 1;
+	m_syncEverySeconds = seconds;
+}
+
+bool ChessGameLog::IsOpen() const
+{
+#if defined(_WIN32)
+	return m_fileHandle != nullptr;
+#else
+	return m_fileDescriptor >= 0;
+#endif
+}
+
+bool ChessGameLog::WriteBytes(void const* data, size_t numBytes)
+{
+	uint8_t const* bytes = static_cast<uint8_t const*>(data);
+	while (numBytes > 0)
+	{
+#if defined(_WIN32)
+		DWORD numWritten = 0;
+		if (!::WriteFile(static_cast<HANDLE>(m_fileHandle), bytes, static_cast<DWORD>(numBytes), &numWritten, nullptr) || numWritten == 0)
+		{
+			return false;
+		}
+#else
+		ssize_t numWritten = write(m_fileDescriptor, bytes, numBytes);
+		if (numWritten <= 0)
+		{
+			return false;
+		}
+#endif
+		bytes += numWritten;
+		numBytes -= static_cast<size_t>(numWritten);
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+bool ChessGameLog::WriteFile(std::string const& filePath, ChessGameLogHeader const& header, std::vector<uint16_t> const& moves)
+{
+	ChessGameLog gameLog;
+	if (!gameLog.Create(filePath, header))
+	{
+		return false;
+	}
+
+	// One write and one sync for the whole game
+	std::vector<uint8_t> recordBytes;
+	recordBytes.reserve(moves.size() * CHESS_LOG_RECORD_SIZE);
+	for (uint16_t encodedMove : moves)
+	{
+		uint8_t bytes[CHESS_LOG_RECORD_SIZE];
+		GetRecordBytes(encodedMove, gameLog.m_runningChecksum, bytes);
+		recordBytes.insert(recordBytes.end(), bytes, bytes + CHESS_LOG_RECORD_SIZE);
+	}
+	gameLog.m_numUnsyncedRecords = static_cast<int>(moves.size());
+	bool isWritten = gameLog.WriteBytes(recordBytes.data(), recordBytes.size()) && gameLog.Sync();
+	gameLog.Close();
+	return isWritten;
+}
+
+bool ChessGameLog::ReadFile(std::string const& filePath, ChessGameLogHeader& out_header, std::vector<uint16_t>& out_moves, bool& out_wasTruncated)
+{
+	out_moves.clear();
+	out_wasTruncated = false;
+
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if (bytes.size() < 12 || !std::equal(CHESS_LOG_MAGIC, CHESS_LOG_MAGIC + 4, bytes.begin()) || ReadLittleEndian16(&bytes[4]) != CHESS_LOG_VERSION)
+	{
+		return false;
+	}
+	size_t headerSize = ReadLittleEndian16(&bytes[6]);
+	if (headerSize < 20 || headerSize > bytes.size())
+	{
+		return false;
+	}
+	uint32_t headerChecksum = ReadLittleEndian32(&bytes[headerSize - 4]);
+	if (UpdateCRC32(0, bytes.data(), headerSize - 4) != headerChecksum)
+	{
+		return false;
+	}
+
+	size_t cursor = 8;
+	out_header.m_initialClockMS = ReadLittleEndian32(&bytes[cursor]);
+	out_header.m_incrementMS = ReadLittleEndian32(&bytes[cursor + 4]);
+	cursor += 8;
+	if (!ReadShortText(bytes, cursor, headerSize - 4, out_header.m_playerNames[0]) ||
+		!ReadShortText(bytes, cursor, headerSize - 4, out_header.m_playerNames[1]) ||
+		!ReadShortText(bytes, cursor, headerSize - 4, out_header.m_startFEN))
+	{
+		return false;
+	}
+
+	// Keep every record whose check matches; the first one that doesn't is where a write was cut short
+	uint32_t runningChecksum = headerChecksum;
+	out_moves.reserve((bytes.size() - headerSize) / CHESS_LOG_RECORD_SIZE);
+	for (cursor = headerSize; cursor + CHESS_LOG_RECORD_SIZE <= bytes.size(); cursor += CHESS_LOG_RECORD_SIZE)
+	{
+		uint16_t encodedMove = ReadLittleEndian16(&bytes[cursor]);
+		uint8_t expectedBytes[CHESS_LOG_RECORD_SIZE];
+		GetRecordBytes(encodedMove, runningChecksum, expectedBytes);
+		if (ReadLittleEndian16(&bytes[cursor + 2]) != ReadLittleEndian16(&expectedBytes[2]))
+		{
+			break;
+		}
+		out_moves.push_back(encodedMove);
+	}
+	out_wasTruncated = (cursor != bytes.size());
+	return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+// Moves are ChessMove::GetPacked() values; the spare top bit marks the board's debug teleports
+constexpr uint16_t CHESS_LOG_TELEPORT_BIT = 0x8000;
+// -----------------------------------------------------------------------------
+struct ChessGameLogHeader
+{
+public:
+	std::string m_playerNames[2];
+	uint32_t	m_initialClockMS = 0;
+	uint32_t	m_incrementMS = 0;
+	std::string m_startFEN;		// Empty for the standard starting layout
+};
+// -----------------------------------------------------------------------------
+// Binary game record (.cgl). A checksummed header is followed by 4-byte move records: the 16-bit
+// move and the low half of a CRC32 running over the header and every move so far. A record torn by
+// a crash fails its check, so readers keep exactly the moves that were completely written.
+//
+// While a match is played the log is an append-only journal: each move is one small write, and the
+// data is forced to disk in batches (every few records, on the first move after a quiet spell, and on Close).
+// -----------------------------------------------------------------------------
+class ChessGameLog
+{
+public:
+	ChessGameLog() = default;
+	~ChessGameLog();
+	ChessGameLog(ChessGameLog const& copy) = delete;
+	ChessGameLog& operator=(ChessGameLog const& copy) = delete;
+
+	// Journal writing
+	bool Create(std::string const& filePath, ChessGameLogHeader const& header);		// Replaces any existing file
+	bool AppendMove(uint16_t encodedMove);
+	bool Sync();
+	void Close();
+	void SetSyncBatch(int numRecords, float seconds);
+
+	bool			   IsOpen() const;
+	int				   GetNumMoves() const { return m_numMoves; }
+	std::string const& GetFilePath() const { return m_filePath; }
+
+	// Whole files
+	static bool WriteFile(std::string const& filePath, ChessGameLogHeader const& header, std::vector<uint16_t> const& moves);
+	static bool ReadFile(std::string const& filePath, ChessGameLogHeader& out_header, std::vector<uint16_t>& out_moves, bool& out_wasTruncated);
+
+private:
+	bool WriteBytes(void const* data, size_t numBytes);
+
+private:
+	std::string m_filePath;
+	uint32_t	m_runningChecksum = 0;
+	int			m_numMoves = 0;
+	int			m_numUnsyncedRecords = 0;
+	int			m_syncEveryRecords = 8;
+	float		m_syncEverySeconds = 2.f;
+	std::chrono::steady_clock::time_point m_lastSyncTime;
+#if defined(_WIN32)
+	void* m_fileHandle = nullptr;
+#else
+	int	  m_fileDescriptor = -1;
+#endif
+};
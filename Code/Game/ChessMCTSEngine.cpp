@@ -0,0 +1,466 @@
+#include "Game/ChessMCTSEngine.hpp"
+#include "Game/ChessEvaluation.hpp"
+#include "Game/ChessTablebase.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+constexpr float MCTS_VALUE_SCALE = 65536.f;
+constexpr float MCTS_FIRST_PLAY_REDUCTION = 0.1f;
+constexpr uint64_t PLAYOUTS_BETWEEN_TIME_CHECKS = 16;
+// -----------------------------------------------------------------------------
+
+static float GetTerminalValueForSideToMove(ChessPosition const& position, bool hasLegalMove)
+{
+	if (!hasLegalMove)
+	{
+		return position.IsInCheck(position.GetSideToMove()) ? 0.f : 0.5f;
+	}
+	return 0.5f;
+}
+
+static bool IsDrawnPosition(ChessPosition const& position)
+{
+	return position.m_halfmoveClock >= 100 || position.IsInsufficientMaterial();
+}
+
+void ChessMCTSPolicy::ComputePriors(ChessPosition const& position, ChessMoveList const& moves, float* out_priors) const
+{
+	// Softmax over a cheap move heuristic: winning captures and promotions first, quiet moves flat
+	float maxLogit = -1e9f;
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = moves[moveIndex];
+		float logit = 0.f;
+		if (move.IsCapture())
+		{
+			uint8_t victimCode = position.GetPieceAt(move.m_to);
+			int victimValue = (victimCode == CHESS_EMPTY_SQUARE) ? GetChessPieceValue(ChessPieceType::PAWN) : GetChessPieceValue(GetChessPieceTypeForCode(victimCode));
+			int attackerValue = GetChessPieceValue(GetChessPieceTypeForCode(position.GetPieceAt(move.m_from)));
+			logit += 1.f + static_cast<float>(victimValue - std::min(attackerValue, 1000) / 10) / 300.f;
+		}
+		if (move.IsPromotion())
+		{
+			logit += (move.GetPromotionType() == ChessPieceType::QUEEN) ? 2.5f : -1.f;
+		}
+		out_priors[moveIndex] = logit;
+		maxLogit = std::max(maxLogit, logit);
+	}
+
+	float sum = 0.f;
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		out_priors[moveIndex] = std::exp(out_priors[moveIndex] - maxLogit);
+		sum += out_priors[moveIndex];
+	}
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		out_priors[moveIndex] /= sum;
+	}
+}
+
+ChessMCTSPolicy* ChessMCTSPolicy::CreatePolicy(ChessMCTSPolicyType policyType)
+{
+	switch (policyType)
+	{
+		case ChessMCTSPolicyType::ROLLOUT:	return new ChessRolloutPolicy();
+		default:							return new ChessEvaluationPolicy();
+	}
+}
+
+float ChessRolloutPolicy::EvaluateLeaf(ChessPosition const& position, std::mt19937_64& rng) const
+{
+	ChessPosition rolloutPosition = position;
+	int rootSideToMove = position.GetSideToMove();
+
+	for (int ply = 0; ply < m_maxRolloutPlies; ++ply)
+	{
+		if (IsDrawnPosition(rolloutPosition))
+		{
+			return 0.5f;
+		}
+
+		ChessMoveList moves;
+		rolloutPosition.GenerateLegalMoves(moves);
+		if (moves.m_count == 0)
+		{
+			float value = GetTerminalValueForSideToMove(rolloutPosition, false);
+			return (rolloutPosition.GetSideToMove() == rootSideToMove) ? value : 1.f - value;
+		}
+
+		// Captures are tried first half of the time so playouts do not hang material at random
+		int moveIndex = static_cast<int>(rng() % static_cast<uint64_t>(moves.m_count));
+		if ((rng() & 1) != 0)
+		{
+			int captureOffset = moveIndex;
+			for (int tryIndex = 0; tryIndex < moves.m_count; ++tryIndex)
+			{
+				int candidateIndex = (captureOffset + tryIndex) % moves.m_count;
+				if (moves[candidateIndex].IsCapture() || moves[candidateIndex].IsPromotion())
+				{
+					moveIndex = candidateIndex;
+					break;
+				}
+			}
+		}
+		rolloutPosition.MakeMove(moves[moveIndex]);
+	}
+
+	float value = GetWinProbabilityForScore(EvaluateChessPosition(rolloutPosition));
+	return (rolloutPosition.GetSideToMove() == rootSideToMove) ? value : 1.f - value;
+}
+
+static int SearchPolicyQuiescence(ChessPosition const& position, int alpha, int beta, int pliesLeft)
+{
+	int standPat = EvaluateChessPosition(position);
+	if (standPat >= beta || pliesLeft <= 0)
+	{
+		return standPat;
+	}
+	alpha = std::max(alpha, standPat);
+
+	ChessMoveList captures;
+	position.GenerateLegalCaptures(captures);
+	for (int moveIndex = 0; moveIndex < captures.m_count; ++moveIndex)
+	{
+		ChessPosition childPosition = position;
+		childPosition.MakeMove(captures[moveIndex]);
+		int score = -SearchPolicyQuiescence(childPosition, -beta, -alpha, pliesLeft - 1);
+		if (score >= beta)
+		{
+			return score;
+		}
+		alpha = std::max(alpha, score);
+	}
+	return alpha;
+}
+
+float ChessEvaluationPolicy::EvaluateLeaf(ChessPosition const& position, std::mt19937_64& rng) const
+{
+	UNUSED(rng);
+	int score = SearchPolicyQuiescence(position, -CHESS_MATE_SCORE, CHESS_MATE_SCORE, m_maxQuiescencePlies);
+	return GetWinProbabilityForScore(score);
+}
+
+ChessMCTSEngine::ChessMCTSEngine(int maxTreeNodes)
+	: m_maxTreeNodes(maxTreeNodes)
+{
+}
+
+ChessMCTSEngine::~ChessMCTSEngine()
+{
+	delete m_policy;
+	m_policy = nullptr;
+}
+
+void ChessMCTSEngine::SetPolicy(ChessMCTSPolicy* policy)
+{
+	delete m_policy;
+	m_policy = policy;
+	m_isPolicyOverridden = (policy != nullptr);
+}
+
+ChessSearchResult ChessMCTSEngine::Search(ChessPosition const& position, ChessSearchLimits const& limits)
+{
+	m_isStopRequested = false;
+	m_searchStartTime = std::chrono::steady_clock::now();
+	m_maxSeconds = limits.m_maxSeconds;
+	m_maxPlayouts = limits.m_maxNodes;
+	m_maxDepth = std::max(1, limits.m_maxDepth);
+	m_numPlayouts = 0;
+	m_maxReachedDepth = 0;
+	m_useTablebases = limits.m_useTablebases;
+	m_tablebaseHits = 0;
+
+	if (!m_isPolicyOverridden)
+	{
+		delete m_policy;
+		m_policy = ChessMCTSPolicy::CreatePolicy(limits.m_mctsPolicy);
+	}
+
+	// The pool is allocated once and reused; a fresh tree starts at node 0 every search
+	if (static_cast<int>(m_nodes.size()) != m_maxTreeNodes)
+	{
+		m_nodes = std::vector<ChessMCTSNode>(m_maxTreeNodes);
+	}
+	ChessMCTSNode& rootNode = m_nodes[0];
+	rootNode.m_move = ChessMove();
+	rootNode.m_prior = 1.f;
+	rootNode.m_visits = 0;
+	rootNode.m_virtualLoss = 0;
+	rootNode.m_valueSum = 0;
+	rootNode.m_state = ChessMCTSNodeState::LEAF;
+	m_numAllocatedNodes = 1;
+
+	ChessSearchResult result;
+	if (ProbeTablebaseRoot(position, result))
+	{
+		result.m_seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_searchStartTime).count();
+		result.m_bestMoveSeconds = result.m_seconds;
+		return result;
+	}
+	if (!ExpandNode(rootNode, position) || rootNode.m_numChildren == 0)
+	{
+		return result;
+	}
+
+	// A single legal reply needs no search
+	if (rootNode.m_numChildren > 1)
+	{
+		int numThreads = std::max(1, limits.m_numThreads);
+		std::vector<std::thread> helperThreads;
+		for (int threadIndex = 1; threadIndex < numThreads; ++threadIndex)
+		{
+			helperThreads.emplace_back([this, &position, threadIndex]()
+			{
+				RunWorker(threadIndex, position);
+			});
+		}
+		RunWorker(0, position);
+
+		m_isStopRequested = true;
+		for (std::thread& helperThread : helperThreads)
+		{
+			helperThread.join();
+		}
+	}
+
+	// Most visited child is the most robust choice; value breaks ties
+	ChessMCTSNode const* bestChild = nullptr;
+	for (int childIndex = 0; childIndex < rootNode.m_numChildren; ++childIndex)
+	{
+		ChessMCTSNode const& child = m_nodes[rootNode.m_firstChildIndex + childIndex];
+		if (child.m_state.load(std::memory_order_acquire) == ChessMCTSNodeState::TERMINAL && child.m_terminalValue == 0.f)
+		{
+			bestChild = &child;
+			break;
+		}
+		if (bestChild == nullptr || child.m_visits > bestChild->m_visits ||
+			(child.m_visits == bestChild->m_visits && GetMeanValue(child) > GetMeanValue(*bestChild)))
+		{
+			bestChild = &child;
+		}
+	}
+
+	float winProbability = (bestChild->m_visits > 0) ? GetMeanValue(*bestChild) : 0.5f;
+	winProbability = std::min(std::max(winProbability, 0.001f), 0.999f);
+	result.m_bestMove = bestChild->m_move;
+	result.m_score = static_cast<int>(-400.f * std::log10(1.f / winProbability - 1.f));
+	result.m_depth = m_maxReachedDepth;
+	result.m_nodes = m_numPlayouts;
+	result.m_tablebaseHits = m_tablebaseHits;
+	result.m_seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_searchStartTime).count();
+
+	// Visit counts only settle at the end; the whole search is the time to the move
+	result.m_bestMoveSeconds = result.m_seconds;
+	result.m_bestMoveNodes = result.m_nodes;
+	return result;
+}
+
+void ChessMCTSEngine::RunWorker(int threadIndex, ChessPosition const& rootPosition)
+{
+	std::mt19937_64 rng(0x9E3779B97F4A7C15ull * static_cast<uint64_t>(threadIndex + 1) ^ static_cast<uint64_t>(m_searchStartTime.time_since_epoch().count()));
+	int path[CHESS_MAX_MOVES];
+	uint64_t localPlayouts = 0;
+
+	while (!IsStopRequested())
+	{
+		if ((localPlayouts % PLAYOUTS_BETWEEN_TIME_CHECKS) == 0 && ShouldStop())
+		{
+			m_isStopRequested = true;
+			break;
+		}
+
+		// Selection: descend with virtual loss so other threads prefer different lines
+		ChessPosition position = rootPosition;
+		int pathLength = 0;
+		int nodeIndex = 0;
+		path[pathLength++] = nodeIndex;
+		while (m_nodes[nodeIndex].m_state.load(std::memory_order_acquire) == ChessMCTSNodeState::EXPANDED &&
+			m_nodes[nodeIndex].m_numChildren > 0 && pathLength < std::min(m_maxDepth + 1, CHESS_MAX_MOVES))
+		{
+			nodeIndex = SelectChild(m_nodes[nodeIndex]);
+			m_nodes[nodeIndex].m_virtualLoss += m_virtualLossCount;
+			position.MakeMove(m_nodes[nodeIndex].m_move);
+			path[pathLength++] = nodeIndex;
+		}
+
+		// Expansion + evaluation, value from the side to move at the leaf
+		ChessMCTSNode& leafNode = m_nodes[nodeIndex];
+		float value = 0.5f;
+		ChessWDLScore tablebaseWDL = ChessWDLScore::DRAW;
+		if (leafNode.m_state.load(std::memory_order_acquire) == ChessMCTSNodeState::TERMINAL)
+		{
+			value = leafNode.m_terminalValue;
+		}
+		else if (pathLength > 1 && IsDrawnPosition(position))
+		{
+			value = 0.5f;
+		}
+		else if (pathLength > 1 && m_useTablebases && position.m_halfmoveClock == 0 && g_chessTablebases.ProbeWDL(position, tablebaseWDL))
+		{
+			// Exact result after a capture or pawn move; the leaf stays unexpanded
+			m_tablebaseHits.fetch_add(1, std::memory_order_relaxed);
+			value = (tablebaseWDL == ChessWDLScore::WIN) ? 1.f : ((tablebaseWDL == ChessWDLScore::LOSS) ? 0.f : 0.5f);
+		}
+		else
+		{
+			ExpandNode(leafNode, position);
+			if (leafNode.m_state.load(std::memory_order_acquire) == ChessMCTSNodeState::TERMINAL)
+			{
+				value = leafNode.m_terminalValue;
+			}
+			else
+			{
+				value = m_policy->EvaluateLeaf(position, rng);
+			}
+		}
+
+		// Backpropagation: each node stores value for the player who moved into it
+		for (int pathIndex = pathLength - 1; pathIndex >= 0; --pathIndex)
+		{
+			ChessMCTSNode& pathNode = m_nodes[path[pathIndex]];
+			value = 1.f - value;
+			AddValue(pathNode, value);
+			pathNode.m_visits.fetch_add(1, std::memory_order_relaxed);
+			if (pathIndex > 0)
+			{
+				pathNode.m_virtualLoss -= m_virtualLossCount;
+			}
+		}
+
+		int reachedDepth = pathLength - 1;
+		int previousMaxDepth = m_maxReachedDepth.load(std::memory_order_relaxed);
+		while (reachedDepth > previousMaxDepth && !m_maxReachedDepth.compare_exchange_weak(previousMaxDepth, reachedDepth))
+		{
+		}
+
+		++localPlayouts;
+		m_numPlayouts.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+int ChessMCTSEngine::SelectChild(ChessMCTSNode const& node) const
+{
+	int parentVisits = node.m_visits.load(std::memory_order_relaxed) + node.m_virtualLoss.load(std::memory_order_relaxed);
+	float explorationScale = m_explorationConstant * std::sqrt(static_cast<float>(std::max(parentVisits, 1)));
+
+	// Unvisited children start slightly below the parent's value from the mover's point of view
+	float parentValue = (node.m_visits > 0) ? GetMeanValue(node) : 0.5f;
+	float firstPlayValue = std::max(0.f, 1.f - parentValue - MCTS_FIRST_PLAY_REDUCTION);
+
+	int bestChildIndex = node.m_firstChildIndex;
+	float bestScore = -1e9f;
+	for (int childOffset = 0; childOffset < node.m_numChildren; ++childOffset)
+	{
+		int childIndex = node.m_firstChildIndex + childOffset;
+		ChessMCTSNode const& child = m_nodes[childIndex];
+		if (child.m_state.load(std::memory_order_acquire) == ChessMCTSNodeState::TERMINAL && child.m_terminalValue == 0.f)
+		{
+			// Proven win for the mover: a checkmate reply is never worth exploring around
+			return childIndex;
+		}
+
+		int visits = child.m_visits.load(std::memory_order_relaxed);
+		int virtualLoss = child.m_virtualLoss.load(std::memory_order_relaxed);
+		int effectiveVisits = visits + virtualLoss;
+
+		// Virtual loss counts as lost playouts: more visits, no added value
+		float meanValue = firstPlayValue;
+		if (effectiveVisits > 0)
+		{
+			meanValue = (static_cast<float>(child.m_valueSum.load(std::memory_order_relaxed)) / MCTS_VALUE_SCALE) / static_cast<float>(effectiveVisits);
+			if (visits == 0)
+			{
+				meanValue = std::min(meanValue, firstPlayValue);
+			}
+		}
+		float score = meanValue + explorationScale * child.m_prior / static_cast<float>(1 + effectiveVisits);
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestChildIndex = childIndex;
+		}
+	}
+	return bestChildIndex;
+}
+
+bool ChessMCTSEngine::ExpandNode(ChessMCTSNode& node, ChessPosition const& position)
+{
+	ChessMCTSNodeState expectedState = ChessMCTSNodeState::LEAF;
+	if (!node.m_state.compare_exchange_strong(expectedState, ChessMCTSNodeState::EXPANDING, std::memory_order_acq_rel))
+	{
+		// Another thread owns this expansion; the caller just evaluates the leaf
+		return expectedState == ChessMCTSNodeState::EXPANDED;
+	}
+
+	ChessMoveList moves;
+	position.GenerateLegalMoves(moves);
+	if (moves.m_count == 0)
+	{
+		node.m_terminalValue = GetTerminalValueForSideToMove(position, false);
+		node.m_numChildren = 0;
+		node.m_state.store(ChessMCTSNodeState::TERMINAL, std::memory_order_release);
+		return true;
+	}
+
+	// Reserved only while it fits, so a full pool stays full instead of the count running on past it
+	int firstChildIndex = m_numAllocatedNodes.load(std::memory_order_relaxed);
+	do
+	{
+		if (firstChildIndex > m_maxTreeNodes - moves.m_count)
+		{
+			// Pool exhausted: keep the node as a leaf and let the policy value it from now on
+			node.m_state.store(ChessMCTSNodeState::LEAF, std::memory_order_release);
+			return false;
+		}
+	}
+	while (!m_numAllocatedNodes.compare_exchange_weak(firstChildIndex, firstChildIndex + moves.m_count, std::memory_order_relaxed));
+
+	float priors[CHESS_MAX_MOVES];
+	m_policy->ComputePriors(position, moves, priors);
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMCTSNode& child = m_nodes[firstChildIndex + moveIndex];
+		child.m_move = moves[moveIndex];
+		child.m_prior = priors[moveIndex];
+		child.m_terminalValue = 0.f;
+		child.m_firstChildIndex = -1;
+		child.m_numChildren = 0;
+		child.m_visits.store(0, std::memory_order_relaxed);
+		child.m_virtualLoss.store(0, std::memory_order_relaxed);
+		child.m_valueSum.store(0, std::memory_order_relaxed);
+		child.m_state.store(ChessMCTSNodeState::LEAF, std::memory_order_relaxed);
+	}
+	node.m_firstChildIndex = firstChildIndex;
+	node.m_numChildren = moves.m_count;
+	node.m_state.store(ChessMCTSNodeState::EXPANDED, std::memory_order_release);
+	return true;
+}
+
+bool ChessMCTSEngine::ShouldStop() const
+{
+	if (m_maxPlayouts != 0 && m_numPlayouts.load(std::memory_order_relaxed) >= m_maxPlayouts)
+	{
+		return true;
+	}
+	float elapsedSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_searchStartTime).count();
+	return m_maxSeconds > 0.f && elapsedSeconds >= m_maxSeconds;
+}
+
+void ChessMCTSEngine::AddValue(ChessMCTSNode& node, float value)
+{
+	node.m_valueSum.fetch_add(static_cast<int64_t>(value * MCTS_VALUE_SCALE), std::memory_order_relaxed);
+}
+
+float ChessMCTSEngine::GetMeanValue(ChessMCTSNode const& node) const
+{
+	int visits = node.m_visits.load(std::memory_order_relaxed);
+	if (visits <= 0)
+	{
+		return 0.5f;
+	}
+	return (static_cast<float>(node.m_valueSum.load(std::memory_order_relaxed)) / MCTS_VALUE_SCALE) / static_cast<float>(visits);
+}
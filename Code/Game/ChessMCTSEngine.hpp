@@ -0,0 +1,109 @@
+#pragma once
+#include "Game/ChessEngine.hpp"
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <vector>
+// -----------------------------------------------------------------------------
+// Leaf policy plugged into the MCTS engine. Values are win probabilities in [0,1]
+// from the point of view of the side to move in the given position.
+// -----------------------------------------------------------------------------
+class ChessMCTSPolicy
+{
+public:
+	virtual ~ChessMCTSPolicy() = default;
+	virtual float EvaluateLeaf(ChessPosition const& position, std::mt19937_64& rng) const = 0;
+	virtual void  ComputePriors(ChessPosition const& position, ChessMoveList const& moves, float* out_priors) const;
+
+	static ChessMCTSPolicy* CreatePolicy(ChessMCTSPolicyType policyType);
+};
+// -----------------------------------------------------------------------------
+class ChessRolloutPolicy : public ChessMCTSPolicy
+{
+public:
+	ChessRolloutPolicy(int maxRolloutPlies = 32) : m_maxRolloutPlies(maxRolloutPlies) {}
+	float EvaluateLeaf(ChessPosition const& position, std::mt19937_64& rng) const override;
+
+private:
+	int m_maxRolloutPlies = 32;
+};
+// -----------------------------------------------------------------------------
+class ChessEvaluationPolicy : public ChessMCTSPolicy
+{
+public:
+	ChessEvaluationPolicy(int maxQuiescencePlies = 6) : m_maxQuiescencePlies(maxQuiescencePlies) {}
+	float EvaluateLeaf(ChessPosition const& position, std::mt19937_64& rng) const override;
+
+private:
+	int m_maxQuiescencePlies = 6;
+};
+// -----------------------------------------------------------------------------
+enum class ChessMCTSNodeState : uint8_t
+{
+	LEAF,
+	EXPANDING,
+	EXPANDED,
+	TERMINAL
+};
+// -----------------------------------------------------------------------------
+// Children of a node are allocated as one contiguous block of the engine's node pool.
+// Statistics are atomics so worker threads share one tree without locks; m_valueSum is
+// fixed point and stored from the view of the player who played m_move.
+// -----------------------------------------------------------------------------
+struct ChessMCTSNode
+{
+public:
+	ChessMove m_move;
+	float	  m_prior = 0.f;
+	float	  m_terminalValue = 0.f;
+	int		  m_firstChildIndex = -1;
+	int		  m_numChildren = 0;
+	std::atomic<int>	 m_visits = 0;
+	std::atomic<int>	 m_virtualLoss = 0;
+	std::atomic<int64_t> m_valueSum = 0;
+	std::atomic<ChessMCTSNodeState> m_state = ChessMCTSNodeState::LEAF;
+};
+// -----------------------------------------------------------------------------
+// PUCT tree search with virtual loss. Every worker thread descends the same tree; the
+// virtual loss added on the way down steers concurrent threads onto different lines.
+// -----------------------------------------------------------------------------
+class ChessMCTSEngine : public ChessEngine
+{
+public:
+	ChessMCTSEngine(int maxTreeNodes = 1 << 21);
+	~ChessMCTSEngine();
+
+	ChessSearchResult Search(ChessPosition const& position, ChessSearchLimits const& limits) override;
+	ChessEngineType	  GetType() const override { return ChessEngineType::MCTS; }
+
+	// Overrides the policy chosen through ChessSearchLimits; the engine takes ownership
+	void SetPolicy(ChessMCTSPolicy* policy);
+
+public:
+	float m_explorationConstant = 1.5f;
+	int	  m_virtualLossCount = 3;
+
+private:
+	void RunWorker(int threadIndex, ChessPosition const& rootPosition);
+	int	 SelectChild(ChessMCTSNode const& node) const;
+	bool ExpandNode(ChessMCTSNode& node, ChessPosition const& position);
+	bool ShouldStop() const;
+
+	void  AddValue(ChessMCTSNode& node, float value);
+	float GetMeanValue(ChessMCTSNode const& node) const;
+
+private:
+	int m_maxTreeNodes = 0;
+	std::vector<ChessMCTSNode> m_nodes;
+	std::atomic<int> m_numAllocatedNodes = 0;
+
+	ChessMCTSPolicy* m_policy = nullptr;
+	bool			 m_isPolicyOverridden = false;
+
+	std::chrono::steady_clock::time_point m_searchStartTime;
+	float	 m_maxSeconds = 1.f;
+	uint64_t m_maxPlayouts = 0;
+	int		 m_maxDepth = 64;
+	std::atomic<uint64_t> m_numPlayouts = 0;
+	std::atomic<int>	  m_maxReachedDepth = 0;
+};
@@ -0,0 +1,123 @@
+#include "Game/ChessMappedFile.hpp"
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ChessMappedFile::~ChessMappedFile()
+{
+	Close();
+}
+
+bool ChessMappedFile::Open(std::string const& filePath)
+{
+	Close();
+
+#if defined(_WIN32)
+	HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	m_fileHandle = fileHandle;
+	m_mappingHandle = mappingHandle;
+	m_data = static_cast<uint8_t const*>(view);
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStats = {};
+	if (fstat(fileDescriptor, &fileStats) != 0 || fileStats.st_size == 0)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+
+	// The mapping keeps its own reference to the file, so the descriptor can go straight away
+	void* view = mmap(nullptr, static_cast<size_t>(fileStats.st_size), PROT_READ, MAP_SHARED, fileDescriptor, 0);
+	close(fileDescriptor);
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_data = static_cast<uint8_t const*>(view);
+	m_size = static_cast<size_t>(fileStats.st_size);
+#endif
+
+	m_filePath = filePath;
+	return true;
+}
+
+void ChessMappedFile::Close()
+{
+	if (m_data == nullptr)
+	{
+		return;
+	}
+
+#if defined(_WIN32)
+	UnmapViewOfFile(m_data);
+	CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+	CloseHandle(static_cast<HANDLE>(m_fileHandle));
+	m_mappingHandle = nullptr;
+	m_fileHandle = nullptr;
+#else
+	munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+	m_filePath.clear();
+}
+
+void ChessMappedFile::ReleasePages(size_t offset, size_t size) const
+{
+	// Only whole pages inside the range, so neighbouring data still being read is never touched
+	size_t const pageSize = 4096;
+	size_t firstPage = (offset + pageSize - 1) & ~(pageSize - 1);
+	size_t endPage = (offset + size) & ~(pageSize - 1);
+	if (m_data == nullptr || endPage <= firstPage || offset + size > m_size)
+	{
+		return;
+	}
+
+#if defined(_WIN32)
+	// Unlocking pages that were never locked takes them out of the working set
+	VirtualUnlock(const_cast<uint8_t*>(m_data + firstPage), endPage - firstPage);
+#else
+	madvise(const_cast<uint8_t*>(m_data + firstPage), endPage - firstPage, MADV_DONTNEED);
+#endif
+}
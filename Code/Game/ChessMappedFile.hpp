@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+// -----------------------------------------------------------------------------
+// Read-only memory map of a whole file. The pages belong to the OS file cache, so every
+// process mapping the same book or table shares one copy and nothing lands on the heap.
+// -----------------------------------------------------------------------------
+class ChessMappedFile
+{
+public:
+	ChessMappedFile() = default;
+	~ChessMappedFile();
+	ChessMappedFile(ChessMappedFile const& copy) = delete;
+	ChessMappedFile& operator=(ChessMappedFile const& copy) = delete;
+
+	bool Open(std::string const& filePath);
+	void Close();
+
+	// Drops already-read pages from this process's working set; they fault back in from the file if touched again
+	void ReleasePages(size_t offset, size_t size) const;
+
+	bool		   IsOpen() const { return m_data != nullptr; }
+	uint8_t const* GetData() const { return m_data; }
+	size_t		   GetSize() const { return m_size; }
+	std::string const& GetFilePath() const { return m_filePath; }
+
+private:
+	uint8_t const* m_data = nullptr;
+	size_t		   m_size = 0;
+	std::string	   m_filePath;
+#if defined(_WIN32)
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+#endif
+};
+// -----------------------------------------------------------------------------
+inline uint16_t ReadBigEndian16(uint8_t const* bytes)
+{
+	return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+}
+
+inline uint32_t ReadBigEndian32(uint8_t const* bytes)
+{
+	return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+}
+
+inline uint64_t ReadBigEndian64(uint8_t const* bytes)
+{
+	return (static_cast<uint64_t>(ReadBigEndian32(bytes)) << 32) | ReadBigEndian32(bytes + 4);
+}
+
+inline uint16_t ReadLittleEndian16(uint8_t const* bytes)
+{
+	return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+inline uint32_t ReadLittleEndian32(uint8_t const* bytes)
+{
+	return bytes[0] | (static_cast<uint32_t>(bytes[1]) << 8) | (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+inline uint64_t ReadLittleEndian64(uint8_t const* bytes)
+{
+	return ReadLittleEndian32(bytes) | (static_cast<uint64_t>(ReadLittleEndian32(bytes + 4)) << 32);
+}
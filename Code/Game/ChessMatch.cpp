@@ -1,5 +1,10 @@
 #include "Game/ChessMatch.hpp"
+#include "Game/ChessGameArchive.hpp"
+#include "Game/ChessMateFinder.hpp"
+#include "Game/ChessPGN.hpp"
+#include "Game/ChessSavedGameReader.hpp"
 #include "Game/ChessPlayer.hpp"
+#include "Game/ChessTablebase.hpp"
 #include "Game/Game.h"
 #include "Game/GameCommon.h"
 #include "Engine/Core/EngineCommon.h"
@@ -10,7 +15,104 @@
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/Math/MathUtils.h"
 #include "Engine/Input/InputSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// -----------------------------------------------------------------------------
+// FEN in console and network arguments: the spaces may be written as '_' so the value survives
+// RemoteCmd, which rebuilds commands from key=value pairs without quotes
+// -----------------------------------------------------------------------------
+static std::string GetFENForArgument(std::string fenArgument)
+{
+	std::replace(fenArgument.begin(), fenArgument.end(), '_', ' ');
+	return fenArgument;
+}
+
+static std::string GetArgumentForFEN(std::string fen)
+{
+	std::replace(fen.begin(), fen.end(), ' ', '_');
+	return fen;
+}
+
+static bool IsResyncAuthority()
+{
+	// Whose copy of the match wins when two disagree: a direct link's host or the text network's server.
+	// In a match server's room neither player is; the server is, and answers RESYNC itself
+	if (g_theGame->m_wireLink.IsConnected())
+	{
+		return g_theGame->m_wireRoomId == 0 && g_theGame->m_wireLink.IsHost();
+	}
+	return g_theNetwork->IsServer();
+}
+
+static int FindFirstFENMismatch(std::string const& fenA, std::string const& fenB)
+{
+	// Index of the first differing space-separated field, or -1 when they agree
+	char const* cursorA = fenA.c_str();
+	char const* cursorB = fenB.c_str();
+	for (int fieldIndex = 0; *cursorA != '\0' || *cursorB != '\0'; ++fieldIndex)
+	{
+		while (*cursorA != '\0' && *cursorA != ' ' && *cursorA == *cursorB)
+		{
+			++cursorA;
+			++cursorB;
+		}
+		bool isEndOfFieldA = (*cursorA == '\0' || *cursorA == ' ');
+		bool isEndOfFieldB = (*cursorB == '\0' || *cursorB == ' ');
+		if (!isEndOfFieldA || !isEndOfFieldB)
+		{
+			return fieldIndex;
+		}
+		cursorA += (*cursorA == ' ') ? 1 : 0;
+		cursorB += (*cursorB == ' ') ? 1 : 0;
+	}
+	return -1;
+}
+
+// -----------------------------------------------------------------------------
+// The journal of the match in progress; at shutdown it becomes LastMatch.cgl, and if it is still
+// here at startup the game crashed and it is kept as RecoveredMatch.cgl
+// -----------------------------------------------------------------------------
+static char const* const GAME_JOURNAL_FILE_PATH = "Data/SavedGames/ActiveMatch.cgl";
+static char const* const LAST_MATCH_LOG_FILE_PATH = "Data/SavedGames/LastMatch.cgl";
+static char const* const RECOVERED_MATCH_LOG_FILE_PATH = "Data/SavedGames/RecoveredMatch.cgl";
+static char const* const COMPLETED_MATCH_FILE_PATH = "Data/SavedGames/CompletedMatch.xml";
+
+// How far the mover's clock may be from ours when its move arrives, allowing for the link's latency
+static float const REMOTE_CLOCK_TOLERANCE_SECONDS = 0.5f;
+
+static void ReplaceFile(char const* sourceFilePath, char const* destinationFilePath)
+{
+	std::remove(destinationFilePath);
+	std::rename(sourceFilePath, destinationFilePath);
+}
+
+static std::string GetFileExtension(std::string const& fileName)
+{
+	size_t extensionStart = fileName.find_last_of('.');
+	return (extensionStart == std::string::npos) ? "" : fileName.substr(extensionStart);
+}
+
+static ChessPosition GetPositionForStartFEN(std::string const& startFEN)
+{
+	ChessPosition position = ChessPosition::GetStartingPosition();
+	if (!startFEN.empty())
+	{
+		position.SetFromFEN(startFEN.c_str());
+	}
+	return position;
+}
 
+static char const* GetFENFieldName(int fieldIndex)
+{
+	static char const* const FIELD_NAMES[] = { "piece placement", "side to move", "castling rights", "en passant square", "halfmove clock", "fullmove number" };
+	return (fieldIndex >= 0 && fieldIndex < 6) ? FIELD_NAMES[fieldIndex] : "trailing fields";
+}
+
+// -----------------------------------------------------------------------------
 ChessMatch::ChessMatch(Game* owner)
 	:m_theGame(owner)
 {
@@ -28,6 +130,32 @@ ChessMatch::ChessMatch(Game* owner)
 	m_playerOneTimeRemaining = m_initialClockTime;
 	m_playerTwoTimeRemaining = m_initialClockTime;
 
+	m_position = ChessPosition::GetStartingPosition();
+	m_keyframeInterval = std::max(g_gameConfigBlackboard.GetValue("replayKeyframeInterval", m_keyframeInterval), 1);
+	RebuildKeyframes();
+
+	// A journal left behind means the last session died mid-match; keep it before starting this match's
+	ChessGameLogHeader interruptedHeader;
+	std::vector<uint16_t> interruptedMoves;
+	bool wasJournalTruncated = false;
+	if (ChessGameLog::ReadFile(GAME_JOURNAL_FILE_PATH, interruptedHeader, interruptedMoves, wasJournalTruncated) && !interruptedMoves.empty())
+	{
+		ReplaceFile(GAME_JOURNAL_FILE_PATH, RECOVERED_MATCH_LOG_FILE_PATH);
+		g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Recovered %d moves of an interrupted match: LoadGame file=RecoveredMatch.cgl", static_cast<int>(interruptedMoves.size())));
+	}
+	m_gameLog.SetSyncBatch(g_gameConfigBlackboard.GetValue("gameLogSyncMoves", 8), g_gameConfigBlackboard.GetValue("gameLogSyncSeconds", 2.f));
+	RestartGameLog();
+
+	// Opening book; the Polyglot keys need the Random64 table before any lookup
+	m_bookRandom.seed(std::random_device()());
+	m_openingBookMaxPlies = g_gameConfigBlackboard.GetValue("openingBookMaxPlies", m_openingBookMaxPlies);
+	m_isTablebaseAdjudicationEnabled = g_gameConfigBlackboard.GetValue("tablebaseAdjudication", "true") == "true";
+	std::string bookFilePath = g_gameConfigBlackboard.GetValue("openingBookFile", "");
+	if (!bookFilePath.empty())
+	{
+		OpenOpeningBook(bookFilePath);
+	}
+
 	// Subscribe to events
 	g_theEventSystem->SubscribeEventCallbackFunction("RemoteCmd", Event_RemoteCmd);
 	g_theEventSystem->SubscribeEventCallbackFunction("ChessDisconnect", Event_ChessDisconnect);
@@ -39,8 +167,16 @@ ChessMatch::ChessMatch(Game* owner)
 	g_theEventSystem->SubscribeEventCallbackFunction("ChessOfferDraw", Event_ChessOfferDraw);
 	g_theEventSystem->SubscribeEventCallbackFunction("ChessAcceptDraw", Event_ChessAcceptDraw);
 	g_theEventSystem->SubscribeEventCallbackFunction("ChessRejectDraw", Event_ChessRejectDraw);
+	g_theEventSystem->SubscribeEventCallbackFunction("ChessResync", Event_ChessResync);
 	g_theEventSystem->SubscribeEventCallbackFunction("SaveGame", Event_SaveChessGame);
 	g_theEventSystem->SubscribeEventCallbackFunction("LoadGame", Event_LoadChessGame);
+	g_theEventSystem->SubscribeEventCallbackFunction("ChessPlayerEngine", Event_ChessPlayerEngine);
+	g_theEventSystem->SubscribeEventCallbackFunction("ChessBookMove", Event_ChessBookMove);
+	g_theEventSystem->SubscribeEventCallbackFunction("ChessFindMate", Event_ChessFindMate);
+	g_theEventSystem->SubscribeEventCallbackFunction("ChessSeek", Event_ChessSeek);
+	g_theEventSystem->SubscribeEventCallbackFunction("ChessFastForward", Event_ChessFastForward);
+	g_theEventSystem->SubscribeEventCallbackFunction("ChessVariation", Event_ChessVariation);
+	g_theEventSystem->SubscribeEventCallbackFunction("ChessFindPosition", Event_ChessFindPosition);
 
 	// DevControls
 	g_theDevConsole->AddLine(Rgba8::ORANGE, "===================================");
@@ -62,6 +198,21 @@ ChessMatch::ChessMatch(Game* owner)
 
 ChessMatch::~ChessMatch()
 {
+	// Engine threads read the players' engines, so they finish first
+	StopEngineSearch();
+
+	// A match closed normally keeps its journal as the last match
+	bool hasLoggedMoves = m_gameLog.GetNumMoves() > 0;
+	m_gameLog.Close();
+	if (hasLoggedMoves)
+	{
+		ReplaceFile(GAME_JOURNAL_FILE_PATH, LAST_MATCH_LOG_FILE_PATH);
+	}
+	else
+	{
+		std::remove(GAME_JOURNAL_FILE_PATH);
+	}
+
 	// Chess Match destroys the board
 	delete m_board;
 	m_board = nullptr;
@@ -79,6 +230,10 @@ void ChessMatch::Update(float deltaseconds)
 	{
 		m_board->Update(deltaseconds);
 	}
+	if (m_isAdjudicated)
+	{
+		return;
+	}
 
 	DebugKeyPresses();
 
@@ -91,6 +246,8 @@ void ChessMatch::Update(float deltaseconds)
 	{
 		UpdateChessClock(deltaseconds);
 	}
+
+	UpdateEngineTurn();
 }
 
 void ChessMatch::DebugKeyPresses()
@@ -107,12 +264,18 @@ void ChessMatch::DebugKeyPresses()
 	{
 		m_chessClockActive = !m_chessClockActive;
 	}
+	if (m_replayMode && g_theInput->WasKeyJustPressed('F'))
+	{
+		FastForwardReplay(static_cast<int>(m_moveHistory.size()), false);
+	}
 
-	if (g_theInput->WasKeyJustPressed(KEYCODE_LEFTARROW))
+	// Holding shift scrubs through the game a ply every frame
+	bool isScrubbing = g_theInput->IsKeyDown(KEYCODE_SHIFT);
+	if (isScrubbing ? g_theInput->IsKeyDown(KEYCODE_LEFTARROW) : g_theInput->WasKeyJustPressed(KEYCODE_LEFTARROW))
 	{
 		RewindOneMove();
 	}
-	if (g_theInput->WasKeyJustPressed(KEYCODE_RIGHTARROW))
+	if (isScrubbing ? g_theInput->IsKeyDown(KEYCODE_RIGHTARROW) : g_theInput->WasKeyJustPressed(KEYCODE_RIGHTARROW))
 	{
 		ForwardOneMove();
 	}
@@ -243,8 +406,13 @@ bool ChessMatch::Event_SaveChessGame(EventArgs& args)
 		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Missing argument! Correct argument: LoadGame file=fileName");
 		return false;
 	}
+	if (GetFileExtension(filename) == ".cga")
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Game archives are built from finished games with Chess3D.exe -archive");
+		return false;
+	}
 
-	g_theGame->m_theMatch->SaveGameToXmlFile(fullPath);
+	g_theGame->m_theMatch->QueueSaveGame(fullPath);
 	return true;
 }
 
@@ -259,7 +427,7 @@ bool ChessMatch::Event_LoadChessGame(EventArgs& args)
 		return false;
 	}
 
-	g_theGame->m_theMatch->LoadGameFromXmlFile(fullPath);
+	g_theGame->m_theMatch->QueueLoadGame(fullPath, args.GetValue("game", 1));
 	return true;
 }
 
@@ -273,6 +441,14 @@ bool ChessMatch::Event_ChessDisconnect(EventArgs& args)
 		return false;
 	}
 
+	// Unlike a dropped binary link, which is resumed, this gives the match's session up
+	if (g_theGame->m_wireLink.GetState() != ChessWireLinkState::CLOSED || g_theGame->m_isWireResuming)
+	{
+		g_theGame->CloseWireLink(reasonText);
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, "Disconnected successfully!");
+		return true;
+	}
+
 	if (g_theNetwork->IsConnected())
 	{
 		if (g_theNetwork->IsServer())
@@ -304,7 +480,7 @@ bool ChessMatch::Event_ChessPlayerInfo(EventArgs& args)
 	if (remoteCommandText == "true")
 	{
 		std::string remoteCmd = Stringf("ChessPlayerInfo name=%s player=%d", nameText.c_str(), playerIndex);
-		g_theNetwork->SendStringToAll(remoteCmd);
+		SendRemoteMessage(ChessWireMessage::MakeText(remoteCmd), remoteCmd);
 	}
 
 	if (playerIndex == 0)
@@ -316,6 +492,8 @@ bool ChessMatch::Event_ChessPlayerInfo(EventArgs& args)
 		g_theGame->m_theMatch->m_playerTwo->SetPlayerName(nameText);
 	}
 
+	// The names live in the journal's header
+	g_theGame->m_theMatch->RestartGameLog();
 	return true;
 }
 
@@ -324,13 +502,43 @@ bool ChessMatch::Event_ChessBegin(EventArgs& args)
 	std::string firstPlayerText = args.GetValue("firstPlayer", "");
 	std::string remoteCommandText = args.GetValue("remote", "false");
 
+	// ChessBegin fen="8/8/8/4k3/8/8/4P3/4K3 w - - 0 1", or with '_' for the spaces as sent over the network
+	std::string fenText = GetFENForArgument(args.GetValue("fen", ""));
+	if (!fenText.empty())
+	{
+		ChessPosition position;
+		if (!position.SetFromFEN(fenText.c_str()))
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Invalid FEN \"%s\". Correct argument: ChessBegin fen=\"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1\"", fenText.c_str()));
+			return false;
+		}
+	}
+
 	g_theGame->DestroyMatch();
 	g_theGame->InitializeChessMatch();
 
+	if (!fenText.empty())
+	{
+		std::string errorMessage;
+		if (!g_theGame->m_theMatch->SetupFromFEN(fenText, errorMessage))
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, errorMessage);
+			return false;
+		}
+		g_theGame->m_theMatch->RestartGameLog();
+		g_theGame->m_theMatch->RebuildKeyframes();
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, "Match begins from " + g_theGame->m_theMatch->m_position.GetFEN());
+		g_theGame->m_theMatch->UpdateDevConsoleBoard();
+	}
+
 	if (remoteCommandText == "true")
 	{
 		std::string remoteCmd = "ChessBegin";
-		g_theNetwork->SendStringToAll(remoteCmd);
+		if (!fenText.empty())
+		{
+			remoteCmd += " fen=" + GetArgumentForFEN(g_theGame->m_theMatch->m_position.GetFEN());
+		}
+		SendRemoteMessage(ChessWireMessage::MakeText(remoteCmd), remoteCmd);
 	}
 
 	return true;
@@ -339,29 +547,58 @@ bool ChessMatch::Event_ChessBegin(EventArgs& args)
 bool ChessMatch::Event_ChessValidate(EventArgs& args)
 {
 	std::string remoteArgs	  = args.GetValue("remote", "");
-	std::string boardArgs	  = args.GetValue("board", "");
+	std::string remoteFEN	  = GetFENForArgument(args.GetValue("fen", ""));
 
 	std::string gameState = GetGameStateAsString(g_theGame->GetCurrentGameState());
 	std::string playerOneName = g_theGame->m_theMatch->m_playerOne->GetPlayerName();
 	std::string playerTwoName = g_theGame->m_theMatch->m_playerTwo->GetPlayerName();
 	int currentMove = g_theGame->m_theMatch->m_currentMoveIndex;
+	std::string localFEN = g_theGame->m_theMatch->m_position.GetFEN();
 
 	g_theDevConsole->AddLine(Rgba8::YELLOW, "========= Chess Validate =========");
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("Game State          : %s", gameState.c_str()));
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("PlayerOne Name      : %s", playerOneName.c_str()));
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("PlayerTwo Name      : %s", playerTwoName.c_str()));
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("Move Number					    : %d", currentMove));
+	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("FEN                 : %s", localFEN.c_str()));
 	g_theDevConsole->AddLine(Rgba8::CYAN, "Current Board Layout: ");
 	g_theGame->m_theMatch->UpdateDevConsoleBoard();
+
+	// A FEN from the other side is compared field by field, after normalizing it through the parser
+	bool isInSync = true;
+	if (!remoteFEN.empty())
+	{
+		ChessPosition remotePosition;
+		if (!remotePosition.SetFromFEN(remoteFEN.c_str()))
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Unreadable FEN to validate against: %s", remoteFEN.c_str()));
+			isInSync = false;
+		}
+		else
+		{
+			int mismatchField = FindFirstFENMismatch(localFEN, remotePosition.GetFEN());
+			isInSync = mismatchField < 0;
+			if (isInSync)
+			{
+				g_theDevConsole->AddLine(Rgba8::GREEN, "FEN matches");
+			}
+			else
+			{
+				g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("FEN mismatch in %s", GetFENFieldName(mismatchField)));
+				g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("  local : %s", localFEN.c_str()));
+				g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("  remote: %s", remotePosition.GetFEN().c_str()));
+			}
+		}
+	}
 	g_theDevConsole->AddLine(Rgba8::YELLOW, "==================================");
 
 	if (remoteArgs == "true")
 	{
-		std::string remoteCmd = Stringf("ChessValidate state=%s player1=%s player2=%s move=%d board=%s", gameState.c_str(), playerOneName.c_str(), playerTwoName.c_str(), currentMove, boardArgs.c_str());
-		g_theNetwork->SendStringToAll(remoteCmd);
+		std::string remoteCmd = Stringf("ChessValidate state=%s player1=%s player2=%s move=%d fen=%s", gameState.c_str(), playerOneName.c_str(), playerTwoName.c_str(), currentMove, GetArgumentForFEN(localFEN).c_str());
+		SendRemoteMessage(ChessWireMessage::MakeText(remoteCmd), remoteCmd);
 	}
 
-	return true;
+	return isInSync;
 }
 
 bool ChessMatch::Event_ChessMove(EventArgs& args)
@@ -392,10 +629,47 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 	//	return false;
 	//}
 
-	IntVec2 fromCoords = g_theGame->m_theMatch->m_board->GetCoordsForNotation(chessPieceFrom);
-	IntVec2 toCoords = g_theGame->m_theMatch->m_board->GetCoordsForNotation(chessPieceTo);
-	bool    isTeleporting = chessPieceTeleport == "true";
-	bool	isRemote = remoteCommand == "true";
+	// A move from the remote over the text network carries state=, the hash of the state it left, and
+	// clock1= clock2= in milliseconds when the clocks run, which we take once the move checks out
+	ChessMatch* match = g_theGame->m_theMatch;
+	std::string stateText = args.GetValue("state", "");
+	ChessWireClock remoteClock;
+	int clockOneMS = args.GetValue("clock1", -1);
+	int clockTwoMS = args.GetValue("clock2", -1);
+	bool hasClock = (clockOneMS >= 0 && clockTwoMS >= 0);
+	if (hasClock)
+	{
+		remoteClock.m_clockMS[0] = static_cast<uint32_t>(clockOneMS);
+		remoteClock.m_clockMS[1] = static_cast<uint32_t>(clockTwoMS);
+	}
+
+	int numPliesShown = match->GetNumPliesShown();
+	float moverSeconds = match->GetTimeRemaining(match->m_playerTurnIndex % 2);
+	IntVec2 fromCoords = match->m_board->GetCoordsForNotation(chessPieceFrom);
+	IntVec2 toCoords = match->m_board->GetCoordsForNotation(chessPieceTo);
+	bool wasMovePlayed = match->PlayBoardMove(fromCoords, toCoords, pawnPromotion, chessPieceTeleport == "true", remoteCommand == "true");
+	bool isInStep = wasMovePlayed;
+	if (!stateText.empty())
+	{
+		isInStep = match->CheckRemoteState(numPliesShown, wasMovePlayed, std::strtoull(stateText.c_str(), nullptr, 16));
+	}
+	if (isInStep && hasClock)
+	{
+		match->TakeMoverClock(remoteClock, moverSeconds);
+	}
+	return wasMovePlayed;
+}
+
+bool ChessMatch::PlayBoardMove(IntVec2 const& fromCoords, IntVec2 const& toCoords, std::string const& pawnPromotion, bool isTeleporting, bool isRemote)
+{
+	if (m_isAdjudicated)
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, "The match is over.");
+		return false;
+	}
+
+	// The move follows whatever the board shows, which after a rewind or seek is short of the end of the line
+	int numPliesShown = GetNumPliesShown();
 
 	// Check if we are remote
 	if (isRemote)
@@ -406,7 +680,7 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 	// Check if we are teleporting, if so we bypass move validation
 	if (isTeleporting)
 	{
-		ChessPiece* piece = g_theGame->m_theMatch->m_board->GetChessPieceForCoords(fromCoords);
+		ChessPiece* piece = m_board->GetChessPieceForCoords(fromCoords);
 		if (!piece)
 		{
 			g_theAudio->StartSound(g_theGame->m_errorSound, false, 0.1f);
@@ -414,30 +688,29 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 			return false;
 		}
 
-		g_theGame->m_theMatch->m_board->RemoveChessPieceAtCoords(fromCoords);
+		ChessPiece* capturedPiece = m_board->GetChessPieceForCoords(toCoords);
+		if (capturedPiece && capturedPiece != piece)
+		{
+			m_board->RemoveChessPiece(capturedPiece);
+			g_theDevConsole->AddLine(Rgba8::ORANGE, "A piece was captured!");
+		}
+		m_board->RemoveChessPieceAtCoords(fromCoords);
 		piece->SetBoardPosition(toCoords);
+		m_board->m_enpassantTargetSquare = -IntVec2::ONE;
 
-		g_theGame->m_theMatch->UpdateDevConsoleBoard();
+		UpdateDevConsoleBoard();
 		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Chess Piece Moved to (%d, %d)", toCoords.x, toCoords.y));
 
-		g_theGame->m_theMatch->m_playerTurnIndex += 1;
-		int newCurrentPlayerIndex = (g_theGame->m_theMatch->m_playerTurnIndex % 2);
-		if (g_theGame->m_currentCameraState != CameraState::FREEFLY)
-		{
-			if (newCurrentPlayerIndex == 0)
-			{
-				g_theGame->m_currentCameraState = CameraState::PLAYERONE_SPECTATING;
-			}
-			else if (newCurrentPlayerIndex == 1)
-			{
-				g_theGame->m_currentCameraState = CameraState::PLAYERTWO_SPECTATING;
-			}
-		}
+		// Kept like any other move, flagged so replays, saves and the remote player relocate the piece too
+		int teleportingPlayerIndex = (m_playerTurnIndex % 2);
+		m_playerTurnIndex += 1;
+		ChessMoveRecord moveRecord = ApplyMoveToPosition(fromCoords, toCoords, "", true);
+		FinishBoardMove(moveRecord, teleportingPlayerIndex, numPliesShown, isRemote);
 		return true;
 	}
 
 	// Check if our move is valid
-	ChessPiece* piece = g_theGame->m_theMatch->m_board->GetChessPieceForCoords(fromCoords);
+	ChessPiece* piece = m_board->GetChessPieceForCoords(fromCoords);
 	if (!piece)
 	{
 		g_theAudio->StartSound(g_theGame->m_errorSound, false, 0.1f);
@@ -446,7 +719,7 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 	}
 
 	// Check if piece belongs to current player
-	int currentPlayerIndex = (g_theGame->m_theMatch->m_playerTurnIndex % 2);
+	int currentPlayerIndex = (m_playerTurnIndex % 2);
 	if (piece->GetPlayerIndex() != currentPlayerIndex)
 	{
 		g_theAudio->StartSound(g_theGame->m_errorSound, false, 0.1f);
@@ -470,7 +743,7 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 	// Clear enpassant
 	if (!(result == ChessMoveResult::VALID_MOVE_NORMAL && piece->GetDefinition()->m_chessPieceType == ChessPieceType::PAWN && abs(fromCoords.y - toCoords.y) == 2))
 	{
-		g_theGame->m_theMatch->m_board->m_enpassantTargetSquare = -IntVec2::ONE;
+		m_board->m_enpassantTargetSquare = -IntVec2::ONE;
 	}
 
 	// Check for castling
@@ -490,18 +763,18 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 			rookToCoords = IntVec2(toCoords.x + 1, fromCoords.y);
 		}
 
-		ChessPiece* rook = g_theGame->m_theMatch->m_board->GetChessPieceForCoords(rookFromCoords);
-		g_theGame->m_theMatch->m_board->RemoveChessPieceAtCoords(rookFromCoords);
+		ChessPiece* rook = m_board->GetChessPieceForCoords(rookFromCoords);
+		m_board->RemoveChessPieceAtCoords(rookFromCoords);
 		rook->SetBoardPosition(rookToCoords);
 	}
 
-	ChessPiece* capturedPiece = g_theGame->m_theMatch->m_board->GetChessPieceForCoords(toCoords);
+	ChessPiece* capturedPiece = m_board->GetChessPieceForCoords(toCoords);
 	if (capturedPiece)
 	{
-		g_theGame->m_theMatch->m_board->RemoveChessPiece(capturedPiece);
+		m_board->RemoveChessPiece(capturedPiece);
 		g_theDevConsole->AddLine(Rgba8::ORANGE, "A piece was captured!");
 	}
-	g_theGame->m_theMatch->m_board->RemoveChessPieceAtCoords(fromCoords);
+	m_board->RemoveChessPieceAtCoords(fromCoords);
 	piece->SetBoardPosition(toCoords);
 
 	// Pawn Promotion
@@ -537,15 +810,15 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 		}
 
 		// Remove the pawn
-		g_theGame->m_theMatch->m_board->RemoveChessPiece(piece);
+		m_board->RemoveChessPiece(piece);
 
 		// Create newly promoted piece
 		ChessPieceDefinition const& def = ChessPieceDefinition::GetChessPieceDef(newType);
-		ChessPiece* promotedPiece = new ChessPiece(def, currentPlayerIndex, g_theGame->m_theMatch->m_board);
+		ChessPiece* promotedPiece = new ChessPiece(def, currentPlayerIndex, m_board);
 		promotedPiece->SetBoardPosition(toCoords);
 
 		// Add our newly promoted piece to board 
-		g_theGame->m_theMatch->m_board->AddChessPiece(promotedPiece);
+		m_board->AddChessPiece(promotedPiece);
 	}
 
 	// Play valid move audio
@@ -554,34 +827,52 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 		g_theAudio->StartSound(g_theGame->m_chessSlideSound, false, 5.f);
 	}
 
+	UpdateDevConsoleBoard();
+	g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Chess Piece Moved to (%d, %d)", toCoords.x, toCoords.y));
+
+	// Switch turns
+	m_playerTurnIndex += 1;
+	ChessMoveRecord moveRecord = ApplyMoveToPosition(fromCoords, toCoords, pawnPromotion, false);
+	FinishBoardMove(moveRecord, currentPlayerIndex, numPliesShown, isRemote);
+	return true;
+}
+
+void ChessMatch::FinishBoardMove(ChessMoveRecord& moveRecord, int playerIndex, int numPliesShown, bool isRemote)
+{
+	moveRecord.m_clockSeconds = (playerIndex == 0) ? m_playerOneTimeRemaining : m_playerTwoTimeRemaining;
+
 	// Record our chess moves
-	if (!g_theGame->m_theMatch->m_isReplayingMove)
+	if (!m_isReplayingMove)
 	{
-		std::string moveCommand = "ChessMove from=" + chessPieceFrom + " to=" + chessPieceTo;
-		if (!pawnPromotion.empty()) 
+		// A move made after rewinding starts a variation, and the line it leaves stays in the tree; a move
+		// the tree already has picks its line back up
+		bool isBranching = numPliesShown < static_cast<int>(m_moveHistory.size());
+		uint32_t parentIndex = (numPliesShown > 0) ? m_lineNodes[numPliesShown - 1] : m_moveTree.GetRoot();
+		uint32_t nodeIndex = m_moveTree.AddMove(parentIndex, moveRecord);
+		if (isBranching)
 		{
-			moveCommand += " promoteTo=" + pawnPromotion;
+			m_moveTree.GetLine(nodeIndex, m_moveHistory, m_lineNodes);
 		}
-		if (chessPieceTeleport == "true") 
+		else
 		{
-			moveCommand += " teleport=true";
+			m_moveHistory.push_back(moveRecord);
+			m_lineNodes.push_back(nodeIndex);
 		}
+		m_currentMoveIndex = numPliesShown + 1;
 
-		if (g_theGame->m_theMatch->m_currentMoveIndex < static_cast<int>(g_theGame->m_theMatch->m_moveHistory.size()) - 1) 
+		// The journal is append-only, so a new branch off an earlier move rewrites it once
+		if (isBranching)
 		{
-			g_theGame->m_theMatch->m_moveHistory.erase(g_theGame->m_theMatch->m_moveHistory.begin() + g_theGame->m_theMatch->m_currentMoveIndex + 1, g_theGame->m_theMatch->m_moveHistory.end());
+			RestartGameLog();
+			RebuildKeyframes();
+		}
+		else
+		{
+			m_gameLog.AppendMove(moveRecord.GetLoggedMove());
+			UpdateKeyframesForNewMove();
 		}
-
-		g_theGame->m_theMatch->m_moveHistory.push_back(moveCommand);
-		g_theGame->m_theMatch->m_currentMoveIndex = static_cast<int>(g_theGame->m_theMatch->m_moveHistory.size()) - 1;
 	}
-
-	g_theGame->m_theMatch->UpdateDevConsoleBoard();
-	g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Chess Piece Moved to (%d, %d)", toCoords.x, toCoords.y));
-
-	// Switch turns
-	g_theGame->m_theMatch->m_playerTurnIndex += 1;
-	int newCurrentPlayerIndex = (g_theGame->m_theMatch->m_playerTurnIndex % 2);
+	int newCurrentPlayerIndex = (m_playerTurnIndex % 2);
 	if (g_theGame->m_currentCameraState != CameraState::FREEFLY)
 	{
 		if (newCurrentPlayerIndex == 0)
@@ -595,8 +886,8 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 	}
 
 	ChessPiece* opponentKing = nullptr;
-	int opponentIndex = (currentPlayerIndex == 0) ? 1 : 0;
-	for (ChessPiece* chessPiece : g_theGame->m_theMatch->m_board->m_chessPieces)
+	int opponentIndex = (playerIndex == 0) ? 1 : 0;
+	for (ChessPiece* chessPiece : m_board->m_chessPieces)
 	{
 		if (chessPiece && chessPiece->GetPlayerIndex() == opponentIndex && chessPiece->GetDefinition()->m_chessPieceType == ChessPieceType::KING)
 		{
@@ -605,33 +896,26 @@ bool ChessMatch::Event_ChessMove(EventArgs& args)
 		}
 	}
 
-	std::string congratsText = Stringf("Congratulations! Player (%d) wins", currentPlayerIndex);
+	std::string congratsText = Stringf("Congratulations! Player (%d) wins", playerIndex);
 
 	if (opponentKing == nullptr)
 	{
 		g_theDevConsole->AddLine(Rgba8::GREEN, congratsText);
 
 		// Save to XML
-		std::string saveFilePath = "Data/SavedGames/CompletedMatch.xml";
-		g_theGame->m_theMatch->SaveGameToXmlFile(saveFilePath);
+		QueueSaveGame(COMPLETED_MATCH_FILE_PATH);
+		m_gameLog.Sync();
+	}
+	else if (!m_isReplayingMove)
+	{
+		AdjudicateWithTablebases();
 	}
 
-	// This will send our command to other connected people
+	// This will send our command to other connected people, checked against the state it leaves here
 	if (isRemote) 
 	{
-		std::string remoteCmd = "ChessMove from=" + chessPieceFrom + " to=" + chessPieceTo;
-		if (!pawnPromotion.empty()) 
-		{
-			remoteCmd += " promoteTo=" + pawnPromotion;
-		}
-		if (chessPieceTeleport == "true") 
-		{
-			remoteCmd += " teleport=true";
-		}
-		g_theNetwork->SendStringToAll(remoteCmd);
+		SendRemoteMove(numPliesShown, moveRecord, true, true);
 	}
-
-	return true;
 }
 
 void ChessMatch::RewindOneMove() 
@@ -642,37 +926,266 @@ void ChessMatch::RewindOneMove()
 	}
 
 	m_currentMoveIndex -= 1;
-	ResetBoardToInitialState();
-
-	for (int moveIndex = 0; moveIndex <= m_currentMoveIndex; ++moveIndex) 
-	{
-		PlayMove(m_moveHistory[moveIndex]);
-	}
+	SeekToPly(m_currentMoveIndex);
 
 	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Rewound to move %d", m_currentMoveIndex));
 }
 
 void ChessMatch::ForwardOneMove()
 {
-	if (m_currentMoveIndex <= 0 || m_moveHistory.empty())
+	if (m_currentMoveIndex >= static_cast<int>(m_moveHistory.size()))
 	{
 		return;
 	}
 
 	m_currentMoveIndex += 1;
-	ResetBoardToInitialState();
+	SeekToPly(m_currentMoveIndex);
+
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Forward to move %d", m_currentMoveIndex));
+}
 
-	for (int moveIndex = 0; moveIndex <= m_currentMoveIndex; ++moveIndex)
+void ChessMatch::SeekToPly(int numPlies)
+{
+	// The nearest keyframe plus at most one interval of moves on the shadow position, then a single
+	// board rebuild; nothing is replayed through ChessMove, so the cost doesn't grow with the game
+	if (m_keyframes.empty())
 	{
-		PlayMove(m_moveHistory[moveIndex]);
+		RebuildKeyframes();
 	}
+	numPlies = std::min(std::max(numPlies, 0), static_cast<int>(m_moveHistory.size()));
+	int keyframeIndex = std::min(numPlies / m_keyframeInterval, static_cast<int>(m_keyframes.size()) - 1);
 
-	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Forward to move %d", m_currentMoveIndex));
+	ChessPosition position = m_keyframes[keyframeIndex];
+	for (int plyIndex = keyframeIndex * m_keyframeInterval; plyIndex < numPlies; ++plyIndex)
+	{
+		m_moveHistory[plyIndex].ApplyToPosition(position);
+	}
+
+	m_board->SetupFromPosition(position);
+	m_position = position;
+	m_playerTurnIndex = (position.m_fullmoveNumber - 1) * 2 + position.m_sideToMove;
+	m_timeSinceLastMove = 0.f;
+}
+
+void ChessMatch::RebuildKeyframes()
+{
+	ChessPosition position = GetPositionForStartFEN(m_startFEN);
+	m_keyframes.clear();
+	m_keyframes.reserve(m_moveHistory.size() / m_keyframeInterval + 1);
+	m_keyframes.push_back(position);
+	for (int plyIndex = 0; plyIndex < static_cast<int>(m_moveHistory.size()); ++plyIndex)
+	{
+		m_moveHistory[plyIndex].ApplyToPosition(position);
+		if ((plyIndex + 1) % m_keyframeInterval == 0)
+		{
+			m_keyframes.push_back(position);
+		}
+	}
+}
+
+void ChessMatch::UpdateKeyframesForNewMove()
+{
+	// The move is already on m_position; keyframes past the point a new branch left the old line are dropped
+	int numPlies = static_cast<int>(m_moveHistory.size());
+	size_t numValidKeyframes = static_cast<size_t>((numPlies - 1) / m_keyframeInterval + 1);
+	if (m_keyframes.size() > numValidKeyframes)
+	{
+		m_keyframes.resize(numValidKeyframes);
+	}
+	if (numPlies % m_keyframeInterval == 0 && m_keyframes.size() == static_cast<size_t>(numPlies / m_keyframeInterval))
+	{
+		m_keyframes.push_back(m_position);
+	}
+}
+
+bool ChessMatch::Event_ChessSeek(EventArgs& args)
+{
+	ChessMatch* match = g_theGame->m_theMatch;
+	int numPlies = args.GetValue("ply", -1);
+	if (numPlies < 0 || numPlies > static_cast<int>(match->m_moveHistory.size()))
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("ChessSeek requires ply=0 to ply=%d", static_cast<int>(match->m_moveHistory.size())));
+		return false;
+	}
+
+	match->SeekToPly(numPlies);
+	match->m_currentMoveIndex = numPlies;
+	match->UpdateDevConsoleBoard();
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Showing the position after %d of %d plies", numPlies, static_cast<int>(match->m_moveHistory.size())));
+	return true;
+}
+
+void ChessMatch::FastForwardReplay(int numPlies, bool isVerifying)
+{
+	// Replays without ChessMove: no animation, sounds or console lines per move, and one board rebuild
+	// at the end. Verifying walks every move from the start through the rules instead of the keyframes.
+	auto startTime = std::chrono::steady_clock::now();
+	numPlies = std::min(std::max(numPlies, 0), static_cast<int>(m_moveHistory.size()));
+
+	int numRejectedMoves = 0;
+	int numTeleports = 0;
+	int firstRejectedPly = -1;
+	int numKeyframeMismatches = 0;
+	int numHashMismatches = 0;
+	if (isVerifying)
+	{
+		if (m_keyframes.empty())
+		{
+			RebuildKeyframes();
+		}
+		ChessPosition position = GetPositionForStartFEN(m_startFEN);
+		for (int plyIndex = 0; plyIndex < numPlies; ++plyIndex)
+		{
+			ChessMoveRecord const& moveRecord = m_moveHistory[plyIndex];
+			bool isRejected = !moveRecord.IsTeleport() && (!moveRecord.IsRulesMove() || !position.IsLegalMove(moveRecord.m_move));
+			numTeleports += moveRecord.IsTeleport() ? 1 : 0;
+			numRejectedMoves += isRejected ? 1 : 0;
+			firstRejectedPly = (firstRejectedPly < 0 && isRejected) ? plyIndex : firstRejectedPly;
+			moveRecord.ApplyToPosition(position);
+			numHashMismatches += (moveRecord.m_positionHash != position.GetHash()) ? 1 : 0;
+
+			size_t keyframeIndex = static_cast<size_t>((plyIndex + 1) / m_keyframeInterval);
+			if ((plyIndex + 1) % m_keyframeInterval == 0 && keyframeIndex < m_keyframes.size() && m_keyframes[keyframeIndex].GetHash() != position.GetHash())
+			{
+				numKeyframeMismatches += 1;
+			}
+		}
+
+		// Stale keyframes would send seeks to the wrong position
+		if (numKeyframeMismatches > 0)
+		{
+			RebuildKeyframes();
+		}
+	}
+
+	SeekToPly(numPlies);
+	m_currentMoveIndex = numPlies;
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+	std::string resultText;
+	if (m_position.GetKingSquare(0) == CHESS_NO_SQUARE || m_position.GetKingSquare(1) == CHESS_NO_SQUARE)
+	{
+		resultText = Stringf(", Player (%d) wins", (m_position.GetKingSquare(1) == CHESS_NO_SQUARE) ? 0 : 1);
+	}
+	else if (numPlies == static_cast<int>(m_moveHistory.size()))
+	{
+		std::string result = ChessSavedGameReader::GetResultForPosition(m_position);
+		resultText = (result != "*") ? ", " + result : "";
+	}
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Fast forwarded to ply %d of %d in %.2f ms%s", numPlies, static_cast<int>(m_moveHistory.size()), milliseconds, resultText.c_str()));
+
+	if (isVerifying)
+	{
+		if (numRejectedMoves > 0)
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("  %d moves the rules reject, the first at ply %d: %s", numRejectedMoves, firstRejectedPly + 1, m_moveHistory[firstRejectedPly].GetMoveCommand().c_str()));
+		}
+		if (numKeyframeMismatches > 0)
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("  %d keyframes disagreed with the moves and were rebuilt", numKeyframeMismatches));
+		}
+		if (numHashMismatches > 0)
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("  %d positions differ from the hash recorded with their move", numHashMismatches));
+		}
+		g_theDevConsole->AddLine((numRejectedMoves + numKeyframeMismatches + numHashMismatches > 0) ? DevConsole::ERROR_MAJOR : DevConsole::INFO_MINOR,
+			Stringf("  Verified %d plies: %d rejected, %d teleports, %d keyframe and %d hash mismatches", numPlies, numRejectedMoves, numTeleports, numKeyframeMismatches, numHashMismatches));
+	}
+}
+
+bool ChessMatch::Event_ChessFastForward(EventArgs& args)
+{
+	ChessMatch* match = g_theGame->m_theMatch;
+	int numRecordedPlies = static_cast<int>(match->m_moveHistory.size());
+	int numPlies = args.GetValue("ply", numRecordedPlies);
+	if (numPlies < 0 || numPlies > numRecordedPlies)
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("ChessFastForward requires ply=0 to ply=%d", numRecordedPlies));
+		return false;
+	}
+
+	match->FastForwardReplay(numPlies, args.GetValue("verify", "false") == "true");
+	return true;
+}
+
+int ChessMatch::GetNumPliesShown() const
+{
+	// The board's turn counter runs on from the starting position's, teleports included
+	ChessPosition startPosition = GetPositionForStartFEN(m_startFEN);
+	int startTurnIndex = (startPosition.m_fullmoveNumber - 1) * 2 + startPosition.m_sideToMove;
+	return std::min(std::max(m_playerTurnIndex - startTurnIndex, 0), static_cast<int>(m_moveHistory.size()));
+}
+
+void ChessMatch::SelectLine(uint32_t nodeIndex)
+{
+	// The line through the node, down its main continuation, showing the position after the node's move
+	m_moveTree.GetLine(nodeIndex, m_moveHistory, m_lineNodes);
+	int numPlies = static_cast<int>(m_moveTree.GetNode(nodeIndex).m_numPlies);
+	RebuildKeyframes();
+	SeekToPly(numPlies);
+	m_currentMoveIndex = numPlies;
+	RestartGameLog();
+	UpdateDevConsoleBoard();
+}
+
+bool ChessMatch::Event_ChessVariation(EventArgs& args)
+{
+	ChessMatch* match = g_theGame->m_theMatch;
+	ChessMoveTree& moveTree = match->m_moveTree;
+	int numPlies = match->GetNumPliesShown();
+	uint32_t parentIndex = (numPlies > 0) ? match->m_lineNodes[numPlies - 1] : moveTree.GetRoot();
+
+	if (args.GetValue("promote", "false") == "true")
+	{
+		if (match->m_lineNodes.empty())
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "No moves have been played yet");
+			return false;
+		}
+		moveTree.PromoteToMainLine(match->m_lineNodes.back());
+		g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("The line on the board, %d plies, is now the main line", static_cast<int>(match->m_lineNodes.size())));
+		return true;
+	}
+
+	std::vector<uint32_t> childIndices;
+	moveTree.GetChildren(parentIndex, childIndices);
+	int selectedNumber = args.GetValue("select", 0);
+	if (selectedNumber != 0)
+	{
+		if (selectedNumber < 1 || selectedNumber > static_cast<int>(childIndices.size()))
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("ChessVariation select= needs 1 to %d for the moves tried after ply %d", static_cast<int>(childIndices.size()), numPlies));
+			return false;
+		}
+		match->SelectLine(childIndices[selectedNumber - 1]);
+		g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Showing variation %d after ply %d, %d plies long", selectedNumber, numPlies, static_cast<int>(match->m_moveHistory.size())));
+		return true;
+	}
+
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("%d moves tried after ply %d (%u moves and %u variations in the match)", static_cast<int>(childIndices.size()), numPlies,
+		moveTree.GetNumNodes() - 1, moveTree.GetNumVariations()));
+	for (int childNumber = 1; childNumber <= static_cast<int>(childIndices.size()); ++childNumber)
+	{
+		uint32_t childIndex = childIndices[childNumber - 1];
+		ChessMoveRecord const& record = moveTree.GetNode(childIndex).m_record;
+		bool isLegal = record.IsRulesMove() && match->m_position.IsLegalMove(record.m_move);
+		std::string moveText = isLegal ? match->m_position.GetSANForMove(record.m_move) : record.GetMoveCommand();
+
+		int numLinePlies = 1;
+		for (uint32_t lineIndex = moveTree.GetNode(childIndex).m_firstChild; lineIndex != CHESS_NO_MOVE_NODE; lineIndex = moveTree.GetNode(lineIndex).m_firstChild)
+		{
+			++numLinePlies;
+		}
+		bool isOnBoard = numPlies < static_cast<int>(match->m_lineNodes.size()) && match->m_lineNodes[numPlies] == childIndex;
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("  %c%d. %-10s %d plies%s", isOnBoard ? '*' : ' ', childNumber, moveText.c_str(), numLinePlies, (childNumber == 1) ? ", main line" : ""));
+	}
+	return true;
 }
 
 bool ChessMatch::Event_ChessResign(EventArgs& args)
 {
 	int playerIndex = args.GetValue("player", -1);
+	std::string remoteArgs = args.GetValue("remote", "false");
 
 	// Check if we are actually a valid player
 	if (playerIndex != 0 && playerIndex != 1) 
@@ -682,6 +1195,10 @@ bool ChessMatch::Event_ChessResign(EventArgs& args)
 	}
 
 	g_theGame->m_theMatch->AutoResignPlayer(playerIndex);
+	if (remoteArgs == "true")
+	{
+		SendRemoteMessage(ChessWireMessage::MakeResign(playerIndex), Stringf("ChessResign player=%d", playerIndex));
+	}
 	return true;
 }
 
@@ -694,7 +1211,7 @@ bool ChessMatch::Event_ChessOfferDraw(EventArgs& args)
 	if (remoteArgs == "true")
 	{
 		std::string remoteCommand = "Your opponent has offered a draw! \n Accept the draw with ChessAcceptDraw or reject the draw with ChessRejectDraw.";
-		g_theNetwork->SendStringToAll(remoteCommand);
+		SendRemoteMessage(ChessWireMessage::MakeOffer(g_theGame->m_theMatch->GetNumPliesShown(), ChessWireOfferType::DRAW_OFFER), remoteCommand);
 		return true;
 	}
 
@@ -706,12 +1223,13 @@ bool ChessMatch::Event_ChessAcceptDraw(EventArgs& args)
 	std::string remoteArgs = args.GetValue("remote", "false");
 
 	g_theGame->m_theMatch->m_hasPlayerOfferedDraw = false;
+	int numPliesShown = g_theGame->m_theMatch->GetNumPliesShown();		// Leaving the match state destroys the match
 	g_theGame->EnterState(GameState::FINISHED_MATCH);
 
 	if (remoteArgs == "true")
 	{
 		std::string remoteCommand = "Accepted the draw offer, chess match will end!";
-		g_theNetwork->SendStringToAll(remoteCommand);
+		SendRemoteMessage(ChessWireMessage::MakeOffer(numPliesShown, ChessWireOfferType::DRAW_ACCEPT), remoteCommand);
 		g_theGame->EnterState(GameState::ATTRACT);
 		return true;
 	}
@@ -728,73 +1246,676 @@ bool ChessMatch::Event_ChessRejectDraw(EventArgs& args)
 	if (remoteArgs == "true")
 	{
 		std::string remoteCommand = "Rejected the draw offer, chess match will keep playing!";
-		g_theNetwork->SendStringToAll(remoteCommand);
+		SendRemoteMessage(ChessWireMessage::MakeOffer(g_theGame->m_theMatch->GetNumPliesShown(), ChessWireOfferType::DRAW_REJECT), remoteCommand);
 		return true;
 	}
 
 	return false;
 }
 
-void ChessMatch::SaveGameToXmlFile(std::string const& filePath) const
+bool ChessMatch::Event_ChessResync(EventArgs& args)
 {
-	XmlDocument xmlDocument;
-
-	XmlElement* root = xmlDocument.NewElement("ChessMatch");
-	xmlDocument.InsertFirstChild(root);
-
-	// Save each move
-	for (int moveIndex = 0; moveIndex < static_cast<int>(m_moveHistory.size()); ++moveIndex)
+	// Sent by a text-network client whose board drifted, or typed to force one: the authoritative side
+	// sends the match, the other asks for it
+	UNUSED(args);
+	if (IsResyncAuthority())
 	{
-		std::string const& moveCommand = m_moveHistory[moveIndex];
-
-		XmlElement* moveElement = xmlDocument.NewElement("Move");
-		moveElement->SetText(moveCommand.c_str());
-
-		root->InsertEndChild(moveElement);
+		g_theGame->m_theMatch->SendResync();
 	}
+	else
+	{
+		SendRemoteMessage(ChessWireMessage::MakeResync(), "ChessResync");
+	}
+	return true;
+}
 
-	// Save to file
-	XmlError result = xmlDocument.SaveFile(filePath.c_str());
-	if (result != tinyxml2::XML_SUCCESS)
+void ChessMatch::SendRemoteMessage(ChessWireMessage const& message, std::string const& textCommand)
+{
+	if (g_theGame->m_wireLink.IsConnected())
+	{
+		g_theGame->m_wireLink.Send(message);
+	}
+	else if (!textCommand.empty())
+	{
+		g_theNetwork->SendStringToAll(textCommand);
+	}
+}
+
+void ChessMatch::ReceiveWireMessage(ChessWireMessage const& message)
+{
+	switch (message.m_type)
+	{
+		case ChessWireMessageType::MOVE:
+		{
+			// The link keeps frames in order, so a move for another ply means the boards have drifted apart
+			int numPliesShown = GetNumPliesShown();
+			if (message.m_move.m_ply != static_cast<uint16_t>(numPliesShown))
+			{
+				g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Remote move for ply %d ignored at ply %d", message.m_move.m_ply, numPliesShown));
+				RequestResync(numPliesShown);
+				return;
+			}
+			ChessMove move = ChessMove::MakeFromPacked(static_cast<uint16_t>(message.m_move.m_loggedMove & ~CHESS_LOG_TELEPORT_BIT));
+			IntVec2 fromCoords(GetChessSquareX(move.m_from), GetChessSquareY(move.m_from));
+			IntVec2 toCoords(GetChessSquareX(move.m_to), GetChessSquareY(move.m_to));
+
+			// The clocks come just before the move they go with, and are only taken once it checks out; a move
+			// without them was made with the clocks stopped, or is catching up and has them sent after it
+			bool hasClock = m_hasRemoteClock && m_remoteClock.m_ply == message.m_move.m_ply;
+			m_hasRemoteClock = false;
+			float moverSeconds = GetTimeRemaining(m_playerTurnIndex % 2);
+			bool wasMovePlayed = PlayBoardMove(fromCoords, toCoords, move.GetPromotionName(), (message.m_move.m_loggedMove & CHESS_LOG_TELEPORT_BIT) != 0, false);
+			bool isInStep = wasMovePlayed;
+			if (message.m_move.m_stateHash != 0)
+			{
+				isInStep = CheckRemoteState(numPliesShown, wasMovePlayed, message.m_move.m_stateHash);
+			}
+			if (isInStep && hasClock)
+			{
+				TakeMoverClock(m_remoteClock, moverSeconds);
+			}
+			break;
+		}
+		case ChessWireMessageType::CLOCK:
+		{
+			// Clocks for a move already on the board bring ours up to date after catching up; the rest wait for their move
+			if (message.m_clock.m_ply < GetNumPliesShown())
+			{
+				ApplyRemoteClock(message.m_clock);
+				break;
+			}
+			m_remoteClock = message.m_clock;
+			m_hasRemoteClock = true;
+			break;
+		}
+		case ChessWireMessageType::RESYNC:
+		{
+			if (IsResyncAuthority())
+			{
+				SendResync();
+			}
+			break;
+		}
+		case ChessWireMessageType::OFFER:
+		{
+			if (message.m_offer.m_offerType == ChessWireOfferType::DRAW_OFFER)
+			{
+				m_hasPlayerOfferedDraw = true;
+				g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, "Your opponent has offered a draw! Accept the draw with ChessAcceptDraw or reject the draw with ChessRejectDraw.");
+			}
+			else if (message.m_offer.m_offerType == ChessWireOfferType::DRAW_REJECT)
+			{
+				m_hasPlayerOfferedDraw = false;
+				g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, "Your opponent rejected the draw offer, the match continues.");
+			}
+			else
+			{
+				// Last, since leaving the match state destroys this match
+				g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, "Your opponent accepted the draw offer, the match ends in a draw.");
+				m_hasPlayerOfferedDraw = false;
+				g_theGame->EnterState(GameState::FINISHED_MATCH);
+			}
+			break;
+		}
+		case ChessWireMessageType::RESIGN:
+		{
+			AutoResignPlayer(message.m_resign.m_playerIndex);
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+}
+
+void ChessMatch::SendRemoteMove(int ply, ChessMoveRecord const& moveRecord, bool isChecked, bool isLive)
+{
+	// A live move's clocks go first so the receiver has them when the move arrives. The binary move is
+	// 6 bytes, 14 with its hash, plus 12 for the clocks when they run
+	std::string moveCommand = moveRecord.GetMoveCommand();
+	if (m_chessClockActive && isLive)
+	{
+		ChessWireMessage clockMessage = ChessWireMessage::MakeClock(ply, m_playerOneTimeRemaining, m_playerTwoTimeRemaining);
+		SendRemoteMessage(clockMessage, "");
+		moveCommand += Stringf(" clock1=%u clock2=%u", clockMessage.m_clock.m_clockMS[0], clockMessage.m_clock.m_clockMS[1]);
+	}
+	uint64_t stateHash = 0;
+	if (isChecked)
+	{
+		stateHash = GetChessWireStateHash(moveRecord.m_positionHash, ply);
+		moveCommand += Stringf(" state=%016llx", static_cast<unsigned long long>(stateHash));
+	}
+	SendRemoteMessage(ChessWireMessage::MakeMove(ply, moveRecord.GetLoggedMove(), stateHash), moveCommand);
+}
+
+bool ChessMatch::CheckRemoteState(int ply, bool wasMovePlayed, uint64_t stateHash)
+{
+	uint64_t localHash = GetChessWireStateHash(m_position.GetHash(), ply);
+	if (wasMovePlayed && localHash == stateHash)
 	{
-		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Failed to save XML file.");
+		return true;
+	}
+
+	if (wasMovePlayed)
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Out of step with the remote after ply %d: state %016llx here, %016llx there",
+			ply + 1, static_cast<unsigned long long>(localHash), static_cast<unsigned long long>(stateHash)));
+	}
+	else
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Out of step with the remote: its move for ply %d can't be played here", ply + 1));
+	}
+	RequestResync(ply);
+	return false;
+}
+
+float ChessMatch::GetTimeRemaining(int playerIndex) const
+{
+	return (playerIndex == 0) ? m_playerOneTimeRemaining : m_playerTwoTimeRemaining;
+}
+
+void ChessMatch::TakeMoverClock(ChessWireClock const& clock, float moverSecondsHere)
+{
+	// The mover stopped its own clock, so its times stand. Ours kept running for the mover until the move
+	// arrived; more than the tolerance apart, with both clocks running, is reported, not resynced.
+	int moverIndex = (m_playerTurnIndex + 1) % 2;
+	float moverSecondsThere = static_cast<float>(clock.m_clockMS[moverIndex]) * 0.001f;
+	if (m_chessClockActive && fabsf(moverSecondsThere - moverSecondsHere) > REMOTE_CLOCK_TOLERANCE_SECONDS)
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Player (%d)'s clock was %.2fs here and %.2fs on the remote; taking the remote's",
+			moverIndex, moverSecondsHere, moverSecondsThere));
+	}
+	ApplyRemoteClock(clock);
+}
+
+void ChessMatch::ApplyRemoteClock(ChessWireClock const& clock)
+{
+	m_playerOneTimeRemaining = static_cast<float>(clock.m_clockMS[0]) * 0.001f;
+	m_playerTwoTimeRemaining = static_cast<float>(clock.m_clockMS[1]) * 0.001f;
+}
+
+void ChessMatch::RequestResync(int ply)
+{
+	// Once per ply, so two sides that can't agree report it instead of resending the match forever
+	if (g_theGame->m_lastResyncPly == ply)
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Still out of step after a resync; compare the boards with ChessValidate remote=true");
+		return;
+	}
+	g_theGame->m_lastResyncPly = ply;
+
+	if (IsResyncAuthority())
+	{
+		SendResync();
 	}
 	else
 	{
-		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, "Match saved to XML: " + filePath);
+		g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, "Asking the remote for the match to resync");
+		SendRemoteMessage(ChessWireMessage::MakeResync(), "ChessResync");
 	}
 }
 
-void ChessMatch::LoadGameFromXmlFile(std::string const& filePath)
+void ChessMatch::SendResync()
 {
+	// The match from the ChessBegin it started with, then the line on the board. Only the last move is
+	// checked, since the rest are the authoritative side's own and there's nothing of the remote's to check
+	std::string beginCommand = "ChessBegin";
+	if (!m_startFEN.empty())
+	{
+		beginCommand += " fen=" + GetArgumentForFEN(m_startFEN);
+	}
+	SendRemoteMessage(ChessWireMessage::MakeText(beginCommand), beginCommand);
+
+	int numPliesShown = GetNumPliesShown();
+	for (int plyIndex = 0; plyIndex < numPliesShown; ++plyIndex)
+	{
+		SendRemoteMove(plyIndex, m_moveHistory[plyIndex], plyIndex == numPliesShown - 1, false);
+	}
+	SendCatchUpClock(numPliesShown);
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Sent the match to ply %d to resync the remote", numPliesShown));
+}
+
+void ChessMatch::SendCatchUpClock(int numPliesShown)
+{
+	// After the moves, for the last of them, so the receiver takes the clocks as they are rather than checking a move with them
+	if (m_chessClockActive && numPliesShown > 0)
+	{
+		SendRemoteMessage(ChessWireMessage::MakeClock(numPliesShown - 1, m_playerOneTimeRemaining, m_playerTwoTimeRemaining), "");
+	}
+}
+
+void ChessMatch::SendMissingMoves(int numPliesKnown, uint64_t positionHash)
+{
+	int numPliesShown = GetNumPliesShown();
+	bool isInStep = numPliesKnown >= 0 && numPliesKnown <= numPliesShown;
+	if (isInStep)
+	{
+		uint64_t localHash = (numPliesKnown > 0) ? m_moveHistory[numPliesKnown - 1].m_positionHash : GetPositionForStartFEN(m_startFEN).GetHash();
+		isInStep = localHash == positionHash;
+	}
+	if (!isInStep)
+	{
+		SendResync();
+		return;
+	}
+
+	for (int plyIndex = numPliesKnown; plyIndex < numPliesShown; ++plyIndex)
+	{
+		SendRemoteMove(plyIndex, m_moveHistory[plyIndex], plyIndex == numPliesShown - 1, false);
+	}
+
+	// Nothing missed still brings the clocks up to date, which kept running while the link was down
+	SendCatchUpClock(numPliesShown);
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Sent the remote the %d moves it missed", numPliesShown - numPliesKnown));
+}
+
+// -----------------------------------------------------------------------------
+// Save and load work for the file worker. These run on its thread, so they see only the job:
+// the match record going out or coming in, and the message the game thread prints when it's done
+// -----------------------------------------------------------------------------
+static void WriteXmlMoveLine(XmlDocument& xmlDocument, XmlElement* lineElement, ChessMoveTree const& moveTree, uint32_t firstNodeIndex)
+{
+	// Each move's alternatives follow it as Variation elements, the way PGN writes them in parentheses
+	for (uint32_t nodeIndex = firstNodeIndex; nodeIndex != CHESS_NO_MOVE_NODE; nodeIndex = moveTree.GetNode(nodeIndex).m_firstChild)
+	{
+		ChessMoveNode const& node = moveTree.GetNode(nodeIndex);
+		XmlElement* moveElement = xmlDocument.NewElement("Move");
+		moveElement->SetText(node.m_record.GetMoveCommand().c_str());
+		if (node.m_record.m_clockSeconds > 0.f)
+		{
+			moveElement->SetAttribute("clock", node.m_record.m_clockSeconds);
+		}
+		lineElement->InsertEndChild(moveElement);
+
+		bool isMainContinuation = moveTree.GetNode(node.m_parent).m_firstChild == nodeIndex;
+		for (uint32_t siblingIndex = node.m_nextSibling; isMainContinuation && siblingIndex != CHESS_NO_MOVE_NODE; siblingIndex = moveTree.GetNode(siblingIndex).m_nextSibling)
+		{
+			XmlElement* variationElement = xmlDocument.NewElement("Variation");
+			lineElement->InsertEndChild(variationElement);
+			WriteXmlMoveLine(xmlDocument, variationElement, moveTree, siblingIndex);
+		}
+	}
+}
+
+static void ReadXmlMoveLine(XmlElement* lineElement, ChessPosition position, uint32_t parentIndex, ChessMoveTree& moveTree)
+{
+	// A Variation is an alternative to the Move before it, so it starts from that move's position and parent
+	ChessPosition positionBeforeMove = position;
+	uint32_t parentBeforeMove = CHESS_NO_MOVE_NODE;
+	for (XmlElement* element = lineElement->FirstChildElement(); element != nullptr; element = element->NextSiblingElement())
+	{
+		std::string elementName = element->Name();
+		if (elementName == "Move")
+		{
+			char const* moveCommand = element->GetText();
+			ChessMove move;
+			bool isTeleport = false;
+			if (moveCommand != nullptr && ParseChessMoveCommand(moveCommand, move, isTeleport))
+			{
+				positionBeforeMove = position;
+				parentBeforeMove = parentIndex;
+				parentIndex = moveTree.AddMove(parentIndex, ChessMoveRecord::MakeAndApply(position, move, isTeleport, element->FloatAttribute("clock", 0.f)));
+			}
+		}
+		else if (elementName == "Variation" && parentBeforeMove != CHESS_NO_MOVE_NODE)
+		{
+			ReadXmlMoveLine(element, positionBeforeMove, parentBeforeMove, moveTree);
+		}
+	}
+}
+
+static bool WriteXmlMatchFile(ChessFileJob& job)
+{
+	ChessMatchRecord const& record = job.m_record;
 	XmlDocument xmlDocument;
-	XmlError result = xmlDocument.LoadFile(filePath.c_str());
 
-	if (result != tinyxml2::XML_SUCCESS) 
+	XmlElement* root = xmlDocument.NewElement("ChessMatch");
+	xmlDocument.InsertFirstChild(root);
+	if (!record.m_startFEN.empty())
+	{
+		root->SetAttribute("startFEN", record.m_startFEN.c_str());
+	}
+	root->SetAttribute("keyframeInterval", record.m_keyframeInterval);
+
+	// Save each move: the main line, with every variation inside it
+	WriteXmlMoveLine(xmlDocument, root, record.m_moveTree, record.m_moveTree.GetNode(record.m_moveTree.GetRoot()).m_firstChild);
+
+	// Keyframes after the start, so a replay can seek without simulating the game first
+	for (int keyframeIndex = 1; keyframeIndex < static_cast<int>(record.m_keyframes.size()); ++keyframeIndex)
 	{
-		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Failed to load XML file.");
+		XmlElement* keyframeElement = xmlDocument.NewElement("Keyframe");
+		keyframeElement->SetAttribute("ply", keyframeIndex * record.m_keyframeInterval);
+		keyframeElement->SetAttribute("fen", record.m_keyframes[keyframeIndex].GetFEN().c_str());
+		root->InsertEndChild(keyframeElement);
+	}
+	job.m_progress = 0.5f;
+
+	// Save to file
+	XmlError result = xmlDocument.SaveFile(job.m_filePath.c_str());
+	if (result != tinyxml2::XML_SUCCESS)
+	{
+		job.m_message = "Failed to save XML file: " + job.m_filePath;
+		return false;
+	}
+	job.m_message = "Match saved to XML: " + job.m_filePath;
+	return true;
+}
+
+static bool ReadXmlMatchFile(ChessFileJob& job)
+{
+	ChessMatchRecord& record = job.m_record;
+	XmlDocument xmlDocument;
+	XmlError result = xmlDocument.LoadFile(job.m_filePath.c_str());
+	if (result != tinyxml2::XML_SUCCESS)
+	{
+		job.m_message = "Failed to load XML file: " + job.m_filePath;
+		return false;
 	}
 
 	XmlElement* root = xmlDocument.RootElement();
-	if (root == nullptr) 
+	if (root == nullptr)
 	{
-		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Invalid game data.");
+		job.m_message = "Invalid game data: " + job.m_filePath;
+		return false;
 	}
+	job.m_progress = 0.5f;
+
+	// Moves are kept as console commands; the records are rebuilt by playing them from the start
+	char const* startFENAttribute = root->Attribute("startFEN");
+	record.m_startFEN = (startFENAttribute != nullptr) ? startFENAttribute : "";
+	ReadXmlMoveLine(root, GetPositionForStartFEN(record.m_startFEN), record.m_moveTree.GetRoot(), record.m_moveTree);
+	std::vector<uint32_t> mainLineNodes;
+	record.m_moveTree.GetLine(record.m_moveTree.GetRoot(), record.m_moveHistory, mainLineNodes);
+
+	// Stored keyframes are kept up to the first one out of sequence; the match decides whether they fit
+	record.m_keyframeInterval = root->IntAttribute("keyframeInterval", 0);
+	if (record.m_keyframeInterval > 0)
+	{
+		record.m_keyframes.push_back(GetPositionForStartFEN(record.m_startFEN));
+		for (XmlElement* keyframeElement = root->FirstChildElement("Keyframe"); keyframeElement != nullptr; keyframeElement = keyframeElement->NextSiblingElement("Keyframe"))
+		{
+			char const* fen = keyframeElement->Attribute("fen");
+			ChessPosition keyframe;
+			if (keyframeElement->IntAttribute("ply", -1) != static_cast<int>(record.m_keyframes.size()) * record.m_keyframeInterval || fen == nullptr || !keyframe.SetFromFEN(fen))
+			{
+				break;
+			}
+			record.m_keyframes.push_back(keyframe);
+		}
+	}
+
+	job.m_message = Stringf("Loaded %d moves from XML file.", static_cast<int>(record.m_moveHistory.size()));
+	if (record.m_moveTree.GetNumVariations() > 0)
+	{
+		job.m_message += Stringf(" It has %u variations; ChessVariation lists them.", record.m_moveTree.GetNumVariations());
+	}
+	return true;
+}
 
-	// Clearing out history in case we have recorded any moves
-	m_moveHistory.clear();
+static bool WritePGNMatchFile(ChessFileJob& job)
+{
+	ChessMatchRecord const& record = job.m_record;
+	ChessPGNGame game;
+	game.m_startPosition = GetPositionForStartFEN(record.m_startFEN);
 
-	for (XmlElement* moveElement = root->FirstChildElement("Move"); moveElement != nullptr; moveElement = moveElement->NextSiblingElement("Move"))
+	ChessPosition position = game.m_startPosition;
+	for (ChessMoveRecord const& moveRecord : record.m_moveHistory)
 	{
-		char const* moveCommand = moveElement->GetText();
-		if (moveCommand != nullptr) 
+		if (!moveRecord.IsRulesMove() || !position.IsLegalMove(moveRecord.m_move))
 		{
-			m_moveHistory.push_back(moveCommand);
-			g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Loaded %d moves from XML file.", m_moveHistory.size()));
+			job.m_message = Stringf("Can't save to PGN, \"%s\" is not a legal chess move", moveRecord.GetMoveCommand().c_str());
+			return false;
 		}
+		position.MakeMove(moveRecord.m_move);
+		game.m_moves.push_back(moveRecord.m_move);
+	}
+
+	game.SetTag("Event", "Chess3D match");
+	game.SetTag("White", record.m_playerNames[0]);
+	game.SetTag("Black", record.m_playerNames[1]);
+	if (position.IsCheckmate())
+	{
+		game.m_result = (position.GetSideToMove() == 0) ? "0-1" : "1-0";
+	}
+	else if (position.IsStalemate() || position.IsInsufficientMaterial())
+	{
+		game.m_result = "1/2-1/2";
+	}
+	job.m_progress = 0.5f;
+
+	ChessPGNWriter writer;
+	if (!writer.Open(job.m_filePath, false) || !writer.WriteGame(game))
+	{
+		job.m_message = "Failed to save PGN file: " + job.m_filePath;
+		return false;
+	}
+	job.m_message = "Match saved to PGN: " + job.m_filePath;
+	return true;
+}
+
+static bool ReadPGNMatchFile(ChessFileJob& job)
+{
+	ChessPGNReader reader;
+	if (!reader.Open(job.m_filePath))
+	{
+		job.m_message = "Failed to load PGN file: " + job.m_filePath;
+		return false;
+	}
+
+	// Games deep in a big archive take a while to reach, so the skipping reports progress as it goes
+	int const SKIP_BATCH_GAMES = 1000;
+	int gameNumber = job.m_gameNumber;
+	bool hasGame = (gameNumber >= 1);
+	for (int numSkipped = 0; hasGame && numSkipped < gameNumber - 1; numSkipped += SKIP_BATCH_GAMES)
+	{
+		hasGame = reader.SkipGames(std::min(SKIP_BATCH_GAMES, gameNumber - 1 - numSkipped));
+		job.m_progress = static_cast<float>(numSkipped) / static_cast<float>(gameNumber);
+	}
+
+	ChessPGNGame game;
+	if (!hasGame || !reader.ReadNextGame(game))
+	{
+		job.m_message = Stringf("%s has no game %d", job.m_filePath.c_str(), gameNumber);
+		return false;
+	}
+	if (!game.IsValid())
+	{
+		job.m_message = Stringf("Game %d can't be replayed: %s", gameNumber, game.m_error.c_str());
+		return false;
+	}
+
+	// The recorded moves replay through ChessMove like any saved match
+	ChessMatchRecord& record = job.m_record;
+	std::string startFEN = game.m_startPosition.GetFEN();
+	record.m_startFEN = (startFEN == ChessPosition::GetStartingPosition().GetFEN()) ? "" : startFEN;
+	ChessPosition position = game.m_startPosition;
+	record.m_moveHistory.reserve(game.m_moves.size());
+	for (ChessMove const& move : game.m_moves)
+	{
+		record.m_moveHistory.push_back(ChessMoveRecord::MakeAndApply(position, move, false));
+	}
+
+	job.m_message = Stringf("Loaded game %d: %s - %s %s, %d moves from PGN file.", gameNumber,
+		game.GetTag("White", "?").c_str(), game.GetTag("Black", "?").c_str(), game.m_result.c_str(), static_cast<int>(record.m_moveHistory.size()));
+	return true;
+}
+
+static bool ReadGameArchiveMatchFile(ChessFileJob& job)
+{
+	ChessGameArchive gameArchive;
+	if (!gameArchive.Open(job.m_filePath))
+	{
+		job.m_message = "Failed to load game archive: " + job.m_filePath;
+		return false;
+	}
+
+	ChessSavedGame game;
+	if (job.m_gameNumber < 1 || !gameArchive.ReadGame(static_cast<uint32_t>(job.m_gameNumber - 1), game))
+	{
+		job.m_message = Stringf("%s has no game %d", job.m_filePath.c_str(), job.m_gameNumber);
+		return false;
+	}
+	if (!game.IsValid())
+	{
+		job.m_message = Stringf("Game %d can't be replayed: %s", job.m_gameNumber, game.m_error.c_str());
+		return false;
+	}
+
+	ChessMatchRecord& record = job.m_record;
+	std::string startFEN = game.m_startPosition.GetFEN();
+	record.m_startFEN = (startFEN == ChessPosition::GetStartingPosition().GetFEN()) ? "" : startFEN;
+	ChessPosition position = game.m_startPosition;
+	record.m_moveHistory.reserve(game.m_moves.size());
+	for (ChessMove const& move : game.m_moves)
+	{
+		record.m_moveHistory.push_back(ChessMoveRecord::MakeAndApply(position, move, false));
+	}
+
+	job.m_message = Stringf("Loaded game %d: %s - %s %s, %d moves from game archive.", job.m_gameNumber,
+		game.m_playerNames[0].c_str(), game.m_playerNames[1].c_str(), game.m_result.c_str(), static_cast<int>(record.m_moveHistory.size()));
+	return true;
+}
+
+static bool WriteGameLogMatchFile(ChessFileJob& job)
+{
+	ChessMatchRecord const& record = job.m_record;
+	ChessGameLogHeader header;
+	header.m_playerNames[0] = record.m_playerNames[0];
+	header.m_playerNames[1] = record.m_playerNames[1];
+	header.m_initialClockMS = static_cast<uint32_t>(record.m_initialClockSeconds * 1000.f);
+	header.m_startFEN = record.m_startFEN;
+
+	std::vector<uint16_t> loggedMoves;
+	loggedMoves.reserve(record.m_moveHistory.size());
+	for (ChessMoveRecord const& moveRecord : record.m_moveHistory)
+	{
+		loggedMoves.push_back(moveRecord.GetLoggedMove());
+	}
+
+	if (!ChessGameLog::WriteFile(job.m_filePath, header, loggedMoves))
+	{
+		job.m_message = "Failed to save game log file: " + job.m_filePath;
+		return false;
+	}
+	job.m_message = Stringf("Match saved to game log: %s (%d bytes)", job.m_filePath.c_str(), static_cast<int>(loggedMoves.size() * 4));
+	return true;
+}
+
+static bool ReadGameLogMatchFile(ChessFileJob& job)
+{
+	ChessGameLogHeader header;
+	std::vector<uint16_t> loggedMoves;
+	bool wasTruncated = false;
+	if (!ChessGameLog::ReadFile(job.m_filePath, header, loggedMoves, wasTruncated))
+	{
+		job.m_message = "Failed to load game log file: " + job.m_filePath;
+		return false;
+	}
+
+	ChessMatchRecord& record = job.m_record;
+	record.m_hasPlayerInfo = true;
+	record.m_playerNames[0] = header.m_playerNames[0];
+	record.m_playerNames[1] = header.m_playerNames[1];
+	record.m_initialClockSeconds = static_cast<float>(header.m_initialClockMS) * 0.001f;
+	record.m_startFEN = header.m_startFEN;
+	ChessPosition position = GetPositionForStartFEN(record.m_startFEN);
+	record.m_moveHistory.reserve(loggedMoves.size());
+	for (uint16_t loggedMove : loggedMoves)
+	{
+		record.m_moveHistory.push_back(ChessMoveRecord::MakeAndApplyLoggedMove(position, loggedMove));
+	}
+
+	job.m_message = Stringf("Loaded %d moves from game log file.", static_cast<int>(record.m_moveHistory.size()));
+	if (wasTruncated)
+	{
+		job.m_message += " It ends in a partly written move, which was dropped.";
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+ChessMatchRecord ChessMatch::GetMatchRecord() const
+{
+	ChessMatchRecord record;
+	record.m_startFEN = m_startFEN;
+	record.m_moveHistory = m_moveHistory;
+	record.m_moveTree = m_moveTree;
+	record.m_hasPlayerInfo = true;
+	record.m_playerNames[0] = m_playerOne->GetPlayerName();
+	record.m_playerNames[1] = m_playerTwo->GetPlayerName();
+	record.m_initialClockSeconds = m_initialClockTime;
+	record.m_keyframeInterval = m_keyframeInterval;
+
+	// Saved keyframes go with the main line, so a variation on the board leaves the loader to rebuild them
+	if (m_lineNodes.empty() || m_moveTree.IsMainLine(m_lineNodes.back()))
+	{
+		record.m_keyframes = m_keyframes;
+	}
+	return record;
+}
+
+void ChessMatch::QueueSaveGame(std::string const& filePath)
+{
+	std::unique_ptr<ChessFileJob> job = std::make_unique<ChessFileJob>();
+	job->m_type = ChessFileJobType::SAVE;
+	job->m_filePath = filePath;
+	job->m_record = GetMatchRecord();
+
+	std::string extension = GetFileExtension(filePath);
+	job->m_work = (extension == ".pgn") ? WritePGNMatchFile : (extension == ".cgl") ? WriteGameLogMatchFile : WriteXmlMatchFile;
+	g_theGame->m_fileWorker.QueueJob(std::move(job));
+}
+
+void ChessMatch::QueueLoadGame(std::string const& filePath, int gameNumber)
+{
+	std::unique_ptr<ChessFileJob> job = std::make_unique<ChessFileJob>();
+	job->m_type = ChessFileJobType::LOAD;
+	job->m_filePath = filePath;
+	job->m_gameNumber = gameNumber;
+
+	std::string extension = GetFileExtension(filePath);
+	job->m_work = (extension == ".pgn") ? ReadPGNMatchFile : (extension == ".cgl") ? ReadGameLogMatchFile : (extension == ".cga") ? ReadGameArchiveMatchFile : ReadXmlMatchFile;
+	g_theGame->m_fileWorker.QueueJob(std::move(job));
+}
+
+void ChessMatch::ApplyLoadedGame(ChessMatchRecord& record)
+{
+	if (record.m_hasPlayerInfo)
+	{
+		m_playerOne->SetPlayerName(record.m_playerNames[0]);
+		m_playerTwo->SetPlayerName(record.m_playerNames[1]);
+		m_initialClockTime = record.m_initialClockSeconds;
+		m_playerOneTimeRemaining = m_initialClockTime;
+		m_playerTwoTimeRemaining = m_initialClockTime;
+	}
+
+	// Games begun from a FEN replay from that position
+	m_startFEN = record.m_startFEN;
+	ResetBoardToInitialState();
+	m_moveHistory = std::move(record.m_moveHistory);
+	if (record.m_moveTree.GetNumNodes() > 1)
+	{
+		m_moveTree = std::move(record.m_moveTree);
+		m_moveTree.GetLine(m_moveTree.GetRoot(), m_moveHistory, m_lineNodes);
+	}
+	else
+	{
+		m_moveTree.Clear();
+		m_moveTree.AddLine(m_moveTree.GetRoot(), m_moveHistory, m_lineNodes);
 	}
+	m_currentMoveIndex = 0;
+	RestartGameLog();
 
-	g_theDevConsole->AddLine(DevConsole::INFO_MINOR, "Game loaded successfully.");
+	// Keyframes stored at our interval are taken as they are; older files, or another interval, rebuild them from the moves
+	if (record.m_keyframeInterval == m_keyframeInterval && record.m_keyframes.size() == m_moveHistory.size() / m_keyframeInterval + 1)
+	{
+		m_keyframes = std::move(record.m_keyframes);
+	}
+	else
+	{
+		RebuildKeyframes();
+	}
 }
 
 void ChessMatch::ReplayRecordedMatch(float deltaSeconds)
@@ -807,7 +1928,7 @@ void ChessMatch::ReplayRecordedMatch(float deltaSeconds)
 	float timeDelay = g_gameConfigBlackboard.GetValue("secondsBetweenPlaybackMoves", 1.f);
 	if (timeDelay == -1)
 	{
-		if (g_theInput->WasKeyJustPressed(KEYCODE_SPACE))
+		if (g_theInput->WasKeyJustPressed(KEYCODE_SPACE) && m_currentMoveIndex < static_cast<int>(m_moveHistory.size()))
 		{
 			PlayMove(m_moveHistory[m_currentMoveIndex]);
 			m_timeSinceLastMove = 0.f;
@@ -826,10 +1947,13 @@ void ChessMatch::ReplayRecordedMatch(float deltaSeconds)
 	}
 }
 
-void ChessMatch::PlayMove(std::string const& moveCommand)
+void ChessMatch::PlayMove(ChessMoveRecord const& moveRecord)
 {
+	// Straight to the board move, without building and parsing a console command
+	IntVec2 fromCoords(GetChessSquareX(moveRecord.m_move.m_from), GetChessSquareY(moveRecord.m_move.m_from));
+	IntVec2 toCoords(GetChessSquareX(moveRecord.m_move.m_to), GetChessSquareY(moveRecord.m_move.m_to));
 	m_isReplayingMove = true;
-	g_theDevConsole->Execute(moveCommand);
+	PlayBoardMove(fromCoords, toCoords, moveRecord.m_move.GetPromotionName(), moveRecord.IsTeleport(), false);
 	m_isReplayingMove = false;
 }
 
@@ -865,11 +1989,505 @@ void ChessMatch::UpdateDevConsoleBoard()
 	}
 }
 
+ChessGameLogHeader ChessMatch::GetGameLogHeader() const
+{
+	ChessGameLogHeader header;
+	header.m_playerNames[0] = m_playerOne->GetPlayerName();
+	header.m_playerNames[1] = m_playerTwo->GetPlayerName();
+	header.m_initialClockMS = static_cast<uint32_t>(m_initialClockTime * 1000.f);
+	header.m_startFEN = m_startFEN;
+	return header;
+}
+
+void ChessMatch::RestartGameLog()
+{
+	if (!m_gameLog.Create(GAME_JOURNAL_FILE_PATH, GetGameLogHeader()))
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Failed to create the match journal %s", GAME_JOURNAL_FILE_PATH));
+		return;
+	}
+	for (ChessMoveRecord const& moveRecord : m_moveHistory)
+	{
+		m_gameLog.AppendMove(moveRecord.GetLoggedMove());
+	}
+	m_gameLog.Sync();
+}
+
 void ChessMatch::ResetBoardToInitialState()
 {
 	delete m_board;
 	m_board = new ChessBoard(this); 
 	m_playerTurnIndex = 0;
 	m_timeSinceLastMove = 0.f;
+	m_position = ChessPosition::GetStartingPosition();
+
+	std::string errorMessage;
+	if (!m_startFEN.empty() && !SetupFromFEN(m_startFEN, errorMessage))
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, errorMessage);
+	}
+}
+
+static ChessPieceType GetPromotionTypeForName(std::string const& promotionName)
+{
+	if (promotionName == "rook")	return ChessPieceType::ROOK;
+	if (promotionName == "bishop")	return ChessPieceType::BISHOP;
+	if (promotionName == "knight")	return ChessPieceType::KNIGHT;
+	return ChessPieceType::QUEEN;
+}
+
+ChessMoveRecord ChessMatch::ApplyMoveToPosition(IntVec2 const& fromCoords, IntVec2 const& toCoords, std::string const& promotionName, bool isTeleport)
+{
+	// The board has already accepted the move; mirror it, or resync if the two rule sets disagree. A
+	// teleport, never a rules move, always resyncs.
+	ChessMove move;
+	move.m_from = static_cast<uint8_t>(GetChessSquare(fromCoords.x, fromCoords.y));
+	move.m_to = static_cast<uint8_t>(GetChessSquare(toCoords.x, toCoords.y));
+	move.m_promotion = promotionName.empty() ? 0 : static_cast<uint8_t>(static_cast<int>(GetPromotionTypeForName(promotionName)) + 1);
+	ChessMoveRecord record = ChessMoveRecord::MakeAndApply(m_position, move, isTeleport);
+	if (!record.IsRulesMove() || m_position.GetSideToMove() != (m_playerTurnIndex % 2))
+	{
+		RebuildPositionFromBoard();
+		record.m_positionHash = m_position.GetHash();
+	}
+	return record;
+}
+
+void ChessMatch::RebuildPositionFromBoard()
+{
+	m_position.Clear();
+	for (ChessPiece* piece : m_board->m_chessPieces)
+	{
+		if (piece != nullptr)
+		{
+			IntVec2 coords = piece->GetBoardPosition();
+			m_position.m_squares[GetChessSquare(coords.x, coords.y)] = MakeChessPieceCode(piece->GetDefinition()->m_chessPieceType, piece->GetPlayerIndex());
+		}
+	}
+	m_position.m_sideToMove = m_playerTurnIndex % 2;
+	m_position.m_fullmoveNumber = 1 + m_playerTurnIndex / 2;
+
+	// Castling rights survive while the king and rook are still unmoved on their home squares
+	uint8_t const castleFlags[2][2] = { { CASTLE_WHITE_KINGSIDE, CASTLE_WHITE_QUEENSIDE }, { CASTLE_BLACK_KINGSIDE, CASTLE_BLACK_QUEENSIDE } };
+	for (int playerIndex = 0; playerIndex < CHESS_NUM_PLAYERS; ++playerIndex)
+	{
+		int homeRank = (playerIndex == 0) ? 0 : 7;
+		ChessPiece* king = m_board->GetChessPieceForCoords(4, homeRank);
+		if (king == nullptr || king->HasMoved() || king->GetPlayerIndex() != playerIndex || king->GetDefinition()->m_chessPieceType != ChessPieceType::KING)
+		{
+			continue;
+		}
+		for (int side = 0; side < 2; ++side)
+		{
+			ChessPiece* rook = m_board->GetChessPieceForCoords((side == 0) ? 7 : 0, homeRank);
+			if (rook != nullptr && !rook->HasMoved() && rook->GetPlayerIndex() == playerIndex && rook->GetDefinition()->m_chessPieceType == ChessPieceType::ROOK)
+			{
+				m_position.m_castlingRights |= castleFlags[playerIndex][side];
+			}
+		}
+	}
+
+	IntVec2 enpassantSquare = m_board->m_enpassantTargetSquare;
+	if (enpassantSquare != -IntVec2::ONE)
+	{
+		m_position.m_enpassantSquare = GetChessSquare(enpassantSquare.x, enpassantSquare.y);
+	}
+	m_position.RefreshDerivedState();
 }
 
+bool ChessMatch::SetupFromFEN(std::string const& fen, std::string& out_errorMessage)
+{
+	ChessPosition position;
+	if (!position.SetFromFEN(fen.c_str()))
+	{
+		out_errorMessage = Stringf("Invalid FEN \"%s\"", fen.c_str());
+		return false;
+	}
+
+	// The board ends the game by capturing a king, so both must be there and the side that just moved can't be in check
+	if (position.GetKingSquare(0) == CHESS_NO_SQUARE || position.GetKingSquare(1) == CHESS_NO_SQUARE ||
+		position.CountPieces(ChessPieceType::KING, 0) != 1 || position.CountPieces(ChessPieceType::KING, 1) != 1)
+	{
+		out_errorMessage = "FEN must have exactly one king per side";
+		return false;
+	}
+	if (position.IsInCheck(1 - position.GetSideToMove()))
+	{
+		out_errorMessage = "FEN leaves the side that just moved in check";
+		return false;
+	}
+
+	StopEngineSearch();
+	m_board->SetupFromPosition(position);
+	m_position = position;
+	m_playerTurnIndex = (position.m_fullmoveNumber - 1) * 2 + position.GetSideToMove();
+
+	std::string normalizedFEN = position.GetFEN();
+	m_startFEN = (normalizedFEN == ChessPosition::GetStartingPosition().GetFEN()) ? "" : normalizedFEN;
+	return true;
+}
+
+ChessPlayer* ChessMatch::GetPlayer(int playerIndex) const
+{
+	return (playerIndex == 0) ? m_playerOne : m_playerTwo;
+}
+
+void ChessMatch::UpdateEngineTurn()
+{
+	if (m_engineSearch.valid())
+	{
+		if (m_engineSearch.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return;
+		}
+
+		ChessSearchResult result = m_engineSearch.get();
+		ChessEngineType engineType = m_searchingEngine->GetType();
+		m_searchingEngine = nullptr;
+
+		// The board may have been rewound or replayed while the engine was thinking
+		if (!result.HasMove() || m_replayMode || m_position.GetHash() != m_engineSearchHash)
+		{
+			return;
+		}
+
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Engine (%s) plays %s: score %d, depth %d, %llu nodes in %.2fs (%.0f nps, %llu tablebase hits)",
+			GetChessEngineTypeName(engineType), result.m_bestMove.GetNotation().c_str(), result.m_score, result.m_depth,
+			static_cast<unsigned long long>(result.m_nodes), result.m_seconds, result.GetNodesPerSecond(), static_cast<unsigned long long>(result.m_tablebaseHits)));
+		PlayEngineMove(result.m_bestMove);
+		return;
+	}
+
+	if (m_replayMode)
+	{
+		return;
+	}
+
+	int currentPlayerIndex = m_playerTurnIndex % 2;
+	ChessPlayer* currentPlayer = GetPlayer(currentPlayerIndex);
+	if (currentPlayer == nullptr || !currentPlayer->IsEngineControlled() || m_position.GetSideToMove() != currentPlayerIndex)
+	{
+		return;
+	}
+
+	// Nothing to search once a king is gone or the side to move is mated or stalemated
+	if (m_position.GetKingSquare(0) == CHESS_NO_SQUARE || m_position.GetKingSquare(1) == CHESS_NO_SQUARE || !m_position.HasLegalMove())
+	{
+		return;
+	}
+
+	ChessEngine* engine = currentPlayer->GetEngine();
+	ChessPosition position = m_position;
+	ChessSearchLimits searchLimits = currentPlayer->GetSearchLimits();
+
+	// Book moves cost no search at all, so they come first while the game is still in the opening
+	int gamePly = (m_position.m_fullmoveNumber - 1) * 2 + m_position.GetSideToMove();
+	ChessMove bookMove;
+	if (searchLimits.m_useOpeningBook && gamePly < m_openingBookMaxPlies && ChooseBookMove(bookMove))
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Engine (%s) plays book move %s", GetChessEngineTypeName(engine->GetType()), bookMove.GetNotation().c_str()));
+		PlayEngineMove(bookMove);
+		return;
+	}
+
+	m_searchingEngine = engine;
+	m_engineSearchHash = m_position.GetHash();
+	m_engineSearch = std::async(std::launch::async, [engine, position, searchLimits]()
+	{
+		return engine->Search(position, searchLimits);
+	});
+}
+
+void ChessMatch::StopEngineSearch()
+{
+	if (!m_engineSearch.valid())
+	{
+		return;
+	}
+
+	// Keep asking in case the stop lands before the search has reset its own flag
+	while (m_engineSearch.wait_for(std::chrono::milliseconds(10)) != std::future_status::ready)
+	{
+		m_searchingEngine->RequestStop();
+	}
+	m_engineSearch.get();
+	m_searchingEngine = nullptr;
+}
+
+void ChessMatch::PlayEngineMove(ChessMove const& move)
+{
+	IntVec2 fromCoords(GetChessSquareX(move.m_from), GetChessSquareY(move.m_from));
+	IntVec2 toCoords(GetChessSquareX(move.m_to), GetChessSquareY(move.m_to));
+	PlayBoardMove(fromCoords, toCoords, move.GetPromotionName(), false, false);
+}
+
+bool ChessMatch::OpenOpeningBook(std::string const& bookFilePath)
+{
+	if (!ChessOpeningBook::HasPolyglotRandoms())
+	{
+		std::string randomsFilePath = g_gameConfigBlackboard.GetValue("polyglotRandomsFile", "Data/Books/PolyglotRandom64.txt");
+		if (!ChessOpeningBook::LoadPolyglotRandoms(randomsFilePath))
+		{
+			DebuggerPrintf("Could not load the 781 Polyglot Random64 keys from %s, or they don't give the standard keys; opening book disabled\n", randomsFilePath.c_str());
+			return false;
+		}
+	}
+
+	if (!m_openingBook.Open(bookFilePath))
+	{
+		DebuggerPrintf("Could not map opening book %s\n", bookFilePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool ChessMatch::ChooseBookMove(ChessMove& out_move)
+{
+	return m_openingBook.ChooseMove(m_position, m_bookRandom(), out_move);
+}
+
+bool ChessMatch::AdjudicateWithTablebases()
+{
+	// Only the plain result counts: fifty-move cursed wins and blessed losses are draws
+	ChessWDLScore wdl = ChessWDLScore::DRAW;
+	bool isRemoteMatch = g_theGame->m_wireLink.GetState() != ChessWireLinkState::CLOSED || g_theGame->m_isWireResuming || g_theNetwork->IsConnected();
+	if (!m_isTablebaseAdjudicationEnabled || m_replayMode || isRemoteMatch || !g_chessTablebases.ProbeWDL(m_position, wdl))
+	{
+		return false;
+	}
+
+	int sideToMove = m_position.GetSideToMove();
+	if (wdl == ChessWDLScore::WIN || wdl == ChessWDLScore::LOSS)
+	{
+		int winningPlayer = (wdl == ChessWDLScore::WIN) ? sideToMove : 1 - sideToMove;
+		g_theDevConsole->AddLine(Rgba8::GREEN, Stringf("Tablebase adjudication: Player (%d) wins", winningPlayer));
+	}
+	else
+	{
+		g_theDevConsole->AddLine(Rgba8::GREEN, Stringf("Tablebase adjudication: drawn (%s)", GetChessWDLScoreName(wdl)));
+	}
+
+	StopEngineSearch();
+	QueueSaveGame(COMPLETED_MATCH_FILE_PATH);
+	m_gameLog.Sync();
+	m_isAdjudicated = true;
+	return true;
+}
+
+bool ChessMatch::Event_ChessPlayerEngine(EventArgs& args)
+{
+	int playerIndex = args.GetValue("player", -1);
+	std::string engineName = args.GetValue("engine", "");
+
+	if (playerIndex != 0 && playerIndex != 1)
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Missing argument! Correct argument: ChessPlayerEngine player=0 engine=mcts");
+		return false;
+	}
+
+	ChessEngineType engineType = GetChessEngineTypeForName(engineName);
+	if (engineType == ChessEngineType::NONE && engineName != "human")
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Invalid engine type. Must be alphabeta, mcts or human.");
+		return false;
+	}
+
+	ChessSearchLimits searchLimits;
+	searchLimits.m_maxSeconds = args.GetValue("seconds", g_gameConfigBlackboard.GetValue("engineSecondsPerMove", 2.f));
+	searchLimits.m_numThreads = args.GetValue("threads", g_gameConfigBlackboard.GetValue("engineThreads", 1));
+	searchLimits.m_maxDepth = args.GetValue("depth", searchLimits.m_maxDepth);
+	searchLimits.m_maxNodes = static_cast<uint64_t>(args.GetValue("nodes", 0));
+	searchLimits.m_mctsPolicy = GetChessMCTSPolicyTypeForName(args.GetValue("policy", "evaluation"));
+	searchLimits.m_useOpeningBook = args.GetValue("book", "true") == "true";
+	searchLimits.m_useTablebases = args.GetValue("tablebases", "true") == "true";
+
+	ChessMatch* match = g_theGame->m_theMatch;
+	match->StopEngineSearch();
+	match->GetPlayer(playerIndex)->SetEngine(engineType, searchLimits);
+
+	if (engineType == ChessEngineType::MCTS)
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Player %d is now played by mcts (%s policy, %d threads, %.1fs per move)", playerIndex,
+			GetChessMCTSPolicyTypeName(searchLimits.m_mctsPolicy), searchLimits.m_numThreads, searchLimits.m_maxSeconds));
+	}
+	else
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Player %d is now played by %s", playerIndex, GetChessEngineTypeName(engineType)));
+	}
+	return true;
+}
+
+bool ChessMatch::Event_ChessBookMove(EventArgs& args)
+{
+	ChessMatch* match = g_theGame->m_theMatch;
+	std::string bookFilePath = args.GetValue("file", "");
+	bool listOnly = args.GetValue("list", "false") == "true";
+
+	if (!bookFilePath.empty() && bookFilePath != match->m_openingBook.GetFilePath())
+	{
+		if (!match->OpenOpeningBook(bookFilePath))
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Could not open opening book %s (is polyglotRandomsFile set?)", bookFilePath.c_str()));
+			return false;
+		}
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Mapped opening book %s (%llu entries)", bookFilePath.c_str(),
+			static_cast<unsigned long long>(match->m_openingBook.GetNumEntries())));
+	}
+
+	if (!match->m_openingBook.IsOpen())
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "No opening book loaded. Correct argument: ChessBookMove file=Data/Books/book.bin");
+		return false;
+	}
+
+	std::vector<ChessBookEntry> entries;
+	match->m_openingBook.GetBookMoves(match->m_position, entries);
+	if (entries.empty())
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, "Position is not in the opening book");
+		return false;
+	}
+
+	for (ChessBookEntry const& entry : entries)
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("  %s weight %d", entry.m_move.GetNotation().c_str(), entry.m_weight));
+	}
+	if (listOnly)
+	{
+		return true;
+	}
+
+	ChessMove bookMove;
+	if (!match->ChooseBookMove(bookMove))
+	{
+		return false;
+	}
+	g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Book move %s", bookMove.GetNotation().c_str()));
+	match->PlayEngineMove(bookMove);
+	return true;
+}
+
+bool ChessMatch::Event_ChessFindMate(EventArgs& args)
+{
+	ChessMatch* match = g_theGame->m_theMatch;
+	ChessMateSearchLimits limits;
+	limits.m_maxPlies = args.GetValue("maxPlies", limits.m_maxPlies);
+	limits.m_maxNodes = static_cast<uint64_t>(args.GetValue("maxNodes", static_cast<int>(limits.m_maxNodes)));
+	if (limits.m_maxPlies < 1)
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Correct argument: ChessFindMate maxPlies=5 (mate in 3 is 5 plies)");
+		return false;
+	}
+
+	ChessMateFinder finder;
+	ChessMateResult result = finder.FindMate(match->m_position, limits);
+	if (result.m_status == ChessMateStatus::PROVEN)
+	{
+		std::string line;
+		for (ChessMove const& move : result.m_line)
+		{
+			line += " " + move.GetNotation();
+		}
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Mate in %d (%d plies):%s", (result.m_matePlies + 1) / 2, result.m_matePlies, line.c_str()));
+	}
+	else if (result.m_status == ChessMateStatus::DISPROVEN)
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("No forced mate within %d plies", limits.m_maxPlies));
+	}
+	else
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Gave up after %llu nodes without settling mate within %d plies",
+			static_cast<unsigned long long>(result.m_nodes), limits.m_maxPlies));
+	}
+	g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("  %llu nodes in %.2f seconds", static_cast<unsigned long long>(result.m_nodes), result.m_seconds));
+	return result.m_status == ChessMateStatus::PROVEN;
+}
+
+bool ChessMatch::Event_ChessFindPosition(EventArgs& args)
+{
+	ChessMatch* match = g_theGame->m_theMatch;
+	std::string indexFilePath = args.GetValue("file", g_gameConfigBlackboard.GetValue("positionIndexFile", "Data/SavedGames/Positions.cpi"));
+	std::string fenText = GetFENForArgument(args.GetValue("fen", ""));
+	int maxGamesListed = args.GetValue("max", 10);
+
+	ChessPosition position = match->m_position;
+	if (!fenText.empty() && !position.SetFromFEN(fenText.c_str()))
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Invalid FEN \"%s\"", fenText.c_str()));
+		return false;
+	}
+
+	// The index stays mapped between searches
+	ChessPositionIndex& positionIndex = match->m_positionIndex;
+	if ((!positionIndex.IsOpen() || positionIndex.GetFilePath() != indexFilePath) && !positionIndex.Open(indexFilePath))
+	{
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("No position index at %s; build it with Chess3D_Release_x64.exe -index", indexFilePath.c_str()));
+		return false;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	uint64_t firstEntryIndex = 0;
+	uint64_t numHits = positionIndex.FindPosition(position.GetHash(), firstEntryIndex);
+	double lookupMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+	if (numHits == 0)
+	{
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Position not reached in any of the %u indexed games (%.1f us)", positionIndex.GetNumGames(), lookupMicroseconds));
+		return true;
+	}
+
+	// What was played next and how those games ended; the most common positions are summed over their first entries only
+	struct NextMoveSummary
+	{
+		ChessMove m_move;
+		bool	  m_isGameEnd = false;
+		int		  m_numTimes = 0;
+		int		  m_numResults[3] = {};		// White wins, draws, black wins
+	};
+	std::vector<NextMoveSummary> nextMoves;
+	uint64_t numSummarizedHits = std::min<uint64_t>(numHits, 100000);
+	uint32_t numGames = 0;
+	uint32_t lastGameIndex = UINT32_MAX;
+	for (uint64_t hitIndex = 0; hitIndex < numSummarizedHits; ++hitIndex)
+	{
+		ChessPositionIndexHit hit = positionIndex.GetHit(firstEntryIndex + hitIndex);
+		numGames += (hit.m_gameIndex != lastGameIndex) ? 1 : 0;
+		lastGameIndex = hit.m_gameIndex;
+
+		auto found = std::find_if(nextMoves.begin(), nextMoves.end(), [&](NextMoveSummary const& summary) { return summary.m_move == hit.m_nextMove; });
+		if (found == nextMoves.end())
+		{
+			nextMoves.push_back(NextMoveSummary());
+			nextMoves.back().m_move = hit.m_nextMove;
+			nextMoves.back().m_isGameEnd = !hit.HasNextMove();
+			found = nextMoves.end() - 1;
+		}
+		found->m_numTimes += 1;
+		std::string result = positionIndex.GetGameResult(hit.m_gameIndex);
+		int resultIndex = (result == "1-0") ? 0 : (result == "1/2-1/2") ? 1 : (result == "0-1") ? 2 : -1;
+		if (resultIndex >= 0)
+		{
+			found->m_numResults[resultIndex] += 1;
+		}
+	}
+	std::sort(nextMoves.begin(), nextMoves.end(), [](NextMoveSummary const& summaryA, NextMoveSummary const& summaryB) { return summaryA.m_numTimes > summaryB.m_numTimes; });
+
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Position reached %llu times%s in %u games (%.1f us lookup)", static_cast<unsigned long long>(numHits),
+		(numSummarizedHits < numHits) ? ", first 100000 summed," : "", numGames, lookupMicroseconds));
+	for (NextMoveSummary const& summary : nextMoves)
+	{
+		std::string moveText = summary.m_isGameEnd ? "(game ended)" : position.IsLegalMove(summary.m_move) ? position.GetSANForMove(summary.m_move) : summary.m_move.GetNotation();
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("  %-12s %6d   +%d =%d -%d", moveText.c_str(), summary.m_numTimes, summary.m_numResults[0], summary.m_numResults[1], summary.m_numResults[2]));
+	}
+
+	// Where to look: LoadGame then ChessSeek to the ply
+	for (uint64_t hitIndex = 0; hitIndex < numHits && hitIndex < static_cast<uint64_t>(maxGamesListed); ++hitIndex)
+	{
+		ChessPositionIndexHit hit = positionIndex.GetHit(firstEntryIndex + hitIndex);
+		ChessIndexedGame game;
+		if (positionIndex.GetGame(hit.m_gameIndex, game))
+		{
+			g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("  %s game %d, ply %d of %d, %s", game.m_filePath.c_str(), game.m_gameNumber, hit.m_ply, game.m_numPlies, game.m_result));
+		}
+	}
+	return true;
+}
@@ -1,7 +1,17 @@
 #pragma once
 #include "Game/ChessBoard.hpp"
+#include "Game/ChessPosition.hpp"
+#include "Game/ChessEngine.hpp"
+#include "Game/ChessFileWorker.hpp"
+#include "Game/ChessGameLog.hpp"
+#include "Game/ChessMoveRecord.hpp"
+#include "Game/ChessOpeningBook.hpp"
+#include "Game/ChessPositionIndex.hpp"
+#include "Game/ChessWireProtocol.hpp"
 #include "Engine/Math/Vec3.h"
 #include "Engine/Core/EventSystem.hpp"
+#include <future>
+#include <random>
 // -----------------------------------------------------------------------------
 class Game;
 class ChessPlayer;
@@ -25,6 +35,13 @@ public:
 	static bool Event_RemoteCmd(EventArgs& args);
 	static bool Event_SaveChessGame(EventArgs& args);
 	static bool Event_LoadChessGame(EventArgs& args);
+	static bool Event_ChessPlayerEngine(EventArgs& args);
+	static bool Event_ChessBookMove(EventArgs& args);
+	static bool Event_ChessFindMate(EventArgs& args);
+	static bool Event_ChessSeek(EventArgs& args);
+	static bool Event_ChessFastForward(EventArgs& args);
+	static bool Event_ChessVariation(EventArgs& args);
+	static bool Event_ChessFindPosition(EventArgs& args);
 
 	// Remote events
 	static bool Event_ChessDisconnect(EventArgs& args);
@@ -36,14 +53,46 @@ public:
 	static bool Event_ChessOfferDraw(EventArgs& args);
 	static bool Event_ChessAcceptDraw(EventArgs& args);
 	static bool Event_ChessRejectDraw(EventArgs& args);
+	static bool Event_ChessResync(EventArgs& args);
 
-	// Saving the game to xml
-	void SaveGameToXmlFile(std::string const& filePath) const;
+	// Remote traffic goes as a binary frame over Game::m_wireLink when that is up, else as the text
+	// command through the engine's NetworkSystem; an empty text command means binary only
+	static void SendRemoteMessage(ChessWireMessage const& message, std::string const& textCommand);
+	void ReceiveWireMessage(ChessWireMessage const& message);
 
-	// Loading a recorded game from xml
-	void LoadGameFromXmlFile(std::string const& filePath);
+	// Every move sent carries a hash of the state it leaves, which the receiver checks. A mismatch, or a
+	// move the receiver can't play, has the authoritative side send the match again from its start.
+	// A live move's clocks go just before it; moves sent to catch up are followed by them instead.
+	void SendRemoteMove(int ply, ChessMoveRecord const& moveRecord, bool isChecked, bool isLive);
+	void SendCatchUpClock(int numPliesShown);
+	bool CheckRemoteState(int ply, bool wasMovePlayed, uint64_t stateHash);
+	// The receiver takes the mover's clocks once its move checks out, reporting them if they're far from its own
+	float GetTimeRemaining(int playerIndex) const;
+	void TakeMoverClock(ChessWireClock const& clock, float moverSecondsHere);
+	void ApplyRemoteClock(ChessWireClock const& clock);
+	void RequestResync(int ply);
+	void SendResync();
+	// For a peer back from a dropped link: the moves after its plies when its position there is ours, else a resync
+	void SendMissingMoves(int numPliesKnown, uint64_t positionHash);
+
+	// Saving and loading run on Game's file worker: xml, PGN archives (loading picks one game out by
+	// its 1-based number) and the binary game log. Results come back through Game::UpdateFileJobs.
+	ChessMatchRecord GetMatchRecord() const;
+	void QueueSaveGame(std::string const& filePath);
+	void QueueLoadGame(std::string const& filePath, int gameNumber);
+	void ApplyLoadedGame(ChessMatchRecord& record);
+
+	// Binary game log, also kept as a crash-safe journal of the match being played
+	ChessGameLogHeader GetGameLogHeader() const;
+	void RestartGameLog();
 	void ReplayRecordedMatch(float deltaSeconds);
-	void PlayMove(std::string const& moveCommand);
+	void PlayMove(ChessMoveRecord const& moveRecord);
+
+	// What ChessMove does once its arguments are read: checks the move on the board, moves the pieces,
+	// records it and passes it on to the remote player
+	bool PlayBoardMove(IntVec2 const& fromCoords, IntVec2 const& toCoords, std::string const& pawnPromotion, bool isTeleporting, bool isRemote);
+	// Teleports and rules moves alike, once the board has moved: history, journal, turn camera, game end and remote send
+	void FinishBoardMove(ChessMoveRecord& moveRecord, int playerIndex, int numPliesShown, bool isRemote);
 
 	// Chess Clock
 	void UpdateChessClock(float deltaseconds);
@@ -53,17 +102,53 @@ public:
 	// Rewinding Timeline
 	void RewindOneMove();
 	void ForwardOneMove();
+	void SeekToPly(int numPlies);
+	void FastForwardReplay(int numPlies, bool isVerifying);
+	void RebuildKeyframes();
+	void UpdateKeyframesForNewMove();
+
+	// Variations
+	int  GetNumPliesShown() const;
+	void SelectLine(uint32_t nodeIndex);
+
+	// Render-free shadow position, kept in step with the board for engines and tools
+	ChessMoveRecord ApplyMoveToPosition(IntVec2 const& fromCoords, IntVec2 const& toCoords, std::string const& promotionName, bool isTeleport);
+	void RebuildPositionFromBoard();
+
+	// Starting from any legal position; the board, turn and shadow position all follow the FEN
+	bool SetupFromFEN(std::string const& fen, std::string& out_errorMessage);
+
+	// Engine players
+	ChessPlayer* GetPlayer(int playerIndex) const;
+	void UpdateEngineTurn();
+	void StopEngineSearch();
+
+	// Opening book
+	bool OpenOpeningBook(std::string const& bookFilePath);
+	bool ChooseBookMove(ChessMove& out_move);
+	void PlayEngineMove(ChessMove const& move);
+
+	// Ends won or drawn endings as soon as the tablebases know the result. Local matches only, since the
+	// opponent's side may not have the tables; Game ends the match once IsAdjudicated() comes back true
+	bool AdjudicateWithTablebases();
+	bool IsAdjudicated() const		{ return m_isAdjudicated; }
 
 public:
 	int m_playerTurnIndex = 0;
 	ChessBoard* m_board = nullptr;
-	std::vector<std::string> m_moveHistory;
+	std::vector<ChessMoveRecord> m_moveHistory;		// The line being played or replayed, one of m_moveTree's
+	std::vector<uint32_t> m_lineNodes;				// m_moveTree node of each move in m_moveHistory
+	ChessMoveTree m_moveTree;
+	ChessPosition m_position;
+	std::string m_startFEN;		// Empty for the standard starting layout; rewinds and replays start here
 
 private:
 	Game* m_theGame = nullptr;
 	ChessPlayer* m_playerOne = nullptr;
 	ChessPlayer* m_playerTwo = nullptr;
 	bool m_hasPlayerOfferedDraw = false;
+	ChessWireClock m_remoteClock;			// The last CLOCK received, which the move after it is checked with
+	bool m_hasRemoteClock = false;
 
 	// Lighting
 	Vec3 m_sunDirection = Vec3(3.f, 1.f, -2.f);
@@ -77,10 +162,33 @@ private:
 
 	// Timing
 	float m_timeSinceLastMove = 0.0f;
-	int   m_currentMoveIndex = 0;
+	int   m_currentMoveIndex = 0;		// Plies the board shows; the next move to replay
 	float m_playerOneTimeRemaining = 0.f;
 	float m_playerTwoTimeRemaining = 0.f;
 	float m_initialClockTime = 300.f;
 	//int m_currentMoveIndex = -1;
 	bool m_isReplayingMove = false;
+
+	// Engine search running in the background for the player to move
+	std::future<ChessSearchResult> m_engineSearch;
+	ChessEngine* m_searchingEngine = nullptr;
+	uint64_t m_engineSearchHash = 0;
+
+	// Every recorded move is appended here as it is played
+	ChessGameLog m_gameLog;
+
+	// m_keyframes[k] is the position after k * m_keyframeInterval plies of m_moveHistory, so seeking
+	// anywhere plays at most one interval of moves
+	std::vector<ChessPosition> m_keyframes;
+	int m_keyframeInterval = 16;
+
+	// Archive position index for ChessFindPosition, mapped on first use
+	ChessPositionIndex m_positionIndex;
+
+	// Polyglot book shared by both engine players and ChessBookMove
+	ChessOpeningBook m_openingBook;
+	int m_openingBookMaxPlies = 20;
+	std::mt19937_64 m_bookRandom;
+	bool m_isTablebaseAdjudicationEnabled = true;
+	bool m_isAdjudicated = false;		// Mid-move, so the match can't be destroyed there and then
 };
\ No newline at end of file
@@ -0,0 +1,1352 @@
+#include "Game/ChessMatchServer.hpp"
+#include "Game/ChessGameLog.hpp"
+#include "Game/ChessMoveRecord.hpp"
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#else
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// -----------------------------------------------------------------------------
+constexpr uint32_t SERVER_LISTEN_POLL_INDEX = 0xFFFFFFFFu;
+constexpr int	   SERVER_LISTEN_BACKLOG = 4096;
+constexpr int	   SERVER_MAX_EVENTS = 1024;
+constexpr int	   SERVER_POLL_TIMEOUT_MS = 100;
+constexpr int	   SERVER_MAX_READS_PER_EVENT = 8;			// Then other connections get a turn; the socket stays ready
+constexpr size_t   SERVER_INITIAL_RECEIVE_BYTES = 512;
+constexpr size_t   SERVER_MAX_RECEIVE_BYTES = 2 * CHESS_WIRE_MAX_FRAME_SIZE;
+constexpr size_t   SERVER_MAX_SEND_BYTES = 64 * 1024;		// A peer further behind than this is dropped
+constexpr float	   SERVER_SWEEP_SECONDS = 1.f;
+constexpr size_t   SPECTATOR_MAX_QUEUED_BYTES = 4096;		// Per spectator; later moves wait in the room's log
+constexpr int	   SPECTATOR_SOCKET_SEND_BYTES = 16 * 1024;	// So a stalled spectator shows up here, not in the system's buffers
+constexpr float	   SPECTATOR_MAX_BEHIND_SECONDS = 10.f;		// Then the spectator is dropped
+// -----------------------------------------------------------------------------
+
+static void RaiseSocketLimit(int numSockets)
+{
+	// Every connection is a file descriptor, and the usual default soft limit is 1024
+#if !defined(_WIN32)
+	rlimit limit = {};
+	if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur >= static_cast<rlim_t>(numSockets))
+	{
+		return;
+	}
+	limit.rlim_cur = std::min(limit.rlim_max, static_cast<rlim_t>(numSockets));
+	setrlimit(RLIMIT_NOFILE, &limit);
+	if (limit.rlim_cur < static_cast<rlim_t>(numSockets))
+	{
+		printf("WARNING: only %llu file descriptors are allowed; raise the hard limit (ulimit -Hn) for %d sockets\n",
+			static_cast<unsigned long long>(limit.rlim_cur), numSockets);
+	}
+#else
+	(void)numSockets;
+#endif
+}
+
+static float GetSecondsSince(std::chrono::steady_clock::time_point startTime)
+{
+	return std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// -----------------------------------------------------------------------------
+// Readiness for many sockets at once: epoll on Linux, where waiting costs the same however many
+// sockets are idle, and WSAPoll over the whole set on Windows. Errors and hangups come back as
+// readable so the next receive finds them.
+// -----------------------------------------------------------------------------
+struct ChessServerPollEvent
+{
+	uint32_t m_index = 0;
+	bool	 m_isReadable = false;
+	bool	 m_isWritable = false;
+};
+
+class ChessServerPoller
+{
+public:
+	ChessServerPoller() = default;
+	~ChessServerPoller();
+	ChessServerPoller(ChessServerPoller const& copy) = delete;
+	ChessServerPoller& operator=(ChessServerPoller const& copy) = delete;
+
+	bool Open();
+	bool Add(uintptr_t socketHandle, uint32_t index, bool isWatchingWrites);
+	void WatchWrites(uintptr_t socketHandle, uint32_t index, bool isWatchingWrites);
+	void Remove(uintptr_t socketHandle, uint32_t index);
+	int	 Wait(ChessServerPollEvent* out_events, int maxEvents, int timeoutMS);
+
+private:
+#if defined(_WIN32)
+	std::vector<WSAPOLLFD> m_entries;
+	std::vector<uint32_t>  m_entryIndices;
+	std::unordered_map<uint32_t, size_t> m_entryForIndex;
+	size_t m_nextEntry = 0;		// Where the last Wait stopped, so a full batch doesn't always favor the same sockets
+#else
+	int m_epoll = -1;
+	std::vector<epoll_event> m_readyEvents;
+#endif
+};
+
+#if defined(_WIN32)
+ChessServerPoller::~ChessServerPoller()
+{
+}
+
+bool ChessServerPoller::Open()
+{
+	return InitializeChessWireSockets();
+}
+
+bool ChessServerPoller::Add(uintptr_t socketHandle, uint32_t index, bool isWatchingWrites)
+{
+	WSAPOLLFD entry = {};
+	entry.fd = static_cast<SOCKET>(socketHandle);
+	entry.events = static_cast<SHORT>(POLLRDNORM | (isWatchingWrites ? POLLWRNORM : 0));
+	m_entryForIndex[index] = m_entries.size();
+	m_entries.push_back(entry);
+	m_entryIndices.push_back(index);
+	return true;
+}
+
+void ChessServerPoller::WatchWrites(uintptr_t, uint32_t index, bool isWatchingWrites)
+{
+	auto found = m_entryForIndex.find(index);
+	if (found != m_entryForIndex.end())
+	{
+		m_entries[found->second].events = static_cast<SHORT>(POLLRDNORM | (isWatchingWrites ? POLLWRNORM : 0));
+	}
+}
+
+void ChessServerPoller::Remove(uintptr_t, uint32_t index)
+{
+	auto found = m_entryForIndex.find(index);
+	if (found == m_entryForIndex.end())
+	{
+		return;
+	}
+	size_t entryIndex = found->second;
+	m_entryForIndex.erase(found);
+	if (entryIndex + 1 != m_entries.size())
+	{
+		m_entries[entryIndex] = m_entries.back();
+		m_entryIndices[entryIndex] = m_entryIndices.back();
+		m_entryForIndex[m_entryIndices[entryIndex]] = entryIndex;
+	}
+	m_entries.pop_back();
+	m_entryIndices.pop_back();
+}
+
+int ChessServerPoller::Wait(ChessServerPollEvent* out_events, int maxEvents, int timeoutMS)
+{
+	if (m_entries.empty())
+	{
+		Sleep(static_cast<DWORD>(timeoutMS));
+		return 0;
+	}
+	if (WSAPoll(m_entries.data(), static_cast<ULONG>(m_entries.size()), timeoutMS) <= 0)
+	{
+		return 0;
+	}
+
+	int numEvents = 0;
+	size_t numEntries = m_entries.size();
+	for (size_t step = 0; step < numEntries && numEvents < maxEvents; ++step)
+	{
+		size_t entryIndex = (m_nextEntry + step) % numEntries;
+		SHORT returnedEvents = m_entries[entryIndex].revents;
+		if (returnedEvents == 0)
+		{
+			continue;
+		}
+		ChessServerPollEvent& event = out_events[numEvents++];
+		event.m_index = m_entryIndices[entryIndex];
+		event.m_isReadable = (returnedEvents & (POLLRDNORM | POLLERR | POLLHUP)) != 0;
+		event.m_isWritable = (returnedEvents & (POLLWRNORM | POLLERR | POLLHUP)) != 0;
+		m_nextEntry = entryIndex + 1;
+	}
+	return numEvents;
+}
+#else
+ChessServerPoller::~ChessServerPoller()
+{
+	if (m_epoll >= 0)
+	{
+		close(m_epoll);
+	}
+}
+
+bool ChessServerPoller::Open()
+{
+	m_epoll = epoll_create1(EPOLL_CLOEXEC);
+	m_readyEvents.resize(SERVER_MAX_EVENTS);
+	return m_epoll >= 0;
+}
+
+bool ChessServerPoller::Add(uintptr_t socketHandle, uint32_t index, bool isWatchingWrites)
+{
+	epoll_event event = {};
+	event.events = isWatchingWrites ? static_cast<uint32_t>(EPOLLIN | EPOLLOUT) : static_cast<uint32_t>(EPOLLIN);
+	event.data.u32 = index;
+	return epoll_ctl(m_epoll, EPOLL_CTL_ADD, static_cast<int>(socketHandle), &event) == 0;
+}
+
+void ChessServerPoller::WatchWrites(uintptr_t socketHandle, uint32_t index, bool isWatchingWrites)
+{
+	epoll_event event = {};
+	event.events = isWatchingWrites ? static_cast<uint32_t>(EPOLLIN | EPOLLOUT) : static_cast<uint32_t>(EPOLLIN);
+	event.data.u32 = index;
+	epoll_ctl(m_epoll, EPOLL_CTL_MOD, static_cast<int>(socketHandle), &event);
+}
+
+void ChessServerPoller::Remove(uintptr_t socketHandle, uint32_t)
+{
+	epoll_event event = {};
+	epoll_ctl(m_epoll, EPOLL_CTL_DEL, static_cast<int>(socketHandle), &event);
+}
+
+int ChessServerPoller::Wait(ChessServerPollEvent* out_events, int maxEvents, int timeoutMS)
+{
+	int numReady = epoll_wait(m_epoll, m_readyEvents.data(), std::min(maxEvents, static_cast<int>(m_readyEvents.size())), timeoutMS);
+	for (int eventIndex = 0; eventIndex < numReady; ++eventIndex)
+	{
+		uint32_t returnedEvents = m_readyEvents[eventIndex].events;
+		out_events[eventIndex].m_index = m_readyEvents[eventIndex].data.u32;
+		out_events[eventIndex].m_isReadable = (returnedEvents & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0;
+		out_events[eventIndex].m_isWritable = (returnedEvents & (EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0;
+	}
+	return std::max(numReady, 0);
+}
+#endif
+
+// -----------------------------------------------------------------------------
+ChessMatchServer::ChessMatchServer(ChessMatchServerSettings const& settings)
+	: m_settings(settings)
+{
+}
+
+ChessMatchServer::~ChessMatchServer()
+{
+	Shutdown();
+}
+
+bool ChessMatchServer::Run()
+{
+	if (!Start())
+	{
+		return false;
+	}
+
+	std::vector<ChessServerPollEvent> events(SERVER_MAX_EVENTS);
+	float nextStatusSeconds = m_settings.m_statusSeconds;
+	float nextSweepSeconds = SERVER_SWEEP_SECONDS;
+	while (!m_isStopRequested)
+	{
+		int numEvents = m_poller->Wait(events.data(), SERVER_MAX_EVENTS, SERVER_POLL_TIMEOUT_MS);
+		for (int eventIndex = 0; eventIndex < numEvents; ++eventIndex)
+		{
+			ChessServerPollEvent const& event = events[eventIndex];
+			if (event.m_index == SERVER_LISTEN_POLL_INDEX)
+			{
+				AcceptConnections();
+				continue;
+			}
+
+			int connectionIndex = static_cast<int>(event.m_index);
+			if (event.m_isWritable && !m_connections[connectionIndex].m_isDropped)
+			{
+				FlushConnection(connectionIndex);
+				if (m_connections[connectionIndex].m_isSpectator)
+				{
+					ServeSpectator(connectionIndex);
+				}
+			}
+			if (event.m_isReadable && !m_connections[connectionIndex].m_isDropped)
+			{
+				ReadConnection(connectionIndex);
+			}
+		}
+		ReleaseDroppedConnections();
+
+		float seconds = GetSecondsSince(m_startTime);
+		if (seconds >= nextSweepSeconds)
+		{
+			DropLaggingSpectators();
+			ReleaseDroppedConnections();
+			ReleaseHeldSeats();
+			nextSweepSeconds = seconds + SERVER_SWEEP_SECONDS;
+		}
+		if (m_settings.m_statusSeconds > 0.f && seconds >= nextStatusSeconds)
+		{
+			PrintStatus();
+			nextStatusSeconds = seconds + m_settings.m_statusSeconds;
+		}
+		if (m_settings.m_runSeconds > 0.f && seconds >= m_settings.m_runSeconds)
+		{
+			break;
+		}
+	}
+
+	PrintStatus();
+	Shutdown();
+	return true;
+}
+
+bool ChessMatchServer::Start()
+{
+	RaiseSocketLimit(m_settings.m_maxConnections + 16);
+	m_poller = std::make_unique<ChessServerPoller>();
+	m_listenSocket = OpenChessWireListenSocket(m_settings.m_port, SERVER_LISTEN_BACKLOG);
+	if (!m_poller->Open() || m_listenSocket == CHESS_NO_WIRE_SOCKET || !m_poller->Add(m_listenSocket, SERVER_LISTEN_POLL_INDEX, false))
+	{
+		printf("ERROR: could not listen on port %s\n", m_settings.m_port.c_str());
+		Shutdown();
+		return false;
+	}
+
+	m_connections.reserve(static_cast<size_t>(m_settings.m_maxConnections));
+	m_startTime = std::chrono::steady_clock::now();
+	printf("Match server listening on port %s for up to %d connections (protocol version %d)\n", m_settings.m_port.c_str(), m_settings.m_maxConnections, CHESS_WIRE_VERSION);
+	fflush(stdout);
+	return true;
+}
+
+void ChessMatchServer::Shutdown()
+{
+	for (ChessServerConnection& connection : m_connections)
+	{
+		CloseChessWireSocket(connection.m_socket);
+	}
+	m_connections.clear();
+	m_freeConnectionIndices.clear();
+	m_droppedConnectionIndices.clear();
+	m_rooms.clear();
+	m_numConnections = 0;
+	CloseChessWireSocket(m_listenSocket);
+	m_poller.reset();
+}
+
+void ChessMatchServer::AcceptConnections()
+{
+	for (;;)
+	{
+		uintptr_t acceptedSocket = AcceptChessWireSocket(m_listenSocket);
+		if (acceptedSocket == CHESS_NO_WIRE_SOCKET)
+		{
+			return;
+		}
+		if (m_numConnections >= m_settings.m_maxConnections)
+		{
+			CloseChessWireSocket(acceptedSocket);
+			continue;
+		}
+
+		int connectionIndex = static_cast<int>(m_connections.size());
+		if (!m_freeConnectionIndices.empty())
+		{
+			connectionIndex = m_freeConnectionIndices.back();
+			m_freeConnectionIndices.pop_back();
+		}
+		else
+		{
+			m_connections.emplace_back();
+		}
+		if (!m_poller->Add(acceptedSocket, static_cast<uint32_t>(connectionIndex), false))
+		{
+			CloseChessWireSocket(acceptedSocket);
+			m_freeConnectionIndices.push_back(connectionIndex);
+			continue;
+		}
+
+		// A reused slot keeps its buffers
+		ChessServerConnection& connection = m_connections[connectionIndex];
+		connection.m_socket = acceptedSocket;
+		connection.m_isDropped = false;
+		connection.m_peerVersion = 0;
+		connection.m_roomId = 0;
+		connection.m_seat = -1;
+		connection.m_isSpectator = false;
+		connection.m_receiveBuffer.resize(std::max(connection.m_receiveBuffer.size(), SERVER_INITIAL_RECEIVE_BYTES));
+		connection.m_receiveEnd = 0;
+		connection.m_sendStart = 0;
+		connection.m_sendEnd = 0;
+		connection.m_isWatchingWrites = false;
+
+		++m_numConnections;
+		++m_numAccepted;
+		m_peakConnections = std::max(m_peakConnections, m_numConnections);
+		Send(connectionIndex, ChessWireMessage::MakeHello());
+	}
+}
+
+void ChessMatchServer::ReadConnection(int connectionIndex)
+{
+	ChessServerConnection& connection = m_connections[connectionIndex];
+	for (int readIndex = 0; readIndex < SERVER_MAX_READS_PER_EVENT && !connection.m_isDropped; ++readIndex)
+	{
+		if (connection.m_receiveEnd == connection.m_receiveBuffer.size())
+		{
+			// Only a frame bigger than the buffer fills it, since whole frames are consumed below
+			if (connection.m_receiveBuffer.size() >= SERVER_MAX_RECEIVE_BYTES)
+			{
+				DropConnection(connectionIndex);
+				return;
+			}
+			connection.m_receiveBuffer.resize(std::min(connection.m_receiveBuffer.size() * 2, SERVER_MAX_RECEIVE_BYTES));
+		}
+
+		int numReceived = ReceiveChessWireBytes(connection.m_socket, connection.m_receiveBuffer.data() + connection.m_receiveEnd, connection.m_receiveBuffer.size() - connection.m_receiveEnd);
+		if (numReceived == 0)
+		{
+			return;
+		}
+		if (numReceived < 0)
+		{
+			DropConnection(connectionIndex);
+			return;
+		}
+		connection.m_receiveEnd += static_cast<size_t>(numReceived);
+
+		size_t frameStart = 0;
+		while (frameStart < connection.m_receiveEnd && !connection.m_isDropped)
+		{
+			ChessWireMessage message;
+			uint8_t const* frameBytes = connection.m_receiveBuffer.data() + frameStart;
+			int frameSize = ReadChessWireFrame(frameBytes, static_cast<int>(connection.m_receiveEnd - frameStart), message);
+			if (frameSize == 0)
+			{
+				break;
+			}
+			if (frameSize < 0)
+			{
+				DropConnection(connectionIndex);
+				return;
+			}
+			HandleFrame(connectionIndex, message, frameBytes, frameSize);
+			frameStart += static_cast<size_t>(frameSize);
+		}
+		if (frameStart > 0)
+		{
+			memmove(connection.m_receiveBuffer.data(), connection.m_receiveBuffer.data() + frameStart, connection.m_receiveEnd - frameStart);
+			connection.m_receiveEnd -= frameStart;
+		}
+	}
+}
+
+void ChessMatchServer::FlushConnection(int connectionIndex)
+{
+	ChessServerConnection& connection = m_connections[connectionIndex];
+	while (connection.m_sendStart < connection.m_sendEnd)
+	{
+		int numSent = SendChessWireBytes(connection.m_socket, connection.m_sendBuffer.data() + connection.m_sendStart, connection.m_sendEnd - connection.m_sendStart);
+		if (numSent == 0)
+		{
+			return;
+		}
+		if (numSent < 0)
+		{
+			DropConnection(connectionIndex);
+			return;
+		}
+		connection.m_sendStart += static_cast<size_t>(numSent);
+	}
+
+	connection.m_sendStart = 0;
+	connection.m_sendEnd = 0;
+	if (connection.m_isWatchingWrites)
+	{
+		connection.m_isWatchingWrites = false;
+		m_poller->WatchWrites(connection.m_socket, static_cast<uint32_t>(connectionIndex), false);
+	}
+}
+
+void ChessMatchServer::DropConnection(int connectionIndex)
+{
+	// Closing waits for the end of the batch, so no handler ever sees a room or slot vanish under it
+	ChessServerConnection& connection = m_connections[connectionIndex];
+	if (!connection.m_isDropped)
+	{
+		connection.m_isDropped = true;
+		m_droppedConnectionIndices.push_back(connectionIndex);
+	}
+}
+
+void ChessMatchServer::ReleaseDroppedConnections()
+{
+	// Leaving a room tells the other seat, which may drop that connection in turn and add it to the list
+	for (size_t droppedIndex = 0; droppedIndex < m_droppedConnectionIndices.size(); ++droppedIndex)
+	{
+		int connectionIndex = m_droppedConnectionIndices[droppedIndex];
+		LeaveRoom(connectionIndex, true);
+
+		ChessServerConnection& connection = m_connections[connectionIndex];
+		m_poller->Remove(connection.m_socket, static_cast<uint32_t>(connectionIndex));
+		CloseChessWireSocket(connection.m_socket);
+		m_freeConnectionIndices.push_back(connectionIndex);
+		--m_numConnections;
+	}
+	m_droppedConnectionIndices.clear();
+}
+
+// -----------------------------------------------------------------------------
+void ChessMatchServer::HandleFrame(int connectionIndex, ChessWireMessage const& message, uint8_t const* frameBytes, int frameSize)
+{
+	ChessServerConnection& connection = m_connections[connectionIndex];
+	if (connection.m_peerVersion == 0)
+	{
+		// The same opening the game's own link insists on
+		bool isSupported = message.m_type == ChessWireMessageType::HELLO && message.m_hello.m_version >= CHESS_WIRE_MIN_VERSION && message.m_hello.m_minVersion <= CHESS_WIRE_VERSION;
+		if (!isSupported)
+		{
+			DropConnection(connectionIndex);
+			return;
+		}
+		connection.m_peerVersion = message.m_hello.m_version;
+		return;
+	}
+	if (connection.m_isSpectator && message.m_type != ChessWireMessageType::JOIN && message.m_type != ChessWireMessageType::RESYNC)
+	{
+		return;
+	}
+
+	switch (message.m_type)
+	{
+		case ChessWireMessageType::JOIN:
+		{
+			JoinRoom(connectionIndex, message.m_join);
+			break;
+		}
+		case ChessWireMessageType::RESUME:
+		{
+			ResumeSeat(connectionIndex, message.m_resume);
+			break;
+		}
+		case ChessWireMessageType::MOVE:
+		{
+			auto found = m_rooms.find(connection.m_roomId);
+			if (found == m_rooms.end() || !CheckAndApplyMove(found->second, connection.m_seat, message.m_move))
+			{
+				++m_numMovesRejected;
+				break;
+			}
+			// The opponent first; spectators never hold up the players
+			++m_numMovesRelayed;
+			RelayToOpponent(connectionIndex, frameBytes, frameSize);
+			ServeSpectators(found->second);
+			break;
+		}
+		case ChessWireMessageType::TEXT:
+		{
+			RelayToOpponent(connectionIndex, frameBytes, frameSize);
+			auto found = m_rooms.find(connection.m_roomId);
+			if (found != m_rooms.end() && message.m_text.substr(0, 10) == "ChessBegin")
+			{
+				ResetRoom(found->second, message.m_text);
+				ServeSpectators(found->second);
+			}
+			break;
+		}
+		case ChessWireMessageType::RESYNC:
+		{
+			// The game again from its start: a spectator through its usual stream, a player all at once
+			auto found = m_rooms.find(connection.m_roomId);
+			if (found == m_rooms.end())
+			{
+				break;
+			}
+			if (connection.m_isSpectator)
+			{
+				connection.m_spectatedGeneration = 0;
+				ServeSpectator(connectionIndex);
+			}
+			else
+			{
+				SendRoomState(connectionIndex, found->second, -1);
+			}
+			break;
+		}
+		case ChessWireMessageType::CLOCK:
+		case ChessWireMessageType::OFFER:
+		case ChessWireMessageType::RESIGN:
+		{
+			RelayToOpponent(connectionIndex, frameBytes, frameSize);
+			auto found = m_rooms.find(connection.m_roomId);
+			if (found == m_rooms.end())
+			{
+				break;
+			}
+
+			// Spectators only see the latest clocks and how the game ended; draw offers stay between the players
+			ChessServerRoom& room = found->second;
+			if (message.m_type == ChessWireMessageType::CLOCK)
+			{
+				room.m_lastClock = message.m_clock;
+				++room.m_numClockUpdates;
+			}
+			else if (message.m_type == ChessWireMessageType::RESIGN || message.m_offer.m_offerType == ChessWireOfferType::DRAW_ACCEPT)
+			{
+				room.m_result = message;
+			}
+			ServeSpectators(room);
+			break;
+		}
+		default:
+		{
+			// HELLO again, SEAT, or a type from a newer client
+			break;
+		}
+	}
+}
+
+void ChessMatchServer::JoinRoom(int connectionIndex, ChessWireJoin const& join)
+{
+	// Joining anywhere, room 0 included, gives up the seat held so far
+	LeaveRoom(connectionIndex, false);
+	if (join.m_roomId == 0)
+	{
+		Send(connectionIndex, ChessWireMessage::MakeSeat(join.m_roomId, CHESS_WIRE_NO_SEAT, 0));
+		return;
+	}
+
+	ChessServerRoom& room = m_rooms[join.m_roomId];
+	if (room.m_roomId == 0)
+	{
+		room.m_roomId = join.m_roomId;
+		room.m_startPosition = ChessPosition::GetStartingPosition();
+		room.m_position = room.m_startPosition;
+		room.m_moveLog.reserve(128);
+	}
+
+	// Any number may watch; a new spectator is sent the game so far before the next move
+	ChessServerConnection& connection = m_connections[connectionIndex];
+	if (join.m_seat == CHESS_WIRE_SPECTATOR_SEAT)
+	{
+		room.m_spectators.push_back(connectionIndex);
+		connection.m_roomId = room.m_roomId;
+		connection.m_isSpectator = true;
+		connection.m_spectatedGeneration = 0;
+		connection.m_isBehind = false;
+		++m_numSpectators;
+		SetChessWireSendBufferSize(connection.m_socket, SPECTATOR_SOCKET_SEND_BYTES);
+		Send(connectionIndex, ChessWireMessage::MakeSeat(room.m_roomId, CHESS_WIRE_SPECTATOR_SEAT, room.NumSeated()));
+		ServeSpectator(connectionIndex);
+		return;
+	}
+
+	int seat = -1;
+	for (int seatIndex = 0; seatIndex < 2; ++seatIndex)
+	{
+		bool isWanted = join.m_seat == CHESS_WIRE_NO_SEAT || join.m_seat == seatIndex;
+		if (seat < 0 && isWanted && room.m_seatConnections[seatIndex] < 0 && room.m_seatTokens[seatIndex] == 0)
+		{
+			seat = seatIndex;
+		}
+	}
+	if (seat < 0)
+	{
+		Send(connectionIndex, ChessWireMessage::MakeSeat(room.m_roomId, CHESS_WIRE_NO_SEAT, room.NumSeated()));
+		if (room.IsEmpty())
+		{
+			m_rooms.erase(join.m_roomId);
+		}
+		return;
+	}
+
+	room.m_seatConnections[seat] = connectionIndex;
+	room.m_seatTokens[seat] = MakeChessWireSessionToken();
+	connection.m_roomId = room.m_roomId;
+	connection.m_seat = seat;
+	SendSeatChange(room);
+	Send(connectionIndex, ChessWireMessage::MakeSession(room.m_seatTokens[seat]));
+}
+
+static uint64_t GetPositionHashAtPly(ChessServerRoom const& room, int numPlies)
+{
+	ChessPosition position = room.m_startPosition;
+	for (int plyIndex = 0; plyIndex < numPlies; ++plyIndex)
+	{
+		ChessMoveRecord::MakeAndApplyLoggedMove(position, room.m_moveLog[plyIndex]);
+	}
+	return position.GetHash();
+}
+
+void ChessMatchServer::ResumeSeat(int connectionIndex, ChessWireResume const& resume)
+{
+	LeaveRoom(connectionIndex, false);
+	auto found = m_rooms.find(resume.m_roomId);
+	int seat = -1;
+	for (int seatIndex = 0; found != m_rooms.end() && seatIndex < 2; ++seatIndex)
+	{
+		seat = (resume.m_token != 0 && found->second.m_seatTokens[seatIndex] == resume.m_token) ? seatIndex : seat;
+	}
+	if (seat < 0)
+	{
+		Send(connectionIndex, ChessWireMessage::MakeSeat(resume.m_roomId, CHESS_WIRE_NO_SEAT, (found != m_rooms.end()) ? found->second.NumSeated() : 0));
+		return;
+	}
+
+	// A player back before its old connection was seen to fail takes over from it
+	ChessServerRoom& room = found->second;
+	int oldConnectionIndex = room.m_seatConnections[seat];
+	if (oldConnectionIndex >= 0)
+	{
+		m_connections[oldConnectionIndex].m_roomId = 0;
+		m_connections[oldConnectionIndex].m_seat = -1;
+		DropConnection(oldConnectionIndex);
+	}
+	ChessServerConnection& connection = m_connections[connectionIndex];
+	room.m_seatConnections[seat] = connectionIndex;
+	connection.m_roomId = room.m_roomId;
+	connection.m_seat = seat;
+	SendSeatChange(room);
+
+	// Only the moves it missed when its position after its plies is the room's; otherwise the whole game
+	bool isInStep = resume.m_ply <= room.m_moveLog.size() && GetPositionHashAtPly(room, resume.m_ply) == resume.m_positionHash;
+	SendRoomState(connectionIndex, room, isInStep ? resume.m_ply : -1);
+	++m_numResumes;
+	m_numResumeKeyframes += isInStep ? 0 : 1;
+}
+
+void ChessMatchServer::LeaveRoom(int connectionIndex, bool isHoldingSeat)
+{
+	ChessServerConnection& connection = m_connections[connectionIndex];
+	auto found = m_rooms.find(connection.m_roomId);
+	bool wasSpectator = connection.m_isSpectator;
+	connection.m_roomId = 0;
+	connection.m_seat = -1;
+	connection.m_isSpectator = false;
+	if (found == m_rooms.end())
+	{
+		return;
+	}
+
+	ChessServerRoom& room = found->second;
+	if (wasSpectator)
+	{
+		std::vector<int>& spectators = room.m_spectators;
+		spectators.erase(std::find(spectators.begin(), spectators.end(), connectionIndex));
+		--m_numSpectators;
+	}
+	for (int seatIndex = 0; seatIndex < 2; ++seatIndex)
+	{
+		if (room.m_seatConnections[seatIndex] == connectionIndex)
+		{
+			room.m_seatConnections[seatIndex] = -1;
+			room.m_seatTokens[seatIndex] = isHoldingSeat ? room.m_seatTokens[seatIndex] : 0;
+			room.m_seatDroppedTimes[seatIndex] = std::chrono::steady_clock::now();
+		}
+	}
+	if (room.IsEmpty())
+	{
+		m_rooms.erase(found);
+		return;
+	}
+	if (!wasSpectator)
+	{
+		SendSeatChange(room);
+	}
+}
+
+void ChessMatchServer::RelayToOpponent(int connectionIndex, uint8_t const* frameBytes, int frameSize)
+{
+	// Relayed as received, so fields a newer client appends reach a newer opponent intact
+	ChessServerConnection const& connection = m_connections[connectionIndex];
+	auto found = m_rooms.find(connection.m_roomId);
+	if (found == m_rooms.end() || connection.m_seat < 0)
+	{
+		return;
+	}
+	int opponentIndex = found->second.m_seatConnections[1 - connection.m_seat];
+	if (opponentIndex >= 0)
+	{
+		++m_numFramesRelayed;
+		SendFrameBytes(opponentIndex, frameBytes, frameSize);
+	}
+}
+
+bool ChessMatchServer::CheckAndApplyMove(ChessServerRoom& room, int seat, ChessWireMove const& move)
+{
+	// In step with the room and on the mover's turn; the rules themselves are left to the games, which
+	// also accept debug teleports, so a rules move only has to pick up one of the mover's own pieces
+	if (move.m_ply != room.m_moveLog.size() || room.m_position.GetSideToMove() != seat)
+	{
+		return false;
+	}
+	bool isTeleport = (move.m_loggedMove & CHESS_LOG_TELEPORT_BIT) != 0;
+	ChessMove chessMove = ChessMove::MakeFromPacked(static_cast<uint16_t>(move.m_loggedMove & ~CHESS_LOG_TELEPORT_BIT));
+	uint8_t pieceCode = room.m_position.GetPieceAt(chessMove.m_from);
+	if (!isTeleport && (pieceCode == CHESS_EMPTY_SQUARE || GetPlayerIndexForCode(pieceCode) != seat))
+	{
+		return false;
+	}
+
+	ChessMoveRecord::MakeAndApplyLoggedMove(room.m_position, move.m_loggedMove);
+	room.m_moveLog.push_back(move.m_loggedMove);
+	return true;
+}
+
+void ChessMatchServer::ResetRoom(ChessServerRoom& room, std::string_view beginCommand)
+{
+	// "ChessBegin fen=...", with the FEN's spaces written as '_'
+	room.m_position = ChessPosition::GetStartingPosition();
+	room.m_startPosition = room.m_position;
+	room.m_moveLog.clear();
+	room.m_beginCommand = std::string(beginCommand);
+	room.m_numClockUpdates = 0;
+	room.m_result = ChessWireMessage();
+	++room.m_generation;
+	size_t fenStart = beginCommand.find("fen=");
+	if (fenStart == std::string_view::npos)
+	{
+		return;
+	}
+	fenStart += 4;
+	std::string fen(beginCommand.substr(fenStart, beginCommand.find(' ', fenStart) - fenStart));
+	std::replace(fen.begin(), fen.end(), '_', ' ');
+	if (!room.m_position.SetFromFEN(fen.c_str()))
+	{
+		room.m_position = ChessPosition::GetStartingPosition();
+	}
+	room.m_startPosition = room.m_position;
+}
+
+void ChessMatchServer::SendRoomState(int connectionIndex, ChessServerRoom const& room, int numPliesKnown)
+{
+	// What a player whose board drifted, or who is back from a dropped connection, rebuilds from. The last
+	// move is checked the way the players check each other's, and the latest clocks follow the moves
+	if (numPliesKnown < 0)
+	{
+		Send(connectionIndex, ChessWireMessage::MakeText(room.m_beginCommand));
+		numPliesKnown = 0;
+	}
+	int numPlies = static_cast<int>(room.m_moveLog.size());
+	for (int plyIndex = numPliesKnown; plyIndex < numPlies; ++plyIndex)
+	{
+		uint64_t stateHash = (plyIndex == numPlies - 1) ? GetChessWireStateHash(room.m_position.GetHash(), plyIndex) : 0;
+		Send(connectionIndex, ChessWireMessage::MakeMove(plyIndex, room.m_moveLog[plyIndex], stateHash));
+	}
+	if (room.m_numClockUpdates > 0)
+	{
+		ChessWireMessage clockMessage;
+		clockMessage.m_type = ChessWireMessageType::CLOCK;
+		clockMessage.m_clock = room.m_lastClock;
+		Send(connectionIndex, clockMessage);
+	}
+	if (room.m_result.m_type != ChessWireMessageType::UNKNOWN)
+	{
+		Send(connectionIndex, room.m_result);
+	}
+}
+
+void ChessMatchServer::ServeSpectators(ChessServerRoom const& room)
+{
+	// Sends never close a connection straight away, so the list stays as it is during the loop
+	for (int spectatorIndex : room.m_spectators)
+	{
+		ServeSpectator(spectatorIndex);
+	}
+}
+
+void ChessMatchServer::ServeSpectator(int connectionIndex)
+{
+	// Fills the spectator's queue up to its bound from the room's state. A spectator that can't keep up
+	// gets everything it missed in one go once its socket drains, with only the latest clocks
+	ChessServerConnection& connection = m_connections[connectionIndex];
+	auto found = m_rooms.find(connection.m_roomId);
+	if (connection.m_isDropped || !connection.m_isSpectator || found == m_rooms.end())
+	{
+		return;
+	}
+	ChessServerRoom const& room = found->second;
+	auto hasSpaceFor = [&](size_t numBytes)
+	{
+		return !connection.m_isDropped && (connection.m_sendEnd - connection.m_sendStart) + numBytes <= SPECTATOR_MAX_QUEUED_BYTES;
+	};
+	auto sendToSpectator = [&](ChessWireMessage const& message)
+	{
+		++m_numSpectatorFrames;
+		Send(connectionIndex, message);
+	};
+
+	if (connection.m_spectatedGeneration != room.m_generation && hasSpaceFor(room.m_beginCommand.size() + 3))
+	{
+		sendToSpectator(ChessWireMessage::MakeText(room.m_beginCommand));
+		connection.m_spectatedGeneration = room.m_generation;
+		connection.m_numPliesSent = 0;
+		connection.m_numClockUpdatesSent = 0;
+		connection.m_hasSentResult = false;
+	}
+	while (connection.m_spectatedGeneration == room.m_generation && connection.m_numPliesSent < room.m_moveLog.size() && hasSpaceFor(6))
+	{
+		sendToSpectator(ChessWireMessage::MakeMove(static_cast<int>(connection.m_numPliesSent), room.m_moveLog[connection.m_numPliesSent]));
+		++connection.m_numPliesSent;
+	}
+
+	bool hasAllMoves = connection.m_spectatedGeneration == room.m_generation && connection.m_numPliesSent == room.m_moveLog.size();
+	if (hasAllMoves && connection.m_numClockUpdatesSent != room.m_numClockUpdates && hasSpaceFor(12))
+	{
+		ChessWireMessage clock;
+		clock.m_type = ChessWireMessageType::CLOCK;
+		clock.m_clock = room.m_lastClock;
+		sendToSpectator(clock);
+		connection.m_numClockUpdatesSent = room.m_numClockUpdates;
+	}
+	if (hasAllMoves && room.m_result.m_type != ChessWireMessageType::UNKNOWN && !connection.m_hasSentResult && hasSpaceFor(5))
+	{
+		sendToSpectator(room.m_result);
+		connection.m_hasSentResult = true;
+	}
+
+	bool isBehind = !hasAllMoves || connection.m_numClockUpdatesSent != room.m_numClockUpdates ||
+		(room.m_result.m_type != ChessWireMessageType::UNKNOWN && !connection.m_hasSentResult);
+	if (isBehind && !connection.m_isBehind)
+	{
+		connection.m_behindSince = std::chrono::steady_clock::now();
+	}
+	connection.m_isBehind = isBehind;
+}
+
+void ChessMatchServer::DropLaggingSpectators()
+{
+	for (int connectionIndex = 0; connectionIndex < static_cast<int>(m_connections.size()); ++connectionIndex)
+	{
+		ChessServerConnection const& connection = m_connections[connectionIndex];
+		if (connection.m_isSpectator && connection.m_isBehind && !connection.m_isDropped && GetSecondsSince(connection.m_behindSince) > SPECTATOR_MAX_BEHIND_SECONDS)
+		{
+			++m_numSpectatorsDropped;
+			DropConnection(connectionIndex);
+		}
+	}
+}
+
+void ChessMatchServer::ReleaseHeldSeats()
+{
+	// A seat nobody came back for goes to the next JOIN, and a room with nobody left goes entirely
+	auto now = std::chrono::steady_clock::now();
+	for (auto roomIterator = m_rooms.begin(); roomIterator != m_rooms.end();)
+	{
+		ChessServerRoom& room = roomIterator->second;
+		for (int seatIndex = 0; seatIndex < 2; ++seatIndex)
+		{
+			float heldSeconds = std::chrono::duration<float>(now - room.m_seatDroppedTimes[seatIndex]).count();
+			if (room.m_seatConnections[seatIndex] < 0 && room.m_seatTokens[seatIndex] != 0 && heldSeconds > m_settings.m_seatHoldSeconds)
+			{
+				room.m_seatTokens[seatIndex] = 0;
+				++m_numSeatsReleased;
+			}
+		}
+		roomIterator = room.IsEmpty() ? m_rooms.erase(roomIterator) : std::next(roomIterator);
+	}
+}
+
+void ChessMatchServer::SendSeatChange(ChessServerRoom const& room)
+{
+	// Sends never close a connection straight away, so the room outlives this loop
+	int numSeated = room.NumSeated();
+	for (int seatIndex = 0; seatIndex < 2; ++seatIndex)
+	{
+		if (room.m_seatConnections[seatIndex] >= 0)
+		{
+			Send(room.m_seatConnections[seatIndex], ChessWireMessage::MakeSeat(room.m_roomId, static_cast<uint8_t>(seatIndex), numSeated));
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+bool ChessMatchServer::Send(int connectionIndex, ChessWireMessage const& message)
+{
+	// Big enough for ChessBegin with a FEN
+	uint8_t frameBytes[256];
+	int frameSize = WriteChessWireFrame(message, frameBytes, static_cast<int>(sizeof(frameBytes)));
+	return frameSize > 0 && SendFrameBytes(connectionIndex, frameBytes, frameSize);
+}
+
+bool ChessMatchServer::SendFrameBytes(int connectionIndex, uint8_t const* frameBytes, int frameSize)
+{
+	ChessServerConnection& connection = m_connections[connectionIndex];
+	if (connection.m_isDropped)
+	{
+		return false;
+	}
+
+	// Straight to the socket when nothing is queued ahead of the frame, which is nearly always
+	size_t numQueued = 0;
+	if (connection.m_sendStart == connection.m_sendEnd)
+	{
+		int numSent = SendChessWireBytes(connection.m_socket, frameBytes, static_cast<size_t>(frameSize));
+		if (numSent < 0)
+		{
+			DropConnection(connectionIndex);
+			return false;
+		}
+		numQueued = static_cast<size_t>(numSent);
+		if (numQueued == static_cast<size_t>(frameSize))
+		{
+			return true;
+		}
+		connection.m_sendStart = 0;
+		connection.m_sendEnd = 0;
+	}
+
+	size_t numBytes = static_cast<size_t>(frameSize) - numQueued;
+	size_t numPending = connection.m_sendEnd - connection.m_sendStart;
+	if (numPending + numBytes > SERVER_MAX_SEND_BYTES)
+	{
+		DropConnection(connectionIndex);
+		return false;
+	}
+	if (connection.m_sendEnd + numBytes > connection.m_sendBuffer.size())
+	{
+		memmove(connection.m_sendBuffer.data(), connection.m_sendBuffer.data() + connection.m_sendStart, numPending);
+		connection.m_sendStart = 0;
+		connection.m_sendEnd = numPending;
+		if (numPending + numBytes > connection.m_sendBuffer.size())
+		{
+			connection.m_sendBuffer.resize(std::min(std::max(connection.m_sendBuffer.size() * 2, numPending + numBytes + 256), SERVER_MAX_SEND_BYTES));
+		}
+	}
+	memcpy(connection.m_sendBuffer.data() + connection.m_sendEnd, frameBytes + numQueued, numBytes);
+	connection.m_sendEnd += numBytes;
+
+	if (!connection.m_isWatchingWrites)
+	{
+		connection.m_isWatchingWrites = true;
+		m_poller->WatchWrites(connection.m_socket, static_cast<uint32_t>(connectionIndex), true);
+	}
+	return true;
+}
+
+void ChessMatchServer::PrintStatus()
+{
+	float seconds = GetSecondsSince(m_startTime);
+	printf("%7.0fs  %d connections (peak %d, %llu accepted), %zu rooms, %llu moves relayed (%.0f/s), %llu rejected, %llu frames relayed\n",
+		seconds, m_numConnections, m_peakConnections, static_cast<unsigned long long>(m_numAccepted), m_rooms.size(),
+		static_cast<unsigned long long>(m_numMovesRelayed), static_cast<double>(m_numMovesRelayed) / std::max(static_cast<double>(seconds), 1e-3),
+		static_cast<unsigned long long>(m_numMovesRejected), static_cast<unsigned long long>(m_numFramesRelayed));
+	printf("          %d spectators, %llu frames sent to them, %llu dropped for falling behind\n", m_numSpectators,
+		static_cast<unsigned long long>(m_numSpectatorFrames), static_cast<unsigned long long>(m_numSpectatorsDropped));
+	printf("          %llu resumes (%llu from the start of the game), %llu held seats released\n", static_cast<unsigned long long>(m_numResumes),
+		static_cast<unsigned long long>(m_numResumeKeyframes), static_cast<unsigned long long>(m_numSeatsReleased));
+	fflush(stdout);
+}
+
+// -----------------------------------------------------------------------------
+ChessServerLoadTest::ChessServerLoadTest(ChessServerLoadSettings const& settings)
+	: m_settings(settings)
+{
+}
+
+ChessServerLoadTest::~ChessServerLoadTest()
+{
+	// Players leave their rooms on the way out, so the server frees the seats instead of holding them for a
+	// resume and the test can run again straight away. Draining first makes the close a FIN, not a reset
+	uint8_t leaveBytes[16];
+	int leaveSize = WriteChessWireFrame(ChessWireMessage::MakeJoin(0, CHESS_WIRE_NO_SEAT), leaveBytes, static_cast<int>(sizeof(leaveBytes)));
+	for (ChessServerLoadClient& client : m_clients)
+	{
+		if (client.m_socket != CHESS_NO_WIRE_SOCKET && client.m_isSeated && !client.m_isSpectator)
+		{
+			while (ReceiveChessWireBytes(client.m_socket, client.m_receiveBuffer, sizeof(client.m_receiveBuffer)) > 0)
+			{
+			}
+			SendChessWireBytes(client.m_socket, leaveBytes, static_cast<size_t>(leaveSize));
+		}
+		CloseChessWireSocket(client.m_socket);
+	}
+}
+
+bool ChessServerLoadTest::Run()
+{
+	m_numPlayers = std::max(2, m_settings.m_numClients & ~1);
+	int numRooms = m_numPlayers / 2;
+	int numClients = m_numPlayers + std::max(0, m_settings.m_numSpectators);
+	RaiseSocketLimit(numClients + 16);
+	m_poller = std::make_unique<ChessServerPoller>();
+	if (!m_poller->Open())
+	{
+		printf("ERROR: could not create the poller\n");
+		return false;
+	}
+	m_clients.resize(static_cast<size_t>(numClients));
+	for (int clientIndex = m_numPlayers; clientIndex < numClients; ++clientIndex)
+	{
+		m_clients[clientIndex].m_isSpectator = true;
+	}
+	m_moveSentTimes.resize(static_cast<size_t>(numRooms));
+	m_moveLatenciesMS.reserve(static_cast<size_t>(numRooms) * static_cast<size_t>(m_settings.m_numPliesPerGame));
+	printf("Load test: %d players in %d rooms and %d spectators on %s:%s, %d plies a game\n", m_numPlayers, numRooms, numClients - m_numPlayers,
+		m_settings.m_address.c_str(), m_settings.m_port.c_str(), m_settings.m_numPliesPerGame);
+	fflush(stdout);
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	std::vector<ChessServerPollEvent> events(SERVER_MAX_EVENTS);
+	while (m_numFinished + m_numFailed < numClients && GetSecondsSince(startTime) < m_settings.m_timeoutSeconds)
+	{
+		OpenNextClients();
+		int numEvents = m_poller->Wait(events.data(), SERVER_MAX_EVENTS, 10);
+		for (int eventIndex = 0; eventIndex < numEvents; ++eventIndex)
+		{
+			int clientIndex = static_cast<int>(events[eventIndex].m_index);
+			ChessServerLoadClient& client = m_clients[clientIndex];
+			if (client.m_socket == CHESS_NO_WIRE_SOCKET)
+			{
+				continue;
+			}
+			if (client.m_isConnecting)
+			{
+				if (GetChessWireSocketError(client.m_socket) != 0)
+				{
+					FailClient(clientIndex);
+					continue;
+				}
+				OnClientConnected(clientIndex);
+			}
+			else if (events[eventIndex].m_isReadable)
+			{
+				ReadClient(clientIndex);
+			}
+		}
+	}
+	float seconds = GetSecondsSince(startTime);
+
+	std::sort(m_moveLatenciesMS.begin(), m_moveLatenciesMS.end());
+	auto getPercentile = [&](float fraction)
+	{
+		return m_moveLatenciesMS.empty() ? 0.f : m_moveLatenciesMS[std::min(m_moveLatenciesMS.size() - 1, static_cast<size_t>(fraction * static_cast<float>(m_moveLatenciesMS.size())))];
+	};
+	int numUnfinished = numClients - m_numFinished - m_numFailed;
+	printf("%d clients connected (%d at once at the peak), %d seated, %d finished their game, %d failed, %d timed out in %.2fs\n",
+		m_numConnected, m_peakConnected, m_numSeated, m_numFinished, m_numFailed, numUnfinished, seconds);
+	printf("  %zu moves relayed, %.0f moves/s; seat to seat latency p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", m_moveLatenciesMS.size(),
+		static_cast<double>(m_moveLatenciesMS.size()) / std::max(static_cast<double>(seconds), 1e-3), getPercentile(0.5f), getPercentile(0.99f), getPercentile(1.f));
+	if (numClients > m_numPlayers)
+	{
+		printf("  %llu moves reached %d spectators\n", static_cast<unsigned long long>(m_numSpectatorMoves), numClients - m_numPlayers);
+	}
+	return m_numFinished == numClients;
+}
+
+void ChessServerLoadTest::OpenNextClients()
+{
+	int numClients = static_cast<int>(m_clients.size());
+	while (m_numOpened < numClients && m_numConnecting < m_settings.m_maxConnectsInFlight)
+	{
+		int clientIndex = m_numOpened++;
+		ChessServerLoadClient& client = m_clients[clientIndex];
+		bool isConnected = false;
+		client.m_socket = OpenChessWireConnectSocket(m_settings.m_address, m_settings.m_port, isConnected);
+		if (client.m_socket == CHESS_NO_WIRE_SOCKET || !m_poller->Add(client.m_socket, static_cast<uint32_t>(clientIndex), !isConnected))
+		{
+			FailClient(clientIndex);
+			continue;
+		}
+
+		client.m_position = ChessPosition::GetStartingPosition();
+		if (isConnected)
+		{
+			OnClientConnected(clientIndex);
+		}
+		else
+		{
+			client.m_isConnecting = true;
+			++m_numConnecting;
+		}
+	}
+}
+
+void ChessServerLoadTest::OnClientConnected(int clientIndex)
+{
+	ChessServerLoadClient& client = m_clients[clientIndex];
+	if (client.m_isConnecting)
+	{
+		client.m_isConnecting = false;
+		--m_numConnecting;
+		m_poller->WatchWrites(client.m_socket, static_cast<uint32_t>(clientIndex), false);
+	}
+	++m_numConnected;
+	++m_numOpenConnections;
+	m_peakConnected = std::max(m_peakConnected, m_numOpenConnections);
+
+	// Room numbers start at 1; the first client of each pair plays first, and spectators go round the rooms
+	bool isSpectator = client.m_isSpectator;
+	uint32_t roomId = static_cast<uint32_t>((isSpectator ? (clientIndex - m_numPlayers) % (m_numPlayers / 2) : clientIndex / 2) + 1);
+	uint8_t seat = isSpectator ? CHESS_WIRE_SPECTATOR_SEAT : static_cast<uint8_t>(clientIndex % 2);
+	if (SendFrame(clientIndex, ChessWireMessage::MakeHello()))
+	{
+		SendFrame(clientIndex, ChessWireMessage::MakeJoin(roomId, seat));
+	}
+}
+
+void ChessServerLoadTest::ReadClient(int clientIndex)
+{
+	ChessServerLoadClient& client = m_clients[clientIndex];
+	int numReceived = ReceiveChessWireBytes(client.m_socket, client.m_receiveBuffer + client.m_receiveEnd, sizeof(client.m_receiveBuffer) - static_cast<size_t>(client.m_receiveEnd));
+	if (numReceived == 0)
+	{
+		return;
+	}
+	if (numReceived < 0)
+	{
+		FailClient(clientIndex);
+		return;
+	}
+	client.m_receiveEnd += numReceived;
+
+	int frameStart = 0;
+	while (client.m_socket != CHESS_NO_WIRE_SOCKET)
+	{
+		ChessWireMessage message;
+		int frameSize = ReadChessWireFrame(client.m_receiveBuffer + frameStart, client.m_receiveEnd - frameStart, message);
+		if (frameSize == 0)
+		{
+			break;
+		}
+		if (frameSize < 0)
+		{
+			FailClient(clientIndex);
+			return;
+		}
+		frameStart += frameSize;
+		HandleFrame(clientIndex, message);
+	}
+	memmove(client.m_receiveBuffer, client.m_receiveBuffer + frameStart, static_cast<size_t>(client.m_receiveEnd - frameStart));
+	client.m_receiveEnd -= frameStart;
+}
+
+void ChessServerLoadTest::HandleFrame(int clientIndex, ChessWireMessage const& message)
+{
+	ChessServerLoadClient& client = m_clients[clientIndex];
+	switch (message.m_type)
+	{
+		case ChessWireMessageType::SEAT:
+		{
+			if (message.m_seat.m_seat == CHESS_WIRE_NO_SEAT)
+			{
+				FailClient(clientIndex);
+			}
+			else if ((message.m_seat.m_numSeated == 2 || client.m_isSpectator) && !client.m_isSeated)
+			{
+				client.m_isSeated = true;
+				++m_numSeated;
+				if (message.m_seat.m_seat == 0 && !client.m_isSpectator)
+				{
+					PlayNextMove(clientIndex);
+				}
+			}
+			break;
+		}
+		case ChessWireMessageType::TEXT:
+		{
+			// A spectator's game so far starts with the room's ChessBegin
+			client.m_position = ChessPosition::GetStartingPosition();
+			client.m_numPlies = 0;
+			break;
+		}
+		case ChessWireMessageType::MOVE:
+		{
+			if (client.m_isSpectator)
+			{
+				ChessMoveRecord::MakeAndApplyLoggedMove(client.m_position, message.m_move.m_loggedMove);
+				++client.m_numPlies;
+				++m_numSpectatorMoves;
+				if (IsGameOver(clientIndex))
+				{
+					FinishClient(clientIndex);
+				}
+				break;
+			}
+			std::chrono::duration<float, std::milli> latency = std::chrono::steady_clock::now() - m_moveSentTimes[clientIndex / 2];
+			m_moveLatenciesMS.push_back(latency.count());
+			ChessMoveRecord::MakeAndApplyLoggedMove(client.m_position, message.m_move.m_loggedMove);
+			++client.m_numPlies;
+			PlayNextMove(clientIndex);
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+}
+
+void ChessServerLoadTest::PlayNextMove(int clientIndex)
+{
+	if (IsGameOver(clientIndex))
+	{
+		FinishClient(clientIndex);
+		return;
+	}
+
+	// Any legal move will do; the choice only has to differ between rooms and repeat between runs
+	ChessServerLoadClient& client = m_clients[clientIndex];
+	ChessMoveList moves;
+	client.m_position.GenerateLegalMoves(moves);
+	ChessMove const& move = moves[static_cast<int>((static_cast<uint32_t>(clientIndex / 2) * 31u + static_cast<uint32_t>(client.m_numPlies) * 7u) % static_cast<uint32_t>(moves.Size()))];
+	ChessMoveRecord record = ChessMoveRecord::MakeAndApply(client.m_position, move, false);
+
+	m_moveSentTimes[clientIndex / 2] = std::chrono::steady_clock::now();
+	if (SendFrame(clientIndex, ChessWireMessage::MakeMove(client.m_numPlies, record.GetLoggedMove())))
+	{
+		++client.m_numPlies;
+		if (IsGameOver(clientIndex))
+		{
+			FinishClient(clientIndex);
+		}
+	}
+}
+
+bool ChessServerLoadTest::IsGameOver(int clientIndex) const
+{
+	// Both seats follow the same position, so both see the game end on the same ply
+	ChessServerLoadClient const& client = m_clients[clientIndex];
+	return client.m_numPlies >= m_settings.m_numPliesPerGame || !client.m_position.HasLegalMove();
+}
+
+void ChessServerLoadTest::FinishClient(int clientIndex)
+{
+	// Stays connected, so every client counts toward the peak until the whole test is done
+	ChessServerLoadClient& client = m_clients[clientIndex];
+	if (!client.m_isFinished)
+	{
+		client.m_isFinished = true;
+		++m_numFinished;
+	}
+}
+
+void ChessServerLoadTest::FailClient(int clientIndex)
+{
+	ChessServerLoadClient& client = m_clients[clientIndex];
+	if (client.m_socket != CHESS_NO_WIRE_SOCKET)
+	{
+		m_numOpenConnections -= client.m_isConnecting ? 0 : 1;
+		m_poller->Remove(client.m_socket, static_cast<uint32_t>(clientIndex));
+		CloseChessWireSocket(client.m_socket);
+	}
+	if (client.m_isConnecting)
+	{
+		client.m_isConnecting = false;
+		--m_numConnecting;
+	}
+	if (!client.m_isFinished)
+	{
+		client.m_isFinished = true;
+		++m_numFailed;
+	}
+}
+
+bool ChessServerLoadTest::SendFrame(int clientIndex, ChessWireMessage const& message)
+{
+	// Frames are a few bytes on an idle socket; one that doesn't go out whole counts as a failure
+	uint8_t frameBytes[64];
+	int frameSize = WriteChessWireFrame(message, frameBytes, static_cast<int>(sizeof(frameBytes)));
+	if (SendChessWireBytes(m_clients[clientIndex].m_socket, frameBytes, static_cast<size_t>(frameSize)) != frameSize)
+	{
+		FailClient(clientIndex);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,220 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include "Game/ChessWireLink.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// -----------------------------------------------------------------------------
+class ChessServerPoller;
+// -----------------------------------------------------------------------------
+struct ChessMatchServerSettings
+{
+public:
+	std::string m_port = "3100";
+	int			m_maxConnections = 16384;
+	float		m_statusSeconds = 10.f;		// Between status lines; 0 = none
+	float		m_runSeconds = 0.f;			// 0 = until Stop()
+	float		m_seatHoldSeconds = 120.f;	// How long a dropped player's seat waits for it to RESUME
+};
+// -----------------------------------------------------------------------------
+struct ChessServerConnection
+{
+public:
+	uintptr_t m_socket = CHESS_NO_WIRE_SOCKET;
+	bool	  m_isDropped = false;		// Closed once the current batch of events is done
+	int		  m_peerVersion = 0;		// 0 until its HELLO arrives
+	uint32_t  m_roomId = 0;				// 0 = not seated
+	int		  m_seat = -1;
+	bool	  m_isSpectator = false;
+
+	// How much of its room's stream a spectator has been sent; the rest is made from the room when it has room
+	uint32_t  m_spectatedGeneration = 0;
+	uint32_t  m_numPliesSent = 0;
+	uint32_t  m_numClockUpdatesSent = 0;
+	bool	  m_hasSentResult = false;
+	bool	  m_isBehind = false;
+	std::chrono::steady_clock::time_point m_behindSince;
+
+	// Both grow on demand up to their limits and are then reused, so a steady stream allocates nothing
+	std::vector<uint8_t> m_receiveBuffer;
+	size_t				 m_receiveEnd = 0;
+	std::vector<uint8_t> m_sendBuffer;
+	size_t				 m_sendStart = 0;
+	size_t				 m_sendEnd = 0;
+	bool				 m_isWatchingWrites = false;
+};
+// -----------------------------------------------------------------------------
+// One match on the server: who holds each seat, the position and move log it has checked so far,
+// and what spectators are sent: the ChessBegin that started the game, its moves, the latest clocks
+// and how it ended. Spectators are served from this state rather than from queued copies of frames.
+// A seat belongs to its session token rather than its connection, so when a player drops the seat is
+// held for it, and the same state brings it back up to date when it resumes.
+// -----------------------------------------------------------------------------
+struct ChessServerRoom
+{
+public:
+	int	 NumSeated() const	{ return (m_seatConnections[0] >= 0 ? 1 : 0) + (m_seatConnections[1] >= 0 ? 1 : 0); }
+	bool IsEmpty() const	{ return NumSeated() == 0 && m_spectators.empty() && m_seatTokens[0] == 0 && m_seatTokens[1] == 0; }
+
+public:
+	uint32_t			  m_roomId = 0;
+	int					  m_seatConnections[2] = { -1, -1 };
+	uint64_t			  m_seatTokens[2] = {};		// 0 = free; kept while a dropped player may resume
+	std::chrono::steady_clock::time_point m_seatDroppedTimes[2];
+	std::vector<int>	  m_spectators;
+	ChessPosition		  m_startPosition;			// From the last ChessBegin
+	ChessPosition		  m_position;
+	std::vector<uint16_t> m_moveLog;		// ChessGameLog moves since the last ChessBegin
+
+	uint32_t		 m_generation = 1;		// Counts ChessBegins, so spectators know to start again
+	std::string		 m_beginCommand = "ChessBegin";
+	ChessWireClock	 m_lastClock;
+	uint32_t		 m_numClockUpdates = 0;
+	ChessWireMessage m_result;				// RESIGN or an accepted draw; UNKNOWN while the game goes on
+};
+// -----------------------------------------------------------------------------
+// Dedicated server hosting any number of independent matches on one port. Each connection speaks
+// ChessWireProtocol, joins a room with JOIN and is then relayed to whoever holds the other seat.
+// Everything runs on one thread around a non-blocking readiness loop: epoll on Linux, WSAPoll on
+// Windows. Moves are checked against the room's position for turn and ply before they are relayed,
+// which makes the server's copy of each game the one a player is resynced from.
+// -----------------------------------------------------------------------------
+class ChessMatchServer
+{
+public:
+	explicit ChessMatchServer(ChessMatchServerSettings const& settings);
+	~ChessMatchServer();
+	ChessMatchServer(ChessMatchServer const& copy) = delete;
+	ChessMatchServer& operator=(ChessMatchServer const& copy) = delete;
+
+	bool Run();
+	void Stop()		{ m_isStopRequested = true; }		// From any thread
+
+private:
+	bool Start();
+	void Shutdown();
+	void AcceptConnections();
+	void ReadConnection(int connectionIndex);
+	void FlushConnection(int connectionIndex);
+	void DropConnection(int connectionIndex);
+	void ReleaseDroppedConnections();
+
+	void HandleFrame(int connectionIndex, ChessWireMessage const& message, uint8_t const* frameBytes, int frameSize);
+	void JoinRoom(int connectionIndex, ChessWireJoin const& join);
+	void ResumeSeat(int connectionIndex, ChessWireResume const& resume);
+	void LeaveRoom(int connectionIndex, bool isHoldingSeat);
+	void ReleaseHeldSeats();
+	void RelayToOpponent(int connectionIndex, uint8_t const* frameBytes, int frameSize);
+	void ServeSpectators(ChessServerRoom const& room);
+	void ServeSpectator(int connectionIndex);
+	void DropLaggingSpectators();
+	bool CheckAndApplyMove(ChessServerRoom& room, int seat, ChessWireMove const& move);
+	void ResetRoom(ChessServerRoom& room, std::string_view beginCommand);
+	// From the room's ChessBegin when numPliesKnown is negative, else only the moves after that many plies
+	void SendRoomState(int connectionIndex, ChessServerRoom const& room, int numPliesKnown);
+	void SendSeatChange(ChessServerRoom const& room);
+
+	bool Send(int connectionIndex, ChessWireMessage const& message);
+	bool SendFrameBytes(int connectionIndex, uint8_t const* frameBytes, int frameSize);
+	void PrintStatus();
+
+private:
+	ChessMatchServerSettings m_settings;
+	std::unique_ptr<ChessServerPoller> m_poller;
+	uintptr_t m_listenSocket = CHESS_NO_WIRE_SOCKET;
+	std::atomic<bool> m_isStopRequested = false;
+
+	std::vector<ChessServerConnection> m_connections;		// By poller index; closed slots are reused
+	std::vector<int> m_freeConnectionIndices;
+	std::vector<int> m_droppedConnectionIndices;
+	int m_numConnections = 0;
+	std::unordered_map<uint32_t, ChessServerRoom> m_rooms;
+
+	uint64_t m_numAccepted = 0;
+	uint64_t m_numMovesRelayed = 0;
+	uint64_t m_numFramesRelayed = 0;
+	uint64_t m_numMovesRejected = 0;
+	uint64_t m_numSpectatorFrames = 0;
+	uint64_t m_numSpectatorsDropped = 0;
+	uint64_t m_numResumes = 0;
+	uint64_t m_numResumeKeyframes = 0;		// Resumes that needed the whole game, not just the missing moves
+	uint64_t m_numSeatsReleased = 0;		// Held seats nobody came back for
+	int		 m_numSpectators = 0;
+	int		 m_peakConnections = 0;
+	std::chrono::steady_clock::time_point m_startTime;
+};
+// -----------------------------------------------------------------------------
+struct ChessServerLoadSettings
+{
+public:
+	std::string m_address = "127.0.0.1";
+	std::string m_port = "3100";
+	int			m_numClients = 10000;			// Two to a room
+	int			m_numPliesPerGame = 40;
+	int			m_numSpectators = 0;			// Spread over the rooms after the players, e.g. 5000 with 2 clients
+	int			m_maxConnectsInFlight = 256;	// Kept under the server's listen backlog
+	float		m_timeoutSeconds = 120.f;
+};
+// -----------------------------------------------------------------------------
+struct ChessServerLoadClient
+{
+public:
+	uintptr_t	  m_socket = CHESS_NO_WIRE_SOCKET;
+	bool		  m_isConnecting = false;
+	bool		  m_isSpectator = false;
+	bool		  m_isSeated = false;
+	bool		  m_isFinished = false;
+	int			  m_numPlies = 0;
+	uint8_t		  m_receiveBuffer[256] = {};
+	int			  m_receiveEnd = 0;
+	ChessPosition m_position;
+};
+// -----------------------------------------------------------------------------
+// Loopback load test for ChessMatchServer: opens every client connection from one thread, seats
+// them in pairs, plays each pair's game with legal moves, and measures how long the server takes
+// to relay a move from one seat to the other while all of them stay connected. Spectators follow
+// the games and finish when they have seen every move.
+// -----------------------------------------------------------------------------
+class ChessServerLoadTest
+{
+public:
+	explicit ChessServerLoadTest(ChessServerLoadSettings const& settings);
+	~ChessServerLoadTest();
+	ChessServerLoadTest(ChessServerLoadTest const& copy) = delete;
+	ChessServerLoadTest& operator=(ChessServerLoadTest const& copy) = delete;
+
+	bool Run();
+
+private:
+	void OpenNextClients();
+	void OnClientConnected(int clientIndex);
+	void ReadClient(int clientIndex);
+	void HandleFrame(int clientIndex, ChessWireMessage const& message);
+	void PlayNextMove(int clientIndex);
+	bool IsGameOver(int clientIndex) const;
+	void FinishClient(int clientIndex);
+	void FailClient(int clientIndex);
+	bool SendFrame(int clientIndex, ChessWireMessage const& message);
+
+private:
+	ChessServerLoadSettings m_settings;
+	std::unique_ptr<ChessServerPoller> m_poller;
+	std::vector<ChessServerLoadClient> m_clients;
+	std::vector<std::chrono::steady_clock::time_point> m_moveSentTimes;		// By room, for the move in flight
+	std::vector<float> m_moveLatenciesMS;
+	uint64_t m_numSpectatorMoves = 0;
+
+	int m_numPlayers = 0;			// Clients before this index play, the rest watch
+	int m_numOpened = 0;
+	int m_numConnecting = 0;
+	int m_numConnected = 0;
+	int m_numOpenConnections = 0;
+	int m_peakConnected = 0;
+	int m_numSeated = 0;
+	int m_numFinished = 0;
+	int m_numFailed = 0;
+};
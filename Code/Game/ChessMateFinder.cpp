@@ -0,0 +1,240 @@
+#include "Game/ChessMateFinder.hpp"
+#include <algorithm>
+#include <chrono>
+
+// -----------------------------------------------------------------------------
+// Numbers are from the side to move: "proof" is what it still needs to show it wins, "disproof"
+// what the opponent needs to refute it. For the attacker winning means mating within the limit;
+// for the defender it means surviving it, so stalemate and running out of plies count as its wins.
+// -----------------------------------------------------------------------------
+constexpr uint32_t PN_INFINITY = 100000000;
+constexpr uint64_t PLIES_KEY_MULTIPLIER = 0x9E3779B97F4A7C15ull;
+constexpr uint32_t QUIET_MOVE_COST = 4;		// Unexplored attacker moves that neither check nor capture look this much harder to prove
+constexpr uint32_t CAPTURE_MOVE_COST = 2;
+// -----------------------------------------------------------------------------
+struct ChessMateTableEntry
+{
+public:
+	uint64_t m_hash = 0;
+	uint32_t m_proof = 0;
+	uint32_t m_disproof = 0;
+	int32_t	 m_pliesLeft = -1;
+};
+// -----------------------------------------------------------------------------
+
+ChessMateFinder::ChessMateFinder(int tableSizeMB)
+{
+	uint64_t numEntries = 1;
+	while (numEntries * 2 * sizeof(ChessMateTableEntry) <= static_cast<uint64_t>(std::max(1, tableSizeMB)) * 1024 * 1024)
+	{
+		numEntries *= 2;
+	}
+	m_table = new ChessMateTableEntry[numEntries];
+	m_tableMask = numEntries - 1;
+}
+
+ChessMateFinder::~ChessMateFinder()
+{
+	delete[] m_table;
+	m_table = nullptr;
+}
+
+ChessMateResult ChessMateFinder::FindMate(ChessPosition const& position, ChessMateSearchLimits const& limits)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	m_nodes = 0;
+	m_maxNodes = limits.m_maxNodes;
+	m_isStopRequested = false;
+
+	// Only odd limits make sense: the mating move is always the attacker's
+	ChessMateResult result;
+	result.m_status = ChessMateStatus::DISPROVEN;
+	for (int pliesLeft = 1; pliesLeft <= limits.m_maxPlies; pliesLeft += 2)
+	{
+		SearchNode(position, pliesLeft, PN_INFINITY, PN_INFINITY);
+
+		uint32_t proof = PN_INFINITY;
+		uint32_t disproof = 0;
+		LookUp(position.GetHash(), pliesLeft, proof, disproof);
+		if (proof == 0)
+		{
+			result.m_status = ChessMateStatus::PROVEN;
+			result.m_matePlies = pliesLeft;
+			ExtractLine(position, pliesLeft, result.m_line);
+			break;
+		}
+		if (disproof != 0)
+		{
+			result.m_status = ChessMateStatus::UNKNOWN;
+			break;
+		}
+	}
+
+	result.m_nodes = m_nodes;
+	result.m_seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+	return result;
+}
+
+bool ChessMateFinder::EvaluateTerminal(ChessPosition const& position, ChessMoveList const& moves, int pliesLeft, uint32_t& out_proof, uint32_t& out_disproof) const
+{
+	bool isAttacker = IsAttackerToMove(pliesLeft);
+	bool sideToMoveWins = false;
+	if (moves.m_count == 0)
+	{
+		// Checkmate loses for either side; stalemate is only a success for the defender
+		sideToMoveWins = !isAttacker && !position.IsInCheck(position.GetSideToMove());
+	}
+	else if (pliesLeft == 0)
+	{
+		sideToMoveWins = true;
+	}
+	else
+	{
+		return false;
+	}
+
+	out_proof = sideToMoveWins ? 0 : PN_INFINITY;
+	out_disproof = sideToMoveWins ? PN_INFINITY : 0;
+	return true;
+}
+
+void ChessMateFinder::SearchNode(ChessPosition const& position, int pliesLeft, uint32_t proofThreshold, uint32_t disproofThreshold)
+{
+	m_nodes += 1;
+	uint64_t hash = position.GetHash();
+
+	ChessMoveList moves;
+	position.GenerateLegalMoves(moves);
+	uint32_t proof = 0;
+	uint32_t disproof = 0;
+	if (EvaluateTerminal(position, moves, pliesLeft, proof, disproof))
+	{
+		Store(hash, pliesLeft, proof, disproof);
+		return;
+	}
+
+	// With one ply left only checks can mate, so the quiet moves are not even children. Unexplored
+	// attacker moves start out cheaper to prove the more forcing they are.
+	std::vector<ChessMove> childMoves;
+	std::vector<uint64_t> childHashes;
+	std::vector<uint32_t> childInitialDisproofs;
+	childMoves.reserve(moves.m_count);
+	childHashes.reserve(moves.m_count);
+	childInitialDisproofs.reserve(moves.m_count);
+	bool isAttacker = IsAttackerToMove(pliesLeft);
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessPosition child = position;
+		child.MakeMove(moves[moveIndex]);
+		bool isCheck = child.IsInCheck(child.GetSideToMove());
+		if (pliesLeft == 1 && !isCheck)
+		{
+			continue;
+		}
+		childMoves.push_back(moves[moveIndex]);
+		childHashes.push_back(child.GetHash());
+		childInitialDisproofs.push_back((!isAttacker || isCheck) ? 1 : (moves[moveIndex].IsCapture() ? CAPTURE_MOVE_COST : QUIET_MOVE_COST));
+	}
+
+	for (;;)
+	{
+		// proof = min over children of their disproof, disproof = sum of their proofs
+		proof = PN_INFINITY;
+		uint64_t disproofSum = 0;
+		int bestChild = -1;
+		uint32_t bestChildProof = 0;
+		uint32_t secondBestDisproof = PN_INFINITY;
+		for (int childIndex = 0; childIndex < static_cast<int>(childMoves.size()); ++childIndex)
+		{
+			uint32_t childProof = 1;
+			uint32_t childDisproof = childInitialDisproofs[childIndex];
+			LookUp(childHashes[childIndex], pliesLeft - 1, childProof, childDisproof);
+			disproofSum += childProof;
+			if (childDisproof < proof)
+			{
+				secondBestDisproof = proof;
+				proof = childDisproof;
+				bestChild = childIndex;
+				bestChildProof = childProof;
+			}
+			else if (childDisproof < secondBestDisproof)
+			{
+				secondBestDisproof = childDisproof;
+			}
+		}
+		disproof = static_cast<uint32_t>(std::min<uint64_t>(disproofSum, PN_INFINITY));
+
+		bool isOutOfBudget = m_nodes >= m_maxNodes || m_isStopRequested;
+		if (proof >= proofThreshold || disproof >= disproofThreshold || bestChild < 0 || isOutOfBudget)
+		{
+			m_isStopRequested = m_isStopRequested || m_nodes >= m_maxNodes;
+			Store(hash, pliesLeft, proof, disproof);
+			return;
+		}
+
+		// The child's thresholds are swapped into its own point of view. Letting it run a quarter past
+		// the second-best sibling (the 1+epsilon trick) stops the search flipping between two children.
+		uint64_t childProofThreshold = std::min<uint64_t>(static_cast<uint64_t>(disproofThreshold) + bestChildProof - disproof, PN_INFINITY);
+		uint32_t childDisproofThreshold = static_cast<uint32_t>(std::min<uint64_t>(proofThreshold, secondBestDisproof + secondBestDisproof / 4 + 1));
+		ChessPosition child = position;
+		child.MakeMove(childMoves[bestChild]);
+		SearchNode(child, pliesLeft - 1, static_cast<uint32_t>(childProofThreshold), childDisproofThreshold);
+	}
+}
+
+bool ChessMateFinder::LookUp(uint64_t hash, int pliesLeft, uint32_t& out_proof, uint32_t& out_disproof) const
+{
+	ChessMateTableEntry const& entry = m_table[(hash ^ (pliesLeft * PLIES_KEY_MULTIPLIER)) & m_tableMask];
+	if (entry.m_hash != hash || entry.m_pliesLeft != pliesLeft)
+	{
+		return false;
+	}
+	out_proof = entry.m_proof;
+	out_disproof = entry.m_disproof;
+	return true;
+}
+
+void ChessMateFinder::Store(uint64_t hash, int pliesLeft, uint32_t proof, uint32_t disproof)
+{
+	ChessMateTableEntry& entry = m_table[(hash ^ (pliesLeft * PLIES_KEY_MULTIPLIER)) & m_tableMask];
+	entry.m_hash = hash;
+	entry.m_pliesLeft = pliesLeft;
+	entry.m_proof = proof;
+	entry.m_disproof = disproof;
+}
+
+void ChessMateFinder::ExtractLine(ChessPosition const& position, int pliesLeft, std::vector<ChessMove>& out_line) const
+{
+	// Attacker: a move to a child proven lost for the defender; defender: every reply is proven lost,
+	// so follow the first one still in the table
+	out_line.clear();
+	ChessPosition current = position;
+	for (; pliesLeft > 0; --pliesLeft)
+	{
+		ChessMoveList moves;
+		current.GenerateLegalMoves(moves);
+		int chosenIndex = -1;
+		for (int moveIndex = 0; moveIndex < moves.m_count && chosenIndex < 0; ++moveIndex)
+		{
+			ChessPosition child = current;
+			child.MakeMove(moves[moveIndex]);
+			uint32_t childProof = PN_INFINITY;
+			uint32_t childDisproof = PN_INFINITY;
+			if (IsAttackerToMove(pliesLeft) && child.IsCheckmate())
+			{
+				chosenIndex = moveIndex;
+			}
+			else if (LookUp(child.GetHash(), pliesLeft - 1, childProof, childDisproof))
+			{
+				bool isProvenForAttacker = IsAttackerToMove(pliesLeft) ? (childDisproof == 0) : (childProof == 0);
+				chosenIndex = isProvenForAttacker ? moveIndex : -1;
+			}
+		}
+		if (chosenIndex < 0)
+		{
+			return;
+		}
+		out_line.push_back(moves[chosenIndex]);
+		current.MakeMove(moves[chosenIndex]);
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+// -----------------------------------------------------------------------------
+struct ChessMateTableEntry;
+// -----------------------------------------------------------------------------
+struct ChessMateSearchLimits
+{
+public:
+	int		 m_maxPlies = 5;				// Counting both sides, so mate in 3 is 5 plies
+	uint64_t m_maxNodes = 2000000;	
+};
+// -----------------------------------------------------------------------------
+enum class ChessMateStatus
+{
+	PROVEN,			// The side to move mates within m_matePlies whatever the defence
+	DISPROVEN,		// No forced mate within the ply limit
+	UNKNOWN			// Node limit or stop request hit first
+};
+// -----------------------------------------------------------------------------
+struct ChessMateResult
+{
+public:
+	ChessMateStatus		   m_status = ChessMateStatus::UNKNOWN;
+	int					   m_matePlies = 0;
+	std::vector<ChessMove> m_line;			// The mating moves with one defence between each
+	uint64_t			   m_nodes = 0;
+	float				   m_seconds = 0.f;
+};
+// -----------------------------------------------------------------------------
+// Depth-first proof-number search (df-pn) for forced mates by the side to move. Proof and
+// disproof numbers live in a hashed table keyed on the position and the plies left, so only
+// the current path is held in memory and the search always follows the most forcing line.
+// The ply limit is raised one attacker move at a time, which makes the first proof the shortest.
+// -----------------------------------------------------------------------------
+class ChessMateFinder
+{
+public:
+	explicit ChessMateFinder(int tableSizeMB = 64);
+	~ChessMateFinder();
+	ChessMateFinder(ChessMateFinder const& copy) = delete;
+	ChessMateFinder& operator=(ChessMateFinder const& copy) = delete;
+
+	ChessMateResult FindMate(ChessPosition const& position, ChessMateSearchLimits const& limits);
+	void			RequestStop() { m_isStopRequested = true; }
+
+private:
+	void SearchNode(ChessPosition const& position, int pliesLeft, uint32_t proofThreshold, uint32_t disproofThreshold);
+	bool EvaluateTerminal(ChessPosition const& position, ChessMoveList const& moves, int pliesLeft, uint32_t& out_proof, uint32_t& out_disproof) const;
+	bool IsAttackerToMove(int pliesLeft) const { return (pliesLeft & 1) != 0; }
+
+	bool LookUp(uint64_t hash, int pliesLeft, uint32_t& out_proof, uint32_t& out_disproof) const;
+	void Store(uint64_t hash, int pliesLeft, uint32_t proof, uint32_t disproof);
+	void ExtractLine(ChessPosition const& position, int pliesLeft, std::vector<ChessMove>& out_line) const;
+
+private:
+	ChessMateTableEntry* m_table = nullptr;
+	uint64_t			 m_tableMask = 0;
+	uint64_t			 m_nodes = 0;
+	uint64_t			 m_maxNodes = 0;
+	std::atomic<bool>	 m_isStopRequested = false;
+};
@@ -0,0 +1,105 @@
+#include "Game/ChessMoveRecord.hpp"
+#include "Game/ChessGameLog.hpp"
+
+// -----------------------------------------------------------------------------
+static void RelocatePiece(ChessPosition& position, int fromSquare, int toSquare)
+{
+	// Follows the board the way ChessMatch::RebuildPositionFromBoard would: castling rights go with a
+	// king or rook leaving or landing on its home square, and the turn passes
+	uint8_t pieceCode = position.GetPieceAt(fromSquare);
+	if (pieceCode == CHESS_EMPTY_SQUARE)
+	{
+		return;
+	}
+	position.RemovePieceAt(fromSquare);
+	position.SetPieceAt(toSquare, pieceCode);
+
+	uint8_t const castleFlags[2][2] = { { CASTLE_WHITE_KINGSIDE, CASTLE_WHITE_QUEENSIDE }, { CASTLE_BLACK_KINGSIDE, CASTLE_BLACK_QUEENSIDE } };
+	for (int playerIndex = 0; playerIndex < CHESS_NUM_PLAYERS; ++playerIndex)
+	{
+		int homeRank = (playerIndex == 0) ? 0 : 7;
+		for (int square : { fromSquare, toSquare })
+		{
+			if (square == GetChessSquare(4, homeRank))
+			{
+				position.m_castlingRights &= ~(castleFlags[playerIndex][0] | castleFlags[playerIndex][1]);
+			}
+			else if (square == GetChessSquare(7, homeRank))
+			{
+				position.m_castlingRights &= ~castleFlags[playerIndex][0];
+			}
+			else if (square == GetChessSquare(0, homeRank))
+			{
+				position.m_castlingRights &= ~castleFlags[playerIndex][1];
+			}
+		}
+	}
+	position.m_enpassantSquare = CHESS_NO_SQUARE;
+	position.m_fullmoveNumber += position.m_sideToMove;
+	position.m_sideToMove ^= 1;
+	position.RefreshDerivedState();
+}
+
+// -----------------------------------------------------------------------------
+std::string ChessMoveRecord::GetMoveCommand() const
+{
+	std::string moveCommand = "ChessMove from=" + GetNotationForChessSquare(m_move.m_from) + " to=" + GetNotationForChessSquare(m_move.m_to);
+	if (m_move.IsPromotion())
+	{
+		moveCommand += " promoteTo=" + m_move.GetPromotionName();
+	}
+	if (IsTeleport())
+	{
+		moveCommand += " teleport=true";
+	}
+	return moveCommand;
+}
+
+uint16_t ChessMoveRecord::GetLoggedMove() const
+{
+	return static_cast<uint16_t>(m_move.GetPacked() | (IsTeleport() ? CHESS_LOG_TELEPORT_BIT : 0));
+}
+
+void ChessMoveRecord::ApplyToPosition(ChessPosition& position) const
+{
+	if (IsRulesMove())
+	{
+		position.MakeMove(m_move);
+	}
+	else
+	{
+		RelocatePiece(position, m_move.m_from, m_move.m_to);
+	}
+}
+
+ChessMoveRecord ChessMoveRecord::MakeAndApply(ChessPosition& position, ChessMove const& move, bool isTeleport, float clockSeconds)
+{
+	ChessMoveRecord record;
+	record.m_clockSeconds = clockSeconds;
+
+	ChessPieceType promotionType = move.IsPromotion() ? move.GetPromotionType() : ChessPieceType::QUEEN;
+	if (!isTeleport && position.FindPseudoLegalMove(move.m_from, move.m_to, promotionType, record.m_move))
+	{
+		bool isEnpassant = (record.m_move.m_flags & CHESS_MOVE_FLAG_ENPASSANT) != 0;
+		int capturedSquare = isEnpassant ? GetChessSquare(GetChessSquareX(move.m_to), GetChessSquareY(move.m_from)) : move.m_to;
+		record.m_capturedPiece = position.GetPieceAt(capturedSquare);
+		position.MakeMove(record.m_move);
+	}
+	else
+	{
+		record.m_move.m_from = move.m_from;
+		record.m_move.m_to = move.m_to;
+		record.m_move.m_promotion = move.m_promotion;
+		record.m_move.m_flags = CHESS_MOVE_FLAG_RELOCATION | (isTeleport ? CHESS_MOVE_FLAG_TELEPORT : 0);
+		record.m_capturedPiece = (position.GetPieceAt(move.m_from) != CHESS_EMPTY_SQUARE) ? position.GetPieceAt(move.m_to) : CHESS_EMPTY_SQUARE;
+		RelocatePiece(position, move.m_from, move.m_to);
+	}
+	record.m_positionHash = position.GetHash();
+	return record;
+}
+
+ChessMoveRecord ChessMoveRecord::MakeAndApplyLoggedMove(ChessPosition& position, uint16_t loggedMove)
+{
+	ChessMove move = ChessMove::MakeFromPacked(static_cast<uint16_t>(loggedMove & ~CHESS_LOG_TELEPORT_BIT));
+	return MakeAndApply(position, move, (loggedMove & CHESS_LOG_TELEPORT_BIT) != 0);
+}
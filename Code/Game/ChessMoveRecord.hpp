@@ -0,0 +1,39 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include <cstdint>
+#include <string>
+// -----------------------------------------------------------------------------
+// Record-only move flags, above the ones the move generator sets. A relocation is anything the rules
+// don't know, which just moves the piece and passes the turn; the board's debug teleports are always one.
+constexpr uint8_t CHESS_MOVE_FLAG_RELOCATION = 1 << 5;
+constexpr uint8_t CHESS_MOVE_FLAG_TELEPORT = 1 << 6;
+// -----------------------------------------------------------------------------
+// One ply of a match's history as plain data: the move with its flags, the piece it captured, the
+// mover's clock and the position hash after it. Rewinds and replays apply the move as stored
+// without parsing anything; console commands and other text forms are only made when asked for.
+// -----------------------------------------------------------------------------
+struct ChessMoveRecord
+{
+public:
+	bool IsRulesMove() const	{ return (m_move.m_flags & CHESS_MOVE_FLAG_RELOCATION) == 0; }
+	bool IsTeleport() const		{ return (m_move.m_flags & CHESS_MOVE_FLAG_TELEPORT) != 0; }
+	bool IsCapture() const		{ return m_capturedPiece != CHESS_EMPTY_SQUARE; }
+
+	// "ChessMove from=e7 to=e8 promoteTo=queen", with teleport=true for teleports
+	std::string GetMoveCommand() const;
+	// ChessGameLog form: the packed move with CHESS_LOG_TELEPORT_BIT for teleports
+	uint16_t	GetLoggedMove() const;
+
+	// Replays the record on the position it was made from
+	void ApplyToPosition(ChessPosition& position) const;
+
+	// Looks the move up in the position to fill in its flags and capture, plays it, and records the hash after it
+	static ChessMoveRecord MakeAndApply(ChessPosition& position, ChessMove const& move, bool isTeleport, float clockSeconds = 0.f);
+	static ChessMoveRecord MakeAndApplyLoggedMove(ChessPosition& position, uint16_t loggedMove);
+
+public:
+	uint64_t  m_positionHash = 0;		// ChessPosition::GetHash() after the move
+	float	  m_clockSeconds = 0.f;		// Mover's time left after the move; 0 when the source didn't keep it
+	ChessMove m_move;
+	uint8_t	  m_capturedPiece = CHESS_EMPTY_SQUARE;
+};
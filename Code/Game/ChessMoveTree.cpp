@@ -0,0 +1,132 @@
+#include "Game/ChessMoveTree.hpp"
+
+// -----------------------------------------------------------------------------
+ChessMoveTree::ChessMoveTree()
+{
+	Clear();
+}
+
+void ChessMoveTree::Clear()
+{
+	m_nodes.clear();
+	m_nodes.push_back(ChessMoveNode());
+}
+
+uint32_t ChessMoveTree::GetNumVariations() const
+{
+	uint32_t numVariations = 0;
+	for (ChessMoveNode const& node : m_nodes)
+	{
+		numVariations += (node.m_nextSibling != CHESS_NO_MOVE_NODE) ? 1 : 0;
+	}
+	return numVariations;
+}
+
+bool ChessMoveTree::IsMainLine(uint32_t nodeIndex) const
+{
+	for (uint32_t parentIndex = m_nodes[nodeIndex].m_parent; parentIndex != CHESS_NO_MOVE_NODE; parentIndex = m_nodes[nodeIndex].m_parent)
+	{
+		if (m_nodes[parentIndex].m_firstChild != nodeIndex)
+		{
+			return false;
+		}
+		nodeIndex = parentIndex;
+	}
+	return true;
+}
+
+uint32_t ChessMoveTree::AddMove(uint32_t parentIndex, ChessMoveRecord const& record)
+{
+	uint32_t existingIndex = FindMove(parentIndex, record);
+	if (existingIndex != CHESS_NO_MOVE_NODE)
+	{
+		return existingIndex;
+	}
+
+	uint32_t newIndex = GetNumNodes();
+	ChessMoveNode newNode;
+	newNode.m_record = record;
+	newNode.m_parent = parentIndex;
+	newNode.m_numPlies = m_nodes[parentIndex].m_numPlies + 1;
+	m_nodes.push_back(newNode);
+
+	uint32_t* link = &m_nodes[parentIndex].m_firstChild;
+	while (*link != CHESS_NO_MOVE_NODE)
+	{
+		link = &m_nodes[*link].m_nextSibling;
+	}
+	*link = newIndex;
+	return newIndex;
+}
+
+uint32_t ChessMoveTree::FindMove(uint32_t parentIndex, ChessMoveRecord const& record) const
+{
+	for (uint32_t childIndex = m_nodes[parentIndex].m_firstChild; childIndex != CHESS_NO_MOVE_NODE; childIndex = m_nodes[childIndex].m_nextSibling)
+	{
+		ChessMoveRecord const& childRecord = m_nodes[childIndex].m_record;
+		if (childRecord.m_move == record.m_move && childRecord.IsTeleport() == record.IsTeleport())
+		{
+			return childIndex;
+		}
+	}
+	return CHESS_NO_MOVE_NODE;
+}
+
+void ChessMoveTree::GetChildren(uint32_t parentIndex, std::vector<uint32_t>& out_childIndices) const
+{
+	out_childIndices.clear();
+	for (uint32_t childIndex = m_nodes[parentIndex].m_firstChild; childIndex != CHESS_NO_MOVE_NODE; childIndex = m_nodes[childIndex].m_nextSibling)
+	{
+		out_childIndices.push_back(childIndex);
+	}
+}
+
+void ChessMoveTree::GetLine(uint32_t nodeIndex, std::vector<ChessMoveRecord>& out_records, std::vector<uint32_t>& out_nodeIndices) const
+{
+	out_nodeIndices.resize(m_nodes[nodeIndex].m_numPlies);
+	for (uint32_t lineIndex = nodeIndex; lineIndex != GetRoot(); lineIndex = m_nodes[lineIndex].m_parent)
+	{
+		out_nodeIndices[m_nodes[lineIndex].m_numPlies - 1] = lineIndex;
+	}
+	for (uint32_t childIndex = m_nodes[nodeIndex].m_firstChild; childIndex != CHESS_NO_MOVE_NODE; childIndex = m_nodes[childIndex].m_firstChild)
+	{
+		out_nodeIndices.push_back(childIndex);
+	}
+
+	out_records.resize(out_nodeIndices.size());
+	for (size_t plyIndex = 0; plyIndex < out_nodeIndices.size(); ++plyIndex)
+	{
+		out_records[plyIndex] = m_nodes[out_nodeIndices[plyIndex]].m_record;
+	}
+}
+
+void ChessMoveTree::AddLine(uint32_t parentIndex, std::vector<ChessMoveRecord> const& records, std::vector<uint32_t>& out_nodeIndices)
+{
+	m_nodes.reserve(m_nodes.size() + records.size());
+	out_nodeIndices.clear();
+	out_nodeIndices.reserve(records.size());
+	for (ChessMoveRecord const& record : records)
+	{
+		parentIndex = AddMove(parentIndex, record);
+		out_nodeIndices.push_back(parentIndex);
+	}
+}
+
+void ChessMoveTree::PromoteToMainLine(uint32_t nodeIndex)
+{
+	for (uint32_t parentIndex = m_nodes[nodeIndex].m_parent; parentIndex != CHESS_NO_MOVE_NODE; parentIndex = m_nodes[nodeIndex].m_parent)
+	{
+		uint32_t* link = &m_nodes[parentIndex].m_firstChild;
+		if (*link != nodeIndex)
+		{
+			while (*link != nodeIndex)
+			{
+				link = &m_nodes[*link].m_nextSibling;
+			}
+			*link = m_nodes[nodeIndex].m_nextSibling;
+			m_nodes[nodeIndex].m_nextSibling = m_nodes[parentIndex].m_firstChild;
+			m_nodes[parentIndex].m_firstChild = nodeIndex;
+		}
+		nodeIndex = parentIndex;
+	}
+}
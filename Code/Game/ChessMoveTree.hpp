@@ -0,0 +1,50 @@
+#pragma once
+#include "Game/ChessMoveRecord.hpp"
+#include <cstdint>
+#include <vector>
+// -----------------------------------------------------------------------------
+constexpr uint32_t CHESS_NO_MOVE_NODE = 0xFFFFFFFF;
+// -----------------------------------------------------------------------------
+struct ChessMoveNode
+{
+public:
+	ChessMoveRecord m_record;
+	uint32_t		m_parent = CHESS_NO_MOVE_NODE;
+	uint32_t		m_firstChild = CHESS_NO_MOVE_NODE;		// The main continuation; later children are variations
+	uint32_t		m_nextSibling = CHESS_NO_MOVE_NODE;		// Next alternative to this move
+	uint32_t		m_numPlies = 0;							// Plies from the start, this move included
+};
+// -----------------------------------------------------------------------------
+// Every line tried in a match, sharing the moves they have in common. Nodes live in one array and
+// link by index to their parent, first child and next sibling, so stepping in any direction is a
+// single lookup and nothing is ever erased: a move made after rewinding becomes a variation.
+// Node 0 is the starting position and has no move.
+// -----------------------------------------------------------------------------
+class ChessMoveTree
+{
+public:
+	ChessMoveTree();
+	void Clear();
+
+	uint32_t			 GetRoot() const { return 0; }
+	uint32_t			 GetNumNodes() const { return static_cast<uint32_t>(m_nodes.size()); }
+	uint32_t			 GetNumVariations() const;		// Moves that are not their parent's main continuation
+	ChessMoveNode const& GetNode(uint32_t nodeIndex) const { return m_nodes[nodeIndex]; }
+	bool				 IsMainLine(uint32_t nodeIndex) const;
+
+	// The child of the parent playing this move, added after the existing children if it is new
+	uint32_t AddMove(uint32_t parentIndex, ChessMoveRecord const& record);
+	uint32_t FindMove(uint32_t parentIndex, ChessMoveRecord const& record) const;
+	void	 GetChildren(uint32_t parentIndex, std::vector<uint32_t>& out_childIndices) const;
+
+	// The moves from the start to the node, then on down its main continuation, and the node of each
+	void GetLine(uint32_t nodeIndex, std::vector<ChessMoveRecord>& out_records, std::vector<uint32_t>& out_nodeIndices) const;
+	// Appends the moves below the parent, one after the other, and returns their nodes
+	void AddLine(uint32_t parentIndex, std::vector<ChessMoveRecord> const& records, std::vector<uint32_t>& out_nodeIndices);
+
+	// Makes the node and every move leading to it the first child of its parent
+	void PromoteToMainLine(uint32_t nodeIndex);
+
+private:
+	std::vector<ChessMoveNode> m_nodes;
+};
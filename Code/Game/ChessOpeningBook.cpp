@@ -0,0 +1,290 @@
+#include "Game/ChessOpeningBook.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+// -----------------------------------------------------------------------------
+constexpr int POLYGLOT_CASTLE_OFFSET = 768;
+constexpr int POLYGLOT_ENPASSANT_OFFSET = 772;
+constexpr int POLYGLOT_TURN_OFFSET = 780;
+// -----------------------------------------------------------------------------
+static uint64_t s_polyglotRandoms[POLYGLOT_NUM_RANDOMS] = {};
+static bool		s_hasPolyglotRandoms = false;
+// -----------------------------------------------------------------------------
+struct PolyglotKeyCheck
+{
+	char const* m_fen;
+	uint64_t	m_key;
+};
+// The test positions of the Polyglot book format: every piece kind at home, castling, en passant and turn
+static PolyglotKeyCheck const POLYGLOT_KEY_CHECKS[] =
+{
+	{ "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",				0x463B96181691FC9Cull },
+	{ "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",			0x823C9B50FD114196ull },
+	{ "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2",			0x0756B94461C50FB0ull },
+	{ "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2",			0x662FAFB965DB29D4ull },
+	{ "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",			0x22A48B5A8E47FF78ull },
+	{ "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3",				0x652A607CA3F242C1ull },
+	{ "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4",				0x00FDD303C946BDD9ull },
+	{ "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3",			0x3C8123EA7B067637ull },
+	{ "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4",			0x5C3F9B829B279560ull },
+};
+// -----------------------------------------------------------------------------
+
+bool ChessOpeningBook::LoadPolyglotRandoms(std::string const& randomsFilePath)
+{
+	FILE* randomsFile = fopen(randomsFilePath.c_str(), "rb");
+	if (randomsFile == nullptr)
+	{
+		return false;
+	}
+
+	// Any layout works as long as the 781 values appear in order: whitespace, commas, 0x and U/ULL suffixes are skipped
+	uint64_t randoms[POLYGLOT_NUM_RANDOMS] = {};
+	int numRandoms = 0;
+	char token[64];
+	int tokenLength = 0;
+	int character = 0;
+	do
+	{
+		character = fgetc(randomsFile);
+		bool isHexDigit = (character >= '0' && character <= '9') || (character >= 'a' && character <= 'f') || (character >= 'A' && character <= 'F') || character == 'x' || character == 'X';
+		if (isHexDigit && tokenLength < static_cast<int>(sizeof(token)) - 1)
+		{
+			token[tokenLength++] = static_cast<char>(character);
+			continue;
+		}
+		if (tokenLength > 0)
+		{
+			token[tokenLength] = '\0';
+			if (numRandoms == POLYGLOT_NUM_RANDOMS)
+			{
+				numRandoms = POLYGLOT_NUM_RANDOMS + 1;
+				break;
+			}
+			randoms[numRandoms++] = strtoull(token, nullptr, 16);
+			tokenLength = 0;
+		}
+		// Skip integer suffixes glued to the value
+		while (character == 'U' || character == 'u' || character == 'L' || character == 'l')
+		{
+			character = fgetc(randomsFile);
+		}
+	}
+	while (character != EOF);
+	fclose(randomsFile);
+
+	if (numRandoms != POLYGLOT_NUM_RANDOMS)
+	{
+		return false;
+	}
+	for (int randomIndex = 0; randomIndex < POLYGLOT_NUM_RANDOMS; ++randomIndex)
+	{
+		s_polyglotRandoms[randomIndex] = randoms[randomIndex];
+	}
+
+	// A table with a wrong or missing value would quietly miss book positions, so it has to give the published keys
+	s_hasPolyglotRandoms = CheckPolyglotKeys();
+	return s_hasPolyglotRandoms;
+}
+
+bool ChessOpeningBook::CheckPolyglotKeys(char const** out_failedFen)
+{
+	for (PolyglotKeyCheck const& keyCheck : POLYGLOT_KEY_CHECKS)
+	{
+		ChessPosition position;
+		if (!position.SetFromFEN(keyCheck.m_fen) || ComputePolyglotKey(position) != keyCheck.m_key)
+		{
+			if (out_failedFen != nullptr)
+			{
+				*out_failedFen = keyCheck.m_fen;
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ChessOpeningBook::HasPolyglotRandoms()
+{
+	return s_hasPolyglotRandoms;
+}
+
+uint64_t ChessOpeningBook::ComputePolyglotKey(ChessPosition const& position)
+{
+	// Polyglot piece kinds alternate black/white: pawn, knight, bishop, rook, queen, king
+	static int const POLYGLOT_KIND_FOR_TYPE[] = { 3, 1, 2, 4, 5, 0 };
+
+	uint64_t key = 0;
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = position.m_squares[square];
+		if (pieceCode == CHESS_EMPTY_SQUARE)
+		{
+			continue;
+		}
+		int kind = POLYGLOT_KIND_FOR_TYPE[static_cast<int>(GetChessPieceTypeForCode(pieceCode))] * 2 + ((GetPlayerIndexForCode(pieceCode) == 0) ? 1 : 0);
+		key ^= s_polyglotRandoms[64 * kind + 8 * GetChessSquareY(square) + GetChessSquareX(square)];
+	}
+
+	if (position.m_castlingRights & CASTLE_WHITE_KINGSIDE)	key ^= s_polyglotRandoms[POLYGLOT_CASTLE_OFFSET + 0];
+	if (position.m_castlingRights & CASTLE_WHITE_QUEENSIDE)	key ^= s_polyglotRandoms[POLYGLOT_CASTLE_OFFSET + 1];
+	if (position.m_castlingRights & CASTLE_BLACK_KINGSIDE)	key ^= s_polyglotRandoms[POLYGLOT_CASTLE_OFFSET + 2];
+	if (position.m_castlingRights & CASTLE_BLACK_QUEENSIDE)	key ^= s_polyglotRandoms[POLYGLOT_CASTLE_OFFSET + 3];
+
+	// The en passant file only counts when a pawn of the side to move could actually capture
+	if (position.m_enpassantSquare != CHESS_NO_SQUARE)
+	{
+		int sideToMove = position.GetSideToMove();
+		int enpassantFile = GetChessSquareX(position.m_enpassantSquare);
+		int pawnRank = (sideToMove == 0) ? 4 : 3;
+		uint8_t ownPawn = MakeChessPieceCode(ChessPieceType::PAWN, sideToMove);
+		bool canCapture = (enpassantFile > 0 && position.m_squares[GetChessSquare(enpassantFile - 1, pawnRank)] == ownPawn) ||
+			(enpassantFile < 7 && position.m_squares[GetChessSquare(enpassantFile + 1, pawnRank)] == ownPawn);
+		if (canCapture)
+		{
+			key ^= s_polyglotRandoms[POLYGLOT_ENPASSANT_OFFSET + enpassantFile];
+		}
+	}
+
+	if (position.GetSideToMove() == 0)
+	{
+		key ^= s_polyglotRandoms[POLYGLOT_TURN_OFFSET];
+	}
+	return key;
+}
+
+bool ChessOpeningBook::Open(std::string const& bookFilePath)
+{
+	if (!m_bookFile.Open(bookFilePath))
+	{
+		return false;
+	}
+	if (m_bookFile.GetSize() % POLYGLOT_ENTRY_SIZE != 0)
+	{
+		m_bookFile.Close();
+		return false;
+	}
+	return true;
+}
+
+void ChessOpeningBook::Close()
+{
+	m_bookFile.Close();
+}
+
+size_t ChessOpeningBook::FindFirstEntry(uint64_t key) const
+{
+	// Lower bound straight over the mapped entries
+	uint8_t const* entries = m_bookFile.GetData();
+	size_t low = 0;
+	size_t high = GetNumEntries();
+	while (low < high)
+	{
+		size_t middle = low + (high - low) / 2;
+		if (ReadBigEndian64(entries + middle * POLYGLOT_ENTRY_SIZE) < key)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low;
+}
+
+bool ChessOpeningBook::DecodeBookMove(ChessPosition const& position, uint16_t polyglotMove, ChessMove& out_move) const
+{
+	// Bits: to file 0-2, to rank 3-5, from file 6-8, from rank 9-11, promotion 12-14 (knight..queen)
+	static ChessPieceType const PROMOTION_TYPES[] = { ChessPieceType::QUEEN, ChessPieceType::KNIGHT, ChessPieceType::BISHOP, ChessPieceType::ROOK, ChessPieceType::QUEEN };
+
+	int toSquare = GetChessSquare(polyglotMove & 7, (polyglotMove >> 3) & 7);
+	int fromSquare = GetChessSquare((polyglotMove >> 6) & 7, (polyglotMove >> 9) & 7);
+	int promotionIndex = (polyglotMove >> 12) & 7;
+	if (promotionIndex > 4)
+	{
+		return false;
+	}
+
+	// Castling is stored as the king capturing its own rook
+	uint8_t movingPiece = position.m_squares[fromSquare];
+	uint8_t targetPiece = position.m_squares[toSquare];
+	if (movingPiece != CHESS_EMPTY_SQUARE && targetPiece != CHESS_EMPTY_SQUARE && GetChessPieceTypeForCode(movingPiece) == ChessPieceType::KING &&
+		GetChessPieceTypeForCode(targetPiece) == ChessPieceType::ROOK && GetPlayerIndexForCode(movingPiece) == GetPlayerIndexForCode(targetPiece))
+	{
+		toSquare = GetChessSquare((GetChessSquareX(toSquare) > GetChessSquareX(fromSquare)) ? 6 : 2, GetChessSquareY(fromSquare));
+	}
+
+	ChessMove move;
+	if (!position.FindPseudoLegalMove(fromSquare, toSquare, PROMOTION_TYPES[promotionIndex], move) || !position.IsLegalMove(move))
+	{
+		return false;
+	}
+	out_move = move;
+	return true;
+}
+
+int ChessOpeningBook::GetBookMoves(ChessPosition const& position, std::vector<ChessBookEntry>& out_entries) const
+{
+	out_entries.clear();
+	if (!IsOpen() || !s_hasPolyglotRandoms)
+	{
+		return 0;
+	}
+
+	uint64_t key = ComputePolyglotKey(position);
+	uint8_t const* entries = m_bookFile.GetData();
+	size_t numEntries = GetNumEntries();
+	for (size_t entryIndex = FindFirstEntry(key); entryIndex < numEntries; ++entryIndex)
+	{
+		uint8_t const* entry = entries + entryIndex * POLYGLOT_ENTRY_SIZE;
+		if (ReadBigEndian64(entry) != key)
+		{
+			break;
+		}
+
+		// Entries that do not decode to a legal move are key collisions or corrupt data
+		ChessBookEntry bookEntry;
+		bookEntry.m_weight = ReadBigEndian16(entry + 10);
+		if (DecodeBookMove(position, ReadBigEndian16(entry + 8), bookEntry.m_move))
+		{
+			out_entries.push_back(bookEntry);
+		}
+	}
+	return static_cast<int>(out_entries.size());
+}
+
+bool ChessOpeningBook::ChooseMove(ChessPosition const& position, uint64_t randomValue, ChessMove& out_move) const
+{
+	std::vector<ChessBookEntry> entries;
+	if (GetBookMoves(position, entries) == 0)
+	{
+		return false;
+	}
+
+	uint64_t totalWeight = 0;
+	for (ChessBookEntry const& entry : entries)
+	{
+		totalWeight += entry.m_weight;
+	}
+
+	// All-zero weights mean "known but unranked", so pick uniformly among them
+	if (totalWeight == 0)
+	{
+		out_move = entries[randomValue % entries.size()].m_move;
+		return true;
+	}
+
+	uint64_t pick = randomValue % totalWeight;
+	for (ChessBookEntry const& entry : entries)
+	{
+		if (pick < entry.m_weight)
+		{
+			out_move = entry.m_move;
+			return true;
+		}
+		pick -= entry.m_weight;
+	}
+	out_move = entries.back().m_move;
+	return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include "Game/ChessMappedFile.hpp"
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+constexpr int POLYGLOT_NUM_RANDOMS = 781;
+constexpr int POLYGLOT_ENTRY_SIZE = 16;
+// -----------------------------------------------------------------------------
+struct ChessBookEntry
+{
+public:
+	ChessMove m_move;
+	uint16_t  m_weight = 0;
+};
+// -----------------------------------------------------------------------------
+// Polyglot .bin opening book read in place through a memory map. Entries are 16 big-endian
+// bytes (key, move, weight, learn) sorted by key, so lookups are a binary search over the map.
+// Polyglot keys use the standard Random64 table, loaded once from a text file of 781 hex values and
+// only used once it gives the keys published with the format.
+// -----------------------------------------------------------------------------
+class ChessOpeningBook
+{
+public:
+	bool Open(std::string const& bookFilePath);
+	void Close();
+	bool IsOpen() const { return m_bookFile.IsOpen(); }
+	std::string const& GetFilePath() const { return m_bookFile.GetFilePath(); }
+	size_t GetNumEntries() const { return m_bookFile.GetSize() / POLYGLOT_ENTRY_SIZE; }
+
+	// Legal book moves for the position, in book order
+	int  GetBookMoves(ChessPosition const& position, std::vector<ChessBookEntry>& out_entries) const;
+
+	// Weighted pick; randomValue is any uniformly random 64-bit number
+	bool ChooseMove(ChessPosition const& position, uint64_t randomValue, ChessMove& out_move) const;
+
+	static bool		LoadPolyglotRandoms(std::string const& randomsFilePath);
+	static bool		HasPolyglotRandoms();
+	static bool		CheckPolyglotKeys(char const** out_failedFen = nullptr);	// Against the format's test positions
+	static uint64_t ComputePolyglotKey(ChessPosition const& position);
+
+private:
+	size_t FindFirstEntry(uint64_t key) const;
+	bool   DecodeBookMove(ChessPosition const& position, uint16_t polyglotMove, ChessMove& out_move) const;
+
+private:
+	ChessMappedFile m_bookFile;
+};
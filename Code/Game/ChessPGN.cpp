@@ -0,0 +1,630 @@
+#include "Game/ChessPGN.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+constexpr size_t PGN_CHUNK_SIZE = 1 << 20;		// Bytes of archive handed to a worker at a time
+constexpr int	 PGN_LINE_LENGTH = 79;
+// -----------------------------------------------------------------------------
+
+static bool IsPGNSymbolGlyph(char glyph)
+{
+	return (glyph >= 'a' && glyph <= 'z') || (glyph >= 'A' && glyph <= 'Z') || (glyph >= '0' && glyph <= '9') ||
+		glyph == '_' || glyph == '+' || glyph == '#' || glyph == '=' || glyph == ':' || glyph == '-' || glyph == '/' || glyph == '!' || glyph == '?';
+}
+
+static bool IsPGNSpace(char glyph)
+{
+	return glyph == ' ' || glyph == '\t' || glyph == '\r';
+}
+
+static char const* GetLineStart(char const* textBegin, char const* cursor)
+{
+	while (cursor > textBegin && cursor[-1] != '\n')
+	{
+		--cursor;
+	}
+	return cursor;
+}
+
+static bool IsFirstOnLine(char const* textBegin, char const* cursor)
+{
+	for (char const* glyph = GetLineStart(textBegin, cursor); glyph < cursor; ++glyph)
+	{
+		if (!IsPGNSpace(*glyph))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+ChessPGNTokenizer::ChessPGNTokenizer(char const* textBegin, char const* textEnd)
+	:m_textBegin(textBegin),
+	 m_cursor(textBegin),
+	 m_textEnd(textEnd)
+{
+}
+
+void ChessPGNTokenizer::SkipWhitespaceAndEscapes()
+{
+	while (m_cursor < m_textEnd)
+	{
+		char glyph = *m_cursor;
+		if (IsPGNSpace(glyph) || glyph == '\n')
+		{
+			++m_cursor;
+			continue;
+		}
+
+		// '%' in the first column escapes the rest of the line
+		if (glyph == '%' && (m_cursor == m_textBegin || m_cursor[-1] == '\n'))
+		{
+			while (m_cursor < m_textEnd && *m_cursor != '\n')
+			{
+				++m_cursor;
+			}
+			continue;
+		}
+		return;
+	}
+}
+
+ChessPGNToken ChessPGNTokenizer::GetNextToken()
+{
+	ChessPGNToken token;
+	for (;;)
+	{
+		SkipWhitespaceAndEscapes();
+		token.m_begin = m_cursor;
+		if (m_cursor >= m_textEnd)
+		{
+			token.m_type = ChessPGNTokenType::END_OF_TEXT;
+			return token;
+		}
+
+		char glyph = *m_cursor;
+		if (glyph == '[')
+		{
+			// [Name "Value"], tolerating missing quotes or bracket up to the end of the line
+			++m_cursor;
+			while (m_cursor < m_textEnd && IsPGNSpace(*m_cursor))
+			{
+				++m_cursor;
+			}
+			char const* nameBegin = m_cursor;
+			while (m_cursor < m_textEnd && IsPGNSymbolGlyph(*m_cursor))
+			{
+				++m_cursor;
+			}
+			token.m_text = std::string_view(nameBegin, m_cursor - nameBegin);
+
+			while (m_cursor < m_textEnd && IsPGNSpace(*m_cursor))
+			{
+				++m_cursor;
+			}
+			if (m_cursor < m_textEnd && *m_cursor == '"')
+			{
+				char const* valueBegin = ++m_cursor;
+				while (m_cursor < m_textEnd && *m_cursor != '"' && *m_cursor != '\n')
+				{
+					m_cursor += (*m_cursor == '\\' && m_cursor + 1 < m_textEnd) ? 2 : 1;
+				}
+				token.m_value = std::string_view(valueBegin, m_cursor - valueBegin);
+			}
+			while (m_cursor < m_textEnd && *m_cursor != ']' && *m_cursor != '\n')
+			{
+				++m_cursor;
+			}
+			m_cursor += (m_cursor < m_textEnd && *m_cursor == ']') ? 1 : 0;
+			token.m_type = ChessPGNTokenType::TAG;
+			return token;
+		}
+
+		if (glyph == '{' || glyph == ';')
+		{
+			// Brace comments run to the closing brace, rest-of-line comments to the newline
+			char terminator = (glyph == '{') ? '}' : '\n';
+			char const* commentBegin = ++m_cursor;
+			while (m_cursor < m_textEnd && *m_cursor != terminator)
+			{
+				++m_cursor;
+			}
+			token.m_text = std::string_view(commentBegin, m_cursor - commentBegin);
+			m_cursor += (m_cursor < m_textEnd) ? 1 : 0;
+			token.m_type = ChessPGNTokenType::COMMENT;
+			return token;
+		}
+
+		if (glyph == '(' || glyph == ')')
+		{
+			token.m_text = std::string_view(m_cursor++, 1);
+			token.m_type = (glyph == '(') ? ChessPGNTokenType::VARIATION_START : ChessPGNTokenType::VARIATION_END;
+			return token;
+		}
+
+		if (glyph == '$')
+		{
+			char const* nagBegin = ++m_cursor;
+			while (m_cursor < m_textEnd && *m_cursor >= '0' && *m_cursor <= '9')
+			{
+				++m_cursor;
+			}
+			token.m_text = std::string_view(nagBegin, m_cursor - nagBegin);
+			token.m_type = ChessPGNTokenType::NAG;
+			return token;
+		}
+
+		if (glyph == '*')
+		{
+			token.m_text = std::string_view(m_cursor++, 1);
+			token.m_type = ChessPGNTokenType::RESULT;
+			return token;
+		}
+
+		if (glyph >= '0' && glyph <= '9')
+		{
+			// Move numbers may be glued to the move ("12.e4", "12...e5"); results and "0-0" carry on as symbols
+			char const* numberEnd = m_cursor;
+			while (numberEnd < m_textEnd && *numberEnd >= '0' && *numberEnd <= '9')
+			{
+				++numberEnd;
+			}
+			if (numberEnd < m_textEnd && *numberEnd == '.')
+			{
+				token.m_text = std::string_view(m_cursor, numberEnd - m_cursor);
+				m_cursor = numberEnd;
+				while (m_cursor < m_textEnd && *m_cursor == '.')
+				{
+					++m_cursor;
+				}
+				token.m_type = ChessPGNTokenType::MOVE_NUMBER;
+				return token;
+			}
+		}
+
+		if (IsPGNSymbolGlyph(glyph))
+		{
+			char const* symbolBegin = m_cursor;
+			while (m_cursor < m_textEnd && IsPGNSymbolGlyph(*m_cursor))
+			{
+				++m_cursor;
+			}
+			token.m_text = std::string_view(symbolBegin, m_cursor - symbolBegin);
+			bool isResult = token.m_text == "1-0" || token.m_text == "0-1" || token.m_text == "1/2-1/2";
+			token.m_type = isResult ? ChessPGNTokenType::RESULT : ChessPGNTokenType::SAN;
+			return token;
+		}
+
+		// Stray periods, byte order marks and the like carry nothing
+		++m_cursor;
+	}
+}
+
+// -----------------------------------------------------------------------------
+void ChessPGNGame::Reset()
+{
+	m_tags.clear();
+	m_startPosition = ChessPosition::GetStartingPosition();
+	m_moves.clear();
+	m_result = "*";
+	m_fileOffset = 0;
+	m_error.clear();
+}
+
+std::string ChessPGNGame::GetTag(std::string_view name, std::string const& defaultValue) const
+{
+	for (ChessPGNTag const& tag : m_tags)
+	{
+		if (tag.m_name == name)
+		{
+			return tag.m_value;
+		}
+	}
+	return defaultValue;
+}
+
+void ChessPGNGame::SetTag(std::string_view name, std::string const& value)
+{
+	for (ChessPGNTag& tag : m_tags)
+	{
+		if (tag.m_name == name)
+		{
+			tag.m_value = value;
+			return;
+		}
+	}
+	m_tags.push_back(ChessPGNTag{ std::string(name), value });
+}
+
+// -----------------------------------------------------------------------------
+bool ChessPGNReader::Open(std::string const& filePath)
+{
+	m_cursor = 0;
+	return m_file.Open(filePath);
+}
+
+void ChessPGNReader::Close()
+{
+	m_file.Close();
+	m_cursor = 0;
+}
+
+bool ChessPGNReader::ReadNextGame(ChessPGNGame& out_game)
+{
+	if (!IsOpen() || m_cursor >= m_file.GetSize())
+	{
+		return false;
+	}
+
+	char const* gameEnd = ParseGame(GetText(), GetText() + m_cursor, GetText() + m_file.GetSize(), out_game);
+	m_cursor = (gameEnd != nullptr) ? static_cast<size_t>(gameEnd - GetText()) : m_file.GetSize();
+	return gameEnd != nullptr;
+}
+
+bool ChessPGNReader::SkipGames(int numGames)
+{
+	ChessPGNGame skippedGame;
+	for (int gameIndex = 0; gameIndex < numGames; ++gameIndex)
+	{
+		if (!ReadNextGame(skippedGame))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ChessPGNReader::SeekToOffset(uint64_t fileOffset)
+{
+	m_cursor = static_cast<size_t>(std::min<uint64_t>(fileOffset, m_file.GetSize()));
+}
+
+char const* ChessPGNReader::ParseGame(char const* textBegin, char const* gameBegin, char const* textEnd, ChessPGNGame& out_game)
+{
+	out_game.Reset();
+	ChessPGNTokenizer tokenizer(textBegin, textEnd);
+	tokenizer.SetCursor(gameBegin);
+
+	ChessPosition position = out_game.m_startPosition;
+	bool hasGame = false;
+	bool isInMoveText = false;
+	int variationDepth = 0;
+	for (;;)
+	{
+		ChessPGNToken token = tokenizer.GetNextToken();
+		if (!hasGame && token.m_type != ChessPGNTokenType::COMMENT && token.m_type != ChessPGNTokenType::END_OF_TEXT)
+		{
+			hasGame = true;
+			out_game.m_fileOffset = static_cast<uint64_t>(token.m_begin - textBegin);
+		}
+
+		switch (token.m_type)
+		{
+			case ChessPGNTokenType::END_OF_TEXT:
+			{
+				return hasGame ? textEnd : nullptr;
+			}
+			case ChessPGNTokenType::TAG:
+			{
+				// A tag section after movetext is the next game; this one ended without a result
+				if (isInMoveText)
+				{
+					return token.m_begin;
+				}
+
+				ChessPGNTag tag;
+				tag.m_name.assign(token.m_text.data(), token.m_text.size());
+				tag.m_value.reserve(token.m_value.size());
+				for (size_t glyphIndex = 0; glyphIndex < token.m_value.size(); ++glyphIndex)
+				{
+					glyphIndex += (token.m_value[glyphIndex] == '\\' && glyphIndex + 1 < token.m_value.size()) ? 1 : 0;
+					tag.m_value += token.m_value[glyphIndex];
+				}
+
+				if (tag.m_name == "FEN")
+				{
+					if (!position.SetFromFEN(tag.m_value.c_str()))
+					{
+						out_game.m_error = "Unreadable FEN tag \"" + tag.m_value + "\"";
+					}
+					out_game.m_startPosition = position;
+				}
+				out_game.m_tags.push_back(std::move(tag));
+				break;
+			}
+			case ChessPGNTokenType::SAN:
+			{
+				isInMoveText = true;
+				if (variationDepth > 0 || !out_game.IsValid())
+				{
+					break;
+				}
+
+				ChessMove move;
+				if (!position.FindMoveForSAN(token.m_text, move))
+				{
+					out_game.m_error = "Illegal move \"" + std::string(token.m_text) + "\" at ply " + std::to_string(out_game.m_moves.size() + 1);
+					break;
+				}
+				position.MakeMove(move);
+				out_game.m_moves.push_back(move);
+				break;
+			}
+			case ChessPGNTokenType::MOVE_NUMBER:
+			case ChessPGNTokenType::NAG:
+			{
+				isInMoveText = true;
+				break;
+			}
+			case ChessPGNTokenType::VARIATION_START:
+			{
+				isInMoveText = true;
+				++variationDepth;
+				break;
+			}
+			case ChessPGNTokenType::VARIATION_END:
+			{
+				variationDepth = std::max(0, variationDepth - 1);
+				break;
+			}
+			case ChessPGNTokenType::RESULT:
+			{
+				if (variationDepth > 0)
+				{
+					break;
+				}
+				out_game.m_result.assign(token.m_text.data(), token.m_text.size());
+				return tokenizer.GetCursor();
+			}
+			case ChessPGNTokenType::COMMENT:
+			default:
+			{
+				break;
+			}
+		}
+	}
+}
+
+char const* ChessPGNReader::FindNextTaggedGameStart(char const* cursor, char const* searchEnd) const
+{
+	// A game starts on a line opening with '[' whose previous non-blank line is not a tag
+	char const* text = GetText();
+	char const* textEnd = text + m_file.GetSize();
+	char const* lineStart = cursor;
+	if (lineStart > text && lineStart[-1] != '\n')
+	{
+		char const* newline = static_cast<char const*>(memchr(lineStart, '\n', textEnd - lineStart));
+		lineStart = (newline != nullptr) ? newline + 1 : textEnd;
+	}
+
+	bool isPreviousLineTag = false;
+	for (char const* previousLineEnd = lineStart; previousLineEnd > text; )
+	{
+		char const* previousLineStart = GetLineStart(text, previousLineEnd - 1);
+		char const* glyph = previousLineStart;
+		while (glyph < previousLineEnd && (IsPGNSpace(*glyph) || *glyph == '\n'))
+		{
+			++glyph;
+		}
+		if (glyph < previousLineEnd)
+		{
+			isPreviousLineTag = (*glyph == '[');
+			break;
+		}
+		previousLineEnd = previousLineStart;
+	}
+
+	while (lineStart < searchEnd)
+	{
+		char const* lineEnd = static_cast<char const*>(memchr(lineStart, '\n', textEnd - lineStart));
+		lineEnd = (lineEnd != nullptr) ? lineEnd : textEnd;
+		char const* glyph = lineStart;
+		while (glyph < lineEnd && IsPGNSpace(*glyph))
+		{
+			++glyph;
+		}
+
+		if (glyph < lineEnd)
+		{
+			if (*glyph == '[' && !isPreviousLineTag)
+			{
+				return lineStart;
+			}
+			isPreviousLineTag = (*glyph == '[');
+		}
+		lineStart = (lineEnd < textEnd) ? lineEnd + 1 : textEnd;
+	}
+	return textEnd;
+}
+
+void ChessPGNReader::ReadChunks(int workerIndex, ChessPGNGameCallback const& callback, ChessPGNReadStats& out_stats)
+{
+	char const* text = GetText();
+	char const* textEnd = text + m_file.GetSize();
+	size_t numChunks = (m_file.GetSize() + PGN_CHUNK_SIZE - 1) / PGN_CHUNK_SIZE;
+	ChessPGNGame game;
+
+	for (size_t chunkIndex = m_nextChunkIndex++; chunkIndex < numChunks; chunkIndex = m_nextChunkIndex++)
+	{
+		// A worker owns the games that start inside its chunk: it syncs to the first tag section at
+		// or after the chunk start and stops at the first one at or after the chunk end. The first
+		// chunk also owns anything in front of the first tag section.
+		char const* chunkBegin = text + chunkIndex * PGN_CHUNK_SIZE;
+		char const* chunkEnd = std::min(chunkBegin + PGN_CHUNK_SIZE, textEnd);
+		char const* gameBegin = (chunkIndex == 0) ? text : FindNextTaggedGameStart(chunkBegin, chunkEnd);
+		ChessPGNTokenizer peekTokenizer(text, textEnd);
+		while (gameBegin < textEnd)
+		{
+			peekTokenizer.SetCursor(gameBegin);
+			ChessPGNToken firstToken = peekTokenizer.GetNextToken();
+			while (firstToken.m_type == ChessPGNTokenType::COMMENT)
+			{
+				firstToken = peekTokenizer.GetNextToken();
+			}
+			if (firstToken.m_type == ChessPGNTokenType::TAG && GetLineStart(text, firstToken.m_begin) >= chunkEnd && IsFirstOnLine(text, firstToken.m_begin))
+			{
+				break;
+			}
+
+			char const* gameEnd = ParseGame(text, gameBegin, textEnd, game);
+			if (gameEnd == nullptr)
+			{
+				break;
+			}
+			out_stats.m_numGames += 1;
+			out_stats.m_numInvalidGames += game.IsValid() ? 0 : 1;
+			out_stats.m_numMoves += game.m_moves.size();
+			callback(game, workerIndex);
+			gameBegin = gameEnd;
+		}
+
+		m_file.ReleasePages(static_cast<size_t>(chunkBegin - text), static_cast<size_t>(chunkEnd - chunkBegin));
+	}
+}
+
+ChessPGNReadStats ChessPGNReader::ReadAllGames(int numThreads, ChessPGNGameCallback const& callback)
+{
+	ChessPGNReadStats stats;
+	if (!IsOpen())
+	{
+		return stats;
+	}
+
+	numThreads = (numThreads > 0) ? numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	auto startTime = std::chrono::steady_clock::now();
+	m_nextChunkIndex = 0;
+
+	std::vector<ChessPGNReadStats> workerStats(numThreads);
+	std::vector<std::thread> workers;
+	for (int workerIndex = 0; workerIndex < numThreads; ++workerIndex)
+	{
+		workers.emplace_back(&ChessPGNReader::ReadChunks, this, workerIndex, std::cref(callback), std::ref(workerStats[workerIndex]));
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	for (ChessPGNReadStats const& workerStat : workerStats)
+	{
+		stats.m_numGames += workerStat.m_numGames;
+		stats.m_numInvalidGames += workerStat.m_numInvalidGames;
+		stats.m_numMoves += workerStat.m_numMoves;
+	}
+	stats.m_numBytes = m_file.GetSize();
+	stats.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return stats;
+}
+
+// -----------------------------------------------------------------------------
+bool ChessPGNWriter::Open(std::string const& filePath, bool append)
+{
+	Close();
+	m_file.open(filePath, std::ios::out | std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+	return m_file.is_open();
+}
+
+void ChessPGNWriter::Close()
+{
+	if (m_file.is_open())
+	{
+		m_file.close();
+	}
+}
+
+bool ChessPGNWriter::WriteGame(ChessPGNGame const& game)
+{
+	static char const* const ROSTER_TAG_NAMES[] = { "Event", "Site", "Date", "Round", "White", "Black" };
+	static char const* const ROSTER_TAG_DEFAULTS[] = { "?", "?", "????.??.??", "?", "?", "?" };
+	static std::string const STARTING_FEN = ChessPosition::GetStartingPosition().GetFEN();
+
+	m_buffer.clear();
+	for (int tagIndex = 0; tagIndex < 6; ++tagIndex)
+	{
+		AppendTag(ROSTER_TAG_NAMES[tagIndex], game.GetTag(ROSTER_TAG_NAMES[tagIndex], ROSTER_TAG_DEFAULTS[tagIndex]));
+	}
+	AppendTag("Result", game.m_result);
+
+	std::string startFEN = game.m_startPosition.GetFEN();
+	if (startFEN != STARTING_FEN)
+	{
+		AppendTag("SetUp", "1");
+		AppendTag("FEN", startFEN);
+	}
+
+	for (ChessPGNTag const& tag : game.m_tags)
+	{
+		bool isWrittenAlready = tag.m_name == "Result" || tag.m_name == "SetUp" || tag.m_name == "FEN";
+		for (int tagIndex = 0; tagIndex < 6 && !isWrittenAlready; ++tagIndex)
+		{
+			isWrittenAlready = tag.m_name == ROSTER_TAG_NAMES[tagIndex];
+		}
+		if (!isWrittenAlready)
+		{
+			AppendTag(tag.m_name, tag.m_value);
+		}
+	}
+	m_buffer += '\n';
+
+	ChessPosition position = game.m_startPosition;
+	int lineLength = 0;
+	for (size_t moveIndex = 0; moveIndex < game.m_moves.size(); ++moveIndex)
+	{
+		ChessMove const& move = game.m_moves[moveIndex];
+		if (!position.IsLegalMove(move))
+		{
+			return false;
+		}
+
+		if (position.m_sideToMove == 0 || moveIndex == 0)
+		{
+			char moveNumberText[16];
+			snprintf(moveNumberText, sizeof(moveNumberText), "%d.%s", position.m_fullmoveNumber, (position.m_sideToMove == 0) ? "" : "..");
+			AppendMoveText(moveNumberText, lineLength);
+		}
+		AppendMoveText(position.GetSANForMove(move), lineLength);
+		position.MakeMove(move);
+	}
+	AppendMoveText(game.m_result, lineLength);
+	m_buffer += "\n\n";
+
+	m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+	return m_file.good();
+}
+
+void ChessPGNWriter::AppendTag(std::string_view name, std::string_view value)
+{
+	m_buffer += '[';
+	m_buffer += name;
+	m_buffer += " \"";
+	for (char glyph : value)
+	{
+		if (glyph == '"' || glyph == '\\')
+		{
+			m_buffer += '\\';
+		}
+		m_buffer += glyph;
+	}
+	m_buffer += "\"]\n";
+}
+
+void ChessPGNWriter::AppendMoveText(std::string_view text, int& lineLength)
+{
+	if (lineLength > 0 && lineLength + 1 + static_cast<int>(text.size()) > PGN_LINE_LENGTH)
+	{
+		m_buffer += '\n';
+		lineLength = 0;
+	}
+	else if (lineLength > 0)
+	{
+		m_buffer += ' ';
+		lineLength += 1;
+	}
+	m_buffer += text;
+	lineLength += static_cast<int>(text.size());
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include "Game/ChessMappedFile.hpp"
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+// -----------------------------------------------------------------------------
+enum class ChessPGNTokenType
+{
+	TAG,
+	MOVE_NUMBER,
+	SAN,
+	NAG,
+	COMMENT,
+	VARIATION_START,
+	VARIATION_END,
+	RESULT,
+	END_OF_TEXT
+};
+// -----------------------------------------------------------------------------
+struct ChessPGNToken
+{
+public:
+	ChessPGNTokenType m_type = ChessPGNTokenType::END_OF_TEXT;
+	char const*		  m_begin = nullptr;	// First character of the token in the source text
+	std::string_view  m_text;				// Tag name, move, NAG, comment body or result
+	std::string_view  m_value;				// Tag value without its quotes; escapes are left in place
+};
+// -----------------------------------------------------------------------------
+// Incremental PGN tokenizer. Tokens are views into the caller's text, which need not be
+// null-terminated, so a memory-mapped archive is tokenized without copying any of it.
+// -----------------------------------------------------------------------------
+class ChessPGNTokenizer
+{
+public:
+	ChessPGNTokenizer(char const* textBegin, char const* textEnd);
+
+	ChessPGNToken GetNextToken();
+	char const*	  GetCursor() const { return m_cursor; }
+	void		  SetCursor(char const* cursor) { m_cursor = cursor; }
+
+private:
+	void SkipWhitespaceAndEscapes();
+
+private:
+	char const* m_textBegin = nullptr;
+	char const* m_cursor = nullptr;
+	char const* m_textEnd = nullptr;
+};
+// -----------------------------------------------------------------------------
+struct ChessPGNTag
+{
+public:
+	std::string m_name;
+	std::string m_value;
+};
+// -----------------------------------------------------------------------------
+struct ChessPGNGame
+{
+public:
+	void		Reset();		// Keeps the buffers' capacity, so one game object serves a whole archive
+	bool		IsValid() const { return m_error.empty(); }
+	std::string GetTag(std::string_view name, std::string const& defaultValue) const;
+	void		SetTag(std::string_view name, std::string const& value);
+
+public:
+	std::vector<ChessPGNTag> m_tags;
+	ChessPosition			 m_startPosition;
+	std::vector<ChessMove>	 m_moves;			// Main line only; variations are skipped
+	std::string				 m_result = "*";
+	uint64_t				 m_fileOffset = 0;	// Byte offset of the game in its file
+	std::string				 m_error;			// Why the game was rejected; empty when every move was legal
+};
+// -----------------------------------------------------------------------------
+struct ChessPGNReadStats
+{
+public:
+	uint64_t m_numGames = 0;
+	uint64_t m_numInvalidGames = 0;
+	uint64_t m_numMoves = 0;
+	uint64_t m_numBytes = 0;
+	double	 m_seconds = 0.0;
+};
+// Called once per game, valid or not. The parallel reader calls it from its worker threads at the same time.
+typedef std::function<void(ChessPGNGame const& game, int workerIndex)> ChessPGNGameCallback;
+// -----------------------------------------------------------------------------
+// Reads PGN archives of any size through a memory map. Games are split at tag sections, so the
+// parallel reader hands each worker a range of the file that it syncs to the next game start;
+// every worker reuses one ChessPGNGame and gives back the pages it has finished with, keeping
+// memory flat no matter how large the archive is. Every SAN move is checked by the move generator.
+// -----------------------------------------------------------------------------
+class ChessPGNReader
+{
+public:
+	bool Open(std::string const& filePath);
+	void Close();
+	bool IsOpen() const { return m_file.IsOpen(); }
+
+	// Sequential access in file order
+	bool ReadNextGame(ChessPGNGame& out_game);		// False once there are no games left
+	bool SkipGames(int numGames);
+	void SeekToOffset(uint64_t fileOffset);		// Offset must be a game start, as recorded in ChessPGNGame::m_fileOffset
+
+	// Whole file on a pool of threads; games arrive in no particular order
+	ChessPGNReadStats ReadAllGames(int numThreads, ChessPGNGameCallback const& callback);
+
+	// Parses the game at gameBegin and returns where it ended, or null if only whitespace and comments were left
+	static char const* ParseGame(char const* textBegin, char const* gameBegin, char const* textEnd, ChessPGNGame& out_game);
+
+private:
+	char const* GetText() const { return reinterpret_cast<char const*>(m_file.GetData()); }
+	char const* FindNextTaggedGameStart(char const* cursor, char const* searchEnd) const;		// End of the file if none starts before searchEnd
+	void		ReadChunks(int workerIndex, ChessPGNGameCallback const& callback, ChessPGNReadStats& out_stats);
+
+private:
+	ChessMappedFile m_file;
+	size_t			m_cursor = 0;
+	std::atomic<size_t> m_nextChunkIndex = 0;
+};
+// -----------------------------------------------------------------------------
+// Appends games in export format: the seven tag roster first, SetUp/FEN for non-standard starts,
+// then SAN movetext wrapped at 80 columns. Each game is built in a reused buffer and written in one call.
+// -----------------------------------------------------------------------------
+class ChessPGNWriter
+{
+public:
+	bool Open(std::string const& filePath, bool append);
+	void Close();
+	bool IsOpen() const { return m_file.is_open(); }
+
+	bool WriteGame(ChessPGNGame const& game);		// False if a move is illegal in its position
+
+private:
+	void AppendTag(std::string_view name, std::string_view value);
+	void AppendMoveText(std::string_view text, int& lineLength);
+
+private:
+	std::ofstream m_file;
+	std::string	  m_buffer;
+};
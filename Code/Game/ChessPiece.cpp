@@ -437,6 +437,10 @@ ChessMoveResult ChessPiece::ValidatePawnMove(IntVec2 fromCoords, IntVec2 toCoord
 	// Check for regular capturing with pawn
 	if (abs(squareMoved.x) == 1 && squareMoved.y == direction && isCaptured)
 	{
+		if (CanPromote(toCoords.y))
+		{
+			return ChessMoveResult::VALID_MOVE_PROMOTION;
+		}
 		return ChessMoveResult::VALID_CAPTURE_NORMAL;
 	}
 
@@ -9,6 +9,8 @@ ChessPlayer::ChessPlayer(int playerIDX, Rgba8 playerColor, ChessMatch* chessMatc
 
 ChessPlayer::~ChessPlayer()
 {
+	delete m_engine;
+	m_engine = nullptr;
 }
 
 void ChessPlayer::SetPlayerName(std::string name)
@@ -20,3 +22,15 @@ std::string ChessPlayer::GetPlayerName() const
 {
 	return m_playerName;
 }
+
+void ChessPlayer::SetEngine(ChessEngineType engineType, ChessSearchLimits const& searchLimits)
+{
+	m_searchLimits = searchLimits;
+	if (m_engine != nullptr && m_engine->GetType() == engineType)
+	{
+		return;
+	}
+
+	delete m_engine;
+	m_engine = ChessEngine::CreateEngine(engineType);
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "Game/ChessEngine.hpp"
 #include "Engine/Core/Rgba8.h"
 #include <string>
 // -----------------------------------------------------------------------------
@@ -15,9 +16,17 @@ public:
 	void SetPlayerName(std::string name);
 	std::string GetPlayerName() const;
 
+	// Engine control, a player without an engine is driven by console/network commands
+	void SetEngine(ChessEngineType engineType, ChessSearchLimits const& searchLimits);
+	bool IsEngineControlled() const { return m_engine != nullptr; }
+	ChessEngine* GetEngine() const { return m_engine; }
+	ChessSearchLimits const& GetSearchLimits() const { return m_searchLimits; }
+
 private:
 	ChessMatch* m_theChessMatch = nullptr;
 	std::string m_playerName = "default";
 	int m_playerIndex = 0;
 	Rgba8 m_playerColor = Rgba8::WHITE;
+	ChessEngine* m_engine = nullptr;
+	ChessSearchLimits m_searchLimits;
 };
\ No newline at end of file
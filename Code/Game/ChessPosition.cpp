@@ -0,0 +1,1108 @@
+#include "Game/ChessPosition.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+// -----------------------------------------------------------------------------
+static int const KNIGHT_OFFSETS[8][2] = { {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2} };
+static int const KING_OFFSETS[8][2] = { {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1} };
+static int const BISHOP_DIRECTIONS[4][2] = { {1, 1}, {-1, 1}, {-1, -1}, {1, -1} };
+static int const ROOK_DIRECTIONS[4][2] = { {1, 0}, {0, 1}, {-1, 0}, {0, -1} };
+// -----------------------------------------------------------------------------
+// Zobrist keys: 12 piece codes x 64 squares, castling rights, en passant file, side to move
+// -----------------------------------------------------------------------------
+struct ChessZobristKeys
+{
+	uint64_t m_pieceKeys[16][CHESS_BOARD_SIZE] = {};
+	uint64_t m_castlingKeys[16] = {};
+	uint64_t m_enpassantKeys[CHESS_BOARD_COLUMNS] = {};
+	uint64_t m_sideToMoveKey = 0;
+
+	ChessZobristKeys()
+	{
+		// SplitMix64 with a fixed seed so hashes are stable across runs, saves and peers
+		uint64_t state = 0x43686573733344ULL;
+		auto nextKey = [&state]()
+		{
+			state += 0x9E3779B97F4A7C15ULL;
+			uint64_t z = state;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		};
+
+		for (int pieceCode = 0; pieceCode < 16; ++pieceCode)
+		{
+			for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+			{
+				m_pieceKeys[pieceCode][square] = nextKey();
+			}
+		}
+		for (int rights = 0; rights < 16; ++rights)
+		{
+			m_castlingKeys[rights] = nextKey();
+		}
+		for (int file = 0; file < CHESS_BOARD_COLUMNS; ++file)
+		{
+			m_enpassantKeys[file] = nextKey();
+		}
+		m_sideToMoveKey = nextKey();
+	}
+};
+
+static ChessZobristKeys const& GetZobristKeys()
+{
+	static ChessZobristKeys s_zobristKeys;
+	return s_zobristKeys;
+}
+
+// -----------------------------------------------------------------------------
+int GetChessSquareForNotation(char const* notation)
+{
+	if (notation == nullptr || notation[0] < 'a' || notation[0] > 'h' || notation[1] < '1' || notation[1] > '8')
+	{
+		return CHESS_NO_SQUARE;
+	}
+	return GetChessSquare(notation[0] - 'a', notation[1] - '1');
+}
+
+std::string GetNotationForChessSquare(int square)
+{
+	if (square < 0 || square >= CHESS_BOARD_SIZE)
+	{
+		return "-";
+	}
+	char notation[3] = { static_cast<char>('a' + GetChessSquareX(square)), static_cast<char>('1' + GetChessSquareY(square)), '\0' };
+	return std::string(notation);
+}
+
+std::string ChessMove::GetNotation() const
+{
+	static char const PROMOTION_GLYPHS[] = { 'r', 'n', 'b', 'q', 'k', 'p' };
+
+	std::string notation = GetNotationForChessSquare(m_from) + GetNotationForChessSquare(m_to);
+	if (IsPromotion())
+	{
+		notation += PROMOTION_GLYPHS[m_promotion - 1];
+	}
+	return notation;
+}
+
+ChessMove ChessMove::MakeFromPacked(uint16_t packedMove)
+{
+	ChessMove move;
+	move.m_from = static_cast<uint8_t>(packedMove & 63);
+	move.m_to = static_cast<uint8_t>((packedMove >> 6) & 63);
+	move.m_promotion = static_cast<uint8_t>((packedMove >> 12) & 7);
+	move.m_flags = move.m_promotion ? CHESS_MOVE_FLAG_PROMOTION : 0;
+	return move;
+}
+
+std::string ChessMove::GetPromotionName() const
+{
+	switch (GetPromotionType())
+	{
+		case ChessPieceType::QUEEN:		return "queen";
+		case ChessPieceType::ROOK:		return "rook";
+		case ChessPieceType::BISHOP:	return "bishop";
+		case ChessPieceType::KNIGHT:	return "knight";
+		default:						return "";
+	}
+}
+
+// -----------------------------------------------------------------------------
+ChessPosition ChessPosition::GetStartingPosition()
+{
+	static ChessPieceType const BACK_RANK[CHESS_BOARD_COLUMNS] =
+	{
+		ChessPieceType::ROOK, ChessPieceType::KNIGHT, ChessPieceType::BISHOP, ChessPieceType::QUEEN,
+		ChessPieceType::KING, ChessPieceType::BISHOP, ChessPieceType::KNIGHT, ChessPieceType::ROOK
+	};
+
+	ChessPosition position;
+	for (int x = 0; x < CHESS_BOARD_COLUMNS; ++x)
+	{
+		position.m_squares[GetChessSquare(x, 0)] = MakeChessPieceCode(BACK_RANK[x], 0);
+		position.m_squares[GetChessSquare(x, 1)] = MakeChessPieceCode(ChessPieceType::PAWN, 0);
+		position.m_squares[GetChessSquare(x, 6)] = MakeChessPieceCode(ChessPieceType::PAWN, 1);
+		position.m_squares[GetChessSquare(x, 7)] = MakeChessPieceCode(BACK_RANK[x], 1);
+	}
+	position.m_castlingRights = CASTLE_ALL;
+	position.RefreshDerivedState();
+	return position;
+}
+
+void ChessPosition::Clear()
+{
+	*this = ChessPosition();
+	RefreshDerivedState();
+}
+
+void ChessPosition::SetPieceAt(int square, uint8_t pieceCode)
+{
+	RemovePieceAt(square);
+	if (pieceCode == CHESS_EMPTY_SQUARE)
+	{
+		return;
+	}
+
+	m_squares[square] = pieceCode;
+	m_hash ^= GetZobristKeys().m_pieceKeys[pieceCode][square];
+	if (GetChessPieceTypeForCode(pieceCode) == ChessPieceType::KING)
+	{
+		m_kingSquares[GetPlayerIndexForCode(pieceCode)] = square;
+	}
+}
+
+void ChessPosition::RemovePieceAt(int square)
+{
+	uint8_t pieceCode = m_squares[square];
+	if (pieceCode == CHESS_EMPTY_SQUARE)
+	{
+		return;
+	}
+
+	m_hash ^= GetZobristKeys().m_pieceKeys[pieceCode][square];
+	m_squares[square] = CHESS_EMPTY_SQUARE;
+	if (GetChessPieceTypeForCode(pieceCode) == ChessPieceType::KING && m_kingSquares[GetPlayerIndexForCode(pieceCode)] == square)
+	{
+		m_kingSquares[GetPlayerIndexForCode(pieceCode)] = CHESS_NO_SQUARE;
+	}
+}
+
+int ChessPosition::CountPieces(ChessPieceType pieceType, int playerIndex) const
+{
+	uint8_t pieceCode = MakeChessPieceCode(pieceType, playerIndex);
+	int count = 0;
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		if (m_squares[square] == pieceCode)
+		{
+			++count;
+		}
+	}
+	return count;
+}
+
+int ChessPosition::CountAllPieces() const
+{
+	int count = 0;
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		if (m_squares[square] != CHESS_EMPTY_SQUARE)
+		{
+			++count;
+		}
+	}
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+void ChessPosition::GeneratePseudoLegalMoves(ChessMoveList& out_moves) const
+{
+	out_moves.m_count = 0;
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = m_squares[square];
+		if (pieceCode == CHESS_EMPTY_SQUARE || GetPlayerIndexForCode(pieceCode) != m_sideToMove)
+		{
+			continue;
+		}
+
+		switch (GetChessPieceTypeForCode(pieceCode))
+		{
+			case ChessPieceType::PAWN:		AddPawnMoves(square, out_moves); break;
+			case ChessPieceType::KNIGHT:	AddStepMoves(square, KNIGHT_OFFSETS, 8, out_moves); break;
+			case ChessPieceType::BISHOP:	AddSlidingMoves(square, BISHOP_DIRECTIONS, 4, out_moves); break;
+			case ChessPieceType::ROOK:		AddSlidingMoves(square, ROOK_DIRECTIONS, 4, out_moves); break;
+			case ChessPieceType::QUEEN:
+			{
+				AddSlidingMoves(square, BISHOP_DIRECTIONS, 4, out_moves);
+				AddSlidingMoves(square, ROOK_DIRECTIONS, 4, out_moves);
+				break;
+			}
+			case ChessPieceType::KING:
+			{
+				AddStepMoves(square, KING_OFFSETS, 8, out_moves);
+				AddCastlingMoves(square, out_moves);
+				break;
+			}
+			default: break;
+		}
+	}
+}
+
+void ChessPosition::GenerateLegalMoves(ChessMoveList& out_moves) const
+{
+	ChessMoveList pseudoLegalMoves;
+	GeneratePseudoLegalMoves(pseudoLegalMoves);
+
+	out_moves.m_count = 0;
+	for (int moveIndex = 0; moveIndex < pseudoLegalMoves.m_count; ++moveIndex)
+	{
+		if (IsLegalMove(pseudoLegalMoves[moveIndex]))
+		{
+			out_moves.Add(pseudoLegalMoves[moveIndex]);
+		}
+	}
+}
+
+void ChessPosition::GenerateLegalCaptures(ChessMoveList& out_moves) const
+{
+	ChessMoveList pseudoLegalMoves;
+	GeneratePseudoLegalMoves(pseudoLegalMoves);
+
+	out_moves.m_count = 0;
+	for (int moveIndex = 0; moveIndex < pseudoLegalMoves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = pseudoLegalMoves[moveIndex];
+		if ((move.IsCapture() || move.IsPromotion()) && IsLegalMove(move))
+		{
+			out_moves.Add(move);
+		}
+	}
+}
+
+bool ChessPosition::IsLegalMove(ChessMove const& move) const
+{
+	ChessPosition afterMove = *this;
+	afterMove.MakeMove(move);
+	return !afterMove.IsInCheck(m_sideToMove);
+}
+
+bool ChessPosition::HasLegalMove() const
+{
+	ChessMoveList pseudoLegalMoves;
+	GeneratePseudoLegalMoves(pseudoLegalMoves);
+	for (int moveIndex = 0; moveIndex < pseudoLegalMoves.m_count; ++moveIndex)
+	{
+		if (IsLegalMove(pseudoLegalMoves[moveIndex]))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ChessPosition::FindPseudoLegalMove(int fromSquare, int toSquare, ChessPieceType promotionType, ChessMove& out_move) const
+{
+	ChessMoveList pseudoLegalMoves;
+	GeneratePseudoLegalMoves(pseudoLegalMoves);
+	for (int moveIndex = 0; moveIndex < pseudoLegalMoves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = pseudoLegalMoves[moveIndex];
+		if (move.m_from != fromSquare || move.m_to != toSquare)
+		{
+			continue;
+		}
+		if (move.IsPromotion() && move.GetPromotionType() != promotionType)
+		{
+			continue;
+		}
+		out_move = move;
+		return true;
+	}
+	return false;
+}
+
+void ChessPosition::AddPawnMoves(int fromSquare, ChessMoveList& out_moves) const
+{
+	static ChessPieceType const PROMOTION_TYPES[4] = { ChessPieceType::QUEEN, ChessPieceType::KNIGHT, ChessPieceType::ROOK, ChessPieceType::BISHOP };
+
+	int x = GetChessSquareX(fromSquare);
+	int y = GetChessSquareY(fromSquare);
+	int direction = (m_sideToMove == 0) ? 1 : -1;
+	int startRank = (m_sideToMove == 0) ? 1 : 6;
+	int promotionRank = (m_sideToMove == 0) ? 7 : 0;
+
+	auto addPawnMove = [&](int toSquare, uint8_t flags)
+	{
+		if (GetChessSquareY(toSquare) == promotionRank)
+		{
+			for (ChessPieceType promotionType : PROMOTION_TYPES)
+			{
+				ChessMove move;
+				move.m_from = static_cast<uint8_t>(fromSquare);
+				move.m_to = static_cast<uint8_t>(toSquare);
+				move.m_promotion = static_cast<uint8_t>(static_cast<int>(promotionType) + 1);
+				move.m_flags = flags | CHESS_MOVE_FLAG_PROMOTION;
+				out_moves.Add(move);
+			}
+			return;
+		}
+
+		ChessMove move;
+		move.m_from = static_cast<uint8_t>(fromSquare);
+		move.m_to = static_cast<uint8_t>(toSquare);
+		move.m_flags = flags;
+		out_moves.Add(move);
+	};
+
+	// Pushes
+	int forwardY = y + direction;
+	if (forwardY >= 0 && forwardY < CHESS_BOARD_ROWS && m_squares[GetChessSquare(x, forwardY)] == CHESS_EMPTY_SQUARE)
+	{
+		addPawnMove(GetChessSquare(x, forwardY), 0);
+
+		int doubleY = y + 2 * direction;
+		if (y == startRank && m_squares[GetChessSquare(x, doubleY)] == CHESS_EMPTY_SQUARE)
+		{
+			addPawnMove(GetChessSquare(x, doubleY), CHESS_MOVE_FLAG_DOUBLE_PUSH);
+		}
+	}
+
+	// Captures, including en passant
+	for (int dx = -1; dx <= 1; dx += 2)
+	{
+		int captureX = x + dx;
+		if (captureX < 0 || captureX >= CHESS_BOARD_COLUMNS || forwardY < 0 || forwardY >= CHESS_BOARD_ROWS)
+		{
+			continue;
+		}
+
+		int toSquare = GetChessSquare(captureX, forwardY);
+		uint8_t target = m_squares[toSquare];
+		if (target != CHESS_EMPTY_SQUARE && GetPlayerIndexForCode(target) != m_sideToMove)
+		{
+			addPawnMove(toSquare, CHESS_MOVE_FLAG_CAPTURE);
+		}
+		else if (toSquare == m_enpassantSquare)
+		{
+			addPawnMove(toSquare, CHESS_MOVE_FLAG_CAPTURE | CHESS_MOVE_FLAG_ENPASSANT);
+		}
+	}
+}
+
+void ChessPosition::AddStepMoves(int fromSquare, int const (*offsets)[2], int numOffsets, ChessMoveList& out_moves) const
+{
+	int x = GetChessSquareX(fromSquare);
+	int y = GetChessSquareY(fromSquare);
+	for (int offsetIndex = 0; offsetIndex < numOffsets; ++offsetIndex)
+	{
+		int toX = x + offsets[offsetIndex][0];
+		int toY = y + offsets[offsetIndex][1];
+		if (toX < 0 || toX >= CHESS_BOARD_COLUMNS || toY < 0 || toY >= CHESS_BOARD_ROWS)
+		{
+			continue;
+		}
+
+		int toSquare = GetChessSquare(toX, toY);
+		uint8_t target = m_squares[toSquare];
+		if (target != CHESS_EMPTY_SQUARE && GetPlayerIndexForCode(target) == m_sideToMove)
+		{
+			continue;
+		}
+
+		ChessMove move;
+		move.m_from = static_cast<uint8_t>(fromSquare);
+		move.m_to = static_cast<uint8_t>(toSquare);
+		move.m_flags = (target != CHESS_EMPTY_SQUARE) ? CHESS_MOVE_FLAG_CAPTURE : 0;
+		out_moves.Add(move);
+	}
+}
+
+void ChessPosition::AddSlidingMoves(int fromSquare, int const (*directions)[2], int numDirections, ChessMoveList& out_moves) const
+{
+	int x = GetChessSquareX(fromSquare);
+	int y = GetChessSquareY(fromSquare);
+	for (int directionIndex = 0; directionIndex < numDirections; ++directionIndex)
+	{
+		int toX = x + directions[directionIndex][0];
+		int toY = y + directions[directionIndex][1];
+		while (toX >= 0 && toX < CHESS_BOARD_COLUMNS && toY >= 0 && toY < CHESS_BOARD_ROWS)
+		{
+			int toSquare = GetChessSquare(toX, toY);
+			uint8_t target = m_squares[toSquare];
+			if (target != CHESS_EMPTY_SQUARE && GetPlayerIndexForCode(target) == m_sideToMove)
+			{
+				break;
+			}
+
+			ChessMove move;
+			move.m_from = static_cast<uint8_t>(fromSquare);
+			move.m_to = static_cast<uint8_t>(toSquare);
+			move.m_flags = (target != CHESS_EMPTY_SQUARE) ? CHESS_MOVE_FLAG_CAPTURE : 0;
+			out_moves.Add(move);
+
+			if (target != CHESS_EMPTY_SQUARE)
+			{
+				break;
+			}
+			toX += directions[directionIndex][0];
+			toY += directions[directionIndex][1];
+		}
+	}
+}
+
+void ChessPosition::AddCastlingMoves(int fromSquare, ChessMoveList& out_moves) const
+{
+	int homeRank = (m_sideToMove == 0) ? 0 : 7;
+	if (fromSquare != GetChessSquare(4, homeRank))
+	{
+		return;
+	}
+
+	uint8_t kingsideRight = (m_sideToMove == 0) ? CASTLE_WHITE_KINGSIDE : CASTLE_BLACK_KINGSIDE;
+	uint8_t queensideRight = (m_sideToMove == 0) ? CASTLE_WHITE_QUEENSIDE : CASTLE_BLACK_QUEENSIDE;
+	if ((m_castlingRights & (kingsideRight | queensideRight)) == 0)
+	{
+		return;
+	}
+
+	int opponentIndex = 1 - m_sideToMove;
+	if (IsSquareAttacked(fromSquare, opponentIndex))
+	{
+		return;
+	}
+
+	uint8_t rookCode = MakeChessPieceCode(ChessPieceType::ROOK, m_sideToMove);
+	if ((m_castlingRights & kingsideRight) &&
+		m_squares[GetChessSquare(7, homeRank)] == rookCode &&
+		m_squares[GetChessSquare(5, homeRank)] == CHESS_EMPTY_SQUARE &&
+		m_squares[GetChessSquare(6, homeRank)] == CHESS_EMPTY_SQUARE &&
+		!IsSquareAttacked(GetChessSquare(5, homeRank), opponentIndex))
+	{
+		ChessMove move;
+		move.m_from = static_cast<uint8_t>(fromSquare);
+		move.m_to = static_cast<uint8_t>(GetChessSquare(6, homeRank));
+		move.m_flags = CHESS_MOVE_FLAG_CASTLE;
+		out_moves.Add(move);
+	}
+
+	if ((m_castlingRights & queensideRight) &&
+		m_squares[GetChessSquare(0, homeRank)] == rookCode &&
+		m_squares[GetChessSquare(1, homeRank)] == CHESS_EMPTY_SQUARE &&
+		m_squares[GetChessSquare(2, homeRank)] == CHESS_EMPTY_SQUARE &&
+		m_squares[GetChessSquare(3, homeRank)] == CHESS_EMPTY_SQUARE &&
+		!IsSquareAttacked(GetChessSquare(3, homeRank), opponentIndex))
+	{
+		ChessMove move;
+		move.m_from = static_cast<uint8_t>(fromSquare);
+		move.m_to = static_cast<uint8_t>(GetChessSquare(2, homeRank));
+		move.m_flags = CHESS_MOVE_FLAG_CASTLE;
+		out_moves.Add(move);
+	}
+}
+
+// -----------------------------------------------------------------------------
+void ChessPosition::MakeMove(ChessMove const& move)
+{
+	ChessZobristKeys const& keys = GetZobristKeys();
+	uint8_t movingPiece = m_squares[move.m_from];
+	ChessPieceType movingType = GetChessPieceTypeForCode(movingPiece);
+	int homeRank = (m_sideToMove == 0) ? 0 : 7;
+
+	// Clear the old en passant and castling contributions; they are re-added below
+	if (m_enpassantSquare != CHESS_NO_SQUARE)
+	{
+		m_hash ^= keys.m_enpassantKeys[GetChessSquareX(m_enpassantSquare)];
+	}
+	m_hash ^= keys.m_castlingKeys[m_castlingRights];
+
+	// En passant is detected from the board so moves rebuilt from their packed form apply correctly
+	bool isCapture = m_squares[move.m_to] != CHESS_EMPTY_SQUARE;
+	bool isEnpassant = movingType == ChessPieceType::PAWN && !isCapture && GetChessSquareX(move.m_to) != GetChessSquareX(move.m_from);
+	if (isEnpassant)
+	{
+		RemovePieceAt(GetChessSquare(GetChessSquareX(move.m_to), GetChessSquareY(move.m_from)));
+		isCapture = true;
+	}
+
+	RemovePieceAt(move.m_from);
+	uint8_t placedPiece = move.IsPromotion() ? MakeChessPieceCode(move.GetPromotionType(), m_sideToMove) : movingPiece;
+	SetPieceAt(move.m_to, placedPiece);
+
+	// Castling moves the rook as well
+	if (movingType == ChessPieceType::KING && abs(GetChessSquareX(move.m_to) - GetChessSquareX(move.m_from)) == 2)
+	{
+		bool isKingside = GetChessSquareX(move.m_to) > GetChessSquareX(move.m_from);
+		int rookFrom = GetChessSquare(isKingside ? 7 : 0, homeRank);
+		int rookTo = GetChessSquare(isKingside ? 5 : 3, homeRank);
+		uint8_t rookCode = m_squares[rookFrom];
+		RemovePieceAt(rookFrom);
+		SetPieceAt(rookTo, rookCode);
+	}
+
+	// Update castling rights when kings or rooks leave (or are captured on) their home squares
+	auto clearRightsForSquare = [this](int square)
+	{
+		if (square == GetChessSquare(4, 0)) m_castlingRights &= ~(CASTLE_WHITE_KINGSIDE | CASTLE_WHITE_QUEENSIDE);
+		if (square == GetChessSquare(7, 0)) m_castlingRights &= ~CASTLE_WHITE_KINGSIDE;
+		if (square == GetChessSquare(0, 0)) m_castlingRights &= ~CASTLE_WHITE_QUEENSIDE;
+		if (square == GetChessSquare(4, 7)) m_castlingRights &= ~(CASTLE_BLACK_KINGSIDE | CASTLE_BLACK_QUEENSIDE);
+		if (square == GetChessSquare(7, 7)) m_castlingRights &= ~CASTLE_BLACK_KINGSIDE;
+		if (square == GetChessSquare(0, 7)) m_castlingRights &= ~CASTLE_BLACK_QUEENSIDE;
+	};
+	clearRightsForSquare(move.m_from);
+	clearRightsForSquare(move.m_to);
+	m_hash ^= keys.m_castlingKeys[m_castlingRights];
+
+	// En passant target is the square skipped by a double pawn push
+	m_enpassantSquare = CHESS_NO_SQUARE;
+	if (movingType == ChessPieceType::PAWN && abs(GetChessSquareY(move.m_to) - GetChessSquareY(move.m_from)) == 2)
+	{
+		m_enpassantSquare = (move.m_from + move.m_to) / 2;
+		m_hash ^= keys.m_enpassantKeys[GetChessSquareX(m_enpassantSquare)];
+	}
+
+	m_halfmoveClock = (movingType == ChessPieceType::PAWN || isCapture) ? 0 : m_halfmoveClock + 1;
+	if (m_sideToMove == 1)
+	{
+		m_fullmoveNumber += 1;
+	}
+	m_sideToMove = 1 - m_sideToMove;
+	m_hash ^= keys.m_sideToMoveKey;
+}
+
+void ChessPosition::MakeNullMove()
+{
+	ChessZobristKeys const& keys = GetZobristKeys();
+	if (m_enpassantSquare != CHESS_NO_SQUARE)
+	{
+		m_hash ^= keys.m_enpassantKeys[GetChessSquareX(m_enpassantSquare)];
+		m_enpassantSquare = CHESS_NO_SQUARE;
+	}
+	m_sideToMove = 1 - m_sideToMove;
+	m_hash ^= keys.m_sideToMoveKey;
+}
+
+// -----------------------------------------------------------------------------
+bool ChessPosition::IsSquareAttacked(int square, int byPlayerIndex) const
+{
+	int x = GetChessSquareX(square);
+	int y = GetChessSquareY(square);
+
+	// Pawns attack diagonally forward, so look one rank "behind" the target from the attacker's view
+	int pawnY = y - ((byPlayerIndex == 0) ? 1 : -1);
+	if (pawnY >= 0 && pawnY < CHESS_BOARD_ROWS)
+	{
+		uint8_t pawnCode = MakeChessPieceCode(ChessPieceType::PAWN, byPlayerIndex);
+		if (x > 0 && m_squares[GetChessSquare(x - 1, pawnY)] == pawnCode) return true;
+		if (x < 7 && m_squares[GetChessSquare(x + 1, pawnY)] == pawnCode) return true;
+	}
+
+	uint8_t knightCode = MakeChessPieceCode(ChessPieceType::KNIGHT, byPlayerIndex);
+	for (int offsetIndex = 0; offsetIndex < 8; ++offsetIndex)
+	{
+		int fromX = x + KNIGHT_OFFSETS[offsetIndex][0];
+		int fromY = y + KNIGHT_OFFSETS[offsetIndex][1];
+		if (fromX >= 0 && fromX < CHESS_BOARD_COLUMNS && fromY >= 0 && fromY < CHESS_BOARD_ROWS && m_squares[GetChessSquare(fromX, fromY)] == knightCode)
+		{
+			return true;
+		}
+	}
+
+	uint8_t kingCode = MakeChessPieceCode(ChessPieceType::KING, byPlayerIndex);
+	for (int offsetIndex = 0; offsetIndex < 8; ++offsetIndex)
+	{
+		int fromX = x + KING_OFFSETS[offsetIndex][0];
+		int fromY = y + KING_OFFSETS[offsetIndex][1];
+		if (fromX >= 0 && fromX < CHESS_BOARD_COLUMNS && fromY >= 0 && fromY < CHESS_BOARD_ROWS && m_squares[GetChessSquare(fromX, fromY)] == kingCode)
+		{
+			return true;
+		}
+	}
+
+	uint8_t queenCode = MakeChessPieceCode(ChessPieceType::QUEEN, byPlayerIndex);
+	uint8_t bishopCode = MakeChessPieceCode(ChessPieceType::BISHOP, byPlayerIndex);
+	uint8_t rookCode = MakeChessPieceCode(ChessPieceType::ROOK, byPlayerIndex);
+	for (int directionIndex = 0; directionIndex < 4; ++directionIndex)
+	{
+		for (int sliderKind = 0; sliderKind < 2; ++sliderKind)
+		{
+			int const* direction = (sliderKind == 0) ? BISHOP_DIRECTIONS[directionIndex] : ROOK_DIRECTIONS[directionIndex];
+			uint8_t sliderCode = (sliderKind == 0) ? bishopCode : rookCode;
+
+			int fromX = x + direction[0];
+			int fromY = y + direction[1];
+			while (fromX >= 0 && fromX < CHESS_BOARD_COLUMNS && fromY >= 0 && fromY < CHESS_BOARD_ROWS)
+			{
+				uint8_t pieceCode = m_squares[GetChessSquare(fromX, fromY)];
+				if (pieceCode != CHESS_EMPTY_SQUARE)
+				{
+					if (pieceCode == sliderCode || pieceCode == queenCode)
+					{
+						return true;
+					}
+					break;
+				}
+				fromX += direction[0];
+				fromY += direction[1];
+			}
+		}
+	}
+
+	return false;
+}
+
+bool ChessPosition::IsInCheck(int playerIndex) const
+{
+	int kingSquare = m_kingSquares[playerIndex];
+	if (kingSquare == CHESS_NO_SQUARE)
+	{
+		return false;
+	}
+	return IsSquareAttacked(kingSquare, 1 - playerIndex);
+}
+
+bool ChessPosition::IsCheckmate() const
+{
+	return IsInCheck(m_sideToMove) && !HasLegalMove();
+}
+
+bool ChessPosition::IsStalemate() const
+{
+	return !IsInCheck(m_sideToMove) && !HasLegalMove();
+}
+
+bool ChessPosition::IsInsufficientMaterial() const
+{
+	int minorPieces = 0;
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = m_squares[square];
+		if (pieceCode == CHESS_EMPTY_SQUARE)
+		{
+			continue;
+		}
+
+		ChessPieceType pieceType = GetChessPieceTypeForCode(pieceCode);
+		if (pieceType == ChessPieceType::PAWN || pieceType == ChessPieceType::ROOK || pieceType == ChessPieceType::QUEEN)
+		{
+			return false;
+		}
+		if (pieceType == ChessPieceType::KNIGHT || pieceType == ChessPieceType::BISHOP)
+		{
+			++minorPieces;
+		}
+	}
+	return minorPieces <= 1;
+}
+
+uint64_t ChessPosition::ComputeHash() const
+{
+	ChessZobristKeys const& keys = GetZobristKeys();
+	uint64_t hash = 0;
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		if (m_squares[square] != CHESS_EMPTY_SQUARE)
+		{
+			hash ^= keys.m_pieceKeys[m_squares[square]][square];
+		}
+	}
+	hash ^= keys.m_castlingKeys[m_castlingRights & CASTLE_ALL];
+	if (m_enpassantSquare != CHESS_NO_SQUARE)
+	{
+		hash ^= keys.m_enpassantKeys[GetChessSquareX(m_enpassantSquare)];
+	}
+	if (m_sideToMove == 1)
+	{
+		hash ^= keys.m_sideToMoveKey;
+	}
+	return hash;
+}
+
+void ChessPosition::RefreshDerivedState()
+{
+	m_kingSquares[0] = CHESS_NO_SQUARE;
+	m_kingSquares[1] = CHESS_NO_SQUARE;
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = m_squares[square];
+		if (pieceCode != CHESS_EMPTY_SQUARE && GetChessPieceTypeForCode(pieceCode) == ChessPieceType::KING)
+		{
+			m_kingSquares[GetPlayerIndexForCode(pieceCode)] = square;
+		}
+	}
+	m_hash = ComputeHash();
+}
+
+// -----------------------------------------------------------------------------
+static uint8_t GetChessPieceCodeForGlyph(char glyph)
+{
+	int playerIndex = (glyph >= 'a' && glyph <= 'z') ? 1 : 0;
+	switch (glyph | 0x20)
+	{
+		case 'r':	return MakeChessPieceCode(ChessPieceType::ROOK, playerIndex);
+		case 'n':	return MakeChessPieceCode(ChessPieceType::KNIGHT, playerIndex);
+		case 'b':	return MakeChessPieceCode(ChessPieceType::BISHOP, playerIndex);
+		case 'q':	return MakeChessPieceCode(ChessPieceType::QUEEN, playerIndex);
+		case 'k':	return MakeChessPieceCode(ChessPieceType::KING, playerIndex);
+		case 'p':	return MakeChessPieceCode(ChessPieceType::PAWN, playerIndex);
+		default:	return CHESS_EMPTY_SQUARE;
+	}
+}
+
+static char GetGlyphForChessPieceCode(uint8_t pieceCode)
+{
+	static char const PIECE_GLYPHS[] = { 'R', 'N', 'B', 'Q', 'K', 'P' };
+	char glyph = PIECE_GLYPHS[static_cast<int>(GetChessPieceTypeForCode(pieceCode))];
+	return (GetPlayerIndexForCode(pieceCode) == 0) ? glyph : static_cast<char>(glyph | 0x20);
+}
+
+static char const* SkipFENSpaces(char const* cursor)
+{
+	while (*cursor == ' ' || *cursor == '\t')
+	{
+		++cursor;
+	}
+	return cursor;
+}
+
+static char const* ParseFENCounter(char const* cursor, int& out_value)
+{
+	// Counters are optional (EPD has none), so only an all-digit token is consumed
+	char const* tokenEnd = cursor;
+	int value = 0;
+	while (*tokenEnd >= '0' && *tokenEnd <= '9')
+	{
+		value = value * 10 + (*tokenEnd - '0');
+		++tokenEnd;
+	}
+	if (tokenEnd == cursor || (*tokenEnd != '\0' && *tokenEnd != ' ' && *tokenEnd != '\t' && *tokenEnd != '\r' && *tokenEnd != '\n'))
+	{
+		return cursor;
+	}
+	out_value = value;
+	return SkipFENSpaces(tokenEnd);
+}
+
+bool ChessPosition::SetFromFEN(char const* fen, char const** out_end)
+{
+	if (fen == nullptr)
+	{
+		return false;
+	}
+
+	ChessPosition position;
+	char const* cursor = SkipFENSpaces(fen);
+
+	// Piece placement, rank 8 first
+	int x = 0;
+	int y = CHESS_BOARD_ROWS - 1;
+	for (; *cursor != '\0' && *cursor != ' '; ++cursor)
+	{
+		char glyph = *cursor;
+		if (glyph == '/')
+		{
+			if (x != CHESS_BOARD_COLUMNS || y == 0)
+			{
+				return false;
+			}
+			x = 0;
+			--y;
+		}
+		else if (glyph >= '1' && glyph <= '8')
+		{
+			x += glyph - '0';
+			if (x > CHESS_BOARD_COLUMNS)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			uint8_t pieceCode = GetChessPieceCodeForGlyph(glyph);
+			if (pieceCode == CHESS_EMPTY_SQUARE || x >= CHESS_BOARD_COLUMNS)
+			{
+				return false;
+			}
+			position.m_squares[GetChessSquare(x, y)] = pieceCode;
+			++x;
+		}
+	}
+	if (x != CHESS_BOARD_COLUMNS || y != 0)
+	{
+		return false;
+	}
+
+	// Side to move
+	cursor = SkipFENSpaces(cursor);
+	if (*cursor != 'w' && *cursor != 'b')
+	{
+		return false;
+	}
+	position.m_sideToMove = (*cursor == 'w') ? 0 : 1;
+	cursor = SkipFENSpaces(cursor + 1);
+
+	// Castling rights
+	if (*cursor == '-')
+	{
+		++cursor;
+	}
+	else
+	{
+		for (; *cursor != '\0' && *cursor != ' '; ++cursor)
+		{
+			switch (*cursor)
+			{
+				case 'K':	position.m_castlingRights |= CASTLE_WHITE_KINGSIDE;		break;
+				case 'Q':	position.m_castlingRights |= CASTLE_WHITE_QUEENSIDE;	break;
+				case 'k':	position.m_castlingRights |= CASTLE_BLACK_KINGSIDE;		break;
+				case 'q':	position.m_castlingRights |= CASTLE_BLACK_QUEENSIDE;	break;
+				default:	return false;
+			}
+		}
+	}
+
+	// En passant target
+	cursor = SkipFENSpaces(cursor);
+	if (*cursor == '-')
+	{
+		++cursor;
+	}
+	else
+	{
+		position.m_enpassantSquare = GetChessSquareForNotation(cursor);
+		if (position.m_enpassantSquare == CHESS_NO_SQUARE)
+		{
+			return false;
+		}
+		cursor += 2;
+	}
+
+	cursor = SkipFENSpaces(cursor);
+	cursor = ParseFENCounter(cursor, position.m_halfmoveClock);
+	cursor = ParseFENCounter(cursor, position.m_fullmoveNumber);
+
+	position.RefreshDerivedState();
+	*this = position;
+	if (out_end != nullptr)
+	{
+		*out_end = cursor;
+	}
+	return true;
+}
+
+std::string ChessPosition::GetFEN() const
+{
+	char fen[96];
+	int length = 0;
+
+	for (int y = CHESS_BOARD_ROWS - 1; y >= 0; --y)
+	{
+		int emptyCount = 0;
+		for (int x = 0; x < CHESS_BOARD_COLUMNS; ++x)
+		{
+			uint8_t pieceCode = m_squares[GetChessSquare(x, y)];
+			if (pieceCode == CHESS_EMPTY_SQUARE)
+			{
+				++emptyCount;
+				continue;
+			}
+			if (emptyCount > 0)
+			{
+				fen[length++] = static_cast<char>('0' + emptyCount);
+				emptyCount = 0;
+			}
+			fen[length++] = GetGlyphForChessPieceCode(pieceCode);
+		}
+		if (emptyCount > 0)
+		{
+			fen[length++] = static_cast<char>('0' + emptyCount);
+		}
+		if (y > 0)
+		{
+			fen[length++] = '/';
+		}
+	}
+
+	fen[length++] = ' ';
+	fen[length++] = (m_sideToMove == 0) ? 'w' : 'b';
+	fen[length++] = ' ';
+	if (m_castlingRights == 0)
+	{
+		fen[length++] = '-';
+	}
+	if (m_castlingRights & CASTLE_WHITE_KINGSIDE)	fen[length++] = 'K';
+	if (m_castlingRights & CASTLE_WHITE_QUEENSIDE)	fen[length++] = 'Q';
+	if (m_castlingRights & CASTLE_BLACK_KINGSIDE)	fen[length++] = 'k';
+	if (m_castlingRights & CASTLE_BLACK_QUEENSIDE)	fen[length++] = 'q';
+	fen[length++] = ' ';
+	if (m_enpassantSquare == CHESS_NO_SQUARE)
+	{
+		fen[length++] = '-';
+	}
+	else
+	{
+		fen[length++] = static_cast<char>('a' + GetChessSquareX(m_enpassantSquare));
+		fen[length++] = static_cast<char>('1' + GetChessSquareY(m_enpassantSquare));
+	}
+	length += snprintf(fen + length, sizeof(fen) - length, " %d %d", m_halfmoveClock, m_fullmoveNumber);
+	return std::string(fen, length);
+}
+
+bool ChessPosition::FindMoveForSAN(std::string_view san, ChessMove& out_move) const
+{
+	// Annotations and check marks carry no move information
+	while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+	{
+		san.remove_suffix(1);
+	}
+	if (san.size() < 2)
+	{
+		return false;
+	}
+
+	// Only the moves matching the text pay for the legality check
+	ChessMoveList moves;
+	GeneratePseudoLegalMoves(moves);
+
+	if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0")
+	{
+		int targetFile = (san.size() == 3) ? 6 : 2;
+		for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+		{
+			ChessMove const& move = moves[moveIndex];
+			if ((move.m_flags & CHESS_MOVE_FLAG_CASTLE) && GetChessSquareX(move.m_to) == targetFile && IsLegalMove(move))
+			{
+				out_move = move;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	ChessPieceType pieceType = ChessPieceType::PAWN;
+	if (san[0] == 'K' || san[0] == 'Q' || san[0] == 'R' || san[0] == 'B' || san[0] == 'N')
+	{
+		pieceType = GetChessPieceTypeForCode(GetChessPieceCodeForGlyph(san[0]));
+		san.remove_prefix(1);
+	}
+
+	// Promotion suffix, with or without '='
+	uint8_t promotion = 0;
+	if (!san.empty() && (san.back() == 'Q' || san.back() == 'R' || san.back() == 'B' || san.back() == 'N'))
+	{
+		promotion = static_cast<uint8_t>(static_cast<int>(GetChessPieceTypeForCode(GetChessPieceCodeForGlyph(san.back()))) + 1);
+		san.remove_suffix(1);
+		if (!san.empty() && san.back() == '=')
+		{
+			san.remove_suffix(1);
+		}
+	}
+	if (san.size() < 2)
+	{
+		return false;
+	}
+
+	int toSquare = GetChessSquareForNotation(san.data() + san.size() - 2);
+	if (toSquare == CHESS_NO_SQUARE)
+	{
+		return false;
+	}
+	san.remove_suffix(2);
+
+	// Whatever is left is disambiguation and the capture mark
+	int fromFile = -1;
+	int fromRank = -1;
+	for (char glyph : san)
+	{
+		if (glyph >= 'a' && glyph <= 'h')
+		{
+			fromFile = glyph - 'a';
+		}
+		else if (glyph >= '1' && glyph <= '8')
+		{
+			fromRank = glyph - '1';
+		}
+		else if (glyph != 'x' && glyph != ':')
+		{
+			return false;
+		}
+	}
+
+	int numMatches = 0;
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = moves[moveIndex];
+		if (move.m_to != toSquare || move.m_promotion != promotion || GetChessPieceTypeForCode(m_squares[move.m_from]) != pieceType)
+		{
+			continue;
+		}
+		if ((fromFile >= 0 && GetChessSquareX(move.m_from) != fromFile) || (fromRank >= 0 && GetChessSquareY(move.m_from) != fromRank) || !IsLegalMove(move))
+		{
+			continue;
+		}
+		out_move = move;
+		++numMatches;
+	}
+	return numMatches == 1;
+}
+
+std::string ChessPosition::GetSANForMove(ChessMove const& move) const
+{
+	// At most seven glyphs ("Qa1xb2+", "exd8=Q#"), so the result fits in the string's small buffer
+	char san[16] = {};
+	int length = 0;
+	ChessPieceType pieceType = GetChessPieceTypeForCode(m_squares[move.m_from]);
+	bool isCapture = move.IsCapture() || (m_squares[move.m_to] != CHESS_EMPTY_SQUARE);
+
+	if (move.m_flags & CHESS_MOVE_FLAG_CASTLE)
+	{
+		char const* castleText = (GetChessSquareX(move.m_to) == 6) ? "O-O" : "O-O-O";
+		while (*castleText != '\0')
+		{
+			san[length++] = *castleText++;
+		}
+	}
+	else
+	{
+		if (pieceType == ChessPieceType::PAWN)
+		{
+			if (isCapture)
+			{
+				san[length++] = static_cast<char>('a' + GetChessSquareX(move.m_from));
+			}
+		}
+		else
+		{
+			san[length++] = GetGlyphForChessPieceCode(MakeChessPieceCode(pieceType, 0));
+
+			// Disambiguate by file, then by rank, then by both, against the other pieces of this type that reach the square
+			ChessMoveList moves;
+			GeneratePseudoLegalMoves(moves);
+			bool isAmbiguous = false;
+			bool isFileShared = false;
+			bool isRankShared = false;
+			for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+			{
+				ChessMove const& other = moves[moveIndex];
+				if (other.m_to != move.m_to || other.m_from == move.m_from || GetChessPieceTypeForCode(m_squares[other.m_from]) != pieceType || !IsLegalMove(other))
+				{
+					continue;
+				}
+				isAmbiguous = true;
+				isFileShared |= GetChessSquareX(other.m_from) == GetChessSquareX(move.m_from);
+				isRankShared |= GetChessSquareY(other.m_from) == GetChessSquareY(move.m_from);
+			}
+			if (isAmbiguous && (!isFileShared || isRankShared))
+			{
+				san[length++] = static_cast<char>('a' + GetChessSquareX(move.m_from));
+			}
+			if (isAmbiguous && isFileShared)
+			{
+				san[length++] = static_cast<char>('1' + GetChessSquareY(move.m_from));
+			}
+		}
+
+		if (isCapture)
+		{
+			san[length++] = 'x';
+		}
+		san[length++] = static_cast<char>('a' + GetChessSquareX(move.m_to));
+		san[length++] = static_cast<char>('1' + GetChessSquareY(move.m_to));
+		if (move.IsPromotion())
+		{
+			san[length++] = '=';
+			san[length++] = GetGlyphForChessPieceCode(MakeChessPieceCode(move.GetPromotionType(), 0));
+		}
+	}
+
+	ChessPosition afterMove = *this;
+	afterMove.MakeMove(move);
+	if (afterMove.IsInCheck(afterMove.m_sideToMove))
+	{
+		san[length++] = afterMove.HasLegalMove() ? '+' : '#';
+	}
+	return std::string(san, length);
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include "Game/GameCommon.h"
+#include "Game/ChessPieceDefinition.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+// -----------------------------------------------------------------------------
+constexpr int CHESS_MAX_MOVES = 256;
+constexpr int CHESS_NO_SQUARE = -1;
+constexpr int CHESS_NUM_PLAYERS = 2;
+// -----------------------------------------------------------------------------
+// Piece codes stored per square: 0 is empty, otherwise (ChessPieceType + 1) with bit 3 set for player 1
+constexpr uint8_t CHESS_EMPTY_SQUARE = 0;
+constexpr uint8_t CHESS_PIECE_PLAYER_BIT = 8;
+// -----------------------------------------------------------------------------
+constexpr uint8_t CASTLE_WHITE_KINGSIDE = 1 << 0;
+constexpr uint8_t CASTLE_WHITE_QUEENSIDE = 1 << 1;
+constexpr uint8_t CASTLE_BLACK_KINGSIDE = 1 << 2;
+constexpr uint8_t CASTLE_BLACK_QUEENSIDE = 1 << 3;
+constexpr uint8_t CASTLE_ALL = CASTLE_WHITE_KINGSIDE | CASTLE_WHITE_QUEENSIDE | CASTLE_BLACK_KINGSIDE | CASTLE_BLACK_QUEENSIDE;
+// -----------------------------------------------------------------------------
+constexpr uint8_t CHESS_MOVE_FLAG_CAPTURE = 1 << 0;
+constexpr uint8_t CHESS_MOVE_FLAG_DOUBLE_PUSH = 1 << 1;
+constexpr uint8_t CHESS_MOVE_FLAG_ENPASSANT = 1 << 2;
+constexpr uint8_t CHESS_MOVE_FLAG_CASTLE = 1 << 3;
+constexpr uint8_t CHESS_MOVE_FLAG_PROMOTION = 1 << 4;
+// -----------------------------------------------------------------------------
+inline uint8_t MakeChessPieceCode(ChessPieceType pieceType, int playerIndex)
+{
+	return static_cast<uint8_t>((static_cast<int>(pieceType) + 1) | (playerIndex == 0 ? 0 : CHESS_PIECE_PLAYER_BIT));
+}
+
+inline ChessPieceType GetChessPieceTypeForCode(uint8_t pieceCode)
+{
+	return static_cast<ChessPieceType>((pieceCode & 7) - 1);
+}
+
+inline int GetPlayerIndexForCode(uint8_t pieceCode)
+{
+	return (pieceCode & CHESS_PIECE_PLAYER_BIT) ? 1 : 0;
+}
+
+inline int GetChessSquare(int x, int y)		{ return y * CHESS_BOARD_COLUMNS + x; }
+inline int GetChessSquareX(int square)		{ return square % CHESS_BOARD_COLUMNS; }
+inline int GetChessSquareY(int square)		{ return square / CHESS_BOARD_COLUMNS; }
+int			GetChessSquareForNotation(char const* notation);
+std::string GetNotationForChessSquare(int square);
+// -----------------------------------------------------------------------------
+struct ChessMove
+{
+public:
+	uint8_t m_from = 0;
+	uint8_t m_to = 0;
+	uint8_t m_promotion = 0;	// ChessPieceType + 1, or 0 when the move is not a promotion
+	uint8_t m_flags = 0;
+
+public:
+	bool IsNull() const			{ return m_from == m_to; }
+	bool IsCapture() const		{ return (m_flags & CHESS_MOVE_FLAG_CAPTURE) != 0; }
+	bool IsPromotion() const	{ return m_promotion != 0; }
+	ChessPieceType GetPromotionType() const { return static_cast<ChessPieceType>(m_promotion - 1); }
+	bool operator==(ChessMove const& other) const { return m_from == other.m_from && m_to == other.m_to && m_promotion == other.m_promotion; }
+	bool operator!=(ChessMove const& other) const { return !(*this == other); }
+
+	// Long algebraic notation used by the engines and tools, e.g. "e2e4" or "e7e8q"
+	std::string GetNotation() const;
+	std::string GetPromotionName() const;
+
+	// 16-bit form (from:6 to:6 promotion:3); flags are not kept and are recovered from the position
+	uint16_t		 GetPacked() const { return static_cast<uint16_t>(m_from | (m_to << 6) | (m_promotion << 12)); }
+	static ChessMove MakeFromPacked(uint16_t packedMove);
+};
+// -----------------------------------------------------------------------------
+struct ChessMoveList
+{
+public:
+	ChessMove m_moves[CHESS_MAX_MOVES];
+	int m_count = 0;
+
+public:
+	void Add(ChessMove const& move) { m_moves[m_count++] = move; }
+	int  Size() const { return m_count; }
+	ChessMove const& operator[](int index) const { return m_moves[index]; }
+	ChessMove& operator[](int index) { return m_moves[index]; }
+};
+// -----------------------------------------------------------------------------
+// ChessPosition is the render-free rules state used by the engines, tools and the match shadow copy.
+// It is small and trivially copyable, so searches use copy-make instead of unmake.
+// -----------------------------------------------------------------------------
+class ChessPosition
+{
+public:
+	static ChessPosition GetStartingPosition();
+	void Clear();
+
+	// FEN/SAN text forms. Parsing works in place on the caller's buffer; out_end points past the
+	// last FEN field consumed so EPD operations can be read from there.
+	bool		SetFromFEN(char const* fen, char const** out_end = nullptr);
+	std::string GetFEN() const;
+	bool		FindMoveForSAN(std::string_view san, ChessMove& out_move) const;
+	std::string GetSANForMove(ChessMove const& move) const;		// Move must be legal here
+
+	// Board access
+	uint8_t GetPieceAt(int square) const { return m_squares[square]; }
+	void	SetPieceAt(int square, uint8_t pieceCode);
+	void	RemovePieceAt(int square);
+	int		GetKingSquare(int playerIndex) const { return m_kingSquares[playerIndex]; }
+	int		GetSideToMove() const { return m_sideToMove; }
+	uint64_t GetHash() const { return m_hash; }
+	int		CountPieces(ChessPieceType pieceType, int playerIndex) const;
+	int		CountAllPieces() const;
+
+	// Move generation
+	void GeneratePseudoLegalMoves(ChessMoveList& out_moves) const;
+	void GenerateLegalMoves(ChessMoveList& out_moves) const;
+	void GenerateLegalCaptures(ChessMoveList& out_moves) const;
+	bool IsLegalMove(ChessMove const& move) const;
+	bool HasLegalMove() const;
+	bool FindPseudoLegalMove(int fromSquare, int toSquare, ChessPieceType promotionType, ChessMove& out_move) const;
+
+	// Making moves
+	void MakeMove(ChessMove const& move);
+	void MakeNullMove();
+
+	// Attacks and game state
+	bool IsSquareAttacked(int square, int byPlayerIndex) const;
+	bool IsInCheck(int playerIndex) const;
+	bool IsCheckmate() const;
+	bool IsStalemate() const;
+	bool IsInsufficientMaterial() const;
+	uint64_t ComputeHash() const;
+	void RefreshDerivedState();
+
+public:
+	uint8_t  m_squares[CHESS_BOARD_SIZE] = {};
+	int		 m_sideToMove = 0;
+	uint8_t  m_castlingRights = 0;
+	int		 m_enpassantSquare = CHESS_NO_SQUARE;
+	int		 m_halfmoveClock = 0;
+	int		 m_fullmoveNumber = 1;
+	int		 m_kingSquares[CHESS_NUM_PLAYERS] = { CHESS_NO_SQUARE, CHESS_NO_SQUARE };
+	uint64_t m_hash = 0;
+
+private:
+	void AddPawnMoves(int fromSquare, ChessMoveList& out_moves) const;
+	void AddStepMoves(int fromSquare, int const (*offsets)[2], int numOffsets, ChessMoveList& out_moves) const;
+	void AddSlidingMoves(int fromSquare, int const (*directions)[2], int numDirections, ChessMoveList& out_moves) const;
+	void AddCastlingMoves(int fromSquare, ChessMoveList& out_moves) const;
+};
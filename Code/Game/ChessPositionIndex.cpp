@@ -0,0 +1,342 @@
+#include "Game/ChessPositionIndex.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// -----------------------------------------------------------------------------
+constexpr uint8_t  POSITION_INDEX_MAGIC[4] = { 'C', '3', 'P', 'I' };
+constexpr uint16_t POSITION_INDEX_VERSION = 1;
+constexpr size_t   POSITION_INDEX_HEADER_SIZE = 32;
+constexpr size_t   POSITION_INDEX_ENTRY_SIZE = 16;
+constexpr size_t   POSITION_INDEX_GAME_SIZE = 24;
+constexpr int	   POSITION_INDEX_MAX_PLY = 0xFFFF;
+// -----------------------------------------------------------------------------
+static char const* const GAME_RESULTS[] = { "*", "1-0", "0-1", "1/2-1/2" };
+// -----------------------------------------------------------------------------
+
+struct ChessPositionIndexEntry
+{
+public:
+	bool operator<(ChessPositionIndexEntry const& other) const
+	{
+		if (m_hash != other.m_hash)			  return m_hash < other.m_hash;
+		if (m_gameIndex != other.m_gameIndex) return m_gameIndex < other.m_gameIndex;
+		return m_ply < other.m_ply;
+	}
+
+public:
+	uint64_t m_hash = 0;
+	uint32_t m_gameIndex = 0;
+	uint16_t m_ply = 0;
+	uint16_t m_nextMove = 0;		// ChessMove::GetPacked(), 0 when the game ended here
+};
+
+struct ChessPositionIndexGame
+{
+public:
+	uint32_t m_fileIndex = 0;
+	uint32_t m_gameNumber = 1;
+	uint64_t m_fileOffset = 0;
+	uint32_t m_numPlies = 0;
+	uint8_t  m_result = 0;
+	bool	 m_isFromArchive = false;
+};
+
+static uint8_t GetResultCode(std::string const& result)
+{
+	for (uint8_t resultCode = 1; resultCode < 4; ++resultCode)
+	{
+		if (result == GAME_RESULTS[resultCode])
+		{
+			return resultCode;
+		}
+	}
+	return 0;
+}
+
+static void AppendLittleEndian(std::vector<uint8_t>& bytes, uint64_t value, int numBytes)
+{
+	for (int byteIndex = 0; byteIndex < numBytes; ++byteIndex)
+	{
+		bytes.push_back(static_cast<uint8_t>(value >> (8 * byteIndex)));
+	}
+}
+
+// -----------------------------------------------------------------------------
+bool ChessPositionIndex::Open(std::string const& filePath)
+{
+	Close();
+	if (!m_file.Open(filePath))
+	{
+		return false;
+	}
+
+	uint8_t const* data = m_file.GetData();
+	size_t fileSize = m_file.GetSize();
+	if (fileSize < POSITION_INDEX_HEADER_SIZE || !std::equal(POSITION_INDEX_MAGIC, POSITION_INDEX_MAGIC + 4, data) || ReadLittleEndian16(data + 4) != POSITION_INDEX_VERSION)
+	{
+		Close();
+		return false;
+	}
+	m_numEntries = ReadLittleEndian64(data + 8);
+	m_numGames = ReadLittleEndian32(data + 16);
+	uint32_t numSourceFiles = ReadLittleEndian32(data + 20);
+	m_gameTableOffset = ReadLittleEndian64(data + 24);
+
+	// The sizes have to add up before anything is read through them
+	uint64_t fileTableOffset = m_gameTableOffset + static_cast<uint64_t>(m_numGames) * POSITION_INDEX_GAME_SIZE;
+	if (m_gameTableOffset != POSITION_INDEX_HEADER_SIZE + m_numEntries * POSITION_INDEX_ENTRY_SIZE || fileTableOffset > fileSize)
+	{
+		Close();
+		return false;
+	}
+
+	size_t cursor = static_cast<size_t>(fileTableOffset);
+	m_sourceFilePaths.reserve(numSourceFiles);
+	for (uint32_t fileIndex = 0; fileIndex < numSourceFiles; ++fileIndex)
+	{
+		size_t length = (cursor + 2 <= fileSize) ? ReadLittleEndian16(data + cursor) : fileSize;
+		if (cursor + 2 + length > fileSize)
+		{
+			Close();
+			return false;
+		}
+		m_sourceFilePaths.emplace_back(reinterpret_cast<char const*>(data + cursor + 2), length);
+		cursor += 2 + length;
+	}
+	return true;
+}
+
+void ChessPositionIndex::Close()
+{
+	m_file.Close();
+	m_numEntries = 0;
+	m_numGames = 0;
+	m_gameTableOffset = 0;
+	m_sourceFilePaths.clear();
+}
+
+uint64_t ChessPositionIndex::FindPosition(uint64_t hash, uint64_t& out_firstEntryIndex) const
+{
+	// Lower and upper bound over the sorted hashes, reading the mapped entries in place
+	uint64_t low = 0;
+	uint64_t high = m_numEntries;
+	while (low < high)
+	{
+		uint64_t middle = low + (high - low) / 2;
+		if (ReadLittleEndian64(GetEntryData(middle)) < hash)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	out_firstEntryIndex = low;
+
+	high = m_numEntries;
+	while (low < high)
+	{
+		uint64_t middle = low + (high - low) / 2;
+		if (ReadLittleEndian64(GetEntryData(middle)) <= hash)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low - out_firstEntryIndex;
+}
+
+ChessPositionIndexHit ChessPositionIndex::GetHit(uint64_t entryIndex) const
+{
+	uint8_t const* entryData = GetEntryData(entryIndex);
+	ChessPositionIndexHit hit;
+	hit.m_gameIndex = ReadLittleEndian32(entryData + 8);
+	hit.m_ply = ReadLittleEndian16(entryData + 12);
+	hit.m_nextMove = ChessMove::MakeFromPacked(ReadLittleEndian16(entryData + 14));
+	return hit;
+}
+
+bool ChessPositionIndex::GetGame(uint32_t gameIndex, ChessIndexedGame& out_game) const
+{
+	if (gameIndex >= m_numGames)
+	{
+		return false;
+	}
+
+	uint8_t const* gameData = GetGameData(gameIndex);
+	uint32_t fileIndex = ReadLittleEndian32(gameData);
+	out_game.m_filePath = (fileIndex < m_sourceFilePaths.size()) ? m_sourceFilePaths[fileIndex] : "?";
+	out_game.m_gameNumber = static_cast<int>(ReadLittleEndian32(gameData + 4));
+	out_game.m_fileOffset = ReadLittleEndian64(gameData + 8);
+	out_game.m_numPlies = static_cast<int>(ReadLittleEndian32(gameData + 16));
+	out_game.m_result = GetGameResult(gameIndex);
+	return true;
+}
+
+char const* ChessPositionIndex::GetGameResult(uint32_t gameIndex) const
+{
+	uint8_t resultCode = (gameIndex < m_numGames) ? GetGameData(gameIndex)[20] : 0;
+	return GAME_RESULTS[(resultCode < 4) ? resultCode : 0];
+}
+
+uint8_t const* ChessPositionIndex::GetEntryData(uint64_t entryIndex) const
+{
+	return m_file.GetData() + POSITION_INDEX_HEADER_SIZE + entryIndex * POSITION_INDEX_ENTRY_SIZE;
+}
+
+uint8_t const* ChessPositionIndex::GetGameData(uint32_t gameIndex) const
+{
+	return m_file.GetData() + m_gameTableOffset + static_cast<uint64_t>(gameIndex) * POSITION_INDEX_GAME_SIZE;
+}
+
+// -----------------------------------------------------------------------------
+bool ChessPositionIndex::Build(std::vector<std::string> const& inputPaths, std::string const& outputFilePath, int numThreads, ChessPositionIndexBuildStats& out_stats)
+{
+	auto startTime = std::chrono::steady_clock::now();
+	numThreads = (numThreads > 0) ? numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	std::vector<std::string> sourceFilePaths = ChessSavedGameReader::FindGameFiles(inputPaths);
+	std::unordered_map<std::string, uint32_t> sourceFileIndices;
+	for (uint32_t fileIndex = 0; fileIndex < sourceFilePaths.size(); ++fileIndex)
+	{
+		sourceFileIndices[sourceFilePaths[fileIndex]] = fileIndex;
+	}
+
+	// Each worker collects the entries of the games it replays; only the game table is shared
+	std::vector<ChessPositionIndexGame> games;
+	std::mutex gamesMutex;
+	std::vector<std::vector<ChessPositionIndexEntry>> workerEntries(numThreads);
+	out_stats.m_readStats = ChessSavedGameReader::ReadAllGames(sourceFilePaths, numThreads, [&](ChessSavedGame const& savedGame, int workerIndex)
+	{
+		// Files that held no readable game add nothing; a game that goes wrong part way keeps the positions before it
+		if (savedGame.m_moves.empty() && !savedGame.IsValid())
+		{
+			return;
+		}
+
+		ChessPositionIndexGame game;
+		game.m_fileIndex = sourceFileIndices[savedGame.m_filePath];
+		game.m_fileOffset = savedGame.m_fileOffset;
+		game.m_numPlies = static_cast<uint32_t>(savedGame.m_moves.size());
+		game.m_result = GetResultCode(savedGame.m_result);
+		game.m_isFromArchive = savedGame.m_format == ChessSavedGameFormat::PGN || savedGame.m_format == ChessSavedGameFormat::ARCHIVE;
+		uint32_t gameIndex = 0;
+		{
+			std::lock_guard<std::mutex> gamesLock(gamesMutex);
+			gameIndex = static_cast<uint32_t>(games.size());
+			games.push_back(game);
+		}
+
+		std::vector<ChessPositionIndexEntry>& entries = workerEntries[workerIndex];
+		ChessPosition position = savedGame.m_startPosition;
+		int numIndexedPlies = std::min(static_cast<int>(savedGame.m_moves.size()), POSITION_INDEX_MAX_PLY);
+		for (int ply = 0; ply <= numIndexedPlies; ++ply)
+		{
+			ChessPositionIndexEntry entry;
+			entry.m_hash = position.GetHash();
+			entry.m_gameIndex = gameIndex;
+			entry.m_ply = static_cast<uint16_t>(ply);
+			if (ply < static_cast<int>(savedGame.m_moves.size()))
+			{
+				entry.m_nextMove = savedGame.m_moves[ply].GetPacked();
+				position.MakeMove(savedGame.m_moves[ply]);
+			}
+			entries.push_back(entry);
+		}
+	});
+
+	// Archives are read in parallel and hand games over out of order, so their games are numbered by where they start
+	std::vector<uint32_t> archiveGameIndices;
+	for (uint32_t gameIndex = 0; gameIndex < games.size(); ++gameIndex)
+	{
+		if (games[gameIndex].m_isFromArchive)
+		{
+			archiveGameIndices.push_back(gameIndex);
+		}
+	}
+	std::sort(archiveGameIndices.begin(), archiveGameIndices.end(), [&](uint32_t gameIndexA, uint32_t gameIndexB)
+	{
+		ChessPositionIndexGame const& gameA = games[gameIndexA];
+		ChessPositionIndexGame const& gameB = games[gameIndexB];
+		return (gameA.m_fileIndex != gameB.m_fileIndex) ? gameA.m_fileIndex < gameB.m_fileIndex : gameA.m_fileOffset < gameB.m_fileOffset;
+	});
+	for (size_t sortedIndex = 0; sortedIndex < archiveGameIndices.size(); ++sortedIndex)
+	{
+		ChessPositionIndexGame& game = games[archiveGameIndices[sortedIndex]];
+		bool isFirstInFile = sortedIndex == 0 || games[archiveGameIndices[sortedIndex - 1]].m_fileIndex != game.m_fileIndex;
+		game.m_gameNumber = isFirstInFile ? 1 : games[archiveGameIndices[sortedIndex - 1]].m_gameNumber + 1;
+	}
+
+	std::vector<ChessPositionIndexEntry> entries;
+	size_t numEntries = 0;
+	for (std::vector<ChessPositionIndexEntry> const& workerEntryList : workerEntries)
+	{
+		numEntries += workerEntryList.size();
+	}
+	entries.reserve(numEntries);
+	for (std::vector<ChessPositionIndexEntry>& workerEntryList : workerEntries)
+	{
+		entries.insert(entries.end(), workerEntryList.begin(), workerEntryList.end());
+		std::vector<ChessPositionIndexEntry>().swap(workerEntryList);
+	}
+	std::sort(entries.begin(), entries.end());
+
+	std::ofstream file(outputFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> bytes(POSITION_INDEX_MAGIC, POSITION_INDEX_MAGIC + 4);
+	AppendLittleEndian(bytes, POSITION_INDEX_VERSION, 2);
+	AppendLittleEndian(bytes, 0, 2);
+	AppendLittleEndian(bytes, entries.size(), 8);
+	AppendLittleEndian(bytes, games.size(), 4);
+	AppendLittleEndian(bytes, sourceFilePaths.size(), 4);
+	AppendLittleEndian(bytes, POSITION_INDEX_HEADER_SIZE + entries.size() * POSITION_INDEX_ENTRY_SIZE, 8);
+
+	// Entries go out in batches so the byte buffer stays small however large the archive is
+	constexpr size_t WRITE_BATCH_BYTES = 1 << 20;
+	for (ChessPositionIndexEntry const& entry : entries)
+	{
+		AppendLittleEndian(bytes, entry.m_hash, 8);
+		AppendLittleEndian(bytes, entry.m_gameIndex, 4);
+		AppendLittleEndian(bytes, entry.m_ply, 2);
+		AppendLittleEndian(bytes, entry.m_nextMove, 2);
+		if (bytes.size() >= WRITE_BATCH_BYTES)
+		{
+			file.write(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+			out_stats.m_numBytes += bytes.size();
+			bytes.clear();
+		}
+	}
+	for (ChessPositionIndexGame const& game : games)
+	{
+		AppendLittleEndian(bytes, game.m_fileIndex, 4);
+		AppendLittleEndian(bytes, game.m_gameNumber, 4);
+		AppendLittleEndian(bytes, game.m_fileOffset, 8);
+		AppendLittleEndian(bytes, game.m_numPlies, 4);
+		AppendLittleEndian(bytes, game.m_result, 1);
+		AppendLittleEndian(bytes, 0, 3);
+	}
+	for (std::string const& sourceFilePath : sourceFilePaths)
+	{
+		size_t length = std::min<size_t>(sourceFilePath.size(), 0xFFFF);
+		AppendLittleEndian(bytes, length, 2);
+		bytes.insert(bytes.end(), sourceFilePath.begin(), sourceFilePath.begin() + length);
+	}
+	file.write(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+	out_stats.m_numBytes += bytes.size();
+
+	out_stats.m_numPositions = entries.size();
+	out_stats.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return file.good();
+}
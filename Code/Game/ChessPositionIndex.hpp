@@ -0,0 +1,74 @@
+#pragma once
+#include "Game/ChessMappedFile.hpp"
+#include "Game/ChessPosition.hpp"
+#include "Game/ChessSavedGameReader.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+struct ChessPositionIndexHit
+{
+public:
+	bool HasNextMove() const { return m_nextMove.m_from != m_nextMove.m_to; }
+
+public:
+	uint32_t  m_gameIndex = 0;
+	int		  m_ply = 0;		// Plies played when the position was reached
+	ChessMove m_nextMove;		// What was played from it; no move when the game ended there
+};
+// -----------------------------------------------------------------------------
+struct ChessIndexedGame
+{
+public:
+	std::string m_filePath;
+	int			m_gameNumber = 1;		// 1-based position in a PGN archive, as LoadGame game=N counts
+	uint64_t	m_fileOffset = 0;
+	int			m_numPlies = 0;
+	char const* m_result = "*";
+};
+// -----------------------------------------------------------------------------
+struct ChessPositionIndexBuildStats
+{
+public:
+	ChessSavedGameReadStats m_readStats;
+	uint64_t m_numPositions = 0;
+	uint64_t m_numBytes = 0;
+	double	 m_seconds = 0.0;
+};
+// -----------------------------------------------------------------------------
+// Every position reached in a set of saved games and PGN archives, sorted by Zobrist hash into
+// 16-byte entries (hash, game, ply, next move). The file is memory mapped and searched in place,
+// so a lookup is two binary searches over the mapped entries and nothing is loaded up front.
+// A game table and the source file names follow the entries.
+// -----------------------------------------------------------------------------
+class ChessPositionIndex
+{
+public:
+	bool Open(std::string const& filePath);
+	void Close();
+	bool IsOpen() const { return m_file.IsOpen(); }
+
+	std::string const& GetFilePath() const { return m_file.GetFilePath(); }
+	uint64_t		   GetNumPositions() const { return m_numEntries; }
+	uint32_t		   GetNumGames() const { return m_numGames; }
+
+	// Returns how many entries hold the hash; they are consecutive from out_firstEntryIndex, ordered by game and ply
+	uint64_t			  FindPosition(uint64_t hash, uint64_t& out_firstEntryIndex) const;
+	ChessPositionIndexHit GetHit(uint64_t entryIndex) const;
+	bool				  GetGame(uint32_t gameIndex, ChessIndexedGame& out_game) const;
+	char const*			  GetGameResult(uint32_t gameIndex) const;
+
+	// Replays every game found under the input files and directories on a pool of threads, then sorts and writes the index
+	static bool Build(std::vector<std::string> const& inputPaths, std::string const& outputFilePath, int numThreads, ChessPositionIndexBuildStats& out_stats);
+
+private:
+	uint8_t const* GetEntryData(uint64_t entryIndex) const;
+	uint8_t const* GetGameData(uint32_t gameIndex) const;
+
+private:
+	ChessMappedFile			 m_file;
+	uint64_t				 m_numEntries = 0;
+	uint32_t				 m_numGames = 0;
+	uint64_t				 m_gameTableOffset = 0;
+	std::vector<std::string> m_sourceFilePaths;
+};
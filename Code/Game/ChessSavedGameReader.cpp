@@ -0,0 +1,368 @@
+#include "Game/ChessSavedGameReader.hpp"
+#include "Game/ChessGameArchive.hpp"
+#include "Game/ChessGameLog.hpp"
+#include "Game/ChessPGN.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+bool ParseChessMoveCommand(std::string const& moveCommand, ChessMove& out_move, bool& out_isTeleport)
+{
+	size_t fromIndex = moveCommand.find("from=");
+	size_t toIndex = moveCommand.find(" to=");
+	if (fromIndex == std::string::npos || toIndex == std::string::npos)
+	{
+		return false;
+	}
+
+	int fromSquare = GetChessSquareForNotation(moveCommand.c_str() + fromIndex + 5);
+	int toSquare = GetChessSquareForNotation(moveCommand.c_str() + toIndex + 4);
+	if (fromSquare == CHESS_NO_SQUARE || toSquare == CHESS_NO_SQUARE)
+	{
+		return false;
+	}
+
+	out_move = ChessMove();
+	out_move.m_from = static_cast<uint8_t>(fromSquare);
+	out_move.m_to = static_cast<uint8_t>(toSquare);
+	size_t promotionIndex = moveCommand.find("promoteTo=");
+	if (promotionIndex != std::string::npos)
+	{
+		std::string promotionName = moveCommand.substr(promotionIndex + 10, moveCommand.find(' ', promotionIndex) - (promotionIndex + 10));
+		ChessPieceType promotionType = (promotionName == "rook") ? ChessPieceType::ROOK : (promotionName == "bishop") ? ChessPieceType::BISHOP :
+			(promotionName == "knight") ? ChessPieceType::KNIGHT : ChessPieceType::QUEEN;
+		out_move.m_promotion = static_cast<uint8_t>(static_cast<int>(promotionType) + 1);
+	}
+	out_isTeleport = moveCommand.find("teleport=true") != std::string::npos;
+	return true;
+}
+
+ChessSavedGameFormat GetChessSavedGameFormatForPath(std::string const& filePath)
+{
+	size_t extensionStart = filePath.find_last_of('.');
+	std::string extension = (extensionStart == std::string::npos) ? "" : filePath.substr(extensionStart);
+	if (extension == ".xml")	return ChessSavedGameFormat::XML;
+	if (extension == ".cgl")	return ChessSavedGameFormat::GAME_LOG;
+	if (extension == ".pgn")	return ChessSavedGameFormat::PGN;
+	if (extension == ".cga")	return ChessSavedGameFormat::ARCHIVE;
+	return ChessSavedGameFormat::UNKNOWN;
+}
+
+// -----------------------------------------------------------------------------
+void ChessSavedGame::Reset()
+{
+	m_filePath.clear();
+	m_format = ChessSavedGameFormat::UNKNOWN;
+	m_fileOffset = 0;
+	m_playerNames[0].clear();
+	m_playerNames[1].clear();
+	m_startPosition = ChessPosition::GetStartingPosition();
+	m_moves.clear();
+	m_numRecordedMoves = 0;
+	m_result = "*";
+	m_error.clear();
+	m_wasTruncated = false;
+}
+
+// -----------------------------------------------------------------------------
+static void AddRecordedMove(ChessSavedGame& game, ChessPosition& position, ChessMove const& recordedMove, bool isTeleport)
+{
+	// Everything after the first rejected move is counted but not replayed
+	game.m_numRecordedMoves += 1;
+	if (!game.m_error.empty())
+	{
+		return;
+	}
+
+	std::string plyText = " at ply " + std::to_string(game.m_moves.size() + 1);
+	if (isTeleport)
+	{
+		game.m_error = "Debug teleport " + recordedMove.GetNotation() + plyText;
+		return;
+	}
+
+	ChessMove move;
+	ChessPieceType promotionType = recordedMove.IsPromotion() ? recordedMove.GetPromotionType() : ChessPieceType::QUEEN;
+	if (!position.FindPseudoLegalMove(recordedMove.m_from, recordedMove.m_to, promotionType, move))
+	{
+		game.m_error = "Illegal move " + recordedMove.GetNotation() + plyText;
+		return;
+	}
+	if (!position.IsLegalMove(move))
+	{
+		game.m_error = "Illegal move " + recordedMove.GetNotation() + plyText + ", it leaves the king in check";
+		return;
+	}
+	position.MakeMove(move);
+	game.m_moves.push_back(move);
+}
+
+static void ReadXmlGame(ChessSavedGame& out_game)
+{
+	XmlDocument xmlDocument;
+	XmlElement* root = (xmlDocument.LoadFile(out_game.m_filePath.c_str()) == tinyxml2::XML_SUCCESS) ? xmlDocument.RootElement() : nullptr;
+	if (root == nullptr)
+	{
+		out_game.m_error = "The XML doesn't parse";
+		out_game.m_wasTruncated = true;
+		return;
+	}
+
+	char const* startFEN = root->Attribute("startFEN");
+	if (startFEN != nullptr && !out_game.m_startPosition.SetFromFEN(startFEN))
+	{
+		out_game.m_error = "Unreadable startFEN \"" + std::string(startFEN) + "\"";
+		return;
+	}
+
+	ChessPosition position = out_game.m_startPosition;
+	std::string moveCommand;
+	for (XmlElement* moveElement = root->FirstChildElement("Move"); moveElement != nullptr; moveElement = moveElement->NextSiblingElement("Move"))
+	{
+		ChessMove recordedMove;
+		bool isTeleport = false;
+		char const* moveText = moveElement->GetText();
+		moveCommand = (moveText != nullptr) ? moveText : "";
+		if (!ParseChessMoveCommand(moveCommand, recordedMove, isTeleport))
+		{
+			out_game.m_numRecordedMoves += 1;
+			if (out_game.m_error.empty())
+			{
+				out_game.m_error = "Unreadable move \"" + moveCommand + "\" at ply " + std::to_string(out_game.m_moves.size() + 1);
+			}
+			continue;
+		}
+		AddRecordedMove(out_game, position, recordedMove, isTeleport);
+	}
+	if (out_game.IsValid())
+	{
+		out_game.m_result = ChessSavedGameReader::GetResultForPosition(position);
+	}
+}
+
+static void ReadGameLogGame(ChessSavedGame& out_game)
+{
+	ChessGameLogHeader header;
+	std::vector<uint16_t> loggedMoves;
+	if (!ChessGameLog::ReadFile(out_game.m_filePath, header, loggedMoves, out_game.m_wasTruncated))
+	{
+		out_game.m_error = "The game log header is missing or damaged";
+		out_game.m_wasTruncated = true;
+		return;
+	}
+	out_game.m_playerNames[0] = header.m_playerNames[0];
+	out_game.m_playerNames[1] = header.m_playerNames[1];
+	if (!header.m_startFEN.empty() && !out_game.m_startPosition.SetFromFEN(header.m_startFEN.c_str()))
+	{
+		out_game.m_error = "Unreadable start FEN \"" + header.m_startFEN + "\"";
+		return;
+	}
+
+	ChessPosition position = out_game.m_startPosition;
+	out_game.m_moves.reserve(loggedMoves.size());
+	for (uint16_t loggedMove : loggedMoves)
+	{
+		AddRecordedMove(out_game, position, ChessMove::MakeFromPacked(loggedMove & ~CHESS_LOG_TELEPORT_BIT), (loggedMove & CHESS_LOG_TELEPORT_BIT) != 0);
+	}
+	if (out_game.IsValid())
+	{
+		out_game.m_result = ChessSavedGameReader::GetResultForPosition(position);
+	}
+}
+
+static void AddGameToStats(ChessSavedGame const& game, ChessSavedGameReadStats& out_stats)
+{
+	out_stats.m_numGames += 1;
+	out_stats.m_numInvalidGames += game.IsValid() ? 0 : 1;
+	out_stats.m_numTruncatedGames += game.m_wasTruncated ? 1 : 0;
+	out_stats.m_numMoves += game.m_moves.size();
+}
+
+// -----------------------------------------------------------------------------
+std::vector<std::string> ChessSavedGameReader::FindGameFiles(std::vector<std::string> const& paths)
+{
+	std::vector<std::string> filePaths;
+	for (std::string const& path : paths)
+	{
+		std::error_code errorCode;
+		if (!std::filesystem::is_directory(path, errorCode))
+		{
+			filePaths.push_back(path);
+			continue;
+		}
+
+		// Directory order is up to the file system, so the files found are sorted
+		size_t firstFoundIndex = filePaths.size();
+		for (std::filesystem::directory_entry const& entry : std::filesystem::recursive_directory_iterator(path, errorCode))
+		{
+			std::string filePath = entry.path().generic_string();
+			if (entry.is_regular_file(errorCode) && GetChessSavedGameFormatForPath(filePath) != ChessSavedGameFormat::UNKNOWN)
+			{
+				filePaths.push_back(filePath);
+			}
+		}
+		std::sort(filePaths.begin() + firstFoundIndex, filePaths.end());
+	}
+	return filePaths;
+}
+
+bool ChessSavedGameReader::ReadGameFile(std::string const& filePath, ChessSavedGame& out_game)
+{
+	out_game.Reset();
+	out_game.m_filePath = filePath;
+	out_game.m_format = GetChessSavedGameFormatForPath(filePath);
+	if (out_game.m_format == ChessSavedGameFormat::XML)
+	{
+		ReadXmlGame(out_game);
+		return true;
+	}
+	if (out_game.m_format == ChessSavedGameFormat::GAME_LOG)
+	{
+		ReadGameLogGame(out_game);
+		return true;
+	}
+	return false;
+}
+
+std::string ChessSavedGameReader::GetResultForPosition(ChessPosition const& position)
+{
+	if (position.IsCheckmate())
+	{
+		return (position.GetSideToMove() == 0) ? "0-1" : "1-0";
+	}
+	if (position.IsStalemate() || position.IsInsufficientMaterial())
+	{
+		return "1/2-1/2";
+	}
+	return "*";
+}
+
+ChessSavedGameReadStats ChessSavedGameReader::ReadAllGames(std::vector<std::string> const& filePaths, int numThreads, ChessSavedGameCallback const& callback)
+{
+	numThreads = (numThreads > 0) ? numThreads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<std::string> matchFilePaths;
+	std::vector<std::string> archiveFilePaths;
+	std::vector<std::string> gameArchiveFilePaths;
+	for (std::string const& filePath : filePaths)
+	{
+		ChessSavedGameFormat format = GetChessSavedGameFormatForPath(filePath);
+		(format == ChessSavedGameFormat::PGN ? archiveFilePaths : format == ChessSavedGameFormat::ARCHIVE ? gameArchiveFilePaths : matchFilePaths).push_back(filePath);
+	}
+
+	// Saved matches, a file at a time per worker
+	std::vector<ChessSavedGameReadStats> workerStats(numThreads);
+	std::atomic<size_t> nextFileIndex = 0;
+	std::vector<std::thread> workers;
+	for (int workerIndex = 0; workerIndex < numThreads; ++workerIndex)
+	{
+		workers.emplace_back([&, workerIndex]()
+		{
+			ChessSavedGame game;
+			for (size_t fileIndex = nextFileIndex++; fileIndex < matchFilePaths.size(); fileIndex = nextFileIndex++)
+			{
+				if (!ReadGameFile(matchFilePaths[fileIndex], game))
+				{
+					game.m_error = "Not a saved game format";
+				}
+				AddGameToStats(game, workerStats[workerIndex]);
+				callback(game, workerIndex);
+			}
+		});
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	// PGN archives, each split between all the workers
+	std::vector<ChessSavedGame> workerGames(numThreads);
+	for (std::string const& archiveFilePath : archiveFilePaths)
+	{
+		ChessPGNReader reader;
+		if (!reader.Open(archiveFilePath))
+		{
+			ChessSavedGame& game = workerGames[0];
+			game.Reset();
+			game.m_filePath = archiveFilePath;
+			game.m_format = ChessSavedGameFormat::PGN;
+			game.m_error = "Can't open the archive";
+			AddGameToStats(game, workerStats[0]);
+			callback(game, 0);
+			continue;
+		}
+
+		reader.ReadAllGames(numThreads, [&](ChessPGNGame const& pgnGame, int workerIndex)
+		{
+			ChessSavedGame& game = workerGames[workerIndex];
+			game.Reset();
+			game.m_filePath = archiveFilePath;
+			game.m_format = ChessSavedGameFormat::PGN;
+			game.m_fileOffset = pgnGame.m_fileOffset;
+			game.m_playerNames[0] = pgnGame.GetTag("White", "");
+			game.m_playerNames[1] = pgnGame.GetTag("Black", "");
+			game.m_startPosition = pgnGame.m_startPosition;
+			game.m_moves = pgnGame.m_moves;
+			game.m_numRecordedMoves = static_cast<int>(pgnGame.m_moves.size()) + (pgnGame.IsValid() ? 0 : 1);
+			game.m_result = pgnGame.m_result;
+			game.m_error = pgnGame.m_error;
+			AddGameToStats(game, workerStats[workerIndex]);
+			callback(game, workerIndex);
+		});
+	}
+
+	// Game archives decode any game on its own, so the workers share each one out game by game
+	for (std::string const& gameArchiveFilePath : gameArchiveFilePaths)
+	{
+		ChessGameArchive gameArchive;
+		if (!gameArchive.Open(gameArchiveFilePath))
+		{
+			ChessSavedGame& game = workerGames[0];
+			game.Reset();
+			game.m_filePath = gameArchiveFilePath;
+			game.m_format = ChessSavedGameFormat::ARCHIVE;
+			game.m_error = "Can't open the archive";
+			game.m_wasTruncated = true;
+			AddGameToStats(game, workerStats[0]);
+			callback(game, 0);
+			continue;
+		}
+
+		std::atomic<uint32_t> nextGameIndex = 0;
+		workers.clear();
+		for (int workerIndex = 0; workerIndex < numThreads; ++workerIndex)
+		{
+			workers.emplace_back([&, workerIndex]()
+			{
+				ChessSavedGame& game = workerGames[workerIndex];
+				for (uint32_t gameIndex = nextGameIndex++; gameIndex < gameArchive.GetNumGames(); gameIndex = nextGameIndex++)
+				{
+					gameArchive.ReadGame(gameIndex, game);
+					AddGameToStats(game, workerStats[workerIndex]);
+					callback(game, workerIndex);
+				}
+			});
+		}
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	ChessSavedGameReadStats stats;
+	for (ChessSavedGameReadStats const& workerStat : workerStats)
+	{
+		stats.m_numGames += workerStat.m_numGames;
+		stats.m_numInvalidGames += workerStat.m_numInvalidGames;
+		stats.m_numTruncatedGames += workerStat.m_numTruncatedGames;
+		stats.m_numMoves += workerStat.m_numMoves;
+	}
+	stats.m_numFiles = filePaths.size();
+	stats.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return stats;
+}
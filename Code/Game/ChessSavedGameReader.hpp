@@ -0,0 +1,71 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+// Recorded match moves are the console commands, e.g. "ChessMove from=e7 to=e8 promoteTo=queen",
+// with teleport=true for the board's debug moves
+bool ParseChessMoveCommand(std::string const& moveCommand, ChessMove& out_move, bool& out_isTeleport);
+// -----------------------------------------------------------------------------
+enum class ChessSavedGameFormat
+{
+	UNKNOWN,
+	XML,		// SaveGameToXmlFile
+	GAME_LOG,	// .cgl binary game log and match journal
+	PGN,
+	ARCHIVE		// .cga range-coded archive of finished games
+};
+ChessSavedGameFormat GetChessSavedGameFormatForPath(std::string const& filePath);
+// -----------------------------------------------------------------------------
+struct ChessSavedGame
+{
+public:
+	void Reset();		// Keeps the buffers' capacity, so one game object serves a whole archive
+	bool IsValid() const { return m_error.empty(); }
+
+public:
+	std::string			   m_filePath;
+	ChessSavedGameFormat   m_format = ChessSavedGameFormat::UNKNOWN;
+	uint64_t			   m_fileOffset = 0;		// Byte offset of the game in a PGN or .cga archive
+	std::string			   m_playerNames[2];		// When the format keeps them
+	ChessPosition		   m_startPosition;
+	std::vector<ChessMove> m_moves;					// Every move up to the first one the rules reject
+	int					   m_numRecordedMoves = 0;	// Including any that follow a rejected move
+	std::string			   m_result = "*";			// PGN's recorded result; for matches the result the final position decides
+	std::string			   m_error;					// First illegal move or unreadable record; empty when the whole game replays
+	bool				   m_wasTruncated = false;	// The file ends part way through a record, or doesn't parse at all
+};
+// -----------------------------------------------------------------------------
+struct ChessSavedGameReadStats
+{
+public:
+	uint64_t m_numFiles = 0;
+	uint64_t m_numGames = 0;
+	uint64_t m_numInvalidGames = 0;
+	uint64_t m_numTruncatedGames = 0;
+	uint64_t m_numMoves = 0;
+	double	 m_seconds = 0.0;
+};
+// Called once per game, valid or not, from the reader's worker threads at the same time
+typedef std::function<void(ChessSavedGame const& game, int workerIndex)> ChessSavedGameCallback;
+// -----------------------------------------------------------------------------
+// Reads every format the game saves in without a ChessBoard: each move is replayed on a
+// ChessPosition and checked by the move generator. Saved matches are one game per file and are
+// shared out to the workers file by file; PGN archives go through the parallel PGN reader.
+// -----------------------------------------------------------------------------
+class ChessSavedGameReader
+{
+public:
+	// Files and directories, searched recursively for .xml, .cgl, .pgn and .cga files, in a stable order
+	static std::vector<std::string> FindGameFiles(std::vector<std::string> const& paths);
+
+	// One saved match (.xml or .cgl); false only when the format isn't one of those
+	static bool ReadGameFile(std::string const& filePath, ChessSavedGame& out_game);
+
+	// The result the board would end the game with in this position: mate, stalemate or dead material, else "*"
+	static std::string GetResultForPosition(ChessPosition const& position);
+
+	static ChessSavedGameReadStats ReadAllGames(std::vector<std::string> const& filePaths, int numThreads, ChessSavedGameCallback const& callback);
+};
@@ -0,0 +1,389 @@
+#include "Game/ChessSelfPlay.hpp"
+#include "Game/ChessAlphaBetaEngine.hpp"
+#include "Game/ChessTablebase.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <thread>
+
+// -----------------------------------------------------------------------------
+constexpr int SELFPLAY_STANDINGS_INTERVAL = 100;		// Games between progress lines
+// -----------------------------------------------------------------------------
+
+char const* GetChessSelfPlayTerminationName(ChessSelfPlayTermination termination)
+{
+	switch (termination)
+	{
+		case ChessSelfPlayTermination::CHECKMATE:				return "checkmate";
+		case ChessSelfPlayTermination::STALEMATE:				return "stalemate";
+		case ChessSelfPlayTermination::REPETITION:				return "repetition";
+		case ChessSelfPlayTermination::FIFTY_MOVES:				return "fifty-moves";
+		case ChessSelfPlayTermination::INSUFFICIENT_MATERIAL:	return "insufficient-material";
+		case ChessSelfPlayTermination::TABLEBASE:				return "tablebase";
+		case ChessSelfPlayTermination::MAX_PLIES:				return "max-plies";
+		case ChessSelfPlayTermination::TIME_FORFEIT:			return "time-forfeit";
+		default:												return "unknown";
+	}
+}
+
+static ChessEngine* CreateSelfPlayEngine(ChessSelfPlayPlayerSettings const& player)
+{
+	if (player.m_engineType == ChessEngineType::ALPHA_BETA)
+	{
+		return new ChessAlphaBetaEngine(player.m_hashSizeMB);
+	}
+	return ChessEngine::CreateEngine(player.m_engineType);
+}
+
+static void GetEloForScore(double score, double& out_elo)
+{
+	score = std::clamp(score, 0.0001, 0.9999);
+	out_elo = -400.0 * log10(1.0 / score - 1.0);
+}
+
+// -----------------------------------------------------------------------------
+ChessSelfPlayTournament::ChessSelfPlayTournament(ChessSelfPlaySettings const& settings)
+	: m_settings(settings)
+{
+	m_settings.m_numGames = std::max(2, (m_settings.m_numGames + 1) & ~1);
+	if (m_settings.m_numConcurrentGames <= 0)
+	{
+		m_settings.m_numConcurrentGames = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+	m_settings.m_numConcurrentGames = std::min(m_settings.m_numConcurrentGames, m_settings.m_numGames);
+}
+
+bool ChessSelfPlayTournament::Run()
+{
+	if (!LoadOpenings())
+	{
+		return false;
+	}
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(std::filesystem::path(m_settings.m_gamesFile).parent_path(), errorCode);
+	std::filesystem::create_directories(std::filesystem::path(m_settings.m_resultsFile).parent_path(), errorCode);
+	m_gamesFile.open(m_settings.m_gamesFile, std::ios::out | std::ios::trunc);
+	if (!m_gamesFile.is_open())
+	{
+		printf("ERROR: could not write \"%s\"\n", m_settings.m_gamesFile.c_str());
+		return false;
+	}
+
+	ChessSelfPlayPlayerSettings const& player0 = m_settings.m_players[0];
+	ChessSelfPlayPlayerSettings const& player1 = m_settings.m_players[1];
+	printf("%s (%s) vs %s (%s): %d games, %d at a time, ", player0.m_name.c_str(), GetChessEngineTypeName(player0.m_engineType),
+		player1.m_name.c_str(), GetChessEngineTypeName(player1.m_engineType), m_settings.m_numGames, m_settings.m_numConcurrentGames);
+	if (m_settings.m_moveSeconds > 0.f)
+	{
+		printf("%.3fs per move\n", m_settings.m_moveSeconds);
+	}
+	else
+	{
+		printf("%g+%g\n", m_settings.m_baseSeconds, m_settings.m_incrementSeconds);
+	}
+
+	m_startTime = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int workerIndex = 0; workerIndex < m_settings.m_numConcurrentGames; ++workerIndex)
+	{
+		workers.emplace_back(&ChessSelfPlayTournament::RunWorker, this);
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	m_gamesFile.close();
+	PrintStandings(true);
+	return true;
+}
+
+bool ChessSelfPlayTournament::LoadOpenings()
+{
+	if (m_settings.m_openingsFile.empty())
+	{
+		return true;
+	}
+
+	std::ifstream openingsFile(m_settings.m_openingsFile);
+	if (!openingsFile.is_open())
+	{
+		printf("ERROR: could not open openings file \"%s\"\n", m_settings.m_openingsFile.c_str());
+		return false;
+	}
+
+	// EPD operations after the FEN fields are ignored; positions that are already over are skipped
+	std::string line;
+	while (std::getline(openingsFile, line))
+	{
+		ChessPosition position;
+		if (!line.empty() && line[0] != '#' && position.SetFromFEN(line.c_str()) && position.HasLegalMove())
+		{
+			m_openings.push_back(position);
+		}
+	}
+	if (m_openings.empty())
+	{
+		printf("ERROR: no playable positions in \"%s\"\n", m_settings.m_openingsFile.c_str());
+		return false;
+	}
+	printf("Loaded %d openings from %s\n", static_cast<int>(m_openings.size()), m_settings.m_openingsFile.c_str());
+	return true;
+}
+
+ChessPosition ChessSelfPlayTournament::GetOpeningPosition(int openingIndex) const
+{
+	if (!m_openings.empty())
+	{
+		return m_openings[openingIndex % static_cast<int>(m_openings.size())];
+	}
+
+	// Random legal moves from the start, seeded per opening so both colour swaps get the same one
+	std::mt19937_64 random(m_settings.m_seed * 0x9E3779B97F4A7C15ull + static_cast<uint64_t>(openingIndex));
+	for (;;)
+	{
+		ChessPosition position = ChessPosition::GetStartingPosition();
+		for (int ply = 0; ply < m_settings.m_randomOpeningPlies; ++ply)
+		{
+			ChessMoveList moves;
+			position.GenerateLegalMoves(moves);
+			if (moves.m_count == 0)
+			{
+				break;
+			}
+			position.MakeMove(moves[static_cast<int>(random() % static_cast<uint64_t>(moves.m_count))]);
+		}
+		if (position.HasLegalMove())
+		{
+			return position;
+		}
+	}
+}
+
+void ChessSelfPlayTournament::RunWorker()
+{
+	ChessEngine* engines[2] = { CreateSelfPlayEngine(m_settings.m_players[0]), CreateSelfPlayEngine(m_settings.m_players[1]) };
+
+	for (int gameIndex = m_nextGameIndex++; gameIndex < m_settings.m_numGames; gameIndex = m_nextGameIndex++)
+	{
+		// Consecutive games share an opening with the colours swapped; no game inherits another's table
+		for (ChessEngine* engine : engines)
+		{
+			if (engine->GetType() == ChessEngineType::ALPHA_BETA)
+			{
+				static_cast<ChessAlphaBetaEngine*>(engine)->ClearTranspositionTable();
+			}
+		}
+		ChessSelfPlayGame game;
+		PlayGame(engines, GetOpeningPosition(gameIndex / 2), gameIndex & 1, game);
+		RecordGame(game);
+	}
+
+	delete engines[0];
+	delete engines[1];
+}
+
+void ChessSelfPlayTournament::PlayGame(ChessEngine* engines[2], ChessPosition const& startPosition, int whitePlayer, ChessSelfPlayGame& out_game) const
+{
+	out_game.m_startPosition = startPosition;
+	out_game.m_whitePlayer = whitePlayer;
+
+	ChessPosition position = startPosition;
+	std::vector<uint64_t> hashHistory;
+	hashHistory.push_back(position.GetHash());
+	float clockSeconds[2] = { m_settings.m_baseSeconds, m_settings.m_baseSeconds };		// Per colour
+	while (!IsGameOver(position, hashHistory, out_game))
+	{
+		int sideToMove = position.GetSideToMove();
+		int playerIndex = (sideToMove == 0) ? whitePlayer : 1 - whitePlayer;
+		ChessSelfPlayPlayerSettings const& player = m_settings.m_players[playerIndex];
+
+		ChessSearchLimits limits;
+		limits.m_maxDepth = player.m_maxDepth;
+		limits.m_maxNodes = player.m_maxNodes;
+		limits.m_numThreads = player.m_numThreads;
+		limits.m_mctsPolicy = player.m_mctsPolicy;
+		limits.m_useTablebases = player.m_useTablebases;
+		limits.m_useOpeningBook = false;
+		bool isClockGame = m_settings.m_moveSeconds <= 0.f;
+		limits.m_maxSeconds = isClockGame ? GetChessMoveSecondsForClock(clockSeconds[sideToMove], m_settings.m_incrementSeconds, 0) : m_settings.m_moveSeconds;
+
+		auto searchStartTime = std::chrono::steady_clock::now();
+		ChessSearchResult result = engines[playerIndex]->Search(position, limits);
+		float searchSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - searchStartTime).count();
+		out_game.m_nodes[playerIndex] += result.m_nodes;
+		out_game.m_searchSeconds[playerIndex] += searchSeconds;
+
+		clockSeconds[sideToMove] -= searchSeconds;
+		if (isClockGame && clockSeconds[sideToMove] < 0.f)
+		{
+			out_game.m_whiteScore = (sideToMove == 0) ? 0.f : 1.f;
+			out_game.m_termination = ChessSelfPlayTermination::TIME_FORFEIT;
+			return;
+		}
+		clockSeconds[sideToMove] += m_settings.m_incrementSeconds;
+
+		// An engine that returns nothing in a live position has lost all the same
+		if (!result.HasMove() || !position.IsLegalMove(result.m_bestMove))
+		{
+			out_game.m_whiteScore = (sideToMove == 0) ? 0.f : 1.f;
+			out_game.m_termination = ChessSelfPlayTermination::TIME_FORFEIT;
+			return;
+		}
+		position.MakeMove(result.m_bestMove);
+		out_game.m_moves.push_back(result.m_bestMove);
+		hashHistory.push_back(position.GetHash());
+	}
+}
+
+bool ChessSelfPlayTournament::IsGameOver(ChessPosition const& position, std::vector<uint64_t> const& hashHistory, ChessSelfPlayGame& out_game) const
+{
+	out_game.m_whiteScore = 0.5f;
+	if (!position.HasLegalMove())
+	{
+		bool isCheckmate = position.IsInCheck(position.GetSideToMove());
+		out_game.m_whiteScore = isCheckmate ? ((position.GetSideToMove() == 0) ? 0.f : 1.f) : 0.5f;
+		out_game.m_termination = isCheckmate ? ChessSelfPlayTermination::CHECKMATE : ChessSelfPlayTermination::STALEMATE;
+		return true;
+	}
+	if (position.m_halfmoveClock >= 100)
+	{
+		out_game.m_termination = ChessSelfPlayTermination::FIFTY_MOVES;
+		return true;
+	}
+	if (position.IsInsufficientMaterial())
+	{
+		out_game.m_termination = ChessSelfPlayTermination::INSUFFICIENT_MATERIAL;
+		return true;
+	}
+
+	// Threefold repetition: only positions since the last capture or pawn move can recur
+	int numRepeats = 0;
+	int lastIndex = static_cast<int>(hashHistory.size()) - 1;
+	int firstIndex = std::max(0, lastIndex - position.m_halfmoveClock);
+	for (int historyIndex = lastIndex - 2; historyIndex >= firstIndex; historyIndex -= 2)
+	{
+		numRepeats += (hashHistory[historyIndex] == position.GetHash()) ? 1 : 0;
+	}
+	if (numRepeats >= 2)
+	{
+		out_game.m_termination = ChessSelfPlayTermination::REPETITION;
+		return true;
+	}
+
+	// Same rule as ChessMatch::AdjudicateWithTablebases: cursed wins and blessed losses are draws
+	ChessWDLScore wdl = ChessWDLScore::DRAW;
+	if (m_settings.m_useTablebaseAdjudication && g_chessTablebases.ProbeWDL(position, wdl))
+	{
+		if (wdl == ChessWDLScore::WIN || wdl == ChessWDLScore::LOSS)
+		{
+			int winningSide = (wdl == ChessWDLScore::WIN) ? position.GetSideToMove() : 1 - position.GetSideToMove();
+			out_game.m_whiteScore = (winningSide == 0) ? 1.f : 0.f;
+		}
+		out_game.m_termination = ChessSelfPlayTermination::TABLEBASE;
+		return true;
+	}
+
+	if (static_cast<int>(hashHistory.size()) > m_settings.m_maxPlies)
+	{
+		out_game.m_termination = ChessSelfPlayTermination::MAX_PLIES;
+		return true;
+	}
+	return false;
+}
+
+void ChessSelfPlayTournament::RecordGame(ChessSelfPlayGame const& game)
+{
+	std::string moveText;
+	moveText.reserve(game.m_moves.size() * 5);
+	for (ChessMove const& move : game.m_moves)
+	{
+		moveText += (moveText.empty() ? "" : " ") + move.GetNotation();
+	}
+	char const* resultText = (game.m_whiteScore > 0.75f) ? "1-0" : ((game.m_whiteScore < 0.25f) ? "0-1" : "1/2-1/2");
+	float player0Score = (game.m_whitePlayer == 0) ? game.m_whiteScore : 1.f - game.m_whiteScore;
+
+	std::lock_guard<std::mutex> lock(m_resultsMutex);
+	m_gamesFile << m_settings.m_players[game.m_whitePlayer].m_name << ' ' << m_settings.m_players[1 - game.m_whitePlayer].m_name << ' '
+		<< resultText << ' ' << GetChessSelfPlayTerminationName(game.m_termination) << ';' << game.m_startPosition.GetFEN() << ';' << moveText << '\n';
+
+	m_wins += (player0Score > 0.75f) ? 1 : 0;
+	m_losses += (player0Score < 0.25f) ? 1 : 0;
+	m_draws += (player0Score >= 0.25f && player0Score <= 0.75f) ? 1 : 0;
+	m_terminationCounts[static_cast<int>(game.m_termination)] += 1;
+	for (int playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		m_totalNodes[playerIndex] += game.m_nodes[playerIndex];
+		m_totalSearchSeconds[playerIndex] += game.m_searchSeconds[playerIndex];
+	}
+
+	m_numFinishedGames += 1;
+	if (m_numFinishedGames % SELFPLAY_STANDINGS_INTERVAL == 0 && m_numFinishedGames < m_settings.m_numGames)
+	{
+		PrintStandings(false);
+	}
+}
+
+void ChessSelfPlayTournament::PrintStandings(bool isFinal)
+{
+	// Elo from the mean score, with a 95% interval from the per-game score variance
+	int numGames = m_wins + m_draws + m_losses;
+	if (numGames == 0)
+	{
+		return;
+	}
+	double score = (m_wins + 0.5 * m_draws) / numGames;
+	double variance = (m_wins * (1.0 - score) * (1.0 - score) + m_draws * (0.5 - score) * (0.5 - score) + m_losses * score * score) / numGames;
+	double scoreMargin = 1.96 * sqrt(variance / numGames);
+	double elo = 0.0;
+	double eloLow = 0.0;
+	double eloHigh = 0.0;
+	GetEloForScore(score, elo);
+	GetEloForScore(score - scoreMargin, eloLow);
+	GetEloForScore(score + scoreMargin, eloHigh);
+
+	double nodesPerSecond[2] = {};
+	for (int playerIndex = 0; playerIndex < 2; ++playerIndex)
+	{
+		nodesPerSecond[playerIndex] = (m_totalSearchSeconds[playerIndex] > 0.0) ? static_cast<double>(m_totalNodes[playerIndex]) / m_totalSearchSeconds[playerIndex] : 0.0;
+	}
+	float elapsedSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - m_startTime).count();
+
+	std::string standings;
+	char line[512];
+	snprintf(line, sizeof(line), "%s %d games: %s vs %s  +%d =%d -%d  score %.1f%%  Elo %+.1f +/- %.1f\n", isFinal ? "Final" : "After",
+		numGames, m_settings.m_players[0].m_name.c_str(), m_settings.m_players[1].m_name.c_str(), m_wins, m_draws, m_losses, score * 100.0,
+		elo, (eloHigh - eloLow) * 0.5);
+	standings += line;
+	snprintf(line, sizeof(line), "  nps %s %.0f, %s %.0f; %.1f games/min\n", m_settings.m_players[0].m_name.c_str(), nodesPerSecond[0],
+		m_settings.m_players[1].m_name.c_str(), nodesPerSecond[1], (elapsedSeconds > 0.f) ? 60.f * numGames / elapsedSeconds : 0.f);
+	standings += line;
+	if (isFinal)
+	{
+		standings += " ";
+		for (int terminationIndex = 0; terminationIndex < static_cast<int>(ChessSelfPlayTermination::COUNT); ++terminationIndex)
+		{
+			if (m_terminationCounts[terminationIndex] > 0)
+			{
+				snprintf(line, sizeof(line), " %s %d", GetChessSelfPlayTerminationName(static_cast<ChessSelfPlayTermination>(terminationIndex)), m_terminationCounts[terminationIndex]);
+				standings += line;
+			}
+		}
+		standings += "\n";
+	}
+	printf("%s", standings.c_str());
+	fflush(stdout);
+
+	if (isFinal)
+	{
+		std::ofstream resultsFile(m_settings.m_resultsFile, std::ios::out | std::ios::trunc);
+		resultsFile << standings << "  games in " << m_settings.m_gamesFile << '\n';
+		if (!resultsFile.good())
+		{
+			printf("ERROR: could not write \"%s\"\n", m_settings.m_resultsFile.c_str());
+		}
+	}
+}
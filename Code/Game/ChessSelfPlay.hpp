@@ -0,0 +1,104 @@
+#pragma once
+#include "Game/ChessEngine.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+struct ChessSelfPlayPlayerSettings
+{
+public:
+	std::string			m_name;
+	ChessEngineType		m_engineType = ChessEngineType::ALPHA_BETA;
+	ChessMCTSPolicyType m_mctsPolicy = ChessMCTSPolicyType::EVALUATION;
+	int		 m_maxDepth = 64;
+	uint64_t m_maxNodes = 0;			// 0 = only the clock limits the search
+	int		 m_numThreads = 1;			// Search threads inside each game, on top of the concurrent games
+	int		 m_hashSizeMB = 16;
+	bool	 m_useTablebases = true;
+};
+// -----------------------------------------------------------------------------
+struct ChessSelfPlaySettings
+{
+public:
+	ChessSelfPlayPlayerSettings m_players[2];		// Results are reported from player 0's side
+	int		m_numGames = 100;					// Rounded up to an even number; each opening is played with both colours
+	int		m_numConcurrentGames = 0;			// 0 = one per hardware thread
+	float	m_baseSeconds = 10.f;				// Clock per side...
+	float	m_incrementSeconds = 0.1f;			// ...plus this after every move
+	float	m_moveSeconds = 0.f;				// If set, a fixed time per move replaces the clock
+	std::string m_openingsFile;					// One FEN/EPD position per line; empty = random moves from the start
+	int		m_randomOpeningPlies = 6;
+	int		m_maxPlies = 400;					// Longer games are scored as draws
+	bool	m_useTablebaseAdjudication = true;
+	uint64_t m_seed = 1;
+	std::string m_gamesFile = "Data/SelfPlay/games.txt";
+	std::string m_resultsFile = "Data/SelfPlay/results.txt";
+};
+// -----------------------------------------------------------------------------
+enum class ChessSelfPlayTermination
+{
+	CHECKMATE,
+	STALEMATE,
+	REPETITION,
+	FIFTY_MOVES,
+	INSUFFICIENT_MATERIAL,
+	TABLEBASE,
+	MAX_PLIES,
+	TIME_FORFEIT,
+	COUNT
+};
+char const* GetChessSelfPlayTerminationName(ChessSelfPlayTermination termination);
+// -----------------------------------------------------------------------------
+struct ChessSelfPlayGame
+{
+public:
+	ChessPosition			 m_startPosition;
+	int						 m_whitePlayer = 0;		// Index into ChessSelfPlaySettings::m_players
+	std::vector<ChessMove>	 m_moves;
+	float					 m_whiteScore = 0.5f;
+	ChessSelfPlayTermination m_termination = ChessSelfPlayTermination::MAX_PLIES;
+	uint64_t				 m_nodes[2] = {};		// Per player index, not per colour
+	float					 m_searchSeconds[2] = {};
+};
+// -----------------------------------------------------------------------------
+// Plays engine-vs-engine games on a pool of threads, one game per thread at a time. Every worker
+// owns a pair of engines for its whole life, so tables are allocated once rather than per game.
+// Games are appended to the games file as they finish, one line each:
+//     <white> <black> <result> <termination>;<start FEN>;<moves in long algebraic>
+// -----------------------------------------------------------------------------
+class ChessSelfPlayTournament
+{
+public:
+	explicit ChessSelfPlayTournament(ChessSelfPlaySettings const& settings);
+
+	bool Run();
+
+private:
+	bool LoadOpenings();
+	void RunWorker();
+	void PlayGame(ChessEngine* engines[2], ChessPosition const& startPosition, int whitePlayer, ChessSelfPlayGame& out_game) const;
+	bool IsGameOver(ChessPosition const& position, std::vector<uint64_t> const& hashHistory, ChessSelfPlayGame& out_game) const;
+	ChessPosition GetOpeningPosition(int openingIndex) const;
+	void RecordGame(ChessSelfPlayGame const& game);
+	void PrintStandings(bool isFinal);
+
+private:
+	ChessSelfPlaySettings m_settings;
+	std::vector<ChessPosition> m_openings;
+	std::atomic<int> m_nextGameIndex = 0;
+
+	std::mutex	  m_resultsMutex;
+	std::ofstream m_gamesFile;
+	int			  m_numFinishedGames = 0;
+	int			  m_wins = 0;			// From player 0's side
+	int			  m_draws = 0;
+	int			  m_losses = 0;
+	int			  m_terminationCounts[static_cast<int>(ChessSelfPlayTermination::COUNT)] = {};
+	uint64_t	  m_totalNodes[2] = {};
+	double		  m_totalSearchSeconds[2] = {};
+	std::chrono::steady_clock::time_point m_startTime;
+};
@@ -0,0 +1,1363 @@
+#include "Game/ChessTablebase.hpp"
+#include "Game/ChessEndgameTable.hpp"
+#include "Game/ChessMappedFile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+
+// -----------------------------------------------------------------------------
+// The decoder follows the published Syzygy format (R. de Man); squares are a1 = 0 .. h8 = 63,
+// which is also ChessPosition's layout, and pieces use the format's codes: pawn 1 .. king 6,
+// plus 8 for black.
+// -----------------------------------------------------------------------------
+ChessTablebases g_chessTablebases;
+// -----------------------------------------------------------------------------
+constexpr uint8_t SYZYGY_WDL_MAGIC[] = { 0x71, 0xE8, 0x23, 0x5D };
+constexpr uint8_t SYZYGY_DTZ_MAGIC[] = { 0xD7, 0x66, 0x0C, 0xA5 };
+constexpr uint8_t SYZYGY_FLAG_STM = 1;
+constexpr uint8_t SYZYGY_FLAG_MAPPED = 2;
+constexpr uint8_t SYZYGY_FLAG_WIN_PLIES = 4;
+constexpr uint8_t SYZYGY_FLAG_LOSS_PLIES = 8;
+constexpr uint8_t SYZYGY_FLAG_WIDE = 16;
+constexpr uint8_t SYZYGY_FLAG_SINGLE_VALUE = 128;
+constexpr int SYZYGY_PAWN = 1;
+constexpr int SYZYGY_KING = 6;
+// -----------------------------------------------------------------------------
+constexpr int PROBE_FAIL = 0;
+constexpr int PROBE_OK = 1;
+constexpr int PROBE_CHANGE_STM = -1;			// DTZ table only stores the other side to move
+constexpr int PROBE_ZEROING_BEST_MOVE = 2;		// Best move is a capture or pawn move, so the table value is a don't-care
+// -----------------------------------------------------------------------------
+struct ChessSyzygyPairsData
+{
+public:
+	uint8_t		   m_flags = 0;
+	uint8_t		   m_maxSymbolLength = 0;
+	uint8_t		   m_minSymbolLength = 0;	// Also holds the value of single-value tables
+	uint32_t	   m_numBlocks = 0;
+	uint64_t	   m_blockSize = 0;
+	uint64_t	   m_span = 0;
+	uint8_t const* m_lowestSymbols = nullptr;	// uint16 per symbol length
+	uint8_t const* m_symbolPairs = nullptr;		// 3 bytes per symbol: 12-bit left and right halves
+	uint8_t const* m_blockLengths = nullptr;	// uint16 per block: values stored minus one
+	uint32_t	   m_blockLengthsSize = 0;
+	uint8_t const* m_sparseIndex = nullptr;		// 6 bytes per entry: uint32 block, uint16 offset
+	uint64_t	   m_sparseIndexSize = 0;
+	uint8_t const* m_data = nullptr;
+	std::vector<uint64_t> m_base64;
+	std::vector<uint8_t>  m_symbolLengths;
+	uint8_t		   m_pieces[CHESS_TABLEBASE_MAX_PIECES] = {};
+	uint64_t	   m_groupIndex[CHESS_TABLEBASE_MAX_PIECES + 1] = {};
+	int			   m_groupLength[CHESS_TABLEBASE_MAX_PIECES + 1] = {};
+	uint16_t	   m_mapIndex[4] = {};
+};
+// -----------------------------------------------------------------------------
+struct ChessSyzygyTable
+{
+public:
+	ChessSyzygyPairsData* Get(int sideToMove, int file) { return &m_items[sideToMove % (m_isDTZ ? 1 : 2)][m_hasPawns ? file : 0]; }
+
+public:
+	std::string m_filePath;
+	bool	 m_isDTZ = false;
+	uint64_t m_key = 0;			// Material with the table's first side as white
+	uint64_t m_key2 = 0;		// Same material with the colours swapped
+	int		 m_pieceCount = 0;
+	bool	 m_hasPawns = false;
+	bool	 m_hasUniquePieces = false;
+	int		 m_pawnCount[2] = {};	// Leading colour first
+
+	std::atomic<bool> m_isReady = false;
+	bool			  m_isValid = false;
+	std::mutex		  m_mapMutex;
+	ChessMappedFile	  m_file;
+	ChessSyzygyPairsData m_items[2][4];
+	uint8_t const*	  m_dtzMap = nullptr;
+};
+// -----------------------------------------------------------------------------
+static int		s_mapB1H1H7[CHESS_BOARD_SIZE];
+static int		s_mapA1D1D4[CHESS_BOARD_SIZE];
+static int		s_mapKK[10][CHESS_BOARD_SIZE];
+static uint64_t s_binomial[CHESS_TABLEBASE_MAX_PIECES][CHESS_BOARD_SIZE];
+static int		s_mapPawns[CHESS_BOARD_SIZE];
+static int		s_leadPawnIndex[CHESS_TABLEBASE_MAX_PIECES][CHESS_BOARD_SIZE];
+static int		s_leadPawnsSize[CHESS_TABLEBASE_MAX_PIECES][4];
+// -----------------------------------------------------------------------------
+static int GetOffA1H8(int square)
+{
+	return GetChessSquareY(square) - GetChessSquareX(square);
+}
+
+static int FlipSquareFile(int square)
+{
+	return square ^ 7;
+}
+
+static int FlipSquareRank(int square)
+{
+	return square ^ 56;
+}
+
+static int GetSyzygyPieceForCode(uint8_t pieceCode)
+{
+	// ChessPieceType order is ROOK, KNIGHT, BISHOP, QUEEN, KING, PAWN
+	static int const SYZYGY_TYPE_FOR_TYPE[] = { 4, 2, 3, 5, 6, 1 };
+	return SYZYGY_TYPE_FOR_TYPE[static_cast<int>(GetChessPieceTypeForCode(pieceCode))] + (GetPlayerIndexForCode(pieceCode) == 0 ? 0 : 8);
+}
+
+static uint64_t GetMaterialKeyForCounts(int const (&counts)[CHESS_NUM_PLAYERS][7])
+{
+	// One nibble per colour and Syzygy piece type
+	uint64_t key = 0;
+	for (int playerIndex = 0; playerIndex < CHESS_NUM_PLAYERS; ++playerIndex)
+	{
+		for (int pieceType = SYZYGY_PAWN; pieceType <= SYZYGY_KING; ++pieceType)
+		{
+			key |= static_cast<uint64_t>(counts[playerIndex][pieceType] & 15) << (4 * (playerIndex * 8 + pieceType));
+		}
+	}
+	return key;
+}
+
+static uint64_t GetMaterialKeyForEndgame(ChessEndgameMaterial const& material)
+{
+	int counts[CHESS_NUM_PLAYERS][7] = {};
+	for (int playerIndex = 0; playerIndex < CHESS_NUM_PLAYERS; ++playerIndex)
+	{
+		for (int typeIndex = 0; typeIndex < CHESS_ENDGAME_NUM_PIECE_TYPES; ++typeIndex)
+		{
+			int syzygyPiece = GetSyzygyPieceForCode(MakeChessPieceCode(static_cast<ChessPieceType>(typeIndex), playerIndex));
+			counts[playerIndex][syzygyPiece & 7] = material.m_counts[playerIndex][typeIndex];
+		}
+	}
+	return GetMaterialKeyForCounts(counts);
+}
+
+static uint64_t GetMaterialKey(ChessPosition const& position)
+{
+	int counts[CHESS_NUM_PLAYERS][7] = {};
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = position.m_squares[square];
+		if (pieceCode != CHESS_EMPTY_SQUARE)
+		{
+			int syzygyPiece = GetSyzygyPieceForCode(pieceCode);
+			counts[syzygyPiece >> 3][syzygyPiece & 7] += 1;
+		}
+	}
+	return GetMaterialKeyForCounts(counts);
+}
+
+static void InitializeSyzygyIndexTables()
+{
+	static bool s_isInitialized = false;
+	if (s_isInitialized)
+	{
+		return;
+	}
+	s_isInitialized = true;
+
+	// Squares below the a1-h8 diagonal to 0..27
+	int code = 0;
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		if (GetOffA1H8(square) < 0)
+		{
+			s_mapB1H1H7[square] = code++;
+		}
+	}
+
+	// The a1-d1-d4 triangle to 0..9, diagonal squares last
+	std::vector<int> diagonal;
+	code = 0;
+	for (int square = 0; square <= GetChessSquare(3, 3); ++square)
+	{
+		if (GetOffA1H8(square) < 0 && GetChessSquareX(square) <= 3)
+		{
+			s_mapA1D1D4[square] = code++;
+		}
+		else if (GetOffA1H8(square) == 0 && GetChessSquareX(square) <= 3)
+		{
+			diagonal.push_back(square);
+		}
+	}
+	for (int square : diagonal)
+	{
+		s_mapA1D1D4[square] = code++;
+	}
+
+	// The 462 legal king pairs with the first king in the triangle; with the first king on the
+	// diagonal the second may not be above it, and pairs with both on the diagonal come last
+	std::vector<std::pair<int, int>> bothOnDiagonal;
+	code = 0;
+	for (int triangleIndex = 0; triangleIndex < 10; ++triangleIndex)
+	{
+		for (int firstSquare = 0; firstSquare <= GetChessSquare(3, 3); ++firstSquare)
+		{
+			if (s_mapA1D1D4[firstSquare] != triangleIndex || (triangleIndex == 0 && firstSquare != GetChessSquare(1, 0)))
+			{
+				continue;
+			}
+			for (int secondSquare = 0; secondSquare < CHESS_BOARD_SIZE; ++secondSquare)
+			{
+				bool isTouching = abs(GetChessSquareX(firstSquare) - GetChessSquareX(secondSquare)) <= 1 && abs(GetChessSquareY(firstSquare) - GetChessSquareY(secondSquare)) <= 1;
+				if (isTouching)
+				{
+					continue;
+				}
+				else if (GetOffA1H8(firstSquare) == 0 && GetOffA1H8(secondSquare) > 0)
+				{
+					continue;
+				}
+				else if (GetOffA1H8(firstSquare) == 0 && GetOffA1H8(secondSquare) == 0)
+				{
+					bothOnDiagonal.emplace_back(triangleIndex, secondSquare);
+				}
+				else
+				{
+					s_mapKK[triangleIndex][secondSquare] = code++;
+				}
+			}
+		}
+	}
+	for (std::pair<int, int> const& pair : bothOnDiagonal)
+	{
+		s_mapKK[pair.first][pair.second] = code++;
+	}
+
+	// binomial[k][n] ways to choose k of n squares
+	s_binomial[0][0] = 1;
+	for (int numSquares = 1; numSquares < CHESS_BOARD_SIZE; ++numSquares)
+	{
+		for (int numPieces = 0; numPieces < CHESS_TABLEBASE_MAX_PIECES && numPieces <= numSquares; ++numPieces)
+		{
+			s_binomial[numPieces][numSquares] = (numPieces > 0 ? s_binomial[numPieces - 1][numSquares - 1] : 0) +
+				(numPieces < numSquares ? s_binomial[numPieces][numSquares - 1] : 0);
+		}
+	}
+
+	// Pawn squares a2-h7 to 0..47; the leading pawn is the one with the highest value, i.e.
+	// nearest the edge and, on the same file, lowest
+	int availableSquares = 47;
+	for (int numLeadPawns = 1; numLeadPawns <= 5; ++numLeadPawns)
+	{
+		for (int file = 0; file < 4; ++file)
+		{
+			int index = 0;
+			for (int rank = 1; rank <= 6; ++rank)
+			{
+				int square = GetChessSquare(file, rank);
+				if (numLeadPawns == 1)
+				{
+					s_mapPawns[square] = availableSquares--;
+					s_mapPawns[FlipSquareFile(square)] = availableSquares--;
+				}
+				s_leadPawnIndex[numLeadPawns][square] = index;
+				index += static_cast<int>(s_binomial[numLeadPawns - 1][s_mapPawns[square]]);
+			}
+			s_leadPawnsSize[numLeadPawns][file] = index;
+		}
+	}
+}
+
+static bool ParseSyzygyTableName(std::string const& tableName, int (&out_counts)[CHESS_NUM_PLAYERS][7], int& out_pieceCount)
+{
+	// e.g. "KRPvKN": white's pieces, 'v', black's pieces
+	memset(out_counts, 0, sizeof(out_counts));
+	out_pieceCount = 0;
+	int side = 0;
+	for (char letter : tableName)
+	{
+		int pieceType = 0;
+		switch (letter)
+		{
+			case 'v': side += 1; continue;
+			case 'P': pieceType = 1; break;
+			case 'N': pieceType = 2; break;
+			case 'B': pieceType = 3; break;
+			case 'R': pieceType = 4; break;
+			case 'Q': pieceType = 5; break;
+			case 'K': pieceType = 6; break;
+			default: return false;
+		}
+		if (side > 1)
+		{
+			return false;
+		}
+		out_counts[side][pieceType] += 1;
+		out_pieceCount += 1;
+	}
+	return side == 1 && out_counts[0][SYZYGY_KING] == 1 && out_counts[1][SYZYGY_KING] == 1 && out_pieceCount <= CHESS_TABLEBASE_MAX_PIECES;
+}
+
+// -----------------------------------------------------------------------------
+// Table parsing
+// -----------------------------------------------------------------------------
+static uint8_t ComputeSymbolLength(ChessSyzygyPairsData& pairs, int symbol, std::vector<bool>& visited)
+{
+	// Recursive pairing: every symbol expands into a left and a right symbol until a literal
+	visited[symbol] = true;
+	uint8_t const* pair = pairs.m_symbolPairs + 3 * symbol;
+	int rightSymbol = (pair[2] << 4) | (pair[1] >> 4);
+	if (rightSymbol == 0xFFF)
+	{
+		return 0;
+	}
+
+	int leftSymbol = ((pair[1] & 0xF) << 8) | pair[0];
+	if (!visited[leftSymbol])
+	{
+		pairs.m_symbolLengths[leftSymbol] = ComputeSymbolLength(pairs, leftSymbol, visited);
+	}
+	if (!visited[rightSymbol])
+	{
+		pairs.m_symbolLengths[rightSymbol] = ComputeSymbolLength(pairs, rightSymbol, visited);
+	}
+	return static_cast<uint8_t>(pairs.m_symbolLengths[leftSymbol] + pairs.m_symbolLengths[rightSymbol] + 1);
+}
+
+static uint8_t const* ParsePairsSizes(ChessSyzygyPairsData& pairs, uint8_t const* data)
+{
+	pairs.m_flags = *data++;
+	if (pairs.m_flags & SYZYGY_FLAG_SINGLE_VALUE)
+	{
+		pairs.m_minSymbolLength = *data++;
+		return data;
+	}
+
+	// The group index after the last group is the size of the whole table
+	int numGroups = 0;
+	while (pairs.m_groupLength[numGroups] != 0)
+	{
+		numGroups += 1;
+	}
+	uint64_t tableSize = pairs.m_groupIndex[numGroups];
+
+	pairs.m_blockSize = 1ULL << *data++;
+	pairs.m_span = 1ULL << *data++;
+	pairs.m_sparseIndexSize = (tableSize + pairs.m_span - 1) / pairs.m_span;
+	uint8_t padding = *data++;
+	pairs.m_numBlocks = ReadLittleEndian32(data);
+	data += 4;
+	pairs.m_blockLengthsSize = pairs.m_numBlocks + padding;
+	pairs.m_maxSymbolLength = *data++;
+	pairs.m_minSymbolLength = *data++;
+	pairs.m_lowestSymbols = data;
+
+	// Canonical Huffman: longer codes have lower values, so base64[] is decreasing with length
+	size_t numLengths = pairs.m_maxSymbolLength - pairs.m_minSymbolLength + 1;
+	pairs.m_base64.assign(numLengths, 0);
+	for (int lengthIndex = static_cast<int>(numLengths) - 2; lengthIndex >= 0; --lengthIndex)
+	{
+		pairs.m_base64[lengthIndex] = (pairs.m_base64[lengthIndex + 1] + ReadLittleEndian16(pairs.m_lowestSymbols + 2 * lengthIndex) -
+			ReadLittleEndian16(pairs.m_lowestSymbols + 2 * (lengthIndex + 1))) / 2;
+	}
+	for (size_t lengthIndex = 0; lengthIndex < numLengths; ++lengthIndex)
+	{
+		pairs.m_base64[lengthIndex] <<= 64 - lengthIndex - pairs.m_minSymbolLength;
+	}
+	data += numLengths * 2;
+
+	size_t numSymbols = ReadLittleEndian16(data);
+	data += 2;
+	pairs.m_symbolPairs = data;
+	pairs.m_symbolLengths.assign(numSymbols, 0);
+	std::vector<bool> visited(numSymbols, false);
+	for (size_t symbol = 0; symbol < numSymbols; ++symbol)
+	{
+		if (!visited[symbol])
+		{
+			pairs.m_symbolLengths[symbol] = ComputeSymbolLength(pairs, static_cast<int>(symbol), visited);
+		}
+	}
+	return data + numSymbols * 3 + (numSymbols & 1);
+}
+
+static void SetPieceGroups(ChessSyzygyTable const& table, ChessSyzygyPairsData& pairs, int const order[2], int file)
+{
+	// Leading group: pawns of the leading colour, or the first 3 unique pieces (kings + one), or the 2 kings
+	int numGroups = 0;
+	int firstLength = table.m_hasPawns ? 0 : (table.m_hasUniquePieces ? 3 : 2);
+	pairs.m_groupLength[numGroups] = 1;
+	for (int pieceIndex = 1; pieceIndex < table.m_pieceCount; ++pieceIndex)
+	{
+		if (--firstLength > 0 || pairs.m_pieces[pieceIndex] == pairs.m_pieces[pieceIndex - 1])
+		{
+			pairs.m_groupLength[numGroups] += 1;
+		}
+		else
+		{
+			pairs.m_groupLength[++numGroups] = 1;
+		}
+	}
+	pairs.m_groupLength[++numGroups] = 0;
+
+	// Groups are encoded in a per-table order: order[0] is the leading group, order[1] the remaining pawns
+	bool hasPawnsOnBothSides = table.m_hasPawns && table.m_pawnCount[1] > 0;
+	int nextGroup = hasPawnsOnBothSides ? 2 : 1;
+	int freeSquares = 64 - pairs.m_groupLength[0] - (hasPawnsOnBothSides ? pairs.m_groupLength[1] : 0);
+	uint64_t index = 1;
+	for (int orderIndex = 0; nextGroup < numGroups || orderIndex == order[0] || orderIndex == order[1]; ++orderIndex)
+	{
+		if (orderIndex == order[0])
+		{
+			pairs.m_groupIndex[0] = index;
+			index *= table.m_hasPawns ? s_leadPawnsSize[pairs.m_groupLength[0]][file] : (table.m_hasUniquePieces ? 31332 : 462);
+		}
+		else if (orderIndex == order[1])
+		{
+			pairs.m_groupIndex[1] = index;
+			index *= s_binomial[pairs.m_groupLength[1]][48 - pairs.m_groupLength[0]];
+		}
+		else
+		{
+			pairs.m_groupIndex[nextGroup] = index;
+			index *= s_binomial[pairs.m_groupLength[nextGroup]][freeSquares];
+			freeSquares -= pairs.m_groupLength[nextGroup++];
+		}
+	}
+	pairs.m_groupIndex[numGroups] = index;
+}
+
+static uint8_t const* AlignPointer(uint8_t const* data, uintptr_t alignment)
+{
+	return reinterpret_cast<uint8_t const*>((reinterpret_cast<uintptr_t>(data) + alignment - 1) & ~(alignment - 1));
+}
+
+static bool ParseSyzygyTable(ChessSyzygyTable& table, uint8_t const* data, uint8_t const* dataEnd)
+{
+	constexpr uint8_t SPLIT = 1;
+	constexpr uint8_t HAS_PAWNS = 2;
+	if (((*data & HAS_PAWNS) != 0) != table.m_hasPawns || (!table.m_isDTZ && ((*data & SPLIT) != 0) != (table.m_key != table.m_key2)))
+	{
+		return false;
+	}
+	data++;
+
+	int numSides = (!table.m_isDTZ && table.m_key != table.m_key2) ? 2 : 1;
+	int maxFile = table.m_hasPawns ? 3 : 0;
+	bool hasPawnsOnBothSides = table.m_hasPawns && table.m_pawnCount[1] > 0;
+
+	for (int file = 0; file <= maxFile; ++file)
+	{
+		int order[2][2] = { { *data & 0xF, hasPawnsOnBothSides ? (data[1] & 0xF) : 0xF },
+							{ *data >> 4,  hasPawnsOnBothSides ? (data[1] >> 4) : 0xF } };
+		data += 1 + (hasPawnsOnBothSides ? 1 : 0);
+
+		for (int pieceIndex = 0; pieceIndex < table.m_pieceCount; ++pieceIndex, ++data)
+		{
+			for (int side = 0; side < numSides; ++side)
+			{
+				table.Get(side, file)->m_pieces[pieceIndex] = static_cast<uint8_t>(side ? (*data >> 4) : (*data & 0xF));
+			}
+		}
+		for (int side = 0; side < numSides; ++side)
+		{
+			SetPieceGroups(table, *table.Get(side, file), order[side], file);
+		}
+	}
+	data = AlignPointer(data, 2);
+
+	for (int file = 0; file <= maxFile; ++file)
+	{
+		for (int side = 0; side < numSides; ++side)
+		{
+			data = ParsePairsSizes(*table.Get(side, file), data);
+		}
+	}
+
+	// DTZ values are stored per WDL class through small remapping tables
+	if (table.m_isDTZ)
+	{
+		table.m_dtzMap = data;
+		for (int file = 0; file <= maxFile; ++file)
+		{
+			ChessSyzygyPairsData& pairs = *table.Get(0, file);
+			if ((pairs.m_flags & SYZYGY_FLAG_MAPPED) == 0)
+			{
+				continue;
+			}
+			if (pairs.m_flags & SYZYGY_FLAG_WIDE)
+			{
+				data = AlignPointer(data, 2);
+				for (int mapIndex = 0; mapIndex < 4; ++mapIndex)
+				{
+					pairs.m_mapIndex[mapIndex] = static_cast<uint16_t>((data - table.m_dtzMap) / 2 + 1);
+					data += 2 * ReadLittleEndian16(data) + 2;
+				}
+			}
+			else
+			{
+				for (int mapIndex = 0; mapIndex < 4; ++mapIndex)
+				{
+					pairs.m_mapIndex[mapIndex] = static_cast<uint16_t>(data - table.m_dtzMap + 1);
+					data += *data + 1;
+				}
+			}
+		}
+		data = AlignPointer(data, 2);
+	}
+
+	for (int file = 0; file <= maxFile; ++file)
+	{
+		for (int side = 0; side < numSides; ++side)
+		{
+			ChessSyzygyPairsData& pairs = *table.Get(side, file);
+			pairs.m_sparseIndex = data;
+			data += pairs.m_sparseIndexSize * 6;
+		}
+	}
+	for (int file = 0; file <= maxFile; ++file)
+	{
+		for (int side = 0; side < numSides; ++side)
+		{
+			ChessSyzygyPairsData& pairs = *table.Get(side, file);
+			pairs.m_blockLengths = data;
+			data += pairs.m_blockLengthsSize * 2;
+		}
+	}
+	for (int file = 0; file <= maxFile; ++file)
+	{
+		for (int side = 0; side < numSides; ++side)
+		{
+			ChessSyzygyPairsData& pairs = *table.Get(side, file);
+			data = AlignPointer(data, 64);
+			pairs.m_data = data;
+			data += pairs.m_numBlocks * pairs.m_blockSize;
+		}
+	}
+	return data <= dataEnd;
+}
+
+static bool MapSyzygyTable(ChessSyzygyTable& table)
+{
+	// Double-checked so probes after the first never take the lock
+	if (table.m_isReady.load(std::memory_order_acquire))
+	{
+		return table.m_isValid;
+	}
+
+	std::lock_guard<std::mutex> lock(table.m_mapMutex);
+	if (table.m_isReady.load(std::memory_order_relaxed))
+	{
+		return table.m_isValid;
+	}
+
+	// Valid files are 16 bytes of header plus 64-byte aligned data
+	bool isValid = table.m_file.Open(table.m_filePath) && (table.m_file.GetSize() % 64) == 16;
+	if (isValid)
+	{
+		uint8_t const* magic = table.m_isDTZ ? SYZYGY_DTZ_MAGIC : SYZYGY_WDL_MAGIC;
+		isValid = memcmp(table.m_file.GetData(), magic, 4) == 0 && ParseSyzygyTable(table, table.m_file.GetData() + 4, table.m_file.GetData() + table.m_file.GetSize());
+	}
+	if (!isValid)
+	{
+		table.m_file.Close();
+	}
+	table.m_isValid = isValid;
+	table.m_isReady.store(true, std::memory_order_release);
+	return isValid;
+}
+
+// -----------------------------------------------------------------------------
+// Decoding
+// -----------------------------------------------------------------------------
+static int DecompressPairs(ChessSyzygyPairsData const& pairs, uint64_t index)
+{
+	if (pairs.m_flags & SYZYGY_FLAG_SINGLE_VALUE)
+	{
+		return pairs.m_minSymbolLength;
+	}
+
+	// The sparse index points at the block holding value k * span + span / 2; walk to ours from there
+	uint64_t sparseEntry = index / pairs.m_span;
+	uint32_t block = ReadLittleEndian32(pairs.m_sparseIndex + 6 * sparseEntry);
+	int offset = ReadLittleEndian16(pairs.m_sparseIndex + 6 * sparseEntry + 4);
+	offset += static_cast<int>(index % pairs.m_span) - static_cast<int>(pairs.m_span / 2);
+	while (offset < 0)
+	{
+		offset += ReadLittleEndian16(pairs.m_blockLengths + 2 * (--block)) + 1;
+	}
+	while (offset > ReadLittleEndian16(pairs.m_blockLengths + 2 * block))
+	{
+		offset -= ReadLittleEndian16(pairs.m_blockLengths + 2 * (block++)) + 1;
+	}
+
+	// Walk the block's Huffman symbols until the one covering our offset
+	uint8_t const* blockData = pairs.m_data + static_cast<uint64_t>(block) * pairs.m_blockSize;
+	uint64_t buffer = ReadBigEndian64(blockData);
+	blockData += 8;
+	int bufferBits = 64;
+	int symbol = 0;
+	while (true)
+	{
+		int lengthIndex = 0;
+		while (buffer < pairs.m_base64[lengthIndex])
+		{
+			lengthIndex += 1;
+		}
+		symbol = static_cast<int>((buffer - pairs.m_base64[lengthIndex]) >> (64 - lengthIndex - pairs.m_minSymbolLength));
+		symbol += ReadLittleEndian16(pairs.m_lowestSymbols + 2 * lengthIndex);
+		if (offset < pairs.m_symbolLengths[symbol] + 1)
+		{
+			break;
+		}
+
+		offset -= pairs.m_symbolLengths[symbol] + 1;
+		int symbolBits = lengthIndex + pairs.m_minSymbolLength;
+		buffer <<= symbolBits;
+		bufferBits -= symbolBits;
+		if (bufferBits <= 32)
+		{
+			bufferBits += 32;
+			buffer |= static_cast<uint64_t>(ReadBigEndian32(blockData)) << (64 - bufferBits);
+			blockData += 4;
+		}
+	}
+
+	// Expand the pair tree down to the literal at our offset
+	while (pairs.m_symbolLengths[symbol] != 0)
+	{
+		uint8_t const* pair = pairs.m_symbolPairs + 3 * symbol;
+		int leftSymbol = ((pair[1] & 0xF) << 8) | pair[0];
+		if (offset < pairs.m_symbolLengths[leftSymbol] + 1)
+		{
+			symbol = leftSymbol;
+		}
+		else
+		{
+			offset -= pairs.m_symbolLengths[leftSymbol] + 1;
+			symbol = (pair[2] << 4) | (pair[1] >> 4);
+		}
+	}
+	uint8_t const* literal = pairs.m_symbolPairs + 3 * symbol;
+	return ((literal[1] & 0xF) << 8) | literal[0];
+}
+
+static int MapDTZValue(ChessSyzygyTable& table, int file, int value, ChessWDLScore wdl)
+{
+	static int const WDL_MAP_INDEX[] = { 1, 3, 0, 2, 0 };
+	ChessSyzygyPairsData const& pairs = *table.Get(0, file);
+	int wdlIndex = static_cast<int>(wdl) + 2;
+	if (pairs.m_flags & SYZYGY_FLAG_MAPPED)
+	{
+		int mapIndex = pairs.m_mapIndex[WDL_MAP_INDEX[wdlIndex]] + value;
+		value = (pairs.m_flags & SYZYGY_FLAG_WIDE) ? ReadLittleEndian16(table.m_dtzMap + 2 * mapIndex) : table.m_dtzMap[mapIndex];
+	}
+
+	// Tables store moves unless flagged as plies; cursed results are always in moves
+	if ((wdl == ChessWDLScore::WIN && !(pairs.m_flags & SYZYGY_FLAG_WIN_PLIES)) ||
+		(wdl == ChessWDLScore::LOSS && !(pairs.m_flags & SYZYGY_FLAG_LOSS_PLIES)) ||
+		wdl == ChessWDLScore::CURSED_WIN || wdl == ChessWDLScore::BLESSED_LOSS)
+	{
+		value *= 2;
+	}
+	return value + 1;
+}
+
+static int GetDTZBeforeZeroing(ChessWDLScore wdl)
+{
+	switch (wdl)
+	{
+		case ChessWDLScore::WIN:			return 1;
+		case ChessWDLScore::CURSED_WIN:		return 101;
+		case ChessWDLScore::BLESSED_LOSS:	return -101;
+		case ChessWDLScore::LOSS:			return -1;
+		default:							return 0;
+	}
+}
+
+static int GetSign(int value)
+{
+	return (value > 0) - (value < 0);
+}
+
+// -----------------------------------------------------------------------------
+char const* GetChessWDLScoreName(ChessWDLScore wdl)
+{
+	switch (wdl)
+	{
+		case ChessWDLScore::LOSS:			return "loss";
+		case ChessWDLScore::BLESSED_LOSS:	return "blessed loss";
+		case ChessWDLScore::CURSED_WIN:		return "cursed win";
+		case ChessWDLScore::WIN:			return "win";
+		default:							return "draw";
+	}
+}
+
+int GetChessTablebaseScore(ChessWDLScore wdl, int ply)
+{
+	// Fifty-move rule results are draws for scoring
+	switch (wdl)
+	{
+		case ChessWDLScore::WIN:	return CHESS_TABLEBASE_WIN_SCORE - ply;
+		case ChessWDLScore::LOSS:	return -CHESS_TABLEBASE_WIN_SCORE + ply;
+		default:					return 0;
+	}
+}
+
+ChessTablebases::ChessTablebases()
+{
+}
+
+ChessTablebases::~ChessTablebases()
+{
+	Shutdown();
+}
+
+int ChessTablebases::Initialize(std::string const& searchPaths)
+{
+	Shutdown();
+	InitializeSyzygyIndexTables();
+
+	// Only names are collected here; files are mapped on first use
+	std::vector<std::string> directories;
+	size_t start = 0;
+	while (start <= searchPaths.size())
+	{
+		size_t end = searchPaths.find(';', start);
+		if (end == std::string::npos)
+		{
+			end = searchPaths.size();
+		}
+		if (end > start)
+		{
+			directories.push_back(searchPaths.substr(start, end - start));
+		}
+		start = end + 1;
+	}
+
+	std::error_code errorCode;
+	for (std::string const& directory : directories)
+	{
+		for (std::filesystem::directory_entry const& entry : std::filesystem::directory_iterator(directory, errorCode))
+		{
+			std::filesystem::path const& filePath = entry.path();
+			if (filePath.extension() != ".rtbw")
+			{
+				continue;
+			}
+
+			std::filesystem::path dtzPath = filePath;
+			dtzPath.replace_extension(".rtbz");
+			std::string tableName = filePath.stem().string();
+			AddTable(tableName, filePath.string(), std::filesystem::exists(dtzPath, errorCode) ? dtzPath.string() : "");
+		}
+	}
+	return m_numWDLTables;
+}
+
+void ChessTablebases::Shutdown()
+{
+	m_tables.clear();
+	m_wdlTableForKey.clear();
+	m_dtzTableForKey.clear();
+	m_endgameTables.clear();
+	m_endgameTableForKey.clear();
+	m_maxPieces = 0;
+	m_numWDLTables = 0;
+}
+
+void ChessTablebases::AddTable(std::string const& tableName, std::string const& wdlPath, std::string const& dtzPath)
+{
+	int counts[CHESS_NUM_PLAYERS][7];
+	int pieceCount = 0;
+	if (!ParseSyzygyTableName(tableName, counts, pieceCount))
+	{
+		return;
+	}
+
+	int swappedCounts[CHESS_NUM_PLAYERS][7];
+	memcpy(swappedCounts[0], counts[1], sizeof(counts[1]));
+	memcpy(swappedCounts[1], counts[0], sizeof(counts[0]));
+	uint64_t key = GetMaterialKeyForCounts(counts);
+	if (m_wdlTableForKey.find(key) != m_wdlTableForKey.end())
+	{
+		return;
+	}
+
+	for (int fileIndex = 0; fileIndex < 2; ++fileIndex)
+	{
+		std::string const& filePath = (fileIndex == 0) ? wdlPath : dtzPath;
+		if (filePath.empty())
+		{
+			continue;
+		}
+
+		std::unique_ptr<ChessSyzygyTable> table = std::make_unique<ChessSyzygyTable>();
+		table->m_filePath = filePath;
+		table->m_isDTZ = (fileIndex == 1);
+		table->m_key = key;
+		table->m_key2 = GetMaterialKeyForCounts(swappedCounts);
+		table->m_pieceCount = pieceCount;
+		table->m_hasPawns = (counts[0][SYZYGY_PAWN] + counts[1][SYZYGY_PAWN]) > 0;
+		for (int side = 0; side < CHESS_NUM_PLAYERS; ++side)
+		{
+			for (int pieceType = SYZYGY_PAWN; pieceType < SYZYGY_KING; ++pieceType)
+			{
+				table->m_hasUniquePieces |= (counts[side][pieceType] == 1);
+			}
+		}
+
+		// The side with fewer pawns leads, because that compresses better
+		int whitePawns = counts[0][SYZYGY_PAWN];
+		int blackPawns = counts[1][SYZYGY_PAWN];
+		bool whiteLeads = blackPawns == 0 || (whitePawns > 0 && blackPawns >= whitePawns);
+		table->m_pawnCount[0] = whiteLeads ? whitePawns : blackPawns;
+		table->m_pawnCount[1] = whiteLeads ? blackPawns : whitePawns;
+
+		int tableIndex = static_cast<int>(m_tables.size());
+		std::unordered_map<uint64_t, int>& tableForKey = table->m_isDTZ ? m_dtzTableForKey : m_wdlTableForKey;
+		tableForKey[table->m_key] = tableIndex;
+		tableForKey[table->m_key2] = tableIndex;
+		m_tables.push_back(std::move(table));
+	}
+
+	m_numWDLTables += 1;
+	m_maxPieces = std::max(m_maxPieces, pieceCount);
+}
+
+int ChessTablebases::AddEndgameTables(std::string const& directory)
+{
+	int numFound = 0;
+	std::error_code errorCode;
+	for (std::filesystem::directory_entry const& entry : std::filesystem::directory_iterator(directory, errorCode))
+	{
+		std::filesystem::path const& filePath = entry.path();
+		if (filePath.extension() != CHESS_ENDGAME_FILE_EXTENSION)
+		{
+			continue;
+		}
+
+		// The file name is the material in its stored orientation, e.g. KBNvK.ctb
+		ChessEndgameMaterial material;
+		std::string tableName = filePath.stem().string();
+		if (!material.SetFromName(tableName) || !material.IsCanonical() || material.GetName() != tableName)
+		{
+			continue;
+		}
+		uint64_t key = GetMaterialKeyForEndgame(material);
+		if (m_endgameTableForKey.find(key) != m_endgameTableForKey.end())
+		{
+			continue;
+		}
+
+		int tableIndex = static_cast<int>(m_endgameTables.size());
+		m_endgameTableForKey[key] = tableIndex;
+		m_endgameTableForKey[GetMaterialKeyForEndgame(material.GetColorFlipped())] = tableIndex;
+		m_endgameTables.push_back(std::make_unique<ChessEndgameTable>(filePath.string(), material));
+		m_maxPieces = std::max(m_maxPieces, material.GetNumPieces());
+		numFound += 1;
+	}
+	return numFound;
+}
+
+ChessSyzygyTable* ChessTablebases::FindTable(uint64_t materialKey, bool isDTZ) const
+{
+	std::unordered_map<uint64_t, int> const& tableForKey = isDTZ ? m_dtzTableForKey : m_wdlTableForKey;
+	auto found = tableForKey.find(materialKey);
+	if (found == tableForKey.end())
+	{
+		return nullptr;
+	}
+	ChessSyzygyTable* table = m_tables[found->second].get();
+	return MapSyzygyTable(*table) ? table : nullptr;
+}
+
+bool ChessTablebases::CanProbe(ChessPosition const& position) const
+{
+	// Tables hold no castling rights, and a missing king is a finished game in this ruleset
+	return m_maxPieces > 0 && position.m_castlingRights == 0 && position.GetKingSquare(0) != CHESS_NO_SQUARE &&
+		position.GetKingSquare(1) != CHESS_NO_SQUARE && position.CountAllPieces() <= m_maxPieces;
+}
+
+int ChessTablebases::ProbeTable(ChessPosition const& position, bool isDTZ, ChessWDLScore wdl, int& out_state) const
+{
+	int squares[CHESS_TABLEBASE_MAX_PIECES];
+	int pieces[CHESS_TABLEBASE_MAX_PIECES];
+	int size = 0;
+	int numLeadPawns = 0;
+	int tableFile = 0;
+	uint64_t index = 0;
+
+	if (position.CountAllPieces() == 2)
+	{
+		return isDTZ ? 0 : static_cast<int>(ChessWDLScore::DRAW);
+	}
+
+	uint64_t materialKey = GetMaterialKey(position);
+	ChessSyzygyTable* table = FindTable(materialKey, isDTZ);
+	if (table == nullptr)
+	{
+		out_state = PROBE_FAIL;
+		return 0;
+	}
+
+	// Tables are stored with their first side as white; symmetric tables only store white to move
+	bool isSymmetricBlackToMove = (table->m_key == table->m_key2) && position.GetSideToMove() == 1;
+	bool isBlackStronger = (materialKey != table->m_key);
+	bool isFlipped = isSymmetricBlackToMove || isBlackStronger;
+	int flipColor = isFlipped ? 8 : 0;
+	int flipSquares = isFlipped ? 56 : 0;
+	int sideToMove = (isFlipped ? 1 : 0) ^ position.GetSideToMove();
+
+	// Pawn tables are split by the file of the leading pawn
+	uint8_t leadPawnCode = 0;
+	if (table->m_hasPawns)
+	{
+		int leadPiece = table->Get(0, 0)->m_pieces[0] ^ flipColor;
+		leadPawnCode = MakeChessPieceCode(ChessPieceType::PAWN, leadPiece >> 3);
+		for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+		{
+			if (position.m_squares[square] == leadPawnCode)
+			{
+				squares[size++] = square ^ flipSquares;
+			}
+		}
+		numLeadPawns = size;
+
+		int* leadSquare = std::max_element(squares, squares + numLeadPawns, [](int a, int b) { return s_mapPawns[a] < s_mapPawns[b]; });
+		std::swap(squares[0], *leadSquare);
+		tableFile = GetChessSquareX(squares[0]);
+		if (tableFile > 3)
+		{
+			tableFile = GetChessSquareX(FlipSquareFile(squares[0]));
+		}
+	}
+
+	// DTZ tables are one-sided
+	if (isDTZ)
+	{
+		uint8_t flags = table->Get(sideToMove, tableFile)->m_flags;
+		if ((flags & SYZYGY_FLAG_STM) != sideToMove && !(table->m_key == table->m_key2 && !table->m_hasPawns))
+		{
+			out_state = PROBE_CHANGE_STM;
+			return 0;
+		}
+	}
+
+	for (int square = 0; square < CHESS_BOARD_SIZE; ++square)
+	{
+		uint8_t pieceCode = position.m_squares[square];
+		if (pieceCode != CHESS_EMPTY_SQUARE && (!table->m_hasPawns || pieceCode != leadPawnCode))
+		{
+			squares[size] = square ^ flipSquares;
+			pieces[size++] = GetSyzygyPieceForCode(pieceCode) ^ flipColor;
+		}
+	}
+
+	// Put the pieces in the table's own order
+	ChessSyzygyPairsData const& pairs = *table->Get(sideToMove, tableFile);
+	for (int pieceIndex = numLeadPawns; pieceIndex < size - 1; ++pieceIndex)
+	{
+		for (int otherIndex = pieceIndex; otherIndex < size; ++otherIndex)
+		{
+			if (pairs.m_pieces[pieceIndex] == pieces[otherIndex])
+			{
+				std::swap(pieces[pieceIndex], pieces[otherIndex]);
+				std::swap(squares[pieceIndex], squares[otherIndex]);
+				break;
+			}
+		}
+	}
+
+	// Mirror so the leading piece is on files a-d
+	if (GetChessSquareX(squares[0]) > 3)
+	{
+		for (int pieceIndex = 0; pieceIndex < size; ++pieceIndex)
+		{
+			squares[pieceIndex] = FlipSquareFile(squares[pieceIndex]);
+		}
+	}
+
+	if (table->m_hasPawns)
+	{
+		index = s_leadPawnIndex[numLeadPawns][squares[0]];
+		std::stable_sort(squares + 1, squares + numLeadPawns, [](int a, int b) { return s_mapPawns[a] < s_mapPawns[b]; });
+		for (int pawnIndex = 1; pawnIndex < numLeadPawns; ++pawnIndex)
+		{
+			index += s_binomial[pawnIndex][s_mapPawns[squares[pawnIndex]]];
+		}
+	}
+	else
+	{
+		// Pawnless tables also mirror the leading piece below rank 5 and below the a1-h8 diagonal
+		if (GetChessSquareY(squares[0]) > 3)
+		{
+			for (int pieceIndex = 0; pieceIndex < size; ++pieceIndex)
+			{
+				squares[pieceIndex] = FlipSquareRank(squares[pieceIndex]);
+			}
+		}
+		for (int pieceIndex = 0; pieceIndex < pairs.m_groupLength[0]; ++pieceIndex)
+		{
+			if (GetOffA1H8(squares[pieceIndex]) == 0)
+			{
+				continue;
+			}
+			if (GetOffA1H8(squares[pieceIndex]) > 0)
+			{
+				for (int otherIndex = pieceIndex; otherIndex < size; ++otherIndex)
+				{
+					squares[otherIndex] = ((squares[otherIndex] >> 3) | (squares[otherIndex] << 3)) & 63;
+				}
+			}
+			break;
+		}
+
+		if (table->m_hasUniquePieces)
+		{
+			int adjust1 = (squares[1] > squares[0]) ? 1 : 0;
+			int adjust2 = ((squares[2] > squares[0]) ? 1 : 0) + ((squares[2] > squares[1]) ? 1 : 0);
+			if (GetOffA1H8(squares[0]) != 0)
+			{
+				index = (s_mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+			}
+			else if (GetOffA1H8(squares[1]) != 0)
+			{
+				index = (6 * 63 + GetChessSquareY(squares[0]) * 28 + s_mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+			}
+			else if (GetOffA1H8(squares[2]) != 0)
+			{
+				index = 6 * 63 * 62 + 4 * 28 * 62 + GetChessSquareY(squares[0]) * 7 * 28 + (GetChessSquareY(squares[1]) - adjust1) * 28 + s_mapB1H1H7[squares[2]];
+			}
+			else
+			{
+				index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + GetChessSquareY(squares[0]) * 7 * 6 + (GetChessSquareY(squares[1]) - adjust1) * 6 + (GetChessSquareY(squares[2]) - adjust2);
+			}
+		}
+		else
+		{
+			index = s_mapKK[s_mapA1D1D4[squares[0]]][squares[1]];
+		}
+	}
+
+	// Remaining groups: each square counts down past the squares of earlier groups
+	index *= pairs.m_groupIndex[0];
+	int* groupSquares = squares + pairs.m_groupLength[0];
+	bool hasRemainingPawns = table->m_hasPawns && table->m_pawnCount[1] > 0;
+	for (int groupIndex = 1; pairs.m_groupLength[groupIndex] != 0; ++groupIndex)
+	{
+		int groupLength = pairs.m_groupLength[groupIndex];
+		std::stable_sort(groupSquares, groupSquares + groupLength);
+		uint64_t groupCode = 0;
+		for (int memberIndex = 0; memberIndex < groupLength; ++memberIndex)
+		{
+			int adjust = static_cast<int>(std::count_if(squares, groupSquares, [&](int square) { return groupSquares[memberIndex] > square; }));
+			groupCode += s_binomial[memberIndex + 1][groupSquares[memberIndex] - adjust - (hasRemainingPawns ? 8 : 0)];
+		}
+		hasRemainingPawns = false;
+		index += groupCode * pairs.m_groupIndex[groupIndex];
+		groupSquares += groupLength;
+	}
+
+	out_state = PROBE_OK;
+	int value = DecompressPairs(pairs, index);
+	return isDTZ ? MapDTZValue(*table, tableFile, value, wdl) : value - 2;
+}
+
+ChessWDLScore ChessTablebases::SearchZeroingMoves(ChessPosition const& position, bool checkPawnMoves, int& out_state) const
+{
+	// Tables store "don't care" values where a capture is best, so captures (and pawn moves for
+	// DTZ) are resolved by search and the best of those and the stored value wins
+	ChessMoveList moves;
+	position.GenerateLegalMoves(moves);
+	ChessWDLScore bestValue = ChessWDLScore::LOSS;
+	int numZeroingMoves = 0;
+
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = moves[moveIndex];
+		bool isPawnMove = GetChessPieceTypeForCode(position.GetPieceAt(move.m_from)) == ChessPieceType::PAWN;
+		if (!move.IsCapture() && (!checkPawnMoves || !isPawnMove))
+		{
+			continue;
+		}
+
+		numZeroingMoves += 1;
+		ChessPosition child = position;
+		child.MakeMove(move);
+		ChessWDLScore value = static_cast<ChessWDLScore>(-static_cast<int>(SearchZeroingMoves(child, false, out_state)));
+		if (out_state == PROBE_FAIL)
+		{
+			return ChessWDLScore::DRAW;
+		}
+		if (value > bestValue)
+		{
+			bestValue = value;
+			if (value >= ChessWDLScore::WIN)
+			{
+				out_state = PROBE_ZEROING_BEST_MOVE;
+				return value;
+			}
+		}
+	}
+
+	// With every legal move already searched the stored value may be wrong (e.g. en passant), so it is not read
+	bool hasNoMoreMoves = numZeroingMoves > 0 && numZeroingMoves == moves.m_count;
+	ChessWDLScore value = bestValue;
+	if (!hasNoMoreMoves)
+	{
+		value = static_cast<ChessWDLScore>(ProbeTable(position, false, ChessWDLScore::DRAW, out_state));
+		if (out_state == PROBE_FAIL)
+		{
+			return ChessWDLScore::DRAW;
+		}
+	}
+
+	if (bestValue >= value)
+	{
+		out_state = (bestValue > ChessWDLScore::DRAW || hasNoMoreMoves) ? PROBE_ZEROING_BEST_MOVE : PROBE_OK;
+		return bestValue;
+	}
+	out_state = PROBE_OK;
+	return value;
+}
+
+ChessWDLScore ChessTablebases::ProbeWDLInternal(ChessPosition const& position, int& out_state) const
+{
+	out_state = PROBE_OK;
+	return SearchZeroingMoves(position, false, out_state);
+}
+
+int ChessTablebases::ProbeDTZInternal(ChessPosition const& position, int& out_state) const
+{
+	out_state = PROBE_OK;
+	ChessWDLScore wdl = SearchZeroingMoves(position, true, out_state);
+	if (out_state == PROBE_FAIL || wdl == ChessWDLScore::DRAW)
+	{
+		return 0;
+	}
+	if (out_state == PROBE_ZEROING_BEST_MOVE)
+	{
+		return GetDTZBeforeZeroing(wdl);
+	}
+
+	int dtz = ProbeTable(position, true, wdl, out_state);
+	if (out_state == PROBE_FAIL)
+	{
+		return 0;
+	}
+	if (out_state != PROBE_CHANGE_STM)
+	{
+		bool isCursed = (wdl == ChessWDLScore::BLESSED_LOSS || wdl == ChessWDLScore::CURSED_WIN);
+		return (dtz + (isCursed ? 100 : 0)) * GetSign(static_cast<int>(wdl));
+	}
+
+	// The table stores the other side to move: take the best DTZ over a 1-ply search
+	ChessMoveList moves;
+	position.GenerateLegalMoves(moves);
+	int minDTZ = 0xFFFF;
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessMove const& move = moves[moveIndex];
+		bool isZeroing = move.IsCapture() || GetChessPieceTypeForCode(position.GetPieceAt(move.m_from)) == ChessPieceType::PAWN;
+		ChessPosition child = position;
+		child.MakeMove(move);
+
+		// Zeroing moves take the DTZ from before the move, with the sign from the resulting position
+		if (isZeroing)
+		{
+			dtz = -GetDTZBeforeZeroing(SearchZeroingMoves(child, false, out_state));
+		}
+		else
+		{
+			dtz = -ProbeDTZInternal(child, out_state);
+		}
+		if (dtz == 1 && child.IsCheckmate())
+		{
+			minDTZ = 1;
+		}
+		if (!isZeroing)
+		{
+			dtz += GetSign(dtz);
+		}
+		if (dtz < minDTZ && GetSign(dtz) == GetSign(static_cast<int>(wdl)))
+		{
+			minDTZ = dtz;
+		}
+		if (out_state == PROBE_FAIL)
+		{
+			return 0;
+		}
+	}
+	return (minDTZ == 0xFFFF) ? -1 : minDTZ;
+}
+
+bool ChessTablebases::ProbeWDL(ChessPosition const& position, ChessWDLScore& out_wdl) const
+{
+	if (!CanProbe(position))
+	{
+		return false;
+	}
+
+	int state = PROBE_OK;
+	if (FindTable(GetMaterialKey(position), false) != nullptr)
+	{
+		out_wdl = ProbeWDLInternal(position, state);
+		if (state != PROBE_FAIL)
+		{
+			return true;
+		}
+	}
+
+	int pliesToMate = 0;
+	return ProbeDTM(position, out_wdl, pliesToMate);
+}
+
+bool ChessTablebases::ProbeDTZ(ChessPosition const& position, int& out_dtz) const
+{
+	if (!CanProbe(position))
+	{
+		return false;
+	}
+
+	int state = PROBE_OK;
+	out_dtz = ProbeDTZInternal(position, state);
+	return state != PROBE_FAIL;
+}
+
+bool ChessTablebases::ProbeRoot(ChessPosition const& position, ChessMove& out_move, ChessWDLScore& out_wdl, int& out_dtz) const
+{
+	if (!CanProbe(position))
+	{
+		return false;
+	}
+
+	ChessMoveList moves;
+	position.GenerateLegalMoves(moves);
+	if (moves.m_count == 0)
+	{
+		return false;
+	}
+
+	int bestRank = -0x7FFFFFFF;
+	int bestDTZ = 0;
+	int halfmoveClock = position.m_halfmoveClock;
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessPosition child = position;
+		child.MakeMove(moves[moveIndex]);
+
+		// DTZ counted from the root: zeroing moves are -101/-1/0/1/101, others are one ply further
+		int state = PROBE_OK;
+		int dtz = 0;
+		if (child.m_halfmoveClock == 0)
+		{
+			dtz = GetDTZBeforeZeroing(static_cast<ChessWDLScore>(-static_cast<int>(ProbeWDLInternal(child, state))));
+		}
+		else
+		{
+			dtz = -ProbeDTZInternal(child, state);
+			dtz += GetSign(dtz);
+		}
+		if (dtz == 2 && child.IsCheckmate())
+		{
+			dtz = 1;
+		}
+		if (state == PROBE_FAIL)
+		{
+			return false;
+		}
+
+		// Wins that convert before the fifty-move rule rank equally; otherwise sooner wins and longer losses rank higher
+		int rank = 0;
+		if (dtz > 0)
+		{
+			rank = (dtz + halfmoveClock <= 99) ? 1000 : 1000 - (dtz + halfmoveClock);
+		}
+		else if (dtz < 0)
+		{
+			rank = (-dtz * 2 + halfmoveClock < 100) ? -1000 : -1000 + (-dtz + halfmoveClock);
+		}
+
+		// Within a rank, the fastest win or the slowest loss
+		bool isBetter = rank > bestRank || (rank == bestRank && dtz != 0 && dtz < bestDTZ);
+		if (isBetter)
+		{
+			bestRank = rank;
+			bestDTZ = dtz;
+			out_move = moves[moveIndex];
+		}
+	}
+
+	out_dtz = bestDTZ;
+	if (bestDTZ > 0)
+	{
+		out_wdl = (bestRank == 1000) ? ChessWDLScore::WIN : ChessWDLScore::CURSED_WIN;
+	}
+	else if (bestDTZ < 0)
+	{
+		out_wdl = (bestRank == -1000) ? ChessWDLScore::LOSS : ChessWDLScore::BLESSED_LOSS;
+	}
+	else
+	{
+		out_wdl = ChessWDLScore::DRAW;
+	}
+	return true;
+}
+
+bool ChessTablebases::ProbeDTM(ChessPosition const& position, ChessWDLScore& out_wdl, int& out_pliesToMate) const
+{
+	// En passant is not in the tables, which only matters when the side to move has a pawn to take with
+	if (!CanProbe(position) || (position.m_enpassantSquare != CHESS_NO_SQUARE && position.CountPieces(ChessPieceType::PAWN, position.GetSideToMove()) > 0))
+	{
+		return false;
+	}
+
+	auto found = m_endgameTableForKey.find(GetMaterialKey(position));
+	uint8_t value = CHESS_ENDGAME_DRAW;
+	if (found == m_endgameTableForKey.end() || !m_endgameTables[found->second]->Probe(position, value))
+	{
+		return false;
+	}
+
+	out_wdl = IsChessEndgameWin(value) ? ChessWDLScore::WIN : (IsChessEndgameLoss(value) ? ChessWDLScore::LOSS : ChessWDLScore::DRAW);
+	out_pliesToMate = IsChessEndgameResult(value) ? GetChessEndgamePlies(value) : 0;
+	return true;
+}
+
+bool ChessTablebases::ProbeRootDTM(ChessPosition const& position, ChessMove& out_move, ChessWDLScore& out_wdl, int& out_pliesToMate) const
+{
+	ChessMoveList moves;
+	position.GenerateLegalMoves(moves);
+	if (moves.m_count == 0 || !CanProbe(position))
+	{
+		return false;
+	}
+
+	// Every move has to be known, including captures and promotions into other tables
+	int bestRank = -0x7FFFFFFF;
+	for (int moveIndex = 0; moveIndex < moves.m_count; ++moveIndex)
+	{
+		ChessPosition child = position;
+		child.MakeMove(moves[moveIndex]);
+		ChessWDLScore childWDL = ChessWDLScore::DRAW;
+		int childPlies = 0;
+		if (!ProbeDTM(child, childWDL, childPlies))
+		{
+			return false;
+		}
+
+		// Fastest mate first, then draws, then the longest resistance
+		int rank = 0;
+		if (childWDL == ChessWDLScore::LOSS)
+		{
+			rank = 1000 - childPlies;
+		}
+		else if (childWDL == ChessWDLScore::WIN)
+		{
+			rank = -1000 + childPlies;
+		}
+		if (rank > bestRank)
+		{
+			bestRank = rank;
+			out_move = moves[moveIndex];
+			out_wdl = (childWDL == ChessWDLScore::LOSS) ? ChessWDLScore::WIN : ((childWDL == ChessWDLScore::WIN) ? ChessWDLScore::LOSS : ChessWDLScore::DRAW);
+			out_pliesToMate = (childWDL == ChessWDLScore::DRAW) ? 0 : childPlies + 1;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Game/ChessPosition.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// -----------------------------------------------------------------------------
+constexpr int CHESS_TABLEBASE_MAX_PIECES = 7;
+constexpr int CHESS_TABLEBASE_WIN_SCORE = 20000;	// Below the mate range: the win is certain but the mate distance is not known
+// -----------------------------------------------------------------------------
+enum class ChessWDLScore
+{
+	LOSS = -2,
+	BLESSED_LOSS = -1,	// Lost, but the fifty-move rule saves it
+	DRAW = 0,
+	CURSED_WIN = 1,		// Won, but the fifty-move rule draws it
+	WIN = 2
+};
+char const* GetChessWDLScoreName(ChessWDLScore wdl);
+int			GetChessTablebaseScore(ChessWDLScore wdl, int ply);
+// -----------------------------------------------------------------------------
+struct ChessSyzygyTable;
+class ChessEndgameTable;
+// -----------------------------------------------------------------------------
+// Syzygy WDL (.rtbw) and DTZ (.rtbz) probing, plus the distance-to-mate tables (.ctb) built by
+// ChessEndgameGenerator. Initialize() only scans the configured directories; each file is memory
+// mapped the first time a position needs it, after which probes read straight from the mapping
+// and are safe from any number of search threads.
+// -----------------------------------------------------------------------------
+class ChessTablebases
+{
+public:
+	ChessTablebases();
+	~ChessTablebases();
+
+	// searchPaths is a ';' separated list of directories; returns the number of WDL tables found
+	int  Initialize(std::string const& searchPaths);
+	void Shutdown();
+	int  GetMaxPieces() const { return m_maxPieces; }
+	int  GetNumTables() const { return m_numWDLTables; }
+
+	// Generated tables from one directory; returns how many were found
+	int  AddEndgameTables(std::string const& directory);
+	int  GetNumEndgameTables() const { return static_cast<int>(m_endgameTables.size()); }
+	bool CanProbe(ChessPosition const& position) const;
+
+	// Results are from the side to move. DTZ is in plies to the next capture or pawn move,
+	// positive when winning and negative when losing; 0 is a draw.
+	bool ProbeWDL(ChessPosition const& position, ChessWDLScore& out_wdl) const;
+	bool ProbeDTZ(ChessPosition const& position, int& out_dtz) const;
+
+	// Picks the DTZ-optimal move: fastest conversion when winning, longest resistance when losing
+	bool ProbeRoot(ChessPosition const& position, ChessMove& out_move, ChessWDLScore& out_wdl, int& out_dtz) const;
+
+	// Generated tables only: WIN, LOSS or DRAW and the plies to mate. They know nothing of the
+	// fifty-move rule; ProbeWDL falls back to them when no Syzygy table covers the position.
+	bool ProbeDTM(ChessPosition const& position, ChessWDLScore& out_wdl, int& out_pliesToMate) const;
+	bool ProbeRootDTM(ChessPosition const& position, ChessMove& out_move, ChessWDLScore& out_wdl, int& out_pliesToMate) const;
+
+private:
+	ChessSyzygyTable* FindTable(uint64_t materialKey, bool isDTZ) const;
+	void			  AddTable(std::string const& tableName, std::string const& wdlPath, std::string const& dtzPath);
+
+	int  ProbeTable(ChessPosition const& position, bool isDTZ, ChessWDLScore wdl, int& out_state) const;
+	ChessWDLScore SearchZeroingMoves(ChessPosition const& position, bool checkPawnMoves, int& out_state) const;
+	ChessWDLScore ProbeWDLInternal(ChessPosition const& position, int& out_state) const;
+	int			  ProbeDTZInternal(ChessPosition const& position, int& out_state) const;
+
+private:
+	std::vector<std::unique_ptr<ChessSyzygyTable>> m_tables;
+	std::unordered_map<uint64_t, int> m_wdlTableForKey;
+	std::unordered_map<uint64_t, int> m_dtzTableForKey;
+	std::vector<std::unique_ptr<ChessEndgameTable>> m_endgameTables;
+	std::unordered_map<uint64_t, int> m_endgameTableForKey;
+	int m_maxPieces = 0;
+	int m_numWDLTables = 0;
+};
+// -----------------------------------------------------------------------------
+extern ChessTablebases g_chessTablebases;
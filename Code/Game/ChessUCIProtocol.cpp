@@ -0,0 +1,461 @@
+#include "Game/ChessUCIProtocol.hpp"
+#include "Game/ChessAlphaBetaEngine.hpp"
+#include "Game/ChessEvaluation.hpp"
+#include "Game/ChessTablebase.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+// -----------------------------------------------------------------------------
+constexpr char const* UCI_ENGINE_NAME = "Chess3D";
+constexpr char const* UCI_ENGINE_AUTHOR = "jswilkinSMU";
+// -----------------------------------------------------------------------------
+
+static std::vector<std::string> SplitUCITokens(std::string const& commandLine)
+{
+	std::vector<std::string> tokens;
+	std::istringstream stream(commandLine);
+	std::string token;
+	while (stream >> token)
+	{
+		tokens.push_back(token);
+	}
+	return tokens;
+}
+
+static std::string JoinUCITokens(std::vector<std::string> const& tokens, size_t begin, size_t end)
+{
+	std::string text;
+	for (size_t tokenIndex = begin; tokenIndex < end && tokenIndex < tokens.size(); ++tokenIndex)
+	{
+		text += (text.empty() ? "" : " ") + tokens[tokenIndex];
+	}
+	return text;
+}
+
+static std::string ToLowerUCIText(std::string text)
+{
+	std::transform(text.begin(), text.end(), text.begin(), [](unsigned char character) { return static_cast<char>(tolower(character)); });
+	return text;
+}
+
+// -----------------------------------------------------------------------------
+ChessUCIProtocol::ChessUCIProtocol()
+	: m_bookRandom(std::random_device{}())
+{
+	m_position = ChessPosition::GetStartingPosition();
+
+	// Same data the game loads at startup, minus anything that needs the blackboard
+	g_chessEvalWeights.LoadFromXmlFile("Data/ChessEvalWeights.xml");
+	if (!m_settings.m_endgameTablePath.empty())
+	{
+		g_chessTablebases.AddEndgameTables(m_settings.m_endgameTablePath);
+	}
+	CreateEngine();
+}
+
+ChessUCIProtocol::~ChessUCIProtocol()
+{
+	StopSearch();
+	delete m_engine;
+	m_engine = nullptr;
+}
+
+int ChessUCIProtocol::Run()
+{
+	std::string commandLine;
+	while (std::getline(std::cin, commandLine))
+	{
+		if (!HandleCommand(commandLine))
+		{
+			break;
+		}
+	}
+	StopSearch();
+	return 0;
+}
+
+bool ChessUCIProtocol::HandleCommand(std::string const& commandLine)
+{
+	std::vector<std::string> tokens = SplitUCITokens(commandLine);
+	if (tokens.empty())
+	{
+		return true;
+	}
+
+	std::string const& command = tokens[0];
+	if (command == "uci")
+	{
+		HandleUCI();
+	}
+	else if (command == "isready")
+	{
+		SendLine("readyok");
+	}
+	else if (command == "setoption")
+	{
+		WaitForSearch();
+		HandleSetOption(tokens);
+	}
+	else if (command == "ucinewgame")
+	{
+		WaitForSearch();
+		if (m_engine->GetType() == ChessEngineType::ALPHA_BETA)
+		{
+			static_cast<ChessAlphaBetaEngine*>(m_engine)->ClearTranspositionTable();
+		}
+		m_position = ChessPosition::GetStartingPosition();
+		m_isPositionValid = true;
+	}
+	else if (command == "position")
+	{
+		WaitForSearch();
+		HandlePosition(tokens);
+	}
+	else if (command == "go")
+	{
+		WaitForSearch();
+		HandleGo(tokens);
+	}
+	else if (command == "stop")
+	{
+		StopSearch();
+	}
+	else if (command == "quit")
+	{
+		return false;
+	}
+	else if (command == "d")
+	{
+		SendLine("info string " + m_position.GetFEN());
+	}
+	else if (command != "debug" && command != "register" && command != "ponderhit")
+	{
+		SendLine("info string Unknown command " + command);
+	}
+	return true;
+}
+
+void ChessUCIProtocol::HandleUCI()
+{
+	SendLine(std::string("id name ") + UCI_ENGINE_NAME);
+	SendLine(std::string("id author ") + UCI_ENGINE_AUTHOR);
+	SendLine("option name Hash type spin default " + std::to_string(m_settings.m_hashSizeMB) + " min 1 max 4096");
+	SendLine("option name Threads type spin default " + std::to_string(m_settings.m_numThreads) + " min 1 max 256");
+	SendLine("option name Move Overhead type spin default " + std::to_string(m_settings.m_moveOverheadMS) + " min 0 max 5000");
+	SendLine("option name Engine type combo default alphabeta var alphabeta var mcts");
+	SendLine("option name MCTSPolicy type combo default evaluation var evaluation var rollout");
+	SendLine("option name OwnBook type check default false");
+	SendLine("option name BookFile type string default <empty>");
+	SendLine("option name PolyglotRandomsFile type string default " + m_settings.m_polyglotRandomsFile);
+	SendLine("option name SyzygyPath type string default <empty>");
+	SendLine("option name EndgameTablePath type string default " + m_settings.m_endgameTablePath);
+	SendLine("option name EvalWeightsFile type string default Data/ChessEvalWeights.xml");
+	SendLine("uciok");
+}
+
+void ChessUCIProtocol::HandleSetOption(std::vector<std::string> const& tokens)
+{
+	// setoption name <name, may contain spaces> [value <value, may contain spaces>]
+	auto nameToken = std::find(tokens.begin(), tokens.end(), "name");
+	auto valueToken = std::find(tokens.begin(), tokens.end(), "value");
+	if (nameToken == tokens.end())
+	{
+		SendLine("info string setoption needs a name");
+		return;
+	}
+
+	size_t nameIndex = static_cast<size_t>(nameToken - tokens.begin()) + 1;
+	size_t valueIndex = static_cast<size_t>(valueToken - tokens.begin());
+	std::string name = JoinUCITokens(tokens, nameIndex, valueIndex);
+	std::string value = (valueToken != tokens.end()) ? JoinUCITokens(tokens, valueIndex + 1, tokens.size()) : "";
+	if (value == "<empty>")
+	{
+		value.clear();
+	}
+	ApplyOption(ToLowerUCIText(name), value);
+}
+
+void ChessUCIProtocol::ApplyOption(std::string const& name, std::string const& value)
+{
+	if (name == "hash")
+	{
+		m_settings.m_hashSizeMB = std::clamp(atoi(value.c_str()), 1, 4096);
+		if (m_engine->GetType() == ChessEngineType::ALPHA_BETA)
+		{
+			static_cast<ChessAlphaBetaEngine*>(m_engine)->ResizeTranspositionTable(m_settings.m_hashSizeMB);
+		}
+	}
+	else if (name == "threads")
+	{
+		m_settings.m_numThreads = std::clamp(atoi(value.c_str()), 1, 256);
+	}
+	else if (name == "move overhead")
+	{
+		m_settings.m_moveOverheadMS = std::clamp(atoi(value.c_str()), 0, 5000);
+	}
+	else if (name == "engine")
+	{
+		ChessEngineType engineType = GetChessEngineTypeForName(ToLowerUCIText(value));
+		if (engineType != ChessEngineType::NONE && engineType != m_settings.m_engineType)
+		{
+			m_settings.m_engineType = engineType;
+			CreateEngine();
+		}
+	}
+	else if (name == "mctspolicy")
+	{
+		m_settings.m_mctsPolicy = GetChessMCTSPolicyTypeForName(ToLowerUCIText(value));
+	}
+	else if (name == "ownbook")
+	{
+		m_settings.m_useOwnBook = ToLowerUCIText(value) == "true";
+	}
+	else if (name == "polyglotrandomsfile")
+	{
+		m_settings.m_polyglotRandomsFile = value;
+	}
+	else if (name == "bookfile")
+	{
+		m_settings.m_bookFile = value;
+		m_openingBook.Close();
+		if (value.empty())
+		{
+			return;
+		}
+		if (!ChessOpeningBook::HasPolyglotRandoms() && !ChessOpeningBook::LoadPolyglotRandoms(m_settings.m_polyglotRandomsFile))
+		{
+			SendLine("info string Could not load Polyglot Random64 keys from " + m_settings.m_polyglotRandomsFile + ", or they don't give the standard keys");
+			return;
+		}
+		if (!m_openingBook.Open(value))
+		{
+			SendLine("info string Could not open opening book " + value);
+		}
+	}
+	else if (name == "syzygypath" || name == "endgametablepath")
+	{
+		std::string& path = (name == "syzygypath") ? m_settings.m_syzygyPath : m_settings.m_endgameTablePath;
+		path = value;
+
+		// Both kinds live in the one global set, so it is rebuilt from the two paths
+		int numSyzygyTables = g_chessTablebases.Initialize(m_settings.m_syzygyPath);
+		int numEndgameTables = m_settings.m_endgameTablePath.empty() ? 0 : g_chessTablebases.AddEndgameTables(m_settings.m_endgameTablePath);
+		SendLine("info string " + std::to_string(numSyzygyTables) + " Syzygy and " + std::to_string(numEndgameTables) + " distance-to-mate tables found");
+	}
+	else if (name == "evalweightsfile")
+	{
+		if (!g_chessEvalWeights.LoadFromXmlFile(value))
+		{
+			SendLine("info string Could not load evaluation weights from " + value);
+		}
+	}
+	else
+	{
+		SendLine("info string Unknown option " + name);
+	}
+}
+
+void ChessUCIProtocol::HandlePosition(std::vector<std::string> const& tokens)
+{
+	// position [startpos | fen <six fields>] [moves <move> ...]. Until one is read, the last position no
+	// longer stands, so a go in between must not search it
+	m_isPositionValid = false;
+	auto movesToken = std::find(tokens.begin(), tokens.end(), "moves");
+	size_t movesIndex = static_cast<size_t>(movesToken - tokens.begin());
+
+	ChessPosition position;
+	if (tokens.size() >= 2 && tokens[1] == "startpos")
+	{
+		position = ChessPosition::GetStartingPosition();
+	}
+	else if (tokens.size() >= 3 && tokens[1] == "fen")
+	{
+		std::string fen = JoinUCITokens(tokens, 2, movesIndex);
+		if (!position.SetFromFEN(fen.c_str()))
+		{
+			SendLine("info string Invalid FEN " + fen);
+			return;
+		}
+	}
+	else
+	{
+		SendLine("info string position needs startpos or fen");
+		return;
+	}
+
+	// Each move must match one the rules generate; long algebraic is exactly ChessMove::GetNotation
+	for (size_t tokenIndex = movesIndex + 1; tokenIndex < tokens.size(); ++tokenIndex)
+	{
+		std::string moveText = ToLowerUCIText(tokens[tokenIndex]);
+		ChessMoveList legalMoves;
+		position.GenerateLegalMoves(legalMoves);
+		bool isLegal = false;
+		for (int moveIndex = 0; moveIndex < legalMoves.m_count && !isLegal; ++moveIndex)
+		{
+			if (legalMoves[moveIndex].GetNotation() == moveText)
+			{
+				position.MakeMove(legalMoves[moveIndex]);
+				isLegal = true;
+			}
+		}
+		if (!isLegal)
+		{
+			// As other engines do, play on from the position before the illegal move
+			SendLine("info string Illegal move " + moveText + " in " + position.GetFEN());
+			break;
+		}
+	}
+
+	m_position = position;
+	m_isPositionValid = true;
+}
+
+void ChessUCIProtocol::HandleGo(std::vector<std::string> const& tokens)
+{
+	int remainingMS[2] = { -1, -1 };
+	int incrementMS[2] = { 0, 0 };
+	int movesToGo = 0;
+	int moveTimeMS = -1;
+
+	ChessSearchLimits limits;
+	limits.m_numThreads = m_settings.m_numThreads;
+	limits.m_mctsPolicy = m_settings.m_mctsPolicy;
+	limits.m_useTablebases = true;
+	limits.m_useOpeningBook = m_settings.m_useOwnBook;
+	m_isInfiniteSearch = false;
+	for (size_t tokenIndex = 1; tokenIndex < tokens.size(); ++tokenIndex)
+	{
+		std::string const& key = tokens[tokenIndex];
+		int value = (tokenIndex + 1 < tokens.size()) ? atoi(tokens[tokenIndex + 1].c_str()) : 0;
+		if		(key == "wtime")	 { remainingMS[0] = value; ++tokenIndex; }
+		else if (key == "btime")	 { remainingMS[1] = value; ++tokenIndex; }
+		else if (key == "winc")		 { incrementMS[0] = value; ++tokenIndex; }
+		else if (key == "binc")		 { incrementMS[1] = value; ++tokenIndex; }
+		else if (key == "movestogo") { movesToGo = value; ++tokenIndex; }
+		else if (key == "movetime")	 { moveTimeMS = value; ++tokenIndex; }
+		else if (key == "depth")	 { limits.m_maxDepth = std::max(1, value); ++tokenIndex; }
+		else if (key == "nodes")	 { limits.m_maxNodes = static_cast<uint64_t>(std::max(1, value)); ++tokenIndex; }
+		else if (key == "infinite")	 { m_isInfiniteSearch = true; }
+	}
+
+	// Without a clock or a move time the search only ends on its depth or node limit, or on "stop"
+	int sideToMove = m_position.GetSideToMove();
+	if (moveTimeMS >= 0)
+	{
+		limits.m_maxSeconds = std::max(0.001f, static_cast<float>(moveTimeMS - m_settings.m_moveOverheadMS) * 0.001f);
+	}
+	else if (remainingMS[sideToMove] >= 0 && !m_isInfiniteSearch)
+	{
+		limits.m_maxSeconds = GetMoveSeconds(remainingMS[sideToMove], incrementMS[sideToMove], movesToGo);
+	}
+	else
+	{
+		limits.m_maxSeconds = 0.f;
+	}
+
+	if (!m_isPositionValid)
+	{
+		SendLine("info string No position to search");
+		SendLine("bestmove 0000");
+		return;
+	}
+
+	// Book moves are answered straight away, the same way ChessMatch::StartEngineSearch does
+	ChessMove bookMove;
+	if (limits.m_useOpeningBook && !m_isInfiniteSearch && m_openingBook.IsOpen() && m_openingBook.ChooseMove(m_position, m_bookRandom(), bookMove))
+	{
+		SendLine("info string book move");
+		SendLine("bestmove " + bookMove.GetNotation());
+		return;
+	}
+
+	m_isSearching = true;
+	ChessPosition rootPosition = m_position;
+	m_searchThread = std::thread([this, rootPosition, limits]()
+	{
+		ChessSearchResult result = m_engine->Search(rootPosition, limits);
+		if (m_isInfiniteSearch)
+		{
+			m_infiniteSearchResult = result;
+		}
+		else
+		{
+			SendSearchResult(result);
+		}
+		m_isSearching = false;
+	});
+}
+
+void ChessUCIProtocol::StopSearch()
+{
+	if (!m_searchThread.joinable())
+	{
+		return;
+	}
+
+	// Search() clears the stop flag as it starts, so keep asking until the thread is really done
+	while (m_isSearching)
+	{
+		m_engine->RequestStop();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	m_searchThread.join();
+	if (m_isInfiniteSearch)
+	{
+		m_isInfiniteSearch = false;
+		SendSearchResult(m_infiniteSearchResult);
+	}
+}
+
+void ChessUCIProtocol::WaitForSearch()
+{
+	// Commands that change engine state wait for a finite search; "go infinite" has to be stopped
+	if (m_searchThread.joinable() && !m_isInfiniteSearch)
+	{
+		m_searchThread.join();
+	}
+	StopSearch();
+}
+
+void ChessUCIProtocol::CreateEngine()
+{
+	delete m_engine;
+	m_engine = (m_settings.m_engineType == ChessEngineType::ALPHA_BETA) ? new ChessAlphaBetaEngine(m_settings.m_hashSizeMB) : ChessEngine::CreateEngine(m_settings.m_engineType);
+}
+
+float ChessUCIProtocol::GetMoveSeconds(int remainingMS, int incrementMS, int movesToGo) const
+{
+	float usableSeconds = static_cast<float>(remainingMS - m_settings.m_moveOverheadMS) * 0.001f;
+	return GetChessMoveSecondsForClock(usableSeconds, static_cast<float>(incrementMS) * 0.001f, movesToGo);
+}
+
+void ChessUCIProtocol::SendSearchResult(ChessSearchResult const& result)
+{
+	// Mate scores count plies from the root; UCI wants whole moves, negative when being mated
+	std::string scoreText = "cp " + std::to_string(result.m_score);
+	if (abs(result.m_score) >= CHESS_MATE_THRESHOLD)
+	{
+		int matePlies = CHESS_MATE_SCORE - abs(result.m_score);
+		int mateMoves = (matePlies + 1) / 2;
+		scoreText = "mate " + std::to_string((result.m_score > 0) ? mateMoves : -mateMoves);
+	}
+
+	int elapsedMS = static_cast<int>(result.m_seconds * 1000.f);
+	SendLine("info depth " + std::to_string(std::max(1, result.m_depth)) + " score " + scoreText + " nodes " + std::to_string(result.m_nodes) +
+		" nps " + std::to_string(static_cast<uint64_t>(result.GetNodesPerSecond())) + " time " + std::to_string(elapsedMS) +
+		" tbhits " + std::to_string(result.m_tablebaseHits));
+
+	// With no legal move the GUI still expects an answer; 0000 is the UCI null move
+	SendLine("bestmove " + (result.HasMove() ? result.m_bestMove.GetNotation() : std::string("0000")));
+}
+
+void ChessUCIProtocol::SendLine(std::string const& line)
+{
+	std::lock_guard<std::mutex> lock(m_outputMutex);
+	printf("%s\n", line.c_str());
+	fflush(stdout);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Game/ChessEngine.hpp"
+#include "Game/ChessOpeningBook.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+// -----------------------------------------------------------------------------
+struct ChessUCISettings
+{
+public:
+	ChessEngineType		m_engineType = ChessEngineType::ALPHA_BETA;
+	ChessMCTSPolicyType m_mctsPolicy = ChessMCTSPolicyType::EVALUATION;
+	int			m_hashSizeMB = 32;
+	int			m_numThreads = 1;
+	int			m_moveOverheadMS = 30;			// Kept back from every move for pipe and GUI latency
+	bool		m_useOwnBook = false;
+	std::string m_bookFile;
+	std::string m_polyglotRandomsFile = "Data/Books/PolyglotRandom64.txt";
+	std::string m_syzygyPath;
+	std::string m_endgameTablePath = "Data/Tablebases";
+};
+// -----------------------------------------------------------------------------
+// Universal Chess Interface front end over stdin/stdout, run with "Chess3D.exe -uci" by a
+// tournament manager. Moves from the GUI are only accepted if ChessPosition lists them as legal.
+// The search runs on its own thread so stop, isready and quit are answered while it thinks.
+// -----------------------------------------------------------------------------
+class ChessUCIProtocol
+{
+public:
+	ChessUCIProtocol();
+	~ChessUCIProtocol();
+	ChessUCIProtocol(ChessUCIProtocol const& copy) = delete;
+	ChessUCIProtocol& operator=(ChessUCIProtocol const& copy) = delete;
+
+	int Run();		// Returns the process exit code once "quit" arrives or stdin closes
+
+private:
+	bool HandleCommand(std::string const& commandLine);
+	void HandleUCI();
+	void HandleSetOption(std::vector<std::string> const& tokens);
+	void HandlePosition(std::vector<std::string> const& tokens);
+	void HandleGo(std::vector<std::string> const& tokens);
+	void StopSearch();
+	void WaitForSearch();
+
+	void  CreateEngine();
+	void  ApplyOption(std::string const& name, std::string const& value);
+	float GetMoveSeconds(int remainingMS, int incrementMS, int movesToGo) const;
+	void  SendSearchResult(ChessSearchResult const& result);
+	void  SendLine(std::string const& line);
+
+private:
+	ChessUCISettings m_settings;
+	ChessEngine*	 m_engine = nullptr;
+	ChessPosition	 m_position;
+	bool			 m_isPositionValid = true;		// False after a position command we couldn't read; go then answers 0000
+
+	ChessOpeningBook m_openingBook;
+	std::mt19937_64	 m_bookRandom;
+
+	std::thread		  m_searchThread;
+	std::atomic<bool> m_isSearching = false;
+	bool			  m_isInfiniteSearch = false;
+	ChessSearchResult m_infiniteSearchResult;		// Held back until "stop" for go infinite
+	std::mutex		  m_outputMutex;
+};
@@ -0,0 +1,462 @@
+#include "Game/ChessWireLink.hpp"
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+
+// -----------------------------------------------------------------------------
+constexpr size_t WIRE_LINK_BUFFER_SIZE = 256 * 1024;		// Each way; many times the largest frame
+#if defined(_WIN32)
+constexpr int WIRE_SEND_FLAGS = 0;
+#else
+constexpr int WIRE_SEND_FLAGS = MSG_NOSIGNAL;		// A dropped peer is an error return, not SIGPIPE
+#endif
+// -----------------------------------------------------------------------------
+
+char const* GetChessWireLinkStateName(ChessWireLinkState state)
+{
+	switch (state)
+	{
+		case ChessWireLinkState::LISTENING:		return "listening";
+		case ChessWireLinkState::CONNECTING:	return "connecting";
+		case ChessWireLinkState::CONNECTED:		return "connected";
+		default:								return "closed";
+	}
+}
+
+// -----------------------------------------------------------------------------
+static bool IsWireSocketBusy()
+{
+	// The call would have blocked, or a connect is still under way
+#if defined(_WIN32)
+	int errorCode = WSAGetLastError();
+	return errorCode == WSAEWOULDBLOCK || errorCode == WSAEINPROGRESS;
+#else
+	return errno == EWOULDBLOCK || errno == EAGAIN || errno == EINPROGRESS || errno == EINTR;
+#endif
+}
+
+static bool SetWireSocketOptions(uintptr_t socketHandle)
+{
+	// Frames are a few bytes each and latency matters more than packet count
+	int isNoDelay = 1;
+#if defined(_WIN32)
+	u_long isNonBlocking = 1;
+	setsockopt(static_cast<SOCKET>(socketHandle), IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char const*>(&isNoDelay), sizeof(isNoDelay));
+	return ioctlsocket(static_cast<SOCKET>(socketHandle), FIONBIO, &isNonBlocking) == 0;
+#else
+	int fileDescriptor = static_cast<int>(socketHandle);
+	setsockopt(fileDescriptor, IPPROTO_TCP, TCP_NODELAY, &isNoDelay, sizeof(isNoDelay));
+	int flags = fcntl(fileDescriptor, F_GETFL, 0);
+	return flags >= 0 && fcntl(fileDescriptor, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool IsWireSocketReady(uintptr_t socketHandle, short events)
+{
+	pollfd pollEntry = {};
+	pollEntry.fd = static_cast<decltype(pollEntry.fd)>(socketHandle);
+	pollEntry.events = events;
+#if defined(_WIN32)
+	int numReady = WSAPoll(&pollEntry, 1, 0);
+#else
+	int numReady = poll(&pollEntry, 1, 0);
+#endif
+	return numReady > 0 && (pollEntry.revents & (events | POLLERR | POLLHUP)) != 0;
+}
+
+bool InitializeChessWireSockets()
+{
+#if defined(_WIN32)
+	static bool const s_isStarted = []()
+	{
+		WSADATA socketData;
+		return WSAStartup(MAKEWORD(2, 2), &socketData) == 0;
+	}();
+	return s_isStarted;
+#else
+	return true;
+#endif
+}
+
+uintptr_t OpenChessWireListenSocket(std::string const& port, int backlog)
+{
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	hints.ai_flags = AI_PASSIVE;
+	addrinfo* address = nullptr;
+	if (!InitializeChessWireSockets() || getaddrinfo(nullptr, port.c_str(), &hints, &address) != 0 || address == nullptr)
+	{
+		return CHESS_NO_WIRE_SOCKET;
+	}
+
+	uintptr_t listenSocket = static_cast<uintptr_t>(socket(address->ai_family, address->ai_socktype, address->ai_protocol));
+	int isReusingAddress = 1;
+	bool isListening = listenSocket != CHESS_NO_WIRE_SOCKET &&
+		setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char const*>(&isReusingAddress), sizeof(isReusingAddress)) == 0 &&
+		bind(listenSocket, address->ai_addr, static_cast<int>(address->ai_addrlen)) == 0 && listen(listenSocket, backlog) == 0 && SetWireSocketOptions(listenSocket);
+	freeaddrinfo(address);
+	if (!isListening)
+	{
+		CloseChessWireSocket(listenSocket);
+	}
+	return listenSocket;
+}
+
+uintptr_t OpenChessWireConnectSocket(std::string const& address, std::string const& port, bool& out_isConnected)
+{
+	out_isConnected = false;
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo* resolvedAddress = nullptr;
+	if (!InitializeChessWireSockets() || getaddrinfo(address.c_str(), port.c_str(), &hints, &resolvedAddress) != 0 || resolvedAddress == nullptr)
+	{
+		return CHESS_NO_WIRE_SOCKET;
+	}
+
+	uintptr_t connectSocket = static_cast<uintptr_t>(socket(resolvedAddress->ai_family, resolvedAddress->ai_socktype, resolvedAddress->ai_protocol));
+	bool isStarted = connectSocket != CHESS_NO_WIRE_SOCKET && SetWireSocketOptions(connectSocket);
+	out_isConnected = isStarted && connect(connectSocket, resolvedAddress->ai_addr, static_cast<int>(resolvedAddress->ai_addrlen)) == 0;
+	isStarted = isStarted && (out_isConnected || IsWireSocketBusy());
+	freeaddrinfo(resolvedAddress);
+	if (!isStarted)
+	{
+		CloseChessWireSocket(connectSocket);
+	}
+	return connectSocket;
+}
+
+uintptr_t AcceptChessWireSocket(uintptr_t listenSocket)
+{
+	uintptr_t acceptedSocket = static_cast<uintptr_t>(accept(listenSocket, nullptr, nullptr));
+	if (acceptedSocket != CHESS_NO_WIRE_SOCKET && !SetWireSocketOptions(acceptedSocket))
+	{
+		CloseChessWireSocket(acceptedSocket);
+	}
+	return acceptedSocket;
+}
+
+void CloseChessWireSocket(uintptr_t& socketHandle)
+{
+	if (socketHandle == CHESS_NO_WIRE_SOCKET)
+	{
+		return;
+	}
+#if defined(_WIN32)
+	closesocket(static_cast<SOCKET>(socketHandle));
+#else
+	close(static_cast<int>(socketHandle));
+#endif
+	socketHandle = CHESS_NO_WIRE_SOCKET;
+}
+
+int GetChessWireSocketError(uintptr_t socketHandle)
+{
+	int socketError = 0;
+	socklen_t errorSize = sizeof(socketError);
+	if (getsockopt(socketHandle, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&socketError), &errorSize) != 0)
+	{
+		return -1;
+	}
+	return socketError;
+}
+
+void SetChessWireSendBufferSize(uintptr_t socketHandle, int numBytes)
+{
+	setsockopt(socketHandle, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<char const*>(&numBytes), sizeof(numBytes));
+}
+
+int SendChessWireBytes(uintptr_t socketHandle, uint8_t const* bytes, size_t numBytes)
+{
+	int numSent = static_cast<int>(send(socketHandle, reinterpret_cast<char const*>(bytes), static_cast<int>(numBytes), WIRE_SEND_FLAGS));
+	if (numSent >= 0)
+	{
+		return numSent;
+	}
+	return IsWireSocketBusy() ? 0 : -1;
+}
+
+int ReceiveChessWireBytes(uintptr_t socketHandle, uint8_t* bytes, size_t maxBytes)
+{
+	int numReceived = static_cast<int>(recv(socketHandle, reinterpret_cast<char*>(bytes), static_cast<int>(maxBytes), 0));
+	if (numReceived > 0)
+	{
+		return numReceived;
+	}
+	return (numReceived < 0 && IsWireSocketBusy()) ? 0 : -1;
+}
+
+// -----------------------------------------------------------------------------
+ChessWireLink::ChessWireLink()
+	: m_listenSocket(CHESS_NO_WIRE_SOCKET)
+	, m_socket(CHESS_NO_WIRE_SOCKET)
+{
+	m_sendBuffer.resize(WIRE_LINK_BUFFER_SIZE);
+	m_receiveBuffer.resize(WIRE_LINK_BUFFER_SIZE);
+}
+
+ChessWireLink::~ChessWireLink()
+{
+	Close();
+}
+
+bool ChessWireLink::Listen(std::string const& port)
+{
+	Close();
+	uintptr_t listenSocket = OpenChessWireListenSocket(port, 1);
+	if (listenSocket == CHESS_NO_WIRE_SOCKET)
+	{
+		m_closeReason = "Could not listen on port " + port;
+		return false;
+	}
+
+	m_listenSocket = listenSocket;
+	m_state = ChessWireLinkState::LISTENING;
+	m_isHost = true;
+	return true;
+}
+
+bool ChessWireLink::Connect(std::string const& address, std::string const& port)
+{
+	Close();
+	bool isConnectedAtOnce = false;
+	uintptr_t connectSocket = OpenChessWireConnectSocket(address, port, isConnectedAtOnce);
+	if (connectSocket == CHESS_NO_WIRE_SOCKET)
+	{
+		m_closeReason = "Could not connect to " + address + ":" + port;
+		return false;
+	}
+
+	m_socket = connectSocket;
+	m_state = ChessWireLinkState::CONNECTING;
+	m_isHost = false;
+	if (isConnectedAtOnce)
+	{
+		OnConnected();
+	}
+	return true;
+}
+
+void ChessWireLink::Close(std::string const& reason)
+{
+	CloseChessWireSocket(m_listenSocket);
+	CloseChessWireSocket(m_socket);
+	if (m_state != ChessWireLinkState::CLOSED || !reason.empty())
+	{
+		m_closeReason = reason;
+	}
+	m_state = ChessWireLinkState::CLOSED;
+	m_sendStart = 0;
+	m_sendEnd = 0;
+}
+
+void ChessWireLink::DropPeer(std::string const& reason)
+{
+	// Frames that arrived before the drop are still handed out, as after Close
+	if (m_listenSocket == CHESS_NO_WIRE_SOCKET)
+	{
+		Close(reason);
+		return;
+	}
+	CloseChessWireSocket(m_socket);
+	m_closeReason = reason;
+	m_state = ChessWireLinkState::LISTENING;
+	m_sendStart = 0;
+	m_sendEnd = 0;
+}
+
+void ChessWireLink::Update()
+{
+	if (m_listenSocket != CHESS_NO_WIRE_SOCKET && IsWireSocketReady(m_listenSocket, POLLIN))
+	{
+		// A match has one peer, so the newest connection takes over from any current one
+		uintptr_t acceptedSocket = AcceptChessWireSocket(m_listenSocket);
+		if (acceptedSocket != CHESS_NO_WIRE_SOCKET)
+		{
+			CloseChessWireSocket(m_socket);
+			m_socket = acceptedSocket;
+			OnConnected();
+		}
+	}
+	else if (m_state == ChessWireLinkState::CONNECTING && IsWireSocketReady(m_socket, POLLOUT))
+	{
+		if (GetChessWireSocketError(m_socket) != 0)
+		{
+			Close("Connection refused");
+			return;
+		}
+		OnConnected();
+	}
+
+	if (m_state == ChessWireLinkState::CONNECTED)
+	{
+		FlushSends();
+		ReadIncoming();
+		if (m_peerVersion == 0)
+		{
+			ReadHello();
+		}
+	}
+}
+
+bool ChessWireLink::Send(ChessWireMessage const& message)
+{
+	if (m_state != ChessWireLinkState::CONNECTED)
+	{
+		return false;
+	}
+
+	// Slide what is still unsent to the front rather than ever growing the buffer
+	if (m_sendBuffer.size() - m_sendEnd < static_cast<size_t>(CHESS_WIRE_MAX_FRAME_SIZE) && m_sendStart > 0)
+	{
+		memmove(m_sendBuffer.data(), m_sendBuffer.data() + m_sendStart, m_sendEnd - m_sendStart);
+		m_sendEnd -= m_sendStart;
+		m_sendStart = 0;
+	}
+	int frameSize = WriteChessWireFrame(message, m_sendBuffer.data() + m_sendEnd, static_cast<int>(m_sendBuffer.size() - m_sendEnd));
+	if (frameSize == 0)
+	{
+		return false;
+	}
+	m_sendEnd += static_cast<size_t>(frameSize);
+	FlushSends();
+	return true;
+}
+
+bool ChessWireLink::ReceiveMessage(ChessWireMessage& out_message)
+{
+	// Frames that arrived before the peer hung up are still handed out after the link closes
+	while (m_peerVersion != 0 && m_receiveStart < m_receiveEnd)
+	{
+		int frameSize = ReadChessWireFrame(m_receiveBuffer.data() + m_receiveStart, static_cast<int>(m_receiveEnd - m_receiveStart), out_message);
+		if (frameSize == 0)
+		{
+			return false;
+		}
+		if (frameSize < 0)
+		{
+			m_receiveStart = m_receiveEnd;
+			DropPeer("Corrupt frame from the peer");
+			return false;
+		}
+		m_receiveStart += static_cast<size_t>(frameSize);
+		if (out_message.m_type != ChessWireMessageType::UNKNOWN && out_message.m_type != ChessWireMessageType::HELLO)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void ChessWireLink::ReadHello()
+{
+	ChessWireMessage hello;
+	int frameSize = ReadChessWireFrame(m_receiveBuffer.data() + m_receiveStart, static_cast<int>(m_receiveEnd - m_receiveStart), hello);
+	if (frameSize == 0)
+	{
+		return;
+	}
+
+	// Nothing is handed out before the peer has said which version it speaks
+	if (frameSize < 0 || hello.m_type != ChessWireMessageType::HELLO)
+	{
+		m_receiveStart = m_receiveEnd;
+		DropPeer("The peer did not open with HELLO");
+		return;
+	}
+	if (hello.m_hello.m_version < CHESS_WIRE_MIN_VERSION || hello.m_hello.m_minVersion > CHESS_WIRE_VERSION)
+	{
+		m_receiveStart = m_receiveEnd;
+		DropPeer("The peer speaks protocol version " + std::to_string(hello.m_hello.m_version) + ", this build " +
+			std::to_string(CHESS_WIRE_MIN_VERSION) + " to " + std::to_string(CHESS_WIRE_VERSION));
+		return;
+	}
+	m_receiveStart += static_cast<size_t>(frameSize);
+	m_peerVersion = hello.m_hello.m_version;
+}
+
+void ChessWireLink::OnConnected()
+{
+	m_state = ChessWireLinkState::CONNECTED;
+	m_peerVersion = 0;
+	m_receiveStart = 0;
+	m_receiveEnd = 0;
+	m_sendStart = 0;
+	m_sendEnd = 0;
+	m_closeReason.clear();
+	++m_numConnects;
+	Send(ChessWireMessage::MakeHello());
+}
+
+void ChessWireLink::FlushSends()
+{
+	while (m_sendStart < m_sendEnd)
+	{
+		int numSent = SendChessWireBytes(m_socket, m_sendBuffer.data() + m_sendStart, m_sendEnd - m_sendStart);
+		if (numSent == 0)
+		{
+			return;
+		}
+		if (numSent < 0)
+		{
+			DropPeer("Send failed; the peer is gone");
+			return;
+		}
+		m_sendStart += static_cast<size_t>(numSent);
+		m_numBytesSent += static_cast<uint64_t>(numSent);
+	}
+	m_sendStart = 0;
+	m_sendEnd = 0;
+}
+
+void ChessWireLink::ReadIncoming()
+{
+	for (;;)
+	{
+		if (m_receiveStart == m_receiveEnd)
+		{
+			m_receiveStart = 0;
+			m_receiveEnd = 0;
+		}
+		else if (m_receiveBuffer.size() - m_receiveEnd < static_cast<size_t>(CHESS_WIRE_MAX_FRAME_SIZE))
+		{
+			memmove(m_receiveBuffer.data(), m_receiveBuffer.data() + m_receiveStart, m_receiveEnd - m_receiveStart);
+			m_receiveEnd -= m_receiveStart;
+			m_receiveStart = 0;
+		}
+		size_t freeBytes = m_receiveBuffer.size() - m_receiveEnd;
+		if (freeBytes == 0)
+		{
+			return;
+		}
+
+		int numReceived = ReceiveChessWireBytes(m_socket, m_receiveBuffer.data() + m_receiveEnd, freeBytes);
+		if (numReceived == 0)
+		{
+			return;
+		}
+		if (numReceived < 0)
+		{
+			DropPeer("The peer closed the link");
+			return;
+		}
+		m_receiveEnd += static_cast<size_t>(numReceived);
+		m_numBytesReceived += static_cast<uint64_t>(numReceived);
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "Game/ChessWireProtocol.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+enum class ChessWireLinkState
+{
+	CLOSED,
+	LISTENING,		// Waiting for the one peer a match has, or for it to come back
+	CONNECTING,
+	CONNECTED		// Socket open; frames flow once both HELLOs are in
+};
+char const* GetChessWireLinkStateName(ChessWireLinkState state);
+// -----------------------------------------------------------------------------
+// Non-blocking TCP sockets as plain handles, shared by the link and ChessMatchServer
+// -----------------------------------------------------------------------------
+constexpr uintptr_t CHESS_NO_WIRE_SOCKET = static_cast<uintptr_t>(-1);
+bool	  InitializeChessWireSockets();
+uintptr_t OpenChessWireListenSocket(std::string const& port, int backlog);
+// Connecting carries on in the background unless out_isConnected comes back true
+uintptr_t OpenChessWireConnectSocket(std::string const& address, std::string const& port, bool& out_isConnected);
+uintptr_t AcceptChessWireSocket(uintptr_t listenSocket);
+void	  CloseChessWireSocket(uintptr_t& socketHandle);
+int		  GetChessWireSocketError(uintptr_t socketHandle);		// 0 once a background connect has succeeded
+// Caps what the system buffers for sending, which otherwise grows to megabytes for a peer that stops reading
+void	  SetChessWireSendBufferSize(uintptr_t socketHandle, int numBytes);
+// Bytes moved, 0 when the call would block, or -1 when the peer is gone
+int		  SendChessWireBytes(uintptr_t socketHandle, uint8_t const* bytes, size_t numBytes);
+int		  ReceiveChessWireBytes(uintptr_t socketHandle, uint8_t* bytes, size_t maxBytes);
+// -----------------------------------------------------------------------------
+// Point-to-point TCP link carrying ChessWireProtocol frames between two games, next to the engine's
+// text-only NetworkSystem. Non-blocking throughout: Update() accepts, finishes connecting, flushes and
+// reads whatever has arrived. Send and receive buffers are sized once, so frames cost no allocation.
+// A host keeps its port open while connected: a peer that drops goes back to LISTENING rather than
+// CLOSED, and a new connection replaces the current one, so a peer whose connection died unnoticed
+// here can still come back. Whether it may is up to the game's RESUME check.
+// -----------------------------------------------------------------------------
+class ChessWireLink
+{
+public:
+	ChessWireLink();
+	~ChessWireLink();
+	ChessWireLink(ChessWireLink const& copy) = delete;
+	ChessWireLink& operator=(ChessWireLink const& copy) = delete;
+
+	bool Listen(std::string const& port);
+	bool Connect(std::string const& address, std::string const& port);
+	void Close(std::string const& reason = "");
+	void DropPeer(std::string const& reason);		// Close, except that a host goes on listening
+	void Update();
+
+	// Queued and flushed straight away; false when the link isn't up or the send buffer is full
+	bool Send(ChessWireMessage const& message);
+	// The next whole frame, HELLOs excepted; a TEXT message's text is valid until the next Update
+	bool ReceiveMessage(ChessWireMessage& out_message);
+
+	ChessWireLinkState GetState() const		 { return m_state; }
+	bool			   IsConnected() const	 { return m_state == ChessWireLinkState::CONNECTED && m_peerVersion != 0; }
+	int				   GetPeerVersion() const { return m_peerVersion; }
+	bool			   IsHost() const		 { return m_isHost; }		// Listened rather than connected
+	uint32_t		   GetNumConnects() const { return m_numConnects; }		// Changes with every new peer connection
+	std::string const& GetCloseReason() const { return m_closeReason; }
+	uint64_t		   GetNumBytesSent() const { return m_numBytesSent; }
+	uint64_t		   GetNumBytesReceived() const { return m_numBytesReceived; }
+
+private:
+	void OnConnected();
+	void FlushSends();
+	void ReadIncoming();
+	void ReadHello();
+
+private:
+	ChessWireLinkState m_state = ChessWireLinkState::CLOSED;
+	uintptr_t	m_listenSocket;
+	uintptr_t	m_socket;
+	int			m_peerVersion = 0;		// 0 until the peer's HELLO arrives
+	bool		m_isHost = false;
+	uint32_t	m_numConnects = 0;
+	std::string m_closeReason;
+
+	std::vector<uint8_t> m_sendBuffer;
+	size_t				 m_sendStart = 0;
+	size_t				 m_sendEnd = 0;
+	std::vector<uint8_t> m_receiveBuffer;
+	size_t				 m_receiveStart = 0;
+	size_t				 m_receiveEnd = 0;
+
+	uint64_t m_numBytesSent = 0;
+	uint64_t m_numBytesReceived = 0;
+};
@@ -0,0 +1,375 @@
+#include "Game/ChessWireProtocol.hpp"
+#include <cmath>
+#include <cstring>
+#include <random>
+
+// -----------------------------------------------------------------------------
+// Payload bytes of each fixed frame, by ChessWireMessageType; TEXT has none fixed. Newer versions
+// may append fields, so longer payloads are read and the extra bytes ignored, but shorter ones are corrupt.
+static constexpr int WIRE_PAYLOAD_SIZES[static_cast<int>(ChessWireMessageType::COUNT)] = { 0, 4, 0, 4, 10, 3, 1, 5, 6, 0, 8, 22 };
+static constexpr int WIRE_CHECKED_MOVE_PAYLOAD_SIZE = 12;		// A MOVE with its state hash
+static constexpr uint8_t WIRE_HELLO_MAGIC[2] = { 'C', '3' };
+// -----------------------------------------------------------------------------
+
+static void WriteWire16(uint8_t* bytes, uint16_t value)
+{
+	bytes[0] = static_cast<uint8_t>(value);
+	bytes[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static void WriteWire32(uint8_t* bytes, uint32_t value)
+{
+	WriteWire16(bytes, static_cast<uint16_t>(value));
+	WriteWire16(bytes + 2, static_cast<uint16_t>(value >> 16));
+}
+
+static uint16_t ReadWire16(uint8_t const* bytes)
+{
+	return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t ReadWire32(uint8_t const* bytes)
+{
+	return ReadWire16(bytes) | (static_cast<uint32_t>(ReadWire16(bytes + 2)) << 16);
+}
+
+static void WriteWire64(uint8_t* bytes, uint64_t value)
+{
+	WriteWire32(bytes, static_cast<uint32_t>(value));
+	WriteWire32(bytes + 4, static_cast<uint32_t>(value >> 32));
+}
+
+static uint64_t ReadWire64(uint8_t const* bytes)
+{
+	return ReadWire32(bytes) | (static_cast<uint64_t>(ReadWire32(bytes + 4)) << 32);
+}
+
+static uint64_t MixWireHash(uint64_t value)
+{
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+static uint32_t GetClockMS(float seconds)
+{
+	return (seconds > 0.f) ? static_cast<uint32_t>(std::lround(seconds * 1000.f)) : 0;
+}
+
+// -----------------------------------------------------------------------------
+ChessWireMessage ChessWireMessage::MakeHello()
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::HELLO;
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeText(std::string_view command)
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::TEXT;
+	message.m_text = command;
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeMove(int ply, uint16_t loggedMove, uint64_t stateHash)
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::MOVE;
+	message.m_move.m_ply = static_cast<uint16_t>(ply);
+	message.m_move.m_loggedMove = loggedMove;
+	message.m_move.m_stateHash = stateHash;
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeClock(int ply, float playerOneSeconds, float playerTwoSeconds)
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::CLOCK;
+	message.m_clock.m_ply = static_cast<uint16_t>(ply);
+	message.m_clock.m_clockMS[0] = GetClockMS(playerOneSeconds);
+	message.m_clock.m_clockMS[1] = GetClockMS(playerTwoSeconds);
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeOffer(int ply, ChessWireOfferType offerType)
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::OFFER;
+	message.m_offer.m_ply = static_cast<uint16_t>(ply);
+	message.m_offer.m_offerType = offerType;
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeResign(int playerIndex)
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::RESIGN;
+	message.m_resign.m_playerIndex = static_cast<uint8_t>(playerIndex);
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeJoin(uint32_t roomId, uint8_t seat)
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::JOIN;
+	message.m_join.m_roomId = roomId;
+	message.m_join.m_seat = seat;
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeSeat(uint32_t roomId, uint8_t seat, int numSeated)
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::SEAT;
+	message.m_seat.m_roomId = roomId;
+	message.m_seat.m_seat = seat;
+	message.m_seat.m_numSeated = static_cast<uint8_t>(numSeated);
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeResync()
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::RESYNC;
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeSession(uint64_t token)
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::SESSION;
+	message.m_session.m_token = token;
+	return message;
+}
+
+ChessWireMessage ChessWireMessage::MakeResume(uint32_t roomId, uint64_t token, int ply, uint64_t positionHash)
+{
+	ChessWireMessage message;
+	message.m_type = ChessWireMessageType::RESUME;
+	message.m_resume.m_roomId = roomId;
+	message.m_resume.m_token = token;
+	message.m_resume.m_ply = static_cast<uint16_t>(ply);
+	message.m_resume.m_positionHash = positionHash;
+	return message;
+}
+
+// -----------------------------------------------------------------------------
+int WriteChessWireFrame(ChessWireMessage const& message, uint8_t* out_bytes, int maxBytes)
+{
+	int typeIndex = static_cast<int>(message.m_type);
+	if (message.m_type == ChessWireMessageType::UNKNOWN || typeIndex >= static_cast<int>(ChessWireMessageType::COUNT))
+	{
+		return 0;
+	}
+
+	int payloadSize = (message.m_type == ChessWireMessageType::TEXT) ? static_cast<int>(message.m_text.size()) : WIRE_PAYLOAD_SIZES[typeIndex];
+	if (message.m_type == ChessWireMessageType::MOVE && message.m_move.m_stateHash != 0)
+	{
+		payloadSize = WIRE_CHECKED_MOVE_PAYLOAD_SIZE;
+	}
+	int bodySize = 1 + payloadSize;
+	int prefixSize = (bodySize < 0x80) ? 1 : 2;
+	if (bodySize > CHESS_WIRE_MAX_FRAME_BODY || prefixSize + bodySize > maxBytes)
+	{
+		return 0;
+	}
+
+	uint8_t* cursor = out_bytes;
+	if (prefixSize == 1)
+	{
+		*cursor++ = static_cast<uint8_t>(bodySize);
+	}
+	else
+	{
+		*cursor++ = static_cast<uint8_t>(0x80 | (bodySize & 0x7F));
+		*cursor++ = static_cast<uint8_t>(bodySize >> 7);
+	}
+	*cursor++ = static_cast<uint8_t>(message.m_type);
+
+	switch (message.m_type)
+	{
+		case ChessWireMessageType::HELLO:
+			cursor[0] = WIRE_HELLO_MAGIC[0];
+			cursor[1] = WIRE_HELLO_MAGIC[1];
+			cursor[2] = message.m_hello.m_version;
+			cursor[3] = message.m_hello.m_minVersion;
+			break;
+		case ChessWireMessageType::TEXT:
+			memcpy(cursor, message.m_text.data(), message.m_text.size());
+			break;
+		case ChessWireMessageType::MOVE:
+			WriteWire16(cursor, message.m_move.m_ply);
+			WriteWire16(cursor + 2, message.m_move.m_loggedMove);
+			if (payloadSize == WIRE_CHECKED_MOVE_PAYLOAD_SIZE)
+			{
+				WriteWire64(cursor + 4, message.m_move.m_stateHash);
+			}
+			break;
+		case ChessWireMessageType::CLOCK:
+			WriteWire16(cursor, message.m_clock.m_ply);
+			WriteWire32(cursor + 2, message.m_clock.m_clockMS[0]);
+			WriteWire32(cursor + 6, message.m_clock.m_clockMS[1]);
+			break;
+		case ChessWireMessageType::OFFER:
+			WriteWire16(cursor, message.m_offer.m_ply);
+			cursor[2] = static_cast<uint8_t>(message.m_offer.m_offerType);
+			break;
+		case ChessWireMessageType::RESIGN:
+			cursor[0] = message.m_resign.m_playerIndex;
+			break;
+		case ChessWireMessageType::JOIN:
+			WriteWire32(cursor, message.m_join.m_roomId);
+			cursor[4] = message.m_join.m_seat;
+			break;
+		case ChessWireMessageType::SEAT:
+			WriteWire32(cursor, message.m_seat.m_roomId);
+			cursor[4] = message.m_seat.m_seat;
+			cursor[5] = message.m_seat.m_numSeated;
+			break;
+		case ChessWireMessageType::SESSION:
+			WriteWire64(cursor, message.m_session.m_token);
+			break;
+		case ChessWireMessageType::RESUME:
+			WriteWire32(cursor, message.m_resume.m_roomId);
+			WriteWire64(cursor + 4, message.m_resume.m_token);
+			WriteWire16(cursor + 12, message.m_resume.m_ply);
+			WriteWire64(cursor + 14, message.m_resume.m_positionHash);
+			break;
+		default:
+			break;
+	}
+	return prefixSize + bodySize;
+}
+
+int ReadChessWireFrame(uint8_t const* bytes, int numBytes, ChessWireMessage& out_message)
+{
+	if (numBytes < 1)
+	{
+		return 0;
+	}
+	int prefixSize = 1;
+	int bodySize = bytes[0];
+	if ((bytes[0] & 0x80) != 0)
+	{
+		if (numBytes < 2)
+		{
+			return 0;
+		}
+		if ((bytes[1] & 0x80) != 0)
+		{
+			return -1;
+		}
+		prefixSize = 2;
+		bodySize = (bytes[0] & 0x7F) | (bytes[1] << 7);
+	}
+	if (bodySize == 0)
+	{
+		return -1;
+	}
+	if (numBytes < prefixSize + bodySize)
+	{
+		return 0;
+	}
+
+	uint8_t const* body = bytes + prefixSize;
+	int payloadSize = bodySize - 1;
+	uint8_t const* payload = body + 1;
+	out_message = ChessWireMessage();
+	out_message.m_type = (body[0] < static_cast<uint8_t>(ChessWireMessageType::COUNT)) ? static_cast<ChessWireMessageType>(body[0]) : ChessWireMessageType::UNKNOWN;
+	if (payloadSize < WIRE_PAYLOAD_SIZES[static_cast<int>(out_message.m_type)])
+	{
+		return -1;
+	}
+
+	switch (out_message.m_type)
+	{
+		case ChessWireMessageType::HELLO:
+			if (payload[0] != WIRE_HELLO_MAGIC[0] || payload[1] != WIRE_HELLO_MAGIC[1])
+			{
+				return -1;
+			}
+			out_message.m_hello.m_version = payload[2];
+			out_message.m_hello.m_minVersion = payload[3];
+			break;
+		case ChessWireMessageType::TEXT:
+			out_message.m_text = std::string_view(reinterpret_cast<char const*>(payload), static_cast<size_t>(payloadSize));
+			break;
+		case ChessWireMessageType::MOVE:
+			out_message.m_move.m_ply = ReadWire16(payload);
+			out_message.m_move.m_loggedMove = ReadWire16(payload + 2);
+			out_message.m_move.m_stateHash = (payloadSize >= WIRE_CHECKED_MOVE_PAYLOAD_SIZE) ? ReadWire64(payload + 4) : 0;
+			break;
+		case ChessWireMessageType::CLOCK:
+			out_message.m_clock.m_ply = ReadWire16(payload);
+			out_message.m_clock.m_clockMS[0] = ReadWire32(payload + 2);
+			out_message.m_clock.m_clockMS[1] = ReadWire32(payload + 6);
+			break;
+		case ChessWireMessageType::OFFER:
+			if (payload[2] >= static_cast<uint8_t>(ChessWireOfferType::COUNT))
+			{
+				return -1;
+			}
+			out_message.m_offer.m_ply = ReadWire16(payload);
+			out_message.m_offer.m_offerType = static_cast<ChessWireOfferType>(payload[2]);
+			break;
+		case ChessWireMessageType::RESIGN:
+			out_message.m_resign.m_playerIndex = payload[0];
+			break;
+		case ChessWireMessageType::JOIN:
+			out_message.m_join.m_roomId = ReadWire32(payload);
+			out_message.m_join.m_seat = payload[4];
+			break;
+		case ChessWireMessageType::SEAT:
+			out_message.m_seat.m_roomId = ReadWire32(payload);
+			out_message.m_seat.m_seat = payload[4];
+			out_message.m_seat.m_numSeated = payload[5];
+			break;
+		case ChessWireMessageType::SESSION:
+			out_message.m_session.m_token = ReadWire64(payload);
+			break;
+		case ChessWireMessageType::RESUME:
+			out_message.m_resume.m_roomId = ReadWire32(payload);
+			out_message.m_resume.m_token = ReadWire64(payload + 4);
+			out_message.m_resume.m_ply = ReadWire16(payload + 12);
+			out_message.m_resume.m_positionHash = ReadWire64(payload + 14);
+			break;
+		default:
+			break;
+	}
+	return prefixSize + bodySize;
+}
+
+char const* GetChessWireMessageTypeName(ChessWireMessageType messageType)
+{
+	switch (messageType)
+	{
+		case ChessWireMessageType::HELLO:	return "hello";
+		case ChessWireMessageType::TEXT:	return "text";
+		case ChessWireMessageType::MOVE:	return "move";
+		case ChessWireMessageType::CLOCK:	return "clock";
+		case ChessWireMessageType::OFFER:	return "offer";
+		case ChessWireMessageType::RESIGN:	return "resign";
+		case ChessWireMessageType::JOIN:	return "join";
+		case ChessWireMessageType::SEAT:	return "seat";
+		case ChessWireMessageType::RESYNC:	return "resync";
+		case ChessWireMessageType::SESSION:	return "session";
+		case ChessWireMessageType::RESUME:	return "resume";
+		default:							return "unknown";
+	}
+}
+
+uint64_t GetChessWireStateHash(uint64_t positionHash, int ply)
+{
+	// The ply tells apart the same position reached at different points in the game
+	uint64_t stateHash = MixWireHash(positionHash ^ static_cast<uint64_t>(ply));
+	return (stateHash != 0) ? stateHash : 1;
+}
+
+uint64_t MakeChessWireSessionToken()
+{
+	// Only has to be unguessable by another client of the same server, so the system's entropy is plenty
+	std::random_device randomDevice;
+	uint64_t token = (static_cast<uint64_t>(randomDevice()) << 32) | randomDevice();
+	return (token != 0) ? token : 1;
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+// -----------------------------------------------------------------------------
+// Binary match traffic. Every frame is a length prefix (one byte below 128, else two, 7 bits each,
+// low bits first) counting the type byte and payload that follow it, so a reader can skip frame
+// types it doesn't know. Multi-byte fields are little endian. A link opens with HELLO from both sides.
+// -----------------------------------------------------------------------------
+constexpr uint8_t CHESS_WIRE_VERSION = 4;			// 2 added JOIN and SEAT for match servers, 3 state hashes and RESYNC, 4 SESSION and RESUME
+constexpr uint8_t CHESS_WIRE_MIN_VERSION = 1;		// Oldest version this build still reads
+constexpr int	  CHESS_WIRE_MAX_FRAME_BODY = 0x3FFF;		// Type byte + payload, the most a two-byte prefix holds
+constexpr int	  CHESS_WIRE_MAX_FRAME_SIZE = 2 + CHESS_WIRE_MAX_FRAME_BODY;
+constexpr uint8_t CHESS_WIRE_NO_SEAT = 0xFF;		// JOIN: either seat will do; SEAT: the join was refused
+constexpr uint8_t CHESS_WIRE_SPECTATOR_SEAT = 0xFE;	// JOIN and SEAT: watching, not playing
+// -----------------------------------------------------------------------------
+enum class ChessWireMessageType : uint8_t
+{
+	UNKNOWN = 0,	// A frame from a newer version; skipped
+	HELLO,			// 'C' '3' version minVersion
+	TEXT,			// A console command, e.g. "ChessBegin fen=...", for everything without its own frame
+	MOVE,			// ply:16 move:16 (ChessMoveRecord::GetLoggedMove), then state:64 when the move is checked
+	CLOCK,			// ply:16 then each player's clock in milliseconds:32
+	OFFER,			// ply:16 offer:8
+	RESIGN,			// player:8
+	JOIN,			// room:32 seat:8, asking a match server for a seat
+	SEAT,			// room:32 seat:8 seated:8, the server's answer and then every change in who is seated
+	RESYNC,			// Asks the authoritative side, a direct link's host or the match server, for the match from its start
+	SESSION,		// token:64, given to a player when it is seated, to take the seat back after a dropped connection
+	RESUME,			// room:32 token:64 ply:16 position:64, the seat's token with the plies and position this side has
+	COUNT
+};
+// -----------------------------------------------------------------------------
+enum class ChessWireOfferType : uint8_t
+{
+	DRAW_OFFER,
+	DRAW_ACCEPT,
+	DRAW_REJECT,
+	COUNT
+};
+// -----------------------------------------------------------------------------
+struct ChessWireHello
+{
+	uint8_t m_version = CHESS_WIRE_VERSION;
+	uint8_t m_minVersion = CHESS_WIRE_MIN_VERSION;
+};
+
+struct ChessWireMove
+{
+	uint16_t m_ply = 0;				// Plies played before this move, so the receiver can tell it is in step
+	uint16_t m_loggedMove = 0;		// Packed move with CHESS_LOG_TELEPORT_BIT for teleports
+	uint64_t m_stateHash = 0;		// GetChessWireStateHash after the move; 0 = unchecked, and not sent
+};
+
+struct ChessWireClock
+{
+	uint16_t m_ply = 0;
+	uint32_t m_clockMS[2] = {};
+};
+
+struct ChessWireOffer
+{
+	uint16_t		   m_ply = 0;
+	ChessWireOfferType m_offerType = ChessWireOfferType::DRAW_OFFER;
+};
+
+struct ChessWireResign
+{
+	uint8_t m_playerIndex = 0;
+};
+
+struct ChessWireJoin
+{
+	uint32_t m_roomId = 0;
+	uint8_t	 m_seat = CHESS_WIRE_NO_SEAT;
+};
+
+struct ChessWireSeat
+{
+	uint32_t m_roomId = 0;
+	uint8_t	 m_seat = CHESS_WIRE_NO_SEAT;		// The player index this connection plays as, or CHESS_WIRE_SPECTATOR_SEAT
+	uint8_t	 m_numSeated = 0;					// Players in the room, this one included
+};
+
+struct ChessWireSession
+{
+	uint64_t m_token = 0;
+};
+
+struct ChessWireResume
+{
+	uint32_t m_roomId = 0;				// 0 on a direct link
+	uint64_t m_token = 0;
+	uint16_t m_ply = 0;					// Plies this side has; only the moves after them are sent when its position agrees
+	uint64_t m_positionHash = 0;		// ChessPosition::GetHash after those plies
+};
+// -----------------------------------------------------------------------------
+// One decoded frame. Only the struct named by m_type is meaningful; TEXT points into the bytes
+// the frame was read from and is only valid until they change.
+// -----------------------------------------------------------------------------
+struct ChessWireMessage
+{
+public:
+	static ChessWireMessage MakeHello();
+	static ChessWireMessage MakeText(std::string_view command);
+	static ChessWireMessage MakeMove(int ply, uint16_t loggedMove, uint64_t stateHash = 0);
+	static ChessWireMessage MakeClock(int ply, float playerOneSeconds, float playerTwoSeconds);
+	static ChessWireMessage MakeOffer(int ply, ChessWireOfferType offerType);
+	static ChessWireMessage MakeResign(int playerIndex);
+	static ChessWireMessage MakeJoin(uint32_t roomId, uint8_t seat);
+	static ChessWireMessage MakeSeat(uint32_t roomId, uint8_t seat, int numSeated);
+	static ChessWireMessage MakeResync();
+	static ChessWireMessage MakeSession(uint64_t token);
+	static ChessWireMessage MakeResume(uint32_t roomId, uint64_t token, int ply, uint64_t positionHash);
+
+public:
+	ChessWireMessageType m_type = ChessWireMessageType::UNKNOWN;
+	ChessWireHello		 m_hello;
+	ChessWireMove		 m_move;
+	ChessWireClock		 m_clock;
+	ChessWireOffer		 m_offer;
+	ChessWireResign		 m_resign;
+	ChessWireJoin		 m_join;
+	ChessWireSeat		 m_seat;
+	ChessWireSession	 m_session;
+	ChessWireResume		 m_resume;
+	std::string_view	 m_text;
+};
+// -----------------------------------------------------------------------------
+// Frame size in bytes, or 0 when it doesn't fit in maxBytes; nothing is allocated either way
+int WriteChessWireFrame(ChessWireMessage const& message, uint8_t* out_bytes, int maxBytes);
+// Frame size read from the front of the bytes, 0 while the frame is still incomplete, or -1 when
+// the stream is corrupt and the link should be dropped
+int ReadChessWireFrame(uint8_t const* bytes, int numBytes, ChessWireMessage& out_message);
+char const* GetChessWireMessageTypeName(ChessWireMessageType messageType);
+// What a MOVE's receiver checks its own state against: the position hash after the move, and the move's
+// ply. Clocks tick apart on the two machines, so they're compared on their own, with a tolerance. Never 0.
+uint64_t GetChessWireStateHash(uint64_t positionHash, int ply);
+// A random session token for SESSION; never 0
+uint64_t MakeChessWireSessionToken();
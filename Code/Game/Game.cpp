@@ -24,6 +24,11 @@
 #include "Engine/UI/Elements/UIButton.hpp"
 #include "Engine/UI/Elements/UIBorder.hpp"
 
+// -----------------------------------------------------------------------------
+constexpr float WIRE_RECONNECT_SECONDS = 2.f;		// Between attempts to get a dropped link back
+constexpr float FILE_PROGRESS_FIRST_LINE_SECONDS = 0.5f;	// Saves and loads finishing sooner print only their result
+// -----------------------------------------------------------------------------
+
 Game::Game(App* owner)
 	: m_app(owner)
 {
@@ -31,6 +36,7 @@ Game::Game(App* owner)
 	m_gameMusicPath = g_gameConfigBlackboard.GetValue("gameMusic", "default");
 	m_clickSoundPath = g_gameConfigBlackboard.GetValue("buttonClickSound", "default");
 	m_musicVolume = g_gameConfigBlackboard.GetValue("musicVolume", 0.f);
+	m_wireResumeLimitSeconds = g_gameConfigBlackboard.GetValue("wireResumeSeconds", m_wireResumeLimitSeconds);
 
 	m_gameMusic = g_theAudio->CreateOrGetSound(m_gameMusicPath);
 	m_clickSound = g_theAudio->CreateOrGetSound(m_clickSoundPath);
@@ -158,6 +164,7 @@ void Game::Update()
 
 	UpdateUIPresses(static_cast<float>(deltaSeconds));
 	g_theNetwork->ProcessIncomingMessages();
+	UpdateWireLink(static_cast<float>(deltaSeconds));
 
 	if (m_theMatch != nullptr)
 	{
@@ -165,13 +172,61 @@ void Game::Update()
 		UpdateRaycast();
 		UpdateHighlighted();
 		UpdateSelected();
+
+		// Here rather than where the result was found, which was in the middle of playing a move
+		if (m_theMatch != nullptr && m_theMatch->IsAdjudicated())
+		{
+			EnterState(GameState::FINISHED_MATCH);
+		}
 	}
 
+	UpdateFileJobs();
+
 	AdjustForPauseAndTimeDistortion(static_cast<float>(deltaSeconds));
 	KeyInputPresses();
 	UpdateCameras(static_cast<float>(deltaSeconds));
 }
 
+void Game::UpdateFileJobs()
+{
+	// A job slow enough to notice gets a line every second, so a stalled drive shows up as more than silence
+	ChessFileJobType runningType = ChessFileJobType::SAVE;
+	std::string runningFilePath;
+	float runningProgress = 0.f;
+	float runningSeconds = 0.f;
+	if (m_fileWorker.GetRunningJob(runningType, runningFilePath, runningProgress, runningSeconds) && runningSeconds >= m_nextFileProgressSeconds)
+	{
+		char const* verb = (runningType == ChessFileJobType::SAVE) ? "Saving" : "Loading";
+		std::string progressText = (runningProgress > 0.f) ? Stringf(" %d%%", static_cast<int>(runningProgress * 100.f)) : "";
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("%s %s...%s (%.1fs)", verb, runningFilePath.c_str(), progressText.c_str(), runningSeconds));
+		m_nextFileProgressSeconds = floorf(runningSeconds) + 1.f;
+	}
+
+	// Finished jobs come back here on the game thread, where loads may touch the board
+	for (std::unique_ptr<ChessFileJob> job = m_fileWorker.PopFinishedJob(); job != nullptr; job = m_fileWorker.PopFinishedJob())
+	{
+		m_nextFileProgressSeconds = FILE_PROGRESS_FIRST_LINE_SECONDS;
+		g_theDevConsole->AddLine(job->m_succeeded ? DevConsole::INFO_MINOR : DevConsole::ERROR_MAJOR, job->m_message);
+
+		// A load that finishes after its match has ended has nowhere to go
+		bool isLoad = (job->m_type == ChessFileJobType::LOAD);
+		if (isLoad && job->m_succeeded && m_theMatch != nullptr)
+		{
+			m_theMatch->ApplyLoadedGame(job->m_record);
+		}
+		else if (isLoad && job->m_succeeded)
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("No match to load %s into; start one and load it again.", job->m_filePath.c_str()));
+		}
+
+		EventArgs completionArgs;
+		completionArgs.SetValue("file", job->m_filePath);
+		completionArgs.SetValue("success", job->m_succeeded ? "true" : "false");
+		completionArgs.SetValue("seconds", Stringf("%.3f", job->m_seconds));
+		g_theEventSystem->FireEvent(isLoad ? "ChessGameLoaded" : "ChessGameSaved", completionArgs);
+	}
+}
+
 void Game::UpdateUIPresses(float deltaSeconds)
 {
 	Vec2 clientPos = g_theInput->GetCursorClientPosition();
@@ -755,6 +810,198 @@ void Game::ExitState(GameState state)
 	}
 }
 
+void Game::UpdateWireLink(float deltaSeconds)
+{
+	// A host's link can go from one peer connection to the next within an update, so new connections are
+	// told apart by count rather than by the link going down and up
+	m_wireLink.Update();
+	bool isConnected = m_wireLink.IsConnected();
+	bool isNewConnection = isConnected && m_wireLink.GetNumConnects() != m_numWireConnects;
+	if (m_wasWireLinkConnected && (!isConnected || isNewConnection))
+	{
+		OnWireLinkDropped();
+	}
+	if (isNewConnection)
+	{
+		m_numWireConnects = m_wireLink.GetNumConnects();
+		OnWireLinkConnected();
+	}
+	m_wasWireLinkConnected = isConnected;
+	UpdateWireResume(deltaSeconds);
+
+	// Text frames are console commands exactly as RemoteCmd would run them; the rest belong to the match.
+	// A host waiting for its peer to resume takes nothing else from whoever has connected
+	ChessWireMessage message;
+	while (m_wireLink.ReceiveMessage(message))
+	{
+		if (m_wireLink.IsHost() && m_isWireResuming && message.m_type != ChessWireMessageType::RESUME)
+		{
+			RefuseWirePeer("The peer sent a match before resuming the one that dropped");
+		}
+		else if (message.m_type == ChessWireMessageType::TEXT)
+		{
+			g_theDevConsole->Execute(std::string(message.m_text));
+		}
+		else if (message.m_type == ChessWireMessageType::SESSION)
+		{
+			m_wireSessionToken = message.m_session.m_token;
+		}
+		else if (message.m_type == ChessWireMessageType::RESUME)
+		{
+			ResumeWireSession(message.m_resume);
+		}
+		else if (message.m_type == ChessWireMessageType::SEAT)
+		{
+			ChessWireSeat const& seat = message.m_seat;
+			if (seat.m_seat == CHESS_WIRE_NO_SEAT && m_wireSessionToken != 0)
+			{
+				// The answer to a RESUME the host or server wouldn't take: the seat was given up in the meantime
+				g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Could not resume the match; the seat is no longer held. Reconnect to start again.");
+				m_wireSessionToken = 0;
+				m_isWireResuming = false;
+			}
+			else if (seat.m_seat == CHESS_WIRE_NO_SEAT)
+			{
+				g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Room %u has no free seat", seat.m_roomId));
+			}
+			else if (seat.m_seat == CHESS_WIRE_SPECTATOR_SEAT)
+			{
+				g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Watching room %u, %d players seated", seat.m_roomId, seat.m_numSeated));
+			}
+			else
+			{
+				g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Room %u: playing as player %d, %s", seat.m_roomId, seat.m_seat + 1,
+					(seat.m_numSeated == 2) ? "both players are here" : "waiting for an opponent"));
+			}
+		}
+		else if (m_theMatch != nullptr)
+		{
+			m_theMatch->ReceiveWireMessage(message);
+		}
+	}
+}
+
+void Game::OnWireLinkConnected()
+{
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Binary link connected, protocol version %d", m_wireLink.GetPeerVersion()));
+
+	// A host starts a session with its first peer, then waits for that peer to resume it after a drop
+	if (m_wireLink.IsHost())
+	{
+		if (m_wireSessionToken == 0)
+		{
+			m_wireSessionToken = MakeChessWireSessionToken();
+			m_wireLink.Send(ChessWireMessage::MakeSession(m_wireSessionToken));
+		}
+		return;
+	}
+
+	// A player coming back sends its token with how far its match got, and is sent only what it missed;
+	// a spectator simply joins again and is sent the game from the start
+	if (m_isWireResuming && m_wireSessionToken != 0 && m_wireSeat != CHESS_WIRE_SPECTATOR_SEAT)
+	{
+		int numPliesShown = (m_theMatch != nullptr) ? m_theMatch->GetNumPliesShown() : 0;
+		uint64_t positionHash = (m_theMatch != nullptr) ? m_theMatch->m_position.GetHash() : 0;
+		m_wireLink.Send(ChessWireMessage::MakeResume(m_wireRoomId, m_wireSessionToken, numPliesShown, positionHash));
+		g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("Resuming the match from ply %d", numPliesShown));
+	}
+	else if (m_wireRoomId != 0)
+	{
+		m_wireLink.Send(ChessWireMessage::MakeJoin(m_wireRoomId, m_wireSeat));
+	}
+	m_isWireResuming = false;
+}
+
+void Game::OnWireLinkDropped()
+{
+	std::string closeReason = m_wireLink.GetCloseReason().empty() ? "the peer connected again" : m_wireLink.GetCloseReason();
+	g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, Stringf("Binary link closed: %s", closeReason.c_str()));
+	bool isSpectating = m_wireRoomId != 0 && m_wireSeat == CHESS_WIRE_SPECTATOR_SEAT;
+	if (m_wireSessionToken == 0 && !isSpectating)
+	{
+		return;
+	}
+
+	// The host listens on for its peer; everyone else reconnects on its own
+	m_isWireResuming = true;
+	m_wireResumeSeconds = 0.f;
+	m_wireReconnectSeconds = 0.f;
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf(m_wireLink.IsHost() ? "Holding the match for the peer to resume for %.0f seconds" : "Reconnecting for up to %.0f seconds",
+		m_wireResumeLimitSeconds));
+}
+
+void Game::UpdateWireResume(float deltaSeconds)
+{
+	if (!m_isWireResuming)
+	{
+		return;
+	}
+
+	m_wireResumeSeconds += deltaSeconds;
+	if (m_wireResumeSeconds > m_wireResumeLimitSeconds)
+	{
+		m_isWireResuming = false;
+		m_wireSessionToken = 0;
+		if (m_wireLink.IsHost())
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "The peer did not come back; the next one to connect starts a new match");
+		}
+		else
+		{
+			m_wireLink.Close("Gave up reconnecting");
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Gave up reconnecting the binary link");
+		}
+		return;
+	}
+
+	m_wireReconnectSeconds -= deltaSeconds;
+	if (!m_wireLink.IsHost() && m_wireLink.GetState() == ChessWireLinkState::CLOSED && m_wireReconnectSeconds <= 0.f)
+	{
+		m_wireReconnectSeconds = WIRE_RECONNECT_SECONDS;
+		m_wireLink.Connect(m_wireAddress, m_wirePort);
+	}
+}
+
+void Game::ResumeWireSession(ChessWireResume const& resume)
+{
+	// Only the peer holding the session's token gets the match back
+	if (!m_wireLink.IsHost() || m_wireSessionToken == 0 || resume.m_token != m_wireSessionToken || m_theMatch == nullptr)
+	{
+		RefuseWirePeer("The peer tried to resume a match this side doesn't hold");
+		return;
+	}
+	m_isWireResuming = false;
+	g_theDevConsole->AddLine(DevConsole::INFO_MAJOR, Stringf("The peer resumed the match from ply %d", resume.m_ply));
+	m_theMatch->SendMissingMoves(resume.m_ply, resume.m_positionHash);
+}
+
+void Game::RefuseWirePeer(std::string const& reason)
+{
+	// A SEAT with no seat, as a match server answers a RESUME it won't take; the host listens on either way
+	if (m_wireLink.IsConnected())
+	{
+		m_wireLink.Send(ChessWireMessage::MakeSeat(0, CHESS_WIRE_NO_SEAT, 0));
+		m_wireLink.DropPeer(reason);
+		m_wasWireLinkConnected = false;
+		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, reason);
+	}
+}
+
+void Game::CloseWireLink(std::string const& reason)
+{
+	// A room's seat is given up straight away rather than held for a resume
+	if (m_wireLink.IsConnected() && m_wireRoomId != 0)
+	{
+		m_wireLink.Send(ChessWireMessage::MakeJoin(0, CHESS_WIRE_NO_SEAT));
+	}
+	m_wireLink.Close(reason);
+	m_wasWireLinkConnected = false;
+	m_wireSessionToken = 0;
+	m_isWireResuming = false;
+	m_wireRoomId = 0;
+	m_wireSeat = CHESS_WIRE_NO_SEAT;
+}
+
 bool Game::Event_ChessServerInfo(EventArgs& args)
 {
 	std::string addressArgs = args.GetValue("ip", "");
@@ -790,6 +1037,9 @@ bool Game::Event_ChessServerInfo(EventArgs& args)
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("IP Address       : %s", ip.c_str()));
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("Port             : %s", port.c_str()));
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("Connection Status: %s", status.c_str()));
+	ChessWireLink const& wireLink = g_theGame->m_wireLink;
+	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("Binary Link      : %s, %llu bytes sent, %llu received", GetChessWireLinkStateName(wireLink.GetState()),
+		static_cast<unsigned long long>(wireLink.GetNumBytesSent()), static_cast<unsigned long long>(wireLink.GetNumBytesReceived())));
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("Game State       : %s", gameState.c_str()));
 	g_theDevConsole->AddLine(Rgba8::YELLOW, "===============================");
 
@@ -798,7 +1048,7 @@ bool Game::Event_ChessServerInfo(EventArgs& args)
 
 bool Game::Event_ChessListen(EventArgs& args)
 {
-	if (g_theNetwork->IsConnected())
+	if (g_theNetwork->IsConnected() || g_theGame->m_wireLink.GetState() != ChessWireLinkState::CLOSED)
 	{
 		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Cannot start listening while connected.");
 		return false;
@@ -810,13 +1060,28 @@ bool Game::Event_ChessListen(EventArgs& args)
 		g_theNetwork->GetNetworkConfig().m_port = Stringf("%d", portArgs);
 	}
 
+	// wire=binary carries the match as ChessWireProtocol frames; both sides must pick it
+	if (args.GetValue("wire", "text") == "binary")
+	{
+		std::string port = g_theNetwork->GetNetworkConfig().m_port;
+		g_theGame->m_wireSessionToken = 0;
+		g_theGame->m_isWireResuming = false;
+		if (!g_theGame->m_wireLink.Listen(port))
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, g_theGame->m_wireLink.GetCloseReason());
+			return false;
+		}
+		g_theDevConsole->AddLine(DevConsole::INFO_MINOR, Stringf("Listening for a binary link on port %s", port.c_str()));
+		return true;
+	}
+
 	g_theNetwork->StartServer();
 	return true;
 }
 
 bool Game::Event_Chess_Connect(EventArgs& args)
 {
-	if (g_theNetwork->IsConnected())
+	if (g_theNetwork->IsConnected() || g_theGame->m_wireLink.GetState() != ChessWireLinkState::CLOSED)
 	{
 		g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, "Already connected to a server.");
 		return false;
@@ -834,11 +1099,37 @@ bool Game::Event_Chess_Connect(EventArgs& args)
 		g_theNetwork->GetNetworkConfig().m_port = Stringf("%d", portArgs);
 	}
 
-	g_theNetwork->StartClient();
-
 	std::string ip = g_theNetwork->GetNetworkConfig().m_address;
 	std::string port = g_theNetwork->GetNetworkConfig().m_port;
 
+	// room= takes a seat in one of a match server's rooms (Chess3D -server); seat=1 or 2 picks the side,
+	// and watch=true follows the game as a spectator instead
+	int roomArgs = args.GetValue("room", 0);
+	int seatArgs = args.GetValue("seat", 0);
+	g_theGame->m_wireRoomId = (roomArgs > 0) ? static_cast<uint32_t>(roomArgs) : 0;
+	g_theGame->m_wireSeat = (seatArgs == 1 || seatArgs == 2) ? static_cast<uint8_t>(seatArgs - 1) : CHESS_WIRE_NO_SEAT;
+	if (args.GetValue("watch", "false") == "true")
+	{
+		g_theGame->m_wireSeat = CHESS_WIRE_SPECTATOR_SEAT;
+	}
+	if (args.GetValue("wire", "text") == "binary" || roomArgs > 0)
+	{
+		// Kept for reconnecting if the link drops
+		g_theGame->m_wireAddress = ip;
+		g_theGame->m_wirePort = port;
+		g_theGame->m_wireSessionToken = 0;
+		g_theGame->m_isWireResuming = false;
+		if (!g_theGame->m_wireLink.Connect(ip, port))
+		{
+			g_theDevConsole->AddLine(DevConsole::ERROR_MAJOR, g_theGame->m_wireLink.GetCloseReason());
+			return false;
+		}
+	}
+	else
+	{
+		g_theNetwork->StartClient();
+	}
+
 	g_theDevConsole->AddLine(Rgba8::YELLOW, "========= Connecting to Server =========");
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("Target IP         : %s", ip.c_str()));
 	g_theDevConsole->AddLine(Rgba8::CYAN, Stringf("Target Port       : %s", port.c_str()));
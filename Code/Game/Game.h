@@ -1,6 +1,8 @@
 #pragma once
 #include "Game/GameCommon.h"
 #include "Game/ChessObject.hpp"
+#include "Game/ChessFileWorker.hpp"
+#include "Game/ChessWireLink.hpp"
 #include "Engine/Renderer/Camera.h"
 #include "Engine/Core/Clock.hpp"
 #include "Engine/Core/Vertex_PCU.h"
@@ -26,6 +28,14 @@ public:
 	// Updating
 	void Update();
 	void UpdateUIPresses(float deltaSeconds);
+	void UpdateWireLink(float deltaSeconds);
+	void UpdateWireResume(float deltaSeconds);
+	void OnWireLinkConnected();
+	void OnWireLinkDropped();
+	void ResumeWireSession(ChessWireResume const& resume);
+	void RefuseWirePeer(std::string const& reason);
+	void CloseWireLink(std::string const& reason);		// On purpose, so the session is given up rather than resumed
+	void UpdateFileJobs();
 	void DebugVisuals();
 
 	// Raycasting
@@ -70,6 +80,29 @@ public:
 	ChessMatch* m_theMatch = nullptr;
 	int			m_debugInt = 0;
 
+	// Saves and loads in the background. Here rather than in the match, so a save made as a match ends is
+	// still written in the background and its ChessGameSaved still fires; slow ones get a line every second
+	ChessFileWorker m_fileWorker;
+	float			m_nextFileProgressSeconds = 0.5f;
+
+	// Binary match link, opened by ChessListen/ChessConnect wire=binary instead of the engine's text network
+	ChessWireLink m_wireLink;
+	bool		  m_wasWireLinkConnected = false;
+	uint32_t	  m_wireRoomId = 0;						// Room asked for on a match server; 0 = a direct link
+	uint8_t		  m_wireSeat = CHESS_WIRE_NO_SEAT;
+	int			  m_lastResyncPly = -1;					// Where a resync was last asked for; a second mismatch there is only reported
+
+	// A dropped link is resumed rather than lost: the session token the host or match server gave this
+	// side, where to reconnect to, and how long the link has been down
+	uint64_t	  m_wireSessionToken = 0;
+	std::string	  m_wireAddress;
+	std::string	  m_wirePort;
+	uint32_t	  m_numWireConnects = 0;
+	bool		  m_isWireResuming = false;
+	float		  m_wireResumeSeconds = 0.f;
+	float		  m_wireResumeLimitSeconds = 120.f;		// wireResumeSeconds in GameConfig.xml
+	float		  m_wireReconnectSeconds = 0.f;			// Until the next attempt
+
 	SoundID m_errorSound;
 	SoundID m_chessSlideSound;
 
@@ -0,0 +1,29 @@
+#include "Game/ChessCommandLine.hpp"
+#include <cstdio>
+#include <string>
+
+//-----------------------------------------------------------------------------------------------
+// The headless tools on their own, for Linux and anywhere else without the game's window; built by
+// the CMakeLists.txt at the top of the repository. Runs the same tools Main_Windows.cpp does.
+//-----------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	// Back into the one command line the tools read, quoting any argument the shell split on its spaces
+	std::string commandLine;
+	for (int argIndex = 1; argIndex < argc; ++argIndex)
+	{
+		std::string arg = argv[argIndex];
+		if (arg.find(' ') != std::string::npos)
+		{
+			arg = "\"" + arg + "\"";
+		}
+		commandLine += (argIndex > 1) ? " " + arg : arg;
+	}
+
+	if (!IsChessCommandLineTool(commandLine.c_str()))
+	{
+		printf("Usage: %s -<tool> [key=value ...], e.g. -server port=3100, -serverload port=3100 clients=10000 or -uci\n", (argc > 0) ? argv[0] : "Chess3D_Headless");
+		return 1;
+	}
+	return RunChessCommandLineTool(commandLine.c_str());
+}
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <crtdbg.h>
 #include "App.h"
+#include "Game/ChessCommandLine.hpp"
 #include "Engine/Input/InputSystem.h"
 
 extern HDC g_displayDeviceContext;
@@ -13,9 +14,29 @@ extern App* g_theApp;				// Created and owned by Main_Windows.cpp
 //-----------------------------------------------------------------------------------------------
 int WINAPI WinMain(HINSTANCE applicationInstanceHandle, HINSTANCE, LPSTR commandLineString, int)
 {
-	UNUSED(commandLineString);
 	UNUSED(applicationInstanceHandle);
 
+	// Headless tools run instead of the game and write to the console that launched us, unless
+	// stdin/stdout were handed over as pipes or files (a UCI tournament manager, a redirect)
+	if (IsChessCommandLineTool(commandLineString))
+	{
+		bool isOutputRedirected = GetFileType(GetStdHandle(STD_OUTPUT_HANDLE)) != FILE_TYPE_UNKNOWN;
+		bool isInputRedirected = GetFileType(GetStdHandle(STD_INPUT_HANDLE)) != FILE_TYPE_UNKNOWN;
+		if ((!isOutputRedirected || !isInputRedirected) && (AttachConsole(ATTACH_PARENT_PROCESS) || AllocConsole()))
+		{
+			FILE* consoleStream = nullptr;
+			if (!isOutputRedirected)
+			{
+				freopen_s(&consoleStream, "CONOUT$", "w", stdout);
+			}
+			if (!isInputRedirected)
+			{
+				freopen_s(&consoleStream, "CONIN$", "r", stdin);
+			}
+		}
+		return RunChessCommandLineTool(commandLineString);
+	}
+
 	g_theApp = new App();
 	g_theApp->Startup();
 